@@ -6,15 +6,15 @@
 
 #include "AmsConfiguration.h"
 #include "hexutils.h"
+#include "EnergyDemand.h"
 #if defined(ESP32)
 #include "ESPRandom.h"
 #endif
 
 bool AmsConfiguration::getSystemConfig(SystemConfig& config) {
-	EEPROM.begin(EEPROM_SIZE);
+	loadCache();
 	uint8_t configVersion = EEPROM.read(EEPROM_CONFIG_ADDRESS);
 	EEPROM.get(CONFIG_SYSTEM_START, config);
-	EEPROM.end();
 
 	if(config.firmwareChannel > 3) {
 		config.firmwareChannel = 0;
@@ -52,11 +52,8 @@ bool AmsConfiguration::setSystemConfig(SystemConfig& config) {
 	} else {
 		sysChanged = true;
 	}
-	EEPROM.begin(EEPROM_SIZE);
 	stripNonAscii((uint8_t*) config.country, 2);
-	EEPROM.put(CONFIG_SYSTEM_START, config);
-	bool ret = EEPROM.commit();
-	EEPROM.end();
+	bool ret = writeCache(CONFIG_SYSTEM_START, config);
 	return ret;
 }
 
@@ -70,9 +67,8 @@ void AmsConfiguration::ackSystemConfigChanged() {
 
 bool AmsConfiguration::getNetworkConfig(NetworkConfig& config) {
 	if(hasConfig()) {
-		EEPROM.begin(EEPROM_SIZE);
+		loadCache();
 		EEPROM.get(CONFIG_NETWORK_START, config);
-		EEPROM.end();
 		if(config.sleep > 2) config.sleep = 1;
 		return true;
 	} else {
@@ -113,10 +109,7 @@ bool AmsConfiguration::setNetworkConfig(NetworkConfig& config) {
 	stripNonAscii((uint8_t*) config.dns2, 16);
 	stripNonAscii((uint8_t*) config.hostname, 32);
 
-	EEPROM.begin(EEPROM_SIZE);
-	EEPROM.put(CONFIG_NETWORK_START, config);
-	bool ret = EEPROM.commit();
-	EEPROM.end();
+	bool ret = writeCache(CONFIG_NETWORK_START, config);
 	return ret;
 }
 
@@ -154,9 +147,8 @@ void AmsConfiguration::ackNetworkConfigChange() {
 
 bool AmsConfiguration::getMqttConfig(MqttConfig& config) {
 	if(hasConfig()) {
-		EEPROM.begin(EEPROM_SIZE);
+		loadCache();
 		EEPROM.get(CONFIG_MQTT_START, config);
-		EEPROM.end();
 		if(config.magic != 0xA5) { // New magic for 2.4.11
 			if(config.magic != 0x9C) {
 				if(config.magic != 0x7B) {
@@ -209,10 +201,7 @@ bool AmsConfiguration::setMqttConfig(MqttConfig& config) {
 	if(config.keepalive > 240) config.keepalive = 60;
 	if(config.rebootMinutes > 240) config.rebootMinutes = 0;
 
-	EEPROM.begin(EEPROM_SIZE);
-	EEPROM.put(CONFIG_MQTT_START, config);
-	bool ret = EEPROM.commit();
-	EEPROM.end();
+	bool ret = writeCache(CONFIG_MQTT_START, config);
 	return ret;
 }
 
@@ -249,9 +238,8 @@ void AmsConfiguration::ackMqttChange() {
 
 bool AmsConfiguration::getWebConfig(WebConfig& config) {
 	if(hasConfig()) {
-		EEPROM.begin(EEPROM_SIZE);
+		loadCache();
 		EEPROM.get(CONFIG_WEB_START, config);
-		EEPROM.end();
 		return true;
 	} else {
 		clearWebConfig(config);
@@ -273,10 +261,7 @@ bool AmsConfiguration::setWebConfig(WebConfig& config) {
 	stripNonAscii((uint8_t*) config.password, 37, false, false);
 	stripNonAscii((uint8_t*) config.context, 37);
 
-	EEPROM.begin(EEPROM_SIZE);
-	EEPROM.put(CONFIG_WEB_START, config);
-	bool ret = EEPROM.commit();
-	EEPROM.end();
+	bool ret = writeCache(CONFIG_WEB_START, config);
 	return ret;
 }
 
@@ -296,11 +281,10 @@ void AmsConfiguration::ackWebChange() {
 }
 
 bool AmsConfiguration::getMeterConfig(MeterConfig& config) {
-	EEPROM.begin(EEPROM_SIZE);
+	loadCache();
 	uint8_t configVersion = EEPROM.read(EEPROM_CONFIG_ADDRESS);
 	if(configVersion == EEPROM_CHECK_SUM || configVersion == EEPROM_CLEARED_INDICATOR) {
 		EEPROM.get(CONFIG_METER_START, config);
-		EEPROM.end();
 		if(config.bufferSize < 1 || config.bufferSize > 64) {
 			#if defined(ESP32)
 				config.bufferSize = 2;
@@ -342,10 +326,7 @@ bool AmsConfiguration::setMeterConfig(MeterConfig& config) {
 	} else {
 		meterChanged = true;
 	}
-	EEPROM.begin(EEPROM_SIZE);
-	EEPROM.put(CONFIG_METER_START, config);
-	bool ret = EEPROM.commit();
-	EEPROM.end();
+	bool ret = writeCache(CONFIG_METER_START, config);
 	return ret;
 }
 
@@ -384,9 +365,8 @@ void AmsConfiguration::setMeterChanged() {
 
 bool AmsConfiguration::getDebugConfig(DebugConfig& config) {
 	if(hasConfig()) {
-		EEPROM.begin(EEPROM_SIZE);
+		loadCache();
 		EEPROM.get(CONFIG_DEBUG_START, config);
-		EEPROM.end();
 		return true;
 	} else {
 		clearDebug(config);
@@ -397,10 +377,7 @@ bool AmsConfiguration::getDebugConfig(DebugConfig& config) {
 bool AmsConfiguration::setDebugConfig(DebugConfig& config) {
 	if(!config.serial && !config.telnet)
 		config.level = 4; // Force warning level when debug is disabled
-	EEPROM.begin(EEPROM_SIZE);
-	EEPROM.put(CONFIG_DEBUG_START, config);
-	bool ret = EEPROM.commit();
-	EEPROM.end();
+	bool ret = writeCache(CONFIG_DEBUG_START, config);
 	return ret;
 }
 
@@ -412,9 +389,8 @@ void AmsConfiguration::clearDebug(DebugConfig& config) {
 
 bool AmsConfiguration::getDomoticzConfig(DomoticzConfig& config) {
 	if(hasConfig()) {
-		EEPROM.begin(EEPROM_SIZE);
+		loadCache();
 		EEPROM.get(CONFIG_DOMOTICZ_START, config);
-		EEPROM.end();
 		return true;
 	} else {
 		clearDomo(config);
@@ -433,10 +409,7 @@ bool AmsConfiguration::setDomoticzConfig(DomoticzConfig& config) {
 	} else {
 		mqttChanged = true;
 	}
-	EEPROM.begin(EEPROM_SIZE);
-	EEPROM.put(CONFIG_DOMOTICZ_START, config);
-	bool ret = EEPROM.commit();
-	EEPROM.end();
+	bool ret = writeCache(CONFIG_DOMOTICZ_START, config);
 	return ret;
 }
 
@@ -450,9 +423,8 @@ void AmsConfiguration::clearDomo(DomoticzConfig& config) {
 
 bool AmsConfiguration::getHomeAssistantConfig(HomeAssistantConfig& config) {
 	if(hasConfig()) {
-		EEPROM.begin(EEPROM_SIZE);
+		loadCache();
 		EEPROM.get(CONFIG_HA_START, config);
-		EEPROM.end();
 		if(stripNonAscii((uint8_t*) config.discoveryPrefix, 64) || stripNonAscii((uint8_t*) config.discoveryHostname, 64) || stripNonAscii((uint8_t*) config.discoveryNameTag, 16)) {
 			clearHomeAssistantConfig(config);
 			return false;
@@ -478,10 +450,7 @@ bool AmsConfiguration::setHomeAssistantConfig(HomeAssistantConfig& config) {
 	stripNonAscii((uint8_t*) config.discoveryHostname, 64);
 	stripNonAscii((uint8_t*) config.discoveryNameTag, 16);
 
-	EEPROM.begin(EEPROM_SIZE);
-	EEPROM.put(CONFIG_HA_START, config);
-	bool ret = EEPROM.commit();
-	EEPROM.end();
+	bool ret = writeCache(CONFIG_HA_START, config);
 	return ret;
 }
 
@@ -508,11 +477,10 @@ bool AmsConfiguration::pinUsed(uint8_t pin, GpioConfig& config) {
 }
 
 bool AmsConfiguration::getGpioConfig(GpioConfig& config) {
-	EEPROM.begin(EEPROM_SIZE);
+	loadCache();
 	uint8_t configVersion = EEPROM.read(EEPROM_CONFIG_ADDRESS);
 	if(configVersion == EEPROM_CHECK_SUM || configVersion == EEPROM_CLEARED_INDICATOR) {
 		EEPROM.get(CONFIG_GPIO_START, config);
-		EEPROM.end();
 		if(config.powersaving > 4) config.powersaving = 0;
 		return true;
 	} else {
@@ -568,10 +536,7 @@ bool AmsConfiguration::setGpioConfig(GpioConfig& config) {
 	if(config.apPin >= 0)
 		pinMode(config.apPin, INPUT_PULLUP);
 
-	EEPROM.begin(EEPROM_SIZE);
-	EEPROM.put(CONFIG_GPIO_START, config);
-	bool ret = EEPROM.commit();
-	EEPROM.end();
+	bool ret = writeCache(CONFIG_GPIO_START, config);
 	return ret;
 }
 
@@ -601,9 +566,8 @@ void AmsConfiguration::clearGpio(GpioConfig& config, bool all) {
 
 bool AmsConfiguration::getNtpConfig(NtpConfig& config) {
 	if(hasConfig()) {
-		EEPROM.begin(EEPROM_SIZE);
+		loadCache();
 		EEPROM.get(CONFIG_NTP_START, config);
-		EEPROM.end();
 		return true;
 	} else {
 		clearNtp(config);
@@ -631,10 +595,7 @@ bool AmsConfiguration::setNtpConfig(NtpConfig& config) {
 	stripNonAscii((uint8_t*) config.server, 64);
 	stripNonAscii((uint8_t*) config.timezone, 32);
 
-	EEPROM.begin(EEPROM_SIZE);
-	EEPROM.put(CONFIG_NTP_START, config);
-	bool ret = EEPROM.commit();
-	EEPROM.end();
+	bool ret = writeCache(CONFIG_NTP_START, config);
 	return ret;
 }
 
@@ -655,9 +616,8 @@ void AmsConfiguration::clearNtp(NtpConfig& config) {
 
 bool AmsConfiguration::getPriceServiceConfig(PriceServiceConfig& config) {
 	if(hasConfig()) {
-		EEPROM.begin(EEPROM_SIZE);
+		loadCache();
 		EEPROM.get(CONFIG_PRICE_START, config);
-		EEPROM.end();
 		if(strlen(config.entsoeToken) != 0 && strlen(config.entsoeToken) != 36) {
 			clearPriceServiceConfig(config);
 			return false;
@@ -688,10 +648,7 @@ bool AmsConfiguration::setPriceServiceConfig(PriceServiceConfig& config) {
 	stripNonAscii((uint8_t*) config.area, 17);
 	stripNonAscii((uint8_t*) config.currency, 4);
 
-	EEPROM.begin(EEPROM_SIZE);
-	EEPROM.put(CONFIG_PRICE_START, config);
-	bool ret = EEPROM.commit();
-	EEPROM.end();
+	bool ret = writeCache(CONFIG_PRICE_START, config);
 	return ret;
 }
 
@@ -714,14 +671,14 @@ void AmsConfiguration::ackPriceServiceChange() {
 
 bool AmsConfiguration::getEnergyAccountingConfig(EnergyAccountingConfig& config) {
 	if(hasConfig()) {
-		EEPROM.begin(EEPROM_SIZE);
+		loadCache();
 		EEPROM.get(CONFIG_ENERGYACCOUNTING_START, config);
-		EEPROM.end();
 		if(config.thresholds[9] != 0xFFFF) {
 			clearEnergyAccountingConfig(config);
 			return false;
 		}
 		if(config.hours > 5) config.hours = 5;
+		if(config.demandModel > DEMAND_MODEL_MAX) config.demandModel = DEMAND_MODEL_HOUR_DAILY;
 		return true;
 	} else {
 		clearEnergyAccountingConfig(config);
@@ -731,6 +688,7 @@ bool AmsConfiguration::getEnergyAccountingConfig(EnergyAccountingConfig& config)
 
 bool AmsConfiguration::setEnergyAccountingConfig(EnergyAccountingConfig& config) {
 	if(config.hours > 5) config.hours = 5;
+	if(config.demandModel > DEMAND_MODEL_MAX) config.demandModel = DEMAND_MODEL_HOUR_DAILY;
 	EnergyAccountingConfig existing;
 	if(getEnergyAccountingConfig(existing)) {
 		for(int i = 0; i < 9; i++) {
@@ -740,13 +698,11 @@ bool AmsConfiguration::setEnergyAccountingConfig(EnergyAccountingConfig& config)
 		}
 		config.thresholds[9] = 0xFFFF;
 		energyAccountingChanged |= config.hours != existing.hours;
+		energyAccountingChanged |= config.demandModel != existing.demandModel;
 	} else {
 		energyAccountingChanged = true;
 	}
-	EEPROM.begin(EEPROM_SIZE);
-	EEPROM.put(CONFIG_ENERGYACCOUNTING_START, config);
-	bool ret = EEPROM.commit();
-	EEPROM.end();
+	bool ret = writeCache(CONFIG_ENERGYACCOUNTING_START, config);
 	return ret;
 }
 
@@ -762,6 +718,7 @@ void AmsConfiguration::clearEnergyAccountingConfig(EnergyAccountingConfig& confi
 	config.thresholds[8] = 150;
 	config.thresholds[9] = 0xFFFF;
 	config.hours = 3;
+	config.demandModel = DEMAND_MODEL_HOUR_DAILY;
 }
 
 bool AmsConfiguration::isEnergyAccountingChanged() {
@@ -774,10 +731,10 @@ void AmsConfiguration::ackEnergyAccountingChange() {
 
 bool AmsConfiguration::getUiConfig(UiConfig& config) {
 	if(hasConfig()) {
-		EEPROM.begin(EEPROM_SIZE);
+		loadCache();
 		EEPROM.get(CONFIG_UI_START, config);
 		if(config.showImport > 2) clearUiConfig(config); // Must be wrong
-		EEPROM.end();
+		if(config.realtimePlotWindow > 1) config.realtimePlotWindow = 0;
 		return true;
 	} else {
 		clearUiConfig(config);
@@ -792,10 +749,7 @@ bool AmsConfiguration::setUiConfig(UiConfig& config) {
 	} else {
 		uiLanguageChanged = true;
 	}
-	EEPROM.begin(EEPROM_SIZE);
-	EEPROM.put(CONFIG_UI_START, config);
-	bool ret = EEPROM.commit();
-	EEPROM.end();
+	bool ret = writeCache(CONFIG_UI_START, config);
 	return ret;
 }
 
@@ -817,6 +771,7 @@ void AmsConfiguration::clearUiConfig(UiConfig& config) {
 	config.showPowerFactor = 2;
 	config.darkMode = 2;
 	memset(config.language, 0, 3);
+	config.realtimePlotWindow = 0;
 }
 
 bool AmsConfiguration::isUiLanguageChanged() {
@@ -831,18 +786,14 @@ bool AmsConfiguration::setUpgradeInformation(UpgradeInformation& upinfo) {
 	stripNonAscii((uint8_t*) upinfo.fromVersion, 16);
 	stripNonAscii((uint8_t*) upinfo.toVersion, 16);
 
-	EEPROM.begin(EEPROM_SIZE);
-	EEPROM.put(CONFIG_UPGRADE_INFO_START, upinfo);
-	bool ret = EEPROM.commit();
-	EEPROM.end();
+	bool ret = writeCache(CONFIG_UPGRADE_INFO_START, upinfo);
 	return ret;
 }
 
 bool AmsConfiguration::getUpgradeInformation(UpgradeInformation& upinfo) {
 	if(hasConfig()) {
-		EEPROM.begin(EEPROM_SIZE);
+		loadCache();
 		EEPROM.get(CONFIG_UPGRADE_INFO_START, upinfo);
-		EEPROM.end();
 		if(stripNonAscii((uint8_t*) upinfo.fromVersion, 16) || stripNonAscii((uint8_t*) upinfo.toVersion, 16)) {
 			clearUpgradeInformation(upinfo);
 			return false;
@@ -866,9 +817,8 @@ void AmsConfiguration::clearUpgradeInformation(UpgradeInformation& upinfo) {
 
 bool AmsConfiguration::getCloudConfig(CloudConfig& config) {
 	if(hasConfig()) {
-		EEPROM.begin(EEPROM_SIZE);
+		loadCache();
 		EEPROM.get(CONFIG_CLOUD_START, config);
-		EEPROM.end();
 		if(config.proto > 2) config.proto = 0;
 		return true;
 	} else {
@@ -892,10 +842,7 @@ bool AmsConfiguration::setCloudConfig(CloudConfig& config) {
 
 	stripNonAscii((uint8_t*) config.hostname, 64);
 
-	EEPROM.begin(EEPROM_SIZE);
-	EEPROM.put(CONFIG_CLOUD_START, config);
-	bool ret = EEPROM.commit();
-	EEPROM.end();
+	bool ret = writeCache(CONFIG_CLOUD_START, config);
 	return ret;
 }
 
@@ -918,9 +865,8 @@ void AmsConfiguration::ackCloudConfig() {
 
 bool AmsConfiguration::getZmartChargeConfig(ZmartChargeConfig& config) {
 	if(hasConfig()) {
-		EEPROM.begin(EEPROM_SIZE);
+		loadCache();
 		EEPROM.get(CONFIG_ZC_START, config);
-		EEPROM.end();
 		stripNonAscii((uint8_t*) config.token, 21);
 		stripNonAscii((uint8_t*) config.baseUrl, 64);
 		if(strlen(config.token) != 20 || !config.enabled) {
@@ -955,10 +901,7 @@ bool AmsConfiguration::setZmartChargeConfig(ZmartChargeConfig& config) {
 		memset(config.baseUrl, 0, 64);
 	}
 
-	EEPROM.begin(EEPROM_SIZE);
-	EEPROM.put(CONFIG_ZC_START, config);
-	bool ret = EEPROM.commit();
-	EEPROM.end();
+	bool ret = writeCache(CONFIG_ZC_START, config);
 	return ret;
 }
 
@@ -997,7 +940,9 @@ void AmsConfiguration::getUniqueName(char* buffer, size_t length) {
 }
 
 void AmsConfiguration::clear() {
-	EEPROM.begin(EEPROM_SIZE);
+	loadCache();
+	bool deferred = batching;
+	batching = true;
 
 	SystemConfig sys;
 	EEPROM.get(CONFIG_SYSTEM_START, sys);
@@ -1006,74 +951,73 @@ void AmsConfiguration::clear() {
 	sys.firmwareChannel = 0;
 	sys.energyspeedometer = 0;
 	memset(sys.country, 0, 3);
-	EEPROM.put(CONFIG_SYSTEM_START, sys);
+	writeCache(CONFIG_SYSTEM_START, sys);
 
 	MeterConfig meter;
 	clearMeter(meter);
-	EEPROM.put(CONFIG_METER_START, meter);
+	writeCache(CONFIG_METER_START, meter);
 
 	NetworkConfig network;
 	clearNetworkConfig(network);
-	EEPROM.put(CONFIG_NETWORK_START, network);
+	writeCache(CONFIG_NETWORK_START, network);
 
 	MqttConfig mqtt;
 	clearMqtt(mqtt);
-	EEPROM.put(CONFIG_MQTT_START, mqtt);
+	writeCache(CONFIG_MQTT_START, mqtt);
 
 	WebConfig web;
 	clearWebConfig(web);
-	EEPROM.put(CONFIG_WEB_START, web);
+	writeCache(CONFIG_WEB_START, web);
 
 	DomoticzConfig domo;
 	clearDomo(domo);
-	EEPROM.put(CONFIG_DOMOTICZ_START, domo);
+	writeCache(CONFIG_DOMOTICZ_START, domo);
 
 	HomeAssistantConfig haconf;
 	clearHomeAssistantConfig(haconf);
-	EEPROM.put(CONFIG_HA_START, haconf);
+	writeCache(CONFIG_HA_START, haconf);
 
 	NtpConfig ntp;
 	clearNtp(ntp);
-	EEPROM.put(CONFIG_NTP_START, ntp);
+	writeCache(CONFIG_NTP_START, ntp);
 
 	PriceServiceConfig price;
 	clearPriceServiceConfig(price);
-	EEPROM.put(CONFIG_PRICE_START, price);
+	writeCache(CONFIG_PRICE_START, price);
 
 	EnergyAccountingConfig eac;
 	clearEnergyAccountingConfig(eac);
-	EEPROM.put(CONFIG_ENERGYACCOUNTING_START, eac);
+	writeCache(CONFIG_ENERGYACCOUNTING_START, eac);
 
 	DebugConfig debug;
 	clearDebug(debug);
-	EEPROM.put(CONFIG_DEBUG_START, debug);
+	writeCache(CONFIG_DEBUG_START, debug);
 
 	UiConfig ui;
 	clearUiConfig(ui);
-	EEPROM.put(CONFIG_UI_START, ui);
+	writeCache(CONFIG_UI_START, ui);
 
 	UpgradeInformation upinfo;
 	clearUpgradeInformation(upinfo);
-	EEPROM.put(CONFIG_UPGRADE_INFO_START, upinfo);
+	writeCache(CONFIG_UPGRADE_INFO_START, upinfo);
 
 	CloudConfig cloud;
 	clearCloudConfig(cloud);
-	EEPROM.put(CONFIG_CLOUD_START, cloud);
+	writeCache(CONFIG_CLOUD_START, cloud);
 
 	ZmartChargeConfig zc;
 	clearZmartChargeConfig(zc);
-	EEPROM.put(CONFIG_ZC_START, zc);
+	writeCache(CONFIG_ZC_START, zc);
 
-	EEPROM.put(EEPROM_CONFIG_ADDRESS, EEPROM_CLEARED_INDICATOR);
-	EEPROM.commit();
-	EEPROM.end();
+	writeCache(EEPROM_CONFIG_ADDRESS, EEPROM_CLEARED_INDICATOR);
+	batching = deferred;
+	if(!batching) commit();
 }
 
 bool AmsConfiguration::hasConfig() {
 	if(configVersion == 0) {
-		EEPROM.begin(EEPROM_SIZE);
+		loadCache();
 		configVersion = EEPROM.read(EEPROM_CONFIG_ADDRESS);
-		EEPROM.end();
 	}
 	if(configVersion > EEPROM_CHECK_SUM) {
 		if(loadFromFs(EEPROM_CHECK_SUM)) {
@@ -1091,6 +1035,14 @@ bool AmsConfiguration::hasConfig() {
 					configVersion = 0;
 					return false;
 				}
+			case 104:
+				configVersion = -1; // Prevent loop
+				if(upgradeConfig104()) {
+					configVersion = 105;
+				} else {
+					configVersion = 0;
+					return false;
+				}
 			case EEPROM_CHECK_SUM:
 				return true;
 			default:
@@ -1106,7 +1058,8 @@ int AmsConfiguration::getConfigVersion() {
 }
 
 bool AmsConfiguration::relocateConfig103() {
-	EEPROM.begin(EEPROM_SIZE);
+	loadCache();
+	batching = true;
 
 	MeterConfig meter;
 	UpgradeInformation upinfo;
@@ -1180,46 +1133,89 @@ bool AmsConfiguration::relocateConfig103() {
 	ui.showPerPhasePower = 2;
 	ui.showPowerFactor = 2;
 	ui.darkMode = 2;
-
-	EEPROM.put(CONFIG_UPGRADE_INFO_START, upinfo);
-	EEPROM.put(CONFIG_NETWORK_START, wifi);
-	EEPROM.put(CONFIG_METER_START, meter);
-	EEPROM.put(CONFIG_GPIO_START, gpio);
-	EEPROM.put(CONFIG_PRICE_START, price);
-	EEPROM.put(CONFIG_ENERGYACCOUNTING_START, eac);
-	EEPROM.put(CONFIG_WEB_START, web);
-	EEPROM.put(CONFIG_DEBUG_START, debug);
-	EEPROM.put(CONFIG_NTP_START, ntp);
-	EEPROM.put(CONFIG_MQTT_START, mqtt);
-	EEPROM.put(CONFIG_DOMOTICZ_START, domo);
-	EEPROM.put(CONFIG_HA_START, ha);
-	EEPROM.put(CONFIG_UI_START, ui);
+	ui.realtimePlotWindow = 0;
+
+	writeCache(CONFIG_UPGRADE_INFO_START, upinfo);
+	writeCache(CONFIG_NETWORK_START, wifi);
+	writeCache(CONFIG_METER_START, meter);
+	writeCache(CONFIG_GPIO_START, gpio);
+	writeCache(CONFIG_PRICE_START, price);
+	writeCache(CONFIG_ENERGYACCOUNTING_START, eac);
+	writeCache(CONFIG_WEB_START, web);
+	writeCache(CONFIG_DEBUG_START, debug);
+	writeCache(CONFIG_NTP_START, ntp);
+	writeCache(CONFIG_MQTT_START, mqtt);
+	writeCache(CONFIG_DOMOTICZ_START, domo);
+	writeCache(CONFIG_HA_START, ha);
+	writeCache(CONFIG_UI_START, ui);
 
 	CloudConfig cloud;
 	clearCloudConfig(cloud);
-	EEPROM.put(CONFIG_CLOUD_START, cloud);
+	writeCache(CONFIG_CLOUD_START, cloud);
 
 	ZmartChargeConfig zcc;
 	clearZmartChargeConfig(zcc);
-	EEPROM.put(CONFIG_ZC_START, zcc);
+	writeCache(CONFIG_ZC_START, zcc);
 
-	EEPROM.put(EEPROM_CONFIG_ADDRESS, 104);
-	bool ret = EEPROM.commit();
-	EEPROM.end();
+	writeCache(EEPROM_CONFIG_ADDRESS, 104);
+	bool ret = commit();
+	return ret;
+}
+
+bool AmsConfiguration::upgradeConfig104() {
+	loadCache();
+	batching = true;
+
+	// Older firmware wrote this byte from uninitialized structs, it says nothing
+	EnergyAccountingConfig eac;
+	EEPROM.get(CONFIG_ENERGYACCOUNTING_START, eac);
+	eac.demandModel = DEMAND_MODEL_HOUR_DAILY;
+	writeCache(CONFIG_ENERGYACCOUNTING_START, eac);
+
+	writeCache(EEPROM_CONFIG_ADDRESS, 105);
+	bool ret = commit();
 	return ret;
 }
 
 bool AmsConfiguration::save() {
-	EEPROM.begin(EEPROM_SIZE);
+	loadCache();
 	uint8_t configVersion = EEPROM.read(EEPROM_CONFIG_ADDRESS);
-	EEPROM.put(EEPROM_CONFIG_ADDRESS, EEPROM_CHECK_SUM);
-	bool success = EEPROM.commit();
-	EEPROM.end();
+	writeCache(EEPROM_CONFIG_ADDRESS, EEPROM_CHECK_SUM);
+	bool success = commit();
 
 	configVersion = EEPROM_CHECK_SUM;
 	return success;
 }
 
+void AmsConfiguration::beginBatch() {
+	batching = true;
+}
+
+bool AmsConfiguration::commit() {
+	batching = false;
+	if(!cacheDirty) return true;
+	if(!EEPROM.commit()) return false;
+	cacheDirty = false;
+	return true;
+}
+
+void AmsConfiguration::loadCache() {
+	if(cacheLoaded) return;
+	EEPROM.begin(EEPROM_SIZE);
+	cacheLoaded = true;
+}
+
+bool AmsConfiguration::writeCache(int address, const uint8_t* data, size_t length) {
+	loadCache();
+	for(size_t i = 0; i < length; i++) {
+		if(EEPROM.read(address + i) != data[i]) {
+			EEPROM.write(address + i, data[i]);
+			cacheDirty = true;
+		}
+	}
+	return batching || commit();
+}
+
 void AmsConfiguration::saveToFs() {
 	
 }
@@ -1405,6 +1401,7 @@ void AmsConfiguration::print(Print* debugger)
 	if(getUiConfig(ui)) {
 		debugger->println(F("--UI configuration--"));
 		debugger->printf_P(PSTR("Language:             %s\n"), ui.language);
+		debugger->printf_P(PSTR("Realtime plot window: %d\n"), ui.realtimePlotWindow);
 		debugger->println(F(""));
 		delay(10);
 		debugger->flush();
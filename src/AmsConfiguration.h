@@ -10,7 +10,7 @@
 #include "Arduino.h"
 
 #define EEPROM_SIZE 1024*3
-#define EEPROM_CHECK_SUM 104 // Used to check if config is stored. Change if structure changes
+#define EEPROM_CHECK_SUM 105 // Used to check if config is stored. Change if structure changes
 #define EEPROM_CLEARED_INDICATOR 0xFC
 #define EEPROM_CONFIG_ADDRESS 0
 
@@ -235,7 +235,8 @@ struct PriceServiceConfig {
 struct EnergyAccountingConfig {
 	uint16_t thresholds[10];
 	uint8_t hours;
-}; // 21
+	uint8_t demandModel;
+}; // 22
 
 struct UiConfig {
 	uint8_t showImport;
@@ -254,7 +255,8 @@ struct UiConfig {
 	uint8_t showPowerFactor;
 	uint8_t darkMode;
 	char language[3];
-}; // 15
+	uint8_t realtimePlotWindow; // REALTIME_WINDOW_*
+}; // 19
 
 struct UpgradeInformation {
 	char fromVersion[16];
@@ -386,14 +388,34 @@ public:
 
 	void clear();
 
+	/*
+	 * Defer flash writes from the set*Config() and clear() calls that follow
+	 * until save() or commit(), so a multi-section update costs a single commit.
+	 */
+	void beginBatch();
+	bool commit();
+
 protected:
 
 private:
 	uint8_t configVersion = 0;
 
+	// The EEPROM library keeps its RAM copy for as long as it is open, so it is
+	// opened once and used as the config cache. Writes only dirty it when a byte
+	// actually changes, and commit() is a no-op while nothing is dirty. One flag
+	// covers all sections, since EEPROM.commit() always writes the whole region
+	// (a full sector erase on ESP8266, a single NVS blob on ESP32).
+	bool cacheLoaded = false, cacheDirty = false, batching = false;
+	void loadCache();
+	bool writeCache(int address, const uint8_t* data, size_t length);
+	template<typename T> bool writeCache(int address, const T& t) {
+		return writeCache(address, (const uint8_t*) &t, sizeof(T));
+	}
+
 	bool sysChanged = false, networkChanged = false, mqttChanged = false, webChanged = false, meterChanged = true, ntpChanged = true, priceChanged = false, energyAccountingChanged = true, cloudChanged = true, uiLanguageChanged = false, zcChanged = true;
 
 	bool relocateConfig103(); // 2.2.12, until, but not including 2.3
+	bool upgradeConfig104(); // demandModel taken from what was padding
 
 	void saveToFs();
 	bool loadFromFs(uint8_t version);
@@ -6,10 +6,47 @@
 
 #include "AmsData.h"
 #include <algorithm>
+#include <string.h>
 
 AmsData::AmsData() {}
 
+static void copyId(char* target, size_t size, const char* str) {
+    if(target == str) return;
+    size_t len = str == NULL ? 0 : strnlen(str, size - 1);
+    memcpy(target, str, len);
+    memset(target + len, 0, size - len);
+}
+
+void AmsData::setListId(const char* str) {
+    copyId(listId, sizeof(listId), str);
+}
+
+void AmsData::setMeterId(const char* str) {
+    copyId(meterId, sizeof(meterId), str);
+}
+
+void AmsData::setMeterModel(const char* str) {
+    copyId(meterModel, sizeof(meterModel), str);
+}
+
+// Assigns value to target and marks field in mask if it was different
+template <typename T>
+static inline void assign(T& target, T value, AmsField field, uint64_t& mask) {
+    if(target != value) {
+        target = value;
+        mask |= AMS_FIELD(field);
+    }
+}
+
+static inline void assignId(char* target, size_t size, const char* str, AmsField field, uint64_t& mask) {
+    if(strncmp(target, str == NULL ? "" : str, size - 1) != 0) {
+        copyId(target, size, str);
+        mask |= AMS_FIELD(field);
+    }
+}
+
 void AmsData::apply(AmsData& other) {
+    uint64_t mask = 0;
     if(other.getListType() < 3) {
         unsigned long ms = this->lastUpdateMillis > other.getLastUpdateMillis() ? 0 : other.getLastUpdateMillis() - this->lastUpdateMillis;
 
@@ -18,6 +55,7 @@ void AmsData::apply(AmsData& other) {
                 uint32_t power = (activeImportPower + other.getActiveImportPower()) / 2;
                 float add = power * (((float) ms) / 3600000.0);
                 activeImportCounter += add / 1000.0;
+                if(add > 0) mask |= AMS_FIELD(AmsFieldActiveImportCounter);
             }
 
             if(other.getListType() > 1) {
@@ -26,19 +64,22 @@ void AmsData::apply(AmsData& other) {
                     uint32_t power = (activeExportPower + other.getActiveExportPower()) / 2;
                     float add = power * (((float) ms) / 3600000.0);
                     activeExportCounter += add / 1000.0;
+                    if(add > 0) mask |= AMS_FIELD(AmsFieldActiveExportCounter);
                 }
                 if(other.getReactiveImportPower() > 0) {
                     uint32_t power = (reactiveImportPower + other.getReactiveImportPower()) / 2;
                     float add = power * (((float) ms) / 3600000.0);
                     reactiveImportCounter += add / 1000.0;
+                    if(add > 0) mask |= AMS_FIELD(AmsFieldReactiveImportCounter);
                 }
                 if(other.getReactiveExportPower() > 0) {
                     uint32_t power = (reactiveExportPower + other.getReactiveExportPower()) / 2;
                     float add = power * (((float) ms) / 3600000.0);
                     reactiveExportCounter += add / 1000.0;
+                    if(add > 0) mask |= AMS_FIELD(AmsFieldReactiveExportCounter);
                 }
             }
-            counterEstimated = true;
+            assign(counterEstimated, true, AmsFieldCounterEstimated, mask);
         }
     }
 
@@ -46,78 +87,81 @@ void AmsData::apply(AmsData& other) {
     if(other.getListType() > 1) {
         this->lastList2 = this->lastUpdateMillis;
     }
-    this->packageTimestamp = other.getPackageTimestamp();
-    if(other.getListType() > this->listType)
+    assign(packageTimestamp, other.getPackageTimestamp(), AmsFieldPackageTimestamp, mask);
+    if(other.getListType() > this->listType) {
         this->listType = other.getListType();
+        mask |= AMS_FIELD(AmsFieldListType);
+    }
     switch(other.getListType()) {
         case 4:
-            this->powerFactor = other.getPowerFactor();
-            this->l1PowerFactor = other.getL1PowerFactor();
-            this->l2PowerFactor = other.getL2PowerFactor();
-            this->l3PowerFactor = other.getL3PowerFactor();
-            this->l1activeImportPower = other.getL1ActiveImportPower();
-            this->l2activeImportPower = other.getL2ActiveImportPower();
-            this->l3activeImportPower = other.getL3ActiveImportPower();
-            this->l1activeExportPower = other.getL1ActiveExportPower();
-            this->l2activeExportPower = other.getL2ActiveExportPower();
-            this->l3activeExportPower = other.getL3ActiveExportPower();
-            this->l1activeImportCounter = other.getL1ActiveImportCounter();
-            this->l2activeImportCounter = other.getL2ActiveImportCounter();
-            this->l3activeImportCounter = other.getL3ActiveImportCounter();
-            this->l1activeExportCounter = other.getL1ActiveExportCounter();
-            this->l2activeExportCounter = other.getL2ActiveExportCounter();
-            this->l3activeExportCounter = other.getL3ActiveExportCounter();
+            assign(powerFactor, other.getPowerFactor(), AmsFieldPowerFactor, mask);
+            assign(l1PowerFactor, other.getL1PowerFactor(), AmsFieldL1PowerFactor, mask);
+            assign(l2PowerFactor, other.getL2PowerFactor(), AmsFieldL2PowerFactor, mask);
+            assign(l3PowerFactor, other.getL3PowerFactor(), AmsFieldL3PowerFactor, mask);
+            assign(l1activeImportPower, other.getL1ActiveImportPower(), AmsFieldL1ActiveImportPower, mask);
+            assign(l2activeImportPower, other.getL2ActiveImportPower(), AmsFieldL2ActiveImportPower, mask);
+            assign(l3activeImportPower, other.getL3ActiveImportPower(), AmsFieldL3ActiveImportPower, mask);
+            assign(l1activeExportPower, other.getL1ActiveExportPower(), AmsFieldL1ActiveExportPower, mask);
+            assign(l2activeExportPower, other.getL2ActiveExportPower(), AmsFieldL2ActiveExportPower, mask);
+            assign(l3activeExportPower, other.getL3ActiveExportPower(), AmsFieldL3ActiveExportPower, mask);
+            assign(l1activeImportCounter, other.getL1ActiveImportCounter(), AmsFieldL1ActiveImportCounter, mask);
+            assign(l2activeImportCounter, other.getL2ActiveImportCounter(), AmsFieldL2ActiveImportCounter, mask);
+            assign(l3activeImportCounter, other.getL3ActiveImportCounter(), AmsFieldL3ActiveImportCounter, mask);
+            assign(l1activeExportCounter, other.getL1ActiveExportCounter(), AmsFieldL1ActiveExportCounter, mask);
+            assign(l2activeExportCounter, other.getL2ActiveExportCounter(), AmsFieldL2ActiveExportCounter, mask);
+            assign(l3activeExportCounter, other.getL3ActiveExportCounter(), AmsFieldL3ActiveExportCounter, mask);
         case 3:
-            this->meterTimestamp = other.getMeterTimestamp();
+            assign(meterTimestamp, other.getMeterTimestamp(), AmsFieldMeterTimestamp, mask);
             // Aidon tends to sometime send the same counter as last hour by accident
             if(meterType == AmsTypeAidon && counterEstimated && lastKnownCounter == other.getActiveImportCounter()-other.getActiveExportCounter()) {
                 double diff = activeImportCounter - activeExportCounter - lastKnownCounter;
                 if(diff < 1.0) { // In case a very low value have been calculated, use the new values
-                    this->activeImportCounter = other.getActiveImportCounter();
-                    this->activeImportCounterTariff1 = other.getActiveImportCounterTariff1();
-                    this->activeImportCounterTariff2 = other.getActiveImportCounterTariff2();
-                    this->activeExportCounter = other.getActiveExportCounter();
-                    this->activeExportCounterTariff1 = other.getActiveExportCounterTariff1();
-                    this->activeExportCounterTariff2 = other.getActiveExportCounterTariff2();
-                    this->reactiveImportCounter = other.getReactiveImportCounter();
-                    this->reactiveExportCounter = other.getReactiveExportCounter();
-                    this->lastKnownCounter = activeImportCounter - activeExportCounter;
+                    applyCounters(other, mask);
                 }
             } else {
-                this->activeImportCounter = other.getActiveImportCounter();
-                this->activeImportCounterTariff1 = other.getActiveImportCounterTariff1();
-                this->activeImportCounterTariff2 = other.getActiveImportCounterTariff2();
-                this->activeExportCounter = other.getActiveExportCounter();
-                this->activeExportCounterTariff1 = other.getActiveExportCounterTariff1();
-                this->activeExportCounterTariff2 = other.getActiveExportCounterTariff2();
-                this->reactiveImportCounter = other.getReactiveImportCounter();
-                this->reactiveExportCounter = other.getReactiveExportCounter();
-                this->lastKnownCounter = activeImportCounter - activeExportCounter;
+                applyCounters(other, mask);
             }
-            this->counterEstimated = false;
+            assign(counterEstimated, false, AmsFieldCounterEstimated, mask);
         case 2:
-            this->listId = other.getListId();
-            this->meterId = other.getMeterId();
-            this->meterType = other.getMeterType();
-            this->meterModel = other.getMeterModel();
-            this->reactiveImportPower = other.getReactiveImportPower();
-            this->reactiveExportPower = other.getReactiveExportPower();
-            this->l1current = other.getL1Current();
-            this->l2current = other.getL2Current();
-            this->l2currentMissing = other.isL2currentMissing();
-            this->l3current = other.getL3Current();
-            this->l1voltage = other.getL1Voltage();
-            this->l2voltage = other.getL2Voltage();
-            this->l3voltage = other.getL3Voltage();
-            this->threePhase = other.isThreePhase();
-            this->twoPhase = other.isTwoPhase();
+            assignId(listId, sizeof(listId), other.getListId(), AmsFieldListId, mask);
+            assignId(meterId, sizeof(meterId), other.getMeterId(), AmsFieldMeterId, mask);
+            assign(meterType, other.getMeterType(), AmsFieldMeterType, mask);
+            assignId(meterModel, sizeof(meterModel), other.getMeterModel(), AmsFieldMeterModel, mask);
+            assign(reactiveImportPower, other.getReactiveImportPower(), AmsFieldReactiveImportPower, mask);
+            assign(reactiveExportPower, other.getReactiveExportPower(), AmsFieldReactiveExportPower, mask);
+            assign(l1current, other.getL1Current(), AmsFieldL1Current, mask);
+            assign(l2current, other.getL2Current(), AmsFieldL2Current, mask);
+            assign(l2currentMissing, other.isL2currentMissing(), AmsFieldPhases, mask);
+            assign(l3current, other.getL3Current(), AmsFieldL3Current, mask);
+            assign(l1voltage, other.getL1Voltage(), AmsFieldL1Voltage, mask);
+            assign(l2voltage, other.getL2Voltage(), AmsFieldL2Voltage, mask);
+            assign(l3voltage, other.getL3Voltage(), AmsFieldL3Voltage, mask);
+            assign(threePhase, other.isThreePhase(), AmsFieldPhases, mask);
+            assign(twoPhase, other.isTwoPhase(), AmsFieldPhases, mask);
     }
 
     // Moved outside switch to handle meters alternating between sending active and accumulated values
     if(other.getListType() == 1 || (other.getActiveImportPower() > 0 || other.getActiveExportPower() > 0))
-        this->activeImportPower = other.getActiveImportPower();
+        assign(activeImportPower, other.getActiveImportPower(), AmsFieldActiveImportPower, mask);
     if(other.getListType() == 2 || (other.getActiveImportPower() > 0 || other.getActiveExportPower() > 0))
-        this->activeExportPower = other.getActiveExportPower();
+        assign(activeExportPower, other.getActiveExportPower(), AmsFieldActiveExportPower, mask);
+
+    // Nothing new for the sinks, keep the mask of the last apply that had something
+    if(mask == 0) return;
+    this->changes = mask;
+    this->generation++;
+}
+
+void AmsData::applyCounters(AmsData& other, uint64_t& mask) {
+    assign(activeImportCounter, other.getActiveImportCounter(), AmsFieldActiveImportCounter, mask);
+    assign(activeImportCounterTariff1, other.getActiveImportCounterTariff1(), AmsFieldActiveImportCounterTariff1, mask);
+    assign(activeImportCounterTariff2, other.getActiveImportCounterTariff2(), AmsFieldActiveImportCounterTariff2, mask);
+    assign(activeExportCounter, other.getActiveExportCounter(), AmsFieldActiveExportCounter, mask);
+    assign(activeExportCounterTariff1, other.getActiveExportCounterTariff1(), AmsFieldActiveExportCounterTariff1, mask);
+    assign(activeExportCounterTariff2, other.getActiveExportCounterTariff2(), AmsFieldActiveExportCounterTariff2, mask);
+    assign(reactiveImportCounter, other.getReactiveImportCounter(), AmsFieldReactiveImportCounter, mask);
+    assign(reactiveExportCounter, other.getReactiveExportCounter(), AmsFieldReactiveExportCounter, mask);
+    this->lastKnownCounter = activeImportCounter - activeExportCounter;
 }
 
 void AmsData::apply(OBIS_code_t obis, double value, uint64_t millis64) {
@@ -127,7 +171,7 @@ void AmsData::apply(OBIS_code_t obis, double value, uint64_t millis64) {
     if(obis.gr == 1) {
         if(obis.sensor == 96) {
             if(obis.tariff == 0) {
-                meterId = String((long) value, 10);
+                snprintf(meterId, sizeof(meterId), "%ld", (long) value);
                 return;
             } else if(obis.tariff == 1) {
                 return;
@@ -300,11 +344,11 @@ uint8_t AmsData::getListType() {
     return this->listType;
 }
 
-String AmsData::getListId() {
+const char* AmsData::getListId() {
     return this->listId;
 }
 
-String AmsData::getMeterId() {
+const char* AmsData::getMeterId() {
     return this->meterId;
 }
 
@@ -312,7 +356,7 @@ uint8_t AmsData::getMeterType() {
     return this->meterType;
 }
 
-String AmsData::getMeterModel() {
+const char* AmsData::getMeterModel() {
     return this->meterModel;
 }
 
@@ -476,6 +520,29 @@ int8_t AmsData::getLastError() {
     return lastErrorCount > 2 ? lastError : 0;
 }
 
+uint64_t AmsData::getChanges() {
+    return this->changes;
+}
+
+bool AmsData::hasChanged(AmsField field) {
+    return (this->changes & AMS_FIELD(field)) != 0;
+}
+
+uint32_t AmsData::getGeneration() {
+    return this->generation;
+}
+
+uint64_t AmsData::changesSince(uint32_t& seen) {
+    uint64_t mask = AMS_FIELDS_ALL;
+    if(this->generation == seen) {
+        mask = 0;
+    } else if(this->generation == seen + 1) {
+        mask = this->changes;
+    }
+    seen = this->generation;
+    return mask;
+}
+
 void AmsData::setLastError(int8_t lastError) {
     this->lastError = lastError;
     if(lastError == 0) {
@@ -10,6 +10,11 @@
 #include <WString.h>
 #include "OBIScodes.h"
 
+// Identifier buffers, including the terminator. Longer values are truncated.
+#define AMS_LIST_ID_LENGTH 32
+#define AMS_METER_ID_LENGTH 48
+#define AMS_METER_MODEL_LENGTH 48
+
 enum AmsType {
     AmsTypeAutodetect = 0x00,
     AmsTypeAidon = 0x01,
@@ -22,10 +27,63 @@ enum AmsType {
     AmsTypeUnknown = 0xFF
 };
 
+// Bit positions in AmsData::getChanges()
+enum AmsField {
+    AmsFieldListType = 0,
+    AmsFieldListId,
+    AmsFieldMeterId,
+    AmsFieldMeterType,
+    AmsFieldMeterModel,
+    AmsFieldMeterTimestamp,
+    AmsFieldPackageTimestamp,
+    AmsFieldActiveImportPower,
+    AmsFieldReactiveImportPower,
+    AmsFieldActiveExportPower,
+    AmsFieldReactiveExportPower,
+    AmsFieldL1Voltage,
+    AmsFieldL2Voltage,
+    AmsFieldL3Voltage,
+    AmsFieldL1Current,
+    AmsFieldL2Current,
+    AmsFieldL3Current,
+    AmsFieldPowerFactor,
+    AmsFieldL1PowerFactor,
+    AmsFieldL2PowerFactor,
+    AmsFieldL3PowerFactor,
+    AmsFieldL1ActiveImportPower,
+    AmsFieldL2ActiveImportPower,
+    AmsFieldL3ActiveImportPower,
+    AmsFieldL1ActiveExportPower,
+    AmsFieldL2ActiveExportPower,
+    AmsFieldL3ActiveExportPower,
+    AmsFieldL1ActiveImportCounter,
+    AmsFieldL2ActiveImportCounter,
+    AmsFieldL3ActiveImportCounter,
+    AmsFieldL1ActiveExportCounter,
+    AmsFieldL2ActiveExportCounter,
+    AmsFieldL3ActiveExportCounter,
+    AmsFieldActiveImportCounter,
+    AmsFieldActiveImportCounterTariff1,
+    AmsFieldActiveImportCounterTariff2,
+    AmsFieldReactiveImportCounter,
+    AmsFieldActiveExportCounter,
+    AmsFieldActiveExportCounterTariff1,
+    AmsFieldActiveExportCounterTariff2,
+    AmsFieldReactiveExportCounter,
+    AmsFieldPhases, // threePhase, twoPhase and l2currentMissing
+    AmsFieldCounterEstimated,
+    AmsFieldCount
+};
+
+#define AMS_FIELD(f) (((uint64_t) 1) << (f))
+#define AMS_FIELDS_ALL (AMS_FIELD(AmsFieldCount) - 1)
+
 class AmsData {
 public:
     AmsData();
 
+    // Merges a decoded frame into this state. Records which fields got a new
+    // value in getChanges() and bumps getGeneration() by one.
     void apply(AmsData& other);
     void apply(const OBIS_code_t obis, double value, uint64_t millis64);
 
@@ -35,10 +93,10 @@ public:
 
     uint8_t getListType();
 
-    String getListId();
-    String getMeterId();
+    const char* getListId();
+    const char* getMeterId();
     uint8_t getMeterType();
-    String getMeterModel();
+    const char* getMeterModel();
 
     time_t getMeterTimestamp();
 
@@ -93,13 +151,23 @@ public:
     int8_t getLastError();
     void setLastError(int8_t);
 
+    // Fields changed by the last apply(AmsData&) that changed any, as AMS_FIELD() bits
+    uint64_t getChanges();
+    bool hasChanged(AmsField field);
+    // Number of apply(AmsData&) calls so far that changed a field. A sink that
+    // last saw generation g and now sees g + 1 can rely on getChanges(); for a
+    // larger gap it has to assume everything changed.
+    uint32_t getGeneration();
+    // Fields changed since a sink saw generation seen, all of them after a gap,
+    // and moves seen up to the current generation
+    uint64_t changesSince(uint32_t& seen);
 
 protected:
     uint64_t lastUpdateMillis = 0;
     uint64_t lastList2 = 0;
     uint8_t listType = 0, meterType = AmsTypeUnknown;
     time_t packageTimestamp = 0;
-    String listId = "", meterId = "", meterModel = "";
+    char listId[AMS_LIST_ID_LENGTH] = "", meterId[AMS_METER_ID_LENGTH] = "", meterModel[AMS_METER_MODEL_LENGTH] = "";
     time_t meterTimestamp = 0;
     uint32_t activeImportPower = 0, reactiveImportPower = 0, activeExportPower = 0, reactiveExportPower = 0;
     float l1voltage = 0, l2voltage = 0, l3voltage = 0, l1current = 0, l2current = 0, l3current = 0;
@@ -114,6 +182,16 @@ protected:
 
     int8_t lastError = 0x00;
     uint8_t lastErrorCount = 0;
+
+    uint64_t changes = 0;
+    uint32_t generation = 0;
+
+    void setListId(const char* str);
+    void setMeterId(const char* str);
+    void setMeterModel(const char* str);
+
+private:
+    void applyCounters(AmsData& other, uint64_t& mask);
 };
 
 #endif
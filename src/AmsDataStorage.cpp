@@ -313,8 +313,110 @@ bool AmsDataStorage::update(AmsData* data, time_t now) {
     return ret;
 }
 
+void AmsDataStorage::updateQuarter(AmsData* data, time_t now) {
+    if(now < FirmwareVersion::BuildEpoch) return;
+    if(data->getActiveImportCounter() <= 0) return;
+
+    uint64_t importCounter = data->getActiveImportCounter() * 1000;
+    uint64_t exportCounter = data->getActiveExportCounter() * 1000;
+    time_t start = now - (now % QUARTER_SECONDS);
+
+    // Built up from 0 since boot, the meter has not sent its counter yet
+    bool estimated = data->isCounterEstimated() && data->getListType() < 3;
+    quarterImportPower = max(quarterImportPower, data->getActiveImportPower());
+    quarterExportPower = max(quarterExportPower, data->getActiveExportPower());
+
+    // Nothing yet, or the clock jumped further than the history reaches, either way
+    time_t span = (time_t) QUARTER_SLOTS * QUARTER_SECONDS;
+    if(quarter.count == 0 || quarter.lastQuarter - start >= span || start - quarter.lastQuarter >= span) {
+        memset(quarter.qImport, 0, sizeof(quarter.qImport));
+        memset(quarter.qExport, 0, sizeof(quarter.qExport));
+        quarter.head = 0;
+        quarter.count = 1;
+        quarter.lastQuarter = start;
+        quarter.lastImport = importCounter;
+        quarter.lastExport = exportCounter;
+        quarterRebase = estimated;
+        quarterTime = now;
+        quarterImportPower = data->getActiveImportPower();
+        quarterExportPower = data->getActiveExportPower();
+        return;
+    }
+
+    // An estimated counter corrected downwards gives nothing to add
+    uint64_t importDelta = importCounter > quarter.lastImport ? importCounter - quarter.lastImport : 0;
+    uint64_t exportDelta = exportCounter > quarter.lastExport ? exportCounter - quarter.lastExport : 0;
+
+    // Until the meter has sent its counter there is nothing to take a difference
+    // from, the first one after an estimate only sets where to count from. Nor
+    // is more than the highest power since the counters last moved could have
+    // drawn, with a quarter to spare for counter resolution, usage.
+    time_t since = quarterTime > 0 ? quarterTime : quarter.lastQuarter;
+    time_t elapsed = (now > since ? now - since : 0) + QUARTER_SECONDS;
+    if(estimated || quarterRebase
+        || importDelta > (uint64_t) quarterImportPower * elapsed / 3600
+        || exportDelta > (uint64_t) quarterExportPower * elapsed / 3600) {
+        importDelta = 0;
+        exportDelta = 0;
+    }
+    quarterRebase = estimated;
+    if(importCounter != quarter.lastImport || exportCounter != quarter.lastExport) {
+        quarterTime = now;
+        quarterImportPower = data->getActiveImportPower();
+        quarterExportPower = data->getActiveExportPower();
+    }
+    quarter.lastImport = importCounter;
+    quarter.lastExport = exportCounter;
+
+    // The time passed in comes from the meter or the ESP clock, which disagree
+    // by a little. A step back stays in the quarter in progress.
+    if(start < quarter.lastQuarter) start = quarter.lastQuarter;
+
+    // After a gap the difference is spread over the quarters it covers
+    uint16_t steps = (start - quarter.lastQuarter) / QUARTER_SECONDS;
+    uint16_t parts = max(steps, (uint16_t) 1);
+    for(uint16_t i = 0; i < parts; i++) {
+        if(steps > 0) {
+            quarter.head = (quarter.head + 1) % QUARTER_SLOTS;
+            quarter.qImport[quarter.head] = 0;
+            quarter.qExport[quarter.head] = 0;
+            if(quarter.count < QUARTER_SLOTS) quarter.count++;
+        }
+        uint32_t in = importDelta / parts + (i == parts - 1 ? importDelta % parts : 0);
+        uint32_t out = exportDelta / parts + (i == parts - 1 ? exportDelta % parts : 0);
+        quarter.qImport[quarter.head] = min((uint32_t) UINT16_MAX, (uint32_t) (quarter.qImport[quarter.head] + in));
+        quarter.qExport[quarter.head] = min((uint32_t) UINT16_MAX, (uint32_t) (quarter.qExport[quarter.head] + out));
+    }
+    quarter.lastQuarter = start;
+}
+
+time_t AmsDataStorage::getLastQuarter() {
+    return quarter.count == 0 ? 0 : quarter.lastQuarter;
+}
+
+uint16_t AmsDataStorage::getQuarterCount() {
+    return quarter.count;
+}
+
+uint32_t AmsDataStorage::getQuarterImport(uint16_t ago) {
+    if(ago >= quarter.count) return 0;
+    return quarter.qImport[(quarter.head + QUARTER_SLOTS - ago) % QUARTER_SLOTS];
+}
+
+uint32_t AmsDataStorage::getQuarterExport(uint16_t ago) {
+    if(ago >= quarter.count) return 0;
+    return quarter.qExport[(quarter.head + QUARTER_SLOTS - ago) % QUARTER_SLOTS];
+}
+
+int16_t AmsDataStorage::getQuarterAgo(time_t ts) {
+    if(quarter.count == 0 || ts > quarter.lastQuarter || ts % QUARTER_SECONDS != 0) return -1;
+    time_t ago = (quarter.lastQuarter - ts) / QUARTER_SECONDS;
+    return ago < quarter.count ? ago : -1;
+}
+
 void AmsDataStorage::setHourImport(uint8_t hour, uint32_t val) {
     if(hour < 0 || hour > 24) return;
+    revision++;
     
     uint8_t accuracy = day.accuracy;
     uint32_t update = val / pow(10, accuracy);
@@ -354,6 +456,7 @@ uint32_t AmsDataStorage::getHourImport(uint8_t hour) {
 
 void AmsDataStorage::setHourExport(uint8_t hour, uint32_t val) {
     if(hour < 0 || hour > 24) return;
+    revision++;
     
     uint8_t accuracy = day.accuracy;
     uint32_t update = val / pow(10, accuracy);
@@ -393,6 +496,7 @@ uint32_t AmsDataStorage::getHourExport(uint8_t hour) {
 
 void AmsDataStorage::setDayImport(uint8_t day, uint32_t val) {
     if(day < 1 || day > 31) return;
+    revision++;
     
     uint8_t accuracy = month.accuracy;
     uint32_t update = val / pow(10, accuracy);
@@ -432,6 +536,7 @@ uint32_t AmsDataStorage::getDayImport(uint8_t day) {
 
 void AmsDataStorage::setDayExport(uint8_t day, uint32_t val) {
     if(day < 1 || day > 31) return;
+    revision++;
     
     uint8_t accuracy = month.accuracy;
     uint32_t update = val / pow(10, accuracy);
@@ -469,86 +574,84 @@ uint32_t AmsDataStorage::getDayExport(uint8_t day) {
     return (month.dExport[day-1] * pow(10, month.accuracy));
 }
 
+void AmsDataStorage::setJournal(AmsJournal* journal) {
+    this->journal = journal;
+}
+
 bool AmsDataStorage::load() {
-    if(!LittleFS.begin()) {
+    if(journal == NULL || !LittleFS.begin()) {
         return false;
     }
 
     bool ret = false;
-    if(LittleFS.exists(FILE_DAYPLOT)) {
-        File file = LittleFS.open(FILE_DAYPLOT, "r");
-        char buf[file.size()];
-        file.readBytes(buf, file.size());
-        if(buf[0] > 5) {
-            DayDataPoints* day = (DayDataPoints*) buf;
-            ret = setDayData(*day);
-        } else {
-            DayDataPoints5* old = (DayDataPoints5*) buf;
-            DayDataPoints day = { old->version };
-            day.lastMeterReadTime = old->lastMeterReadTime;
-            day.activeImport = old->activeImport;
-            day.activeExport = old->activeExport;
-            day.accuracy = old->accuracy;
-            for(uint8_t i = 0; i < 24; i++) {
-                day.hImport[i] = old->hImport[i];
-                day.hExport[i] = old->hExport[i];
+    {
+        // Zeroed and sized for the current layout, older ones are shorter
+        uint8_t buf[sizeof(DayDataPoints)] = {};
+        if(journal->load(JournalDayPlot, FILE_DAYPLOT, buf, sizeof(buf)) > 0) {
+            if(buf[0] > 5) {
+                DayDataPoints* day = (DayDataPoints*) buf;
+                ret = setDayData(*day);
+            } else {
+                DayDataPoints5* old = (DayDataPoints5*) buf;
+                DayDataPoints day = { old->version };
+                day.lastMeterReadTime = old->lastMeterReadTime;
+                day.activeImport = old->activeImport;
+                day.activeExport = old->activeExport;
+                day.accuracy = old->accuracy;
+                for(uint8_t i = 0; i < 24; i++) {
+                    day.hImport[i] = old->hImport[i];
+                    day.hExport[i] = old->hExport[i];
+                }
+
+                ret = setDayData(day);
             }
-
-            ret = setDayData(day);
         }
-        file.close();
     }
 
-    if(LittleFS.exists(FILE_MONTHPLOT)) {
-        File file = LittleFS.open(FILE_MONTHPLOT, "r");
-        char buf[file.size()];
-        file.readBytes(buf, file.size());
-        if(buf[0] > 6) {
-            MonthDataPoints* month = (MonthDataPoints*) buf;
-            ret &= setMonthData(*month);
-        } else {
-            MonthDataPoints6* old = (MonthDataPoints6*) buf;
-            MonthDataPoints month = { old->version };
-            month.lastMeterReadTime = old->lastMeterReadTime;
-            month.activeImport = old->activeImport;
-            month.activeExport = old->activeExport;
-            month.accuracy = old->accuracy;
-            for(uint8_t i = 0; i < 31; i++) {
-                month.dImport[i] = old->dImport[i];
-                month.dExport[i] = old->dExport[i];
+    {
+        uint8_t buf[sizeof(MonthDataPoints)] = {};
+        if(journal->load(JournalMonthPlot, FILE_MONTHPLOT, buf, sizeof(buf)) > 0) {
+            if(buf[0] > 6) {
+                MonthDataPoints* month = (MonthDataPoints*) buf;
+                ret &= setMonthData(*month);
+            } else {
+                MonthDataPoints6* old = (MonthDataPoints6*) buf;
+                MonthDataPoints month = { old->version };
+                month.lastMeterReadTime = old->lastMeterReadTime;
+                month.activeImport = old->activeImport;
+                month.activeExport = old->activeExport;
+                month.accuracy = old->accuracy;
+                for(uint8_t i = 0; i < 31; i++) {
+                    month.dImport[i] = old->dImport[i];
+                    month.dExport[i] = old->dExport[i];
+                }
+
+                ret &= setMonthData(month);
             }
+        }
+    }
 
-            ret &= setMonthData(month);
+    {
+        QuarterDataPoints q;
+        if(journal->load(JournalQuarterPlot, FILE_QUARTERPLOT, &q, sizeof(q)) == sizeof(q) && q.version == 1 && q.head < QUARTER_SLOTS && q.count <= QUARTER_SLOTS) {
+            quarter = q;
         }
-        file.close();
     }
 
     return ret;
 }
 
 bool AmsDataStorage::save() {
-    if(!LittleFS.begin()) {
+    if(journal == NULL || !LittleFS.begin()) {
         return false;
     }
-    {
-        File file = LittleFS.open(FILE_DAYPLOT, "w");
-        char buf[sizeof(day)];
-        memcpy(buf, &day, sizeof(day));
-        for(unsigned long i = 0; i < sizeof(day); i++) {
-            file.write(buf[i]);
-        }
-        file.close();
-    }
-    {
-        File file = LittleFS.open(FILE_MONTHPLOT, "w");
-        char buf[sizeof(month)];
-        memcpy(buf, &month, sizeof(month));
-        for(unsigned long i = 0; i < sizeof(month); i++) {
-            file.write(buf[i]);
-        }
-        file.close();
+    // Records equal to the stored ones are not written again
+    bool ret = journal->save(JournalDayPlot, FILE_DAYPLOT, &day, sizeof(day));
+    ret &= journal->save(JournalMonthPlot, FILE_MONTHPLOT, &month, sizeof(month));
+    if(quarter.count > 0) {
+        ret &= journal->save(JournalQuarterPlot, FILE_QUARTERPLOT, &quarter, sizeof(quarter));
     }
-    return true;
+    return ret;
 }
 
 DayDataPoints AmsDataStorage::getDayData() {
@@ -560,6 +663,7 @@ MonthDataPoints AmsDataStorage::getMonthData() {
 }
 
 bool AmsDataStorage::setDayData(DayDataPoints& day) {
+    revision++;
     if(day.version == 5 || day.version == 6) {
         this->day = day;
         this->day.version = 6;
@@ -580,6 +684,7 @@ bool AmsDataStorage::setDayData(DayDataPoints& day) {
 }
 
 bool AmsDataStorage::setMonthData(MonthDataPoints& month) {
+    revision++;
     if(month.version == 6 || month.version == 7) {
         this->month = month;
         this->month.version = 7;
@@ -630,6 +735,10 @@ void AmsDataStorage::setMonthAccuracy(uint8_t accuracy) {
     month.accuracy = accuracy;
 }
 
+uint32_t AmsDataStorage::getRevision() {
+    return revision;
+}
+
 bool AmsDataStorage::isHappy(time_t now) {
     return isDayHappy(now) && isMonthHappy(now);
 }
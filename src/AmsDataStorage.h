@@ -12,6 +12,7 @@
 #include "RemoteDebug.h"
 #endif
 #include "Timezone.h"
+#include "AmsJournal.h"
 
 struct DayDataPoints5 {
     uint8_t version;
@@ -53,6 +54,22 @@ struct MonthDataPoints {
     uint8_t accuracy;
 };
 
+#define QUARTER_SECONDS 900
+#define QUARTER_SLOTS 196 // 49 hours
+
+// Import and export per quarter hour, as the counter difference over the
+// quarter in Wh. qImport[head] is the quarter starting at lastQuarter.
+struct QuarterDataPoints {
+    uint8_t version;
+    uint16_t head;
+    uint16_t count;
+    time_t lastQuarter;
+    uint64_t lastImport;
+    uint64_t lastExport;
+    uint16_t qImport[QUARTER_SLOTS];
+    uint16_t qExport[QUARTER_SLOTS];
+};
+
 class AmsDataStorage {
 public:
     #if defined(AMS_REMOTE_DEBUG)
@@ -61,7 +78,11 @@ public:
     AmsDataStorage(Stream*);
     #endif
     void setTimezone(Timezone*);
+    // Where load() and save() keep the plots, required for both
+    void setJournal(AmsJournal*);
     bool update(AmsData* data, time_t now);
+    // Adds the counter movement since the last call to the current quarter
+    void updateQuarter(AmsData* data, time_t now);
     uint32_t getHourImport(uint8_t);
     uint32_t getHourExport(uint8_t);
     uint32_t getDayImport(uint8_t);
@@ -90,8 +111,28 @@ public:
     void setDayImport(uint8_t, uint32_t);
     void setDayExport(uint8_t, uint32_t);
 
+    // Bumped on every change to the hour or day values
+    uint32_t getRevision();
+
+    // Quarters are counted back from the newest, 0 being the one in progress.
+    // Quarters older than getQuarterCount() have no data and read as 0.
+    time_t getLastQuarter();
+    uint16_t getQuarterCount();
+    uint32_t getQuarterImport(uint16_t ago);
+    uint32_t getQuarterExport(uint16_t ago);
+    // Quarter starting at ts, or -1 if it is not in the history
+    int16_t getQuarterAgo(time_t ts);
+
 private:
     Timezone* tz;
+    AmsJournal* journal = NULL;
+    uint32_t revision = 0;
+    QuarterDataPoints quarter = { 1, 0, 0, 0, 0, 0, {}, {} };
+    // When the quarter counters last moved and the highest power since, not persisted
+    time_t quarterTime = 0;
+    uint32_t quarterImportPower = 0;
+    uint32_t quarterExportPower = 0;
+    bool quarterRebase = false;
     DayDataPoints day = {
         0,
         0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 
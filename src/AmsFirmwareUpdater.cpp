@@ -260,7 +260,7 @@ bool AmsFirmwareUpdater::fetchNextVersion() {
 		if(meterState->getMeterType() != AmsTypeAutodetect) {
 			http.addHeader(F("x-AMS-meter-mfg"), String(meterState->getMeterType(), 10));
 		}
-		if(!meterState->getMeterModel().isEmpty()) {
+		if(strlen(meterState->getMeterModel()) > 0) {
 			http.addHeader(F("x-AMS-meter-model"), meterState->getMeterModel());
 		}
         int status = http.GET();
@@ -319,7 +319,7 @@ bool AmsFirmwareUpdater::fetchVersionDetails() {
 		if(meterState->getMeterType() != AmsTypeAutodetect) {
 			http.addHeader(F("x-AMS-meter-mfg"), String(meterState->getMeterType(), 10));
 		}
-		if(!meterState->getMeterModel().isEmpty()) {
+		if(strlen(meterState->getMeterModel()) > 0) {
 			http.addHeader(F("x-AMS-meter-model"), meterState->getMeterModel());
 		}
         int status = http.GET();
@@ -831,6 +831,7 @@ bool AmsFirmwareUpdater::hasFiles() {
     if(LittleFS.exists(FILE_DAYPLOT)) return true;
     if(LittleFS.exists(FILE_MONTHPLOT)) return true;
     if(LittleFS.exists(FILE_ENERGYACCOUNTING)) return true;
+    if(LittleFS.exists(FILE_JOURNAL)) return true;
     if(LittleFS.exists(FILE_PRICE_CONF)) return true;
     return false;
 }
@@ -1122,6 +1123,7 @@ bool AmsFirmwareUpdater::moveLittleFsFromOldToApp1() {
     copyFile(&oldFs, &tmpFs, FILE_DAYPLOT);
     copyFile(&oldFs, &tmpFs, FILE_MONTHPLOT);
     copyFile(&oldFs, &tmpFs, FILE_ENERGYACCOUNTING);
+    copyFile(&oldFs, &tmpFs, FILE_JOURNAL);
     copyFile(&oldFs, &tmpFs, FILE_PRICE_CONF);
     return true;
 }
@@ -1163,6 +1165,7 @@ bool AmsFirmwareUpdater::moveLittleFsFromApp1ToNew() {
     copyFile(&tmpFs, &newFs, FILE_DAYPLOT);
     copyFile(&tmpFs, &newFs, FILE_MONTHPLOT);
     copyFile(&tmpFs, &newFs, FILE_ENERGYACCOUNTING);
+    copyFile(&tmpFs, &newFs, FILE_JOURNAL);
     copyFile(&tmpFs, &newFs, FILE_PRICE_CONF);
     return true;
 }
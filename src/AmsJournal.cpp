@@ -0,0 +1,253 @@
+/**
+ * @copyright Utilitech AS 2023-2026
+ * License: Fair Source
+ *
+ */
+
+#include "AmsJournal.h"
+#include <string.h>
+#include "LittleFS.h"
+#include "crc.h"
+
+#define JOURNAL_TRAILER 2
+
+AmsJournal::AmsJournal(const char* path, const char* tmpPath) {
+    this->path = path;
+    this->tmpPath = tmpPath;
+}
+
+bool AmsJournal::begin() {
+    scanned = false;
+    if(LittleFS.exists(tmpPath)) {
+        if(LittleFS.exists(path)) {
+            // Left behind by a compaction that did not finish, the journal itself is intact
+            LittleFS.remove(tmpPath);
+        } else {
+            // Interrupted between removing the journal and renaming the copy over it
+            LittleFS.rename(tmpPath, path);
+        }
+    }
+    return scan();
+}
+
+bool AmsJournal::scan() {
+    scanned = true;
+    present = 0;
+    size = 0;
+    if(!LittleFS.exists(path)) {
+        return true;
+    }
+
+    File file = LittleFS.open(path, "r");
+    if(!file) {
+        return false;
+    }
+    uint32_t fileSize = file.size();
+    uint32_t pos = 0;
+    uint8_t buf[JOURNAL_BLOCK];
+    while(pos + sizeof(JournalRecordHeader) + JOURNAL_TRAILER <= fileSize) {
+        JournalRecordHeader header;
+        if(file.read((uint8_t*) &header, sizeof(header)) != sizeof(header)) break;
+        if(header.magic != JOURNAL_MAGIC || header.type == 0 || header.type >= JOURNAL_TYPES || header.length > JOURNAL_MAX_RECORD) break;
+        uint32_t end = pos + sizeof(header) + header.length + JOURNAL_TRAILER;
+        if(end > fileSize) break;
+
+        uint16_t crc = crc16_update(CRC16_INIT, (uint8_t*) &header, sizeof(header));
+        uint16_t left = header.length;
+        while(left > 0) {
+            uint16_t n = left < JOURNAL_BLOCK ? left : JOURNAL_BLOCK;
+            if(file.read(buf, n) != n) break;
+            crc = crc16_update(crc, buf, n);
+            left -= n;
+        }
+        if(left > 0 || file.read(buf, JOURNAL_TRAILER) != JOURNAL_TRAILER) break;
+        if((uint16_t) (buf[0] | (buf[1] << 8)) != crc) break;
+
+        offsets[header.type] = pos + sizeof(header);
+        lengths[header.type] = header.length;
+        present |= 1 << header.type;
+        pos = end;
+    }
+    file.close();
+    size = pos;
+
+    if(pos < fileSize) {
+        // Torn or corrupt tail, keep what is good and drop the rest
+        return compact();
+    }
+    return true;
+}
+
+bool AmsJournal::has(uint8_t type) {
+    if(!scanned) scan();
+    return type < JOURNAL_TYPES && (present & (1 << type));
+}
+
+uint16_t AmsJournal::read(uint8_t type, void* data, uint16_t length) {
+    if(!has(type) || lengths[type] > length) {
+        return 0;
+    }
+    File file = LittleFS.open(path, "r");
+    if(!file) {
+        return 0;
+    }
+    uint16_t ret = 0;
+    if(file.seek(offsets[type]) && file.read((uint8_t*) data, lengths[type]) == lengths[type]) {
+        ret = lengths[type];
+    }
+    file.close();
+    return ret;
+}
+
+bool AmsJournal::matches(uint8_t type, const uint8_t* data, uint16_t length) {
+    if(!has(type) || lengths[type] != length) {
+        return false;
+    }
+    File file = LittleFS.open(path, "r");
+    if(!file) {
+        return false;
+    }
+    bool ret = file.seek(offsets[type]);
+    uint8_t buf[JOURNAL_BLOCK];
+    for(uint16_t pos = 0; ret && pos < length; pos += JOURNAL_BLOCK) {
+        uint16_t n = length - pos < JOURNAL_BLOCK ? length - pos : JOURNAL_BLOCK;
+        ret = file.read(buf, n) == n && memcmp(buf, data + pos, n) == 0;
+    }
+    file.close();
+    return ret;
+}
+
+bool AmsJournal::write(uint8_t type, const void* data, uint16_t length) {
+    if(type == 0 || type >= JOURNAL_TYPES || length > JOURNAL_MAX_RECORD) {
+        return false;
+    }
+    if(!scanned && !scan()) {
+        return false;
+    }
+    if(matches(type, (const uint8_t*) data, length)) {
+        return true;
+    }
+
+    uint32_t recordSize = sizeof(JournalRecordHeader) + length + JOURNAL_TRAILER;
+    if(size + recordSize > JOURNAL_MAX_SIZE) {
+        compact();
+    }
+
+    JournalRecordHeader header = { JOURNAL_MAGIC, type, length };
+    uint16_t crc = crc16_update(CRC16_INIT, (uint8_t*) &header, sizeof(header));
+    crc = crc16_update(crc, (const uint8_t*) data, length);
+    uint8_t trailer[JOURNAL_TRAILER] = { (uint8_t) (crc & 0xFF), (uint8_t) (crc >> 8) };
+
+    File file = LittleFS.open(path, "a");
+    if(!file) {
+        return false;
+    }
+    if(file.size() != size) {
+        // Changed behind our back, by a format for instance
+        file.close();
+        if(!scan()) {
+            return false;
+        }
+        file = LittleFS.open(path, "a");
+        if(!file) {
+            return false;
+        }
+    }
+    bool ret = file.write((uint8_t*) &header, sizeof(header)) == sizeof(header)
+        && file.write((const uint8_t*) data, length) == length
+        && file.write(trailer, JOURNAL_TRAILER) == JOURNAL_TRAILER;
+    file.close();
+
+    if(ret) {
+        offsets[type] = size + sizeof(header);
+        lengths[type] = length;
+        present |= 1 << type;
+        size += recordSize;
+    } else {
+        // Whatever made it to the file is found and dropped on the next scan
+        scanned = false;
+    }
+    return ret;
+}
+
+bool AmsJournal::compact() {
+    if(!scanned && !scan()) {
+        return false;
+    }
+    File src = LittleFS.open(path, "r");
+    if(!src) {
+        return false;
+    }
+    File dst = LittleFS.open(tmpPath, "w");
+    if(!dst) {
+        src.close();
+        return false;
+    }
+
+    bool ret = true;
+    uint32_t pos = 0;
+    uint32_t newOffsets[JOURNAL_TYPES];
+    uint8_t buf[JOURNAL_BLOCK];
+    for(uint8_t type = 1; ret && type < JOURNAL_TYPES; type++) {
+        if(!(present & (1 << type))) continue;
+        // Copies header, payload and trailer as they are, the CRC still holds
+        uint32_t left = sizeof(JournalRecordHeader) + lengths[type] + JOURNAL_TRAILER;
+        newOffsets[type] = pos + sizeof(JournalRecordHeader);
+        ret = src.seek(offsets[type] - sizeof(JournalRecordHeader));
+        while(ret && left > 0) {
+            uint16_t n = left < JOURNAL_BLOCK ? left : JOURNAL_BLOCK;
+            ret = src.read(buf, n) == n && dst.write(buf, n) == n;
+            left -= n;
+            pos += n;
+        }
+    }
+    src.close();
+    dst.close();
+
+    if(ret && !LittleFS.rename(tmpPath, path)) {
+        LittleFS.remove(path);
+        ret = LittleFS.rename(tmpPath, path);
+    }
+    if(!ret) {
+        if(LittleFS.exists(path)) LittleFS.remove(tmpPath);
+        scanned = false;
+        return false;
+    }
+
+    for(uint8_t type = 1; type < JOURNAL_TYPES; type++) {
+        if(present & (1 << type)) offsets[type] = newOffsets[type];
+    }
+    size = pos;
+    return true;
+}
+
+uint16_t AmsJournal::load(uint8_t type, const char* legacyPath, void* data, uint16_t length) {
+    uint16_t ret = read(type, data, length);
+    if(ret > 0 || !LittleFS.exists(legacyPath)) {
+        return ret;
+    }
+    File file = LittleFS.open(legacyPath, "r");
+    if(!file) {
+        return 0;
+    }
+    if(file.size() <= length) {
+        ret = file.read((uint8_t*) data, file.size());
+    }
+    file.close();
+    return ret;
+}
+
+bool AmsJournal::save(uint8_t type, const char* legacyPath, const void* data, uint16_t length) {
+    if(!write(type, data, length)) {
+        return false;
+    }
+    if(LittleFS.exists(legacyPath)) {
+        LittleFS.remove(legacyPath);
+    }
+    return true;
+}
+
+uint32_t AmsJournal::getSize() {
+    if(!scanned) scan();
+    return size;
+}
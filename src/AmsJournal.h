@@ -0,0 +1,76 @@
+/**
+ * @copyright Utilitech AS 2023-2026
+ * License: Fair Source
+ *
+ */
+
+#ifndef _AMSJOURNAL_H
+#define _AMSJOURNAL_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "AmsStorage.h"
+
+#define JOURNAL_MAGIC 0xA7
+#define JOURNAL_TYPES 8
+#define JOURNAL_MAX_RECORD 2048
+#define JOURNAL_MAX_SIZE 16384 // Compacted before an append would grow it past this
+#define JOURNAL_BLOCK 64
+
+enum JournalRecordType {
+    JournalDayPlot = 1,
+    JournalMonthPlot = 2,
+    JournalQuarterPlot = 3,
+    JournalEnergyAccounting = 4,
+    JournalPrices = 5,
+    JournalCurrency = 6,
+    JournalDemand = 7
+};
+
+// On file: header, payload, then CRC16 of both, little-endian
+struct JournalRecordHeader {
+    uint8_t magic;
+    uint8_t type;
+    uint16_t length;
+};
+
+// Append-only file of CRC protected records where the newest record of a
+// type wins. A record cut short by a power loss fails its check, so loading
+// falls back to the record before it. Compacting copies the newest record of
+// each type to a new file and renames it over the journal.
+class AmsJournal {
+public:
+    AmsJournal(const char* path = FILE_JOURNAL, const char* tmpPath = FILE_JOURNAL_TMP);
+
+    // Scans the journal and rewrites it without a torn tail if it has one
+    bool begin();
+    // Appends a record, unless the newest one of the type holds the same bytes
+    bool write(uint8_t type, const void* data, uint16_t length);
+    // Copies the newest record of type into data. Returns its length, 0 if
+    // there is none or it does not fit.
+    uint16_t read(uint8_t type, void* data, uint16_t length);
+    bool has(uint8_t type);
+    bool compact();
+
+    // As read(), falling back to the file the record replaces if the journal
+    // does not have it yet
+    uint16_t load(uint8_t type, const char* legacyPath, void* data, uint16_t length);
+    // As write(), removing the file the record replaces once it is stored
+    bool save(uint8_t type, const char* legacyPath, const void* data, uint16_t length);
+
+    uint32_t getSize();
+
+private:
+    const char* path;
+    const char* tmpPath;
+    bool scanned = false;
+    uint32_t size = 0;
+    uint8_t present = 0;
+    uint32_t offsets[JOURNAL_TYPES];
+    uint16_t lengths[JOURNAL_TYPES];
+
+    bool scan();
+    bool matches(uint8_t type, const uint8_t* data, uint16_t length);
+};
+
+#endif
@@ -20,3 +20,19 @@ void AmsJsonGenerator::generateMonthPlotJson(AmsDataStorage* ds, char* buf, size
 		}
 		snprintf_P(buf+pos, bufSize-pos, PSTR("}"));
 }
+
+void AmsJsonGenerator::generateQuarterPlotJson(AmsDataStorage* ds, char* buf, size_t bufSize, uint16_t offset, uint16_t size) {
+		if(size > QUARTER_PLOT_MAX) size = QUARTER_PLOT_MAX;
+		if(offset > QUARTER_SLOTS) offset = QUARTER_SLOTS;
+		if(offset + size > QUARTER_SLOTS) size = QUARTER_SLOTS - offset;
+		uint16_t pos = snprintf_P(buf, bufSize, PSTR("{\"unit\":\"wh\",\"period\":%d,\"last\":%lu,\"offset\":%d,\"size\":%d,\"total\":%d,\"i\":["),
+			QUARTER_SECONDS, (unsigned long) ds->getLastQuarter(), offset, size, ds->getQuarterCount());
+		for(uint16_t i = 0; i < size; i++) {
+			pos += snprintf_P(buf+pos, bufSize-pos, PSTR("%s%lu"), i == 0 ? "" : ",", (unsigned long) ds->getQuarterImport(offset + i));
+		}
+		pos += snprintf_P(buf+pos, bufSize-pos, PSTR("],\"e\":["));
+		for(uint16_t i = 0; i < size; i++) {
+			pos += snprintf_P(buf+pos, bufSize-pos, PSTR("%s%lu"), i == 0 ? "" : ",", (unsigned long) ds->getQuarterExport(offset + i));
+		}
+		snprintf_P(buf+pos, bufSize-pos, PSTR("]}"));
+}
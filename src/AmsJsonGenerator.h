@@ -7,8 +7,13 @@
 
 #include "AmsDataStorage.h"
 
+#define QUARTER_PLOT_MAX 96
+
 class AmsJsonGenerator {
 public:
     static void generateDayPlotJson(AmsDataStorage* ds, char* buf, size_t bufSize);
     static void generateMonthPlotJson(AmsDataStorage* ds, char* buf, size_t bufSize);
+    // size quarters from offset quarters back, newest first, in Wh. At most
+    // QUARTER_PLOT_MAX per call so it fits a 2 kB buffer.
+    static void generateQuarterPlotJson(AmsDataStorage* ds, char* buf, size_t bufSize, uint16_t offset, uint16_t size);
 };
\ No newline at end of file
@@ -15,7 +15,10 @@
 
 #define FILE_DAYPLOT "/dayplot.bin"
 #define FILE_MONTHPLOT "/monthplot.bin"
+#define FILE_QUARTERPLOT "/quarterplot.bin"
 #define FILE_ENERGYACCOUNTING "/energyaccounting.bin"
+#define FILE_JOURNAL "/journal.bin"
+#define FILE_JOURNAL_TMP "/journal.tmp"
 
 #define FILE_CFG "/configfile.cfg"
 #define FILE_PRICE_CONF "/priceconf.bin"
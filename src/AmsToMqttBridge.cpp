@@ -123,6 +123,9 @@ HardwareSerial Debug = Serial;
 #endif
 
 #define BUF_SIZE_COMMON (2048)
+#if BUF_SIZE_COMMON < JOURNAL_MAX_RECORD
+#error "PriceService reads journal records into commonBuffer"
+#endif
 
 #include "Timezones.h"
 
@@ -241,12 +244,14 @@ GpioConfig gpioConfig;
 
 MeterConfig meterConfig;
 AmsData meterState;
+AmsData meterData; // Decode slot, reused for every frame
 bool ntpEnabled = false;
 
 bool mdnsEnabled = false;
 
 AmsFirmwareUpdater updater(&Debug, &hw, &meterState);
 
+AmsJournal journal;
 AmsDataStorage ds(&Debug);
 #if defined(_CLOUDCONNECTOR_H)
 CloudConnector *cloud = NULL;
@@ -643,6 +648,8 @@ void setup() {
 #endif
 	yield();
 
+	ds.setJournal(&journal);
+	ea.setJournal(&journal);
 
 	if(hasFs) {
 		#if defined(ESP8266)
@@ -655,6 +662,10 @@ void setup() {
 			}
 		#endif
 
+		if(!journal.begin()) {
+			debugW_P(PSTR("Unable to read journal"));
+		}
+
 		if(LittleFS.exists(FILE_FIRMWARE_DELETE)) {
 			LittleFS.remove(FILE_FIRMWARE_DELETE);
 		} else if(LittleFS.exists(FILE_CFG)) {
@@ -681,7 +692,8 @@ void setup() {
 
 	PriceServiceConfig price;
 	if(config.getPriceServiceConfig(price)) {
-		ps = new PriceService(&Debug);
+		ps = new PriceService(&Debug, commonBuffer);
+		ps->setJournal(&journal);
 		ps->setup(price);
 		ws.setPriceService(ps);
 	}
@@ -711,6 +723,7 @@ void setup() {
 			config.setUiLanguageChanged();
 		}
 	}
+	rtp.setWindow(ui.realtimePlotWindow);
 
 	yield();
 
@@ -1004,7 +1017,7 @@ void handleMdns() {
 #if defined(ESP32) && defined(ENERGY_SPEEDOMETER_PASS)
 void handleEnergySpeedometer() {
 	if(sysConfig.energyspeedometer == 7) {
-		if(!meterState.getMeterId().isEmpty()) {
+		if(strlen(meterState.getMeterId()) > 0) {
 			if(energySpeedometer == NULL) {
 				config.getUniqueName(energySpeedometerConfig.clientId, 32);
 				energySpeedometer = new JsonMqttHandler(energySpeedometerConfig, &Debug, (char*) commonBuffer, &hw, &ds, &updater);
@@ -1036,7 +1049,7 @@ void handleEnergySpeedometer() {
 
 #if defined(CUSTOM_MQTT_HOST)
 void handleCustomMqtt() {
-	if(meterState.getMeterId().isEmpty()) return;
+	if(strlen(meterState.getMeterId()) == 0) return;
 	if(customMqttHandler == NULL) {
 		config.getUniqueName(customMqttConfig.clientId, 32);
 		switch(CUSTOM_MQTT_PAYLOAD_FORMAT) {
@@ -1441,7 +1454,8 @@ void handlePriceService(unsigned long now) {
 			PriceServiceConfig price;
 			if(config.getPriceServiceConfig(price) && price.enabled && strlen(price.area) > 0) {
 				if(ps == NULL) {
-					ps = new PriceService(&Debug);
+					ps = new PriceService(&Debug, commonBuffer);
+					ps->setJournal(&journal);
 					ea.setPriceService(ps);
 					ws.setPriceService(ps);
 					#if defined(_CLOUDCONNECTOR_H)
@@ -1681,15 +1695,12 @@ bool readHanPort() {
 	}
 	meterState.setLastError(mc->getLastError());
 
-	AmsData* data = mc->getData(meterState);
-
-	if(data != NULL) {
-		if(data->getListType() > 0) {
-			handleDataSuccess(data);
+	if(mc->getData(meterState, meterData)) {
+		if(meterData.getListType() > 0) {
+			handleDataSuccess(&meterData);
 		} else {
 			meterState.setLastError(METER_ERROR_UNKNOWN_DATA);
 		}
-		delete data;
 	}
 	yield();
 	return true;
@@ -1699,25 +1710,45 @@ void handleDataSuccess(AmsData* data) {
 	if(!setupMode && !hw.ledFlash(LED_GREEN, 1))
 		hw.ledFlash(LED_INTERNAL, 1);
 
-	if(mqttHandler != NULL && checkVoltageIfNeeded(0.2)) {
-		#if defined(ESP32)
-			esp_task_wdt_reset();
-		#elif defined(ESP8266)
-			ESP.wdtFeed();
-		#endif
-		yield();
-		mqttHandler->publish(data, &meterState, &ea, ps);
-	}
+	// Merge first, so the sinks get the state along with the fields this frame changed
+	bool wasCounterEstimated = meterState.isCounterEstimated();
+	meterState.apply(*data);
+	rtp.update(meterState);
+
+	// One context for all sinks, so accounting and hardware are read once and
+	// a payload rendered by one handler is reused by the next
+	uint8_t sinks = mqttHandler != NULL ? 1 : 0;
 	#if defined(ESP32) && defined(ENERGY_SPEEDOMETER_PASS)
-	if(energySpeedometer != NULL && checkVoltageIfNeeded(0.1)) {
-		energySpeedometer->publish(&meterState, &meterState, &ea, ps);
-	}
+	if(energySpeedometer != NULL) sinks++;
 	#endif
 	#if defined(CUSTOM_MQTT_HOST)
-	if(customMqttHandler != NULL && checkVoltageIfNeeded(0.1)) {
-		customMqttHandler->publish(data, &meterState, &ea, ps);
-	}
+	if(customMqttHandler != NULL) sinks++;
 	#endif
+	if(sinks > 0) {
+		AmsPublishContext ctx(data, &meterState, &ea, ps, &hw, sinks);
+		if(mqttHandler != NULL && checkVoltageIfNeeded(0.2)) {
+			#if defined(ESP32)
+				esp_task_wdt_reset();
+			#elif defined(ESP8266)
+				ESP.wdtFeed();
+			#endif
+			yield();
+			mqttHandler->publish(ctx);
+		}
+		#if defined(ESP32) && defined(ENERGY_SPEEDOMETER_PASS)
+		if(energySpeedometer != NULL && checkVoltageIfNeeded(0.1)) {
+			// Always given the full state
+			ctx.update = &meterState;
+			energySpeedometer->publish(ctx);
+			ctx.update = data;
+		}
+		#endif
+		#if defined(CUSTOM_MQTT_HOST)
+		if(customMqttHandler != NULL && checkVoltageIfNeeded(0.1)) {
+			customMqttHandler->publish(ctx);
+		}
+		#endif
+	}
 
 	time_t now = time(nullptr);
 	time_t meterTime = data->getMeterTimestamp();
@@ -1735,15 +1766,12 @@ void handleDataSuccess(AmsData* data) {
 		}
 	}
 
-	bool wasCounterEstimated = meterState.isCounterEstimated();
-	meterState.apply(*data);
-	rtp.update(meterState);
-
 	time_t dataUpdateTime = now;
 	if(abs(now - meterTime) < 300) {
 		// If the meter timestamp is close to our internal clock, use meter timestamp, because that is best for data tracking
 		dataUpdateTime = meterTime;
 	}
+	ds.updateQuarter(&meterState, dataUpdateTime);
 
 	tmElements_t tm, mtm;
 	breakTime(now, tm);
@@ -2260,7 +2288,7 @@ void configFileParse() {
 			if(!lPrice) { config.getPriceServiceConfig(price); lPrice = true; };
 			strcpy(price.currency, buf+14);
 		} else if(strncmp_P(buf, PSTR("priceModifier "), 14) == 0) {
-			if(ps == NULL) ps = new PriceService(&Debug);
+			if(ps == NULL) ps = new PriceService(&Debug, commonBuffer);
 			PriceConfig pc;
 			memset(&pc, 0, sizeof(PriceConfig));
 
@@ -2355,6 +2383,8 @@ void configFileParse() {
 				pch = strtok (NULL, " ");
 			}
 			eac.hours = String(pch).toInt();
+			pch = strtok (NULL, " ");
+			if(pch != NULL) eac.demandModel = String(pch).toInt();
 		} else if(strncmp_P(buf, PSTR("dayplot "), 8) == 0) {
 			int i = 0;
 			DayDataPoints day = { 0 };
@@ -2610,10 +2640,12 @@ void configFileParse() {
 		if(!LittleFS.format()) {
 			debugE_P(PSTR("Unable to format broken filesystem"));
 		}
+		journal.begin();
 	}
 
 	debugI_P(PSTR("Saving configuration now..."));
 	Serial.flush();
+	config.beginBatch();
 	if(lSys) config.setSystemConfig(sys);
 	if(lNetwork) config.setNetworkConfig(network);
 	if(lMqtt) config.setMqttConfig(mqtt);
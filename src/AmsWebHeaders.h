@@ -31,5 +31,6 @@ static const char MIME_HTML[] PROGMEM = "text/html";
 static const char MIME_JSON[] PROGMEM = "application/json";
 static const char MIME_CSS[] PROGMEM = "text/css";
 static const char MIME_JS[] PROGMEM = "text/javascript";
+static const char MIME_OCTET_STREAM[] PROGMEM = "application/octet-stream";
 
 static const char ORIGIN_AMSLESER_CLOUD[] PROGMEM = "https://www.amsleser.cloud";
@@ -119,6 +119,7 @@ void AmsWebServer::setup(AmsConfiguration* config, GpioConfig* gpioConfig, AmsDa
 	server.on(context + F("/data.json"), HTTP_GET, std::bind(&AmsWebServer::dataJson, this));
 	server.on(context + F("/dayplot.json"), HTTP_GET, std::bind(&AmsWebServer::dayplotJson, this));
 	server.on(context + F("/monthplot.json"), HTTP_GET, std::bind(&AmsWebServer::monthplotJson, this));
+	server.on(context + F("/quarterplot.json"), HTTP_GET, std::bind(&AmsWebServer::quarterplotJson, this));
 	server.on(context + F("/energyprice.json"), HTTP_GET, std::bind(&AmsWebServer::energyPriceJson, this));
 	server.on(context + F("/importprice.json"), HTTP_GET, std::bind(&AmsWebServer::importPriceJson, this));
 	server.on(context + F("/exportprice.json"), HTTP_GET, std::bind(&AmsWebServer::exportPriceJson, this));
@@ -160,6 +161,7 @@ void AmsWebServer::setup(AmsConfiguration* config, GpioConfig* gpioConfig, AmsDa
 	server.on(context + F("/data.json"), HTTP_OPTIONS, std::bind(&AmsWebServer::optionsGet, this));
 	server.on(context + F("/dayplot.json"), HTTP_OPTIONS, std::bind(&AmsWebServer::optionsGet, this));
 	server.on(context + F("/monthplot.json"), HTTP_OPTIONS, std::bind(&AmsWebServer::optionsGet, this));
+	server.on(context + F("/quarterplot.json"), HTTP_OPTIONS, std::bind(&AmsWebServer::optionsGet, this));
 	server.on(context + F("/energyprice.json"), HTTP_OPTIONS, std::bind(&AmsWebServer::optionsGet, this));
 	server.on(context + F("/temperature.json"), HTTP_OPTIONS, std::bind(&AmsWebServer::optionsGet, this));
 	server.on(context + F("/tariff.json"), HTTP_OPTIONS, std::bind(&AmsWebServer::optionsGet, this));
@@ -791,6 +793,7 @@ void AmsWebServer::dataJson() {
 		if(!peaks.isEmpty()) peaks += ",";
 		peaks += String(ea->getPeak(i).value / 100.0);
 	}
+	EnergyDemand* dm = ea->getDemand();
 
 	time_t now = time(nullptr);
 
@@ -862,6 +865,13 @@ void AmsWebServer::dataJson() {
 		ea->getCostThisMonth(),
 		ea->getProducedThisMonth(),
 		ea->getIncomeThisMonth(),
+		dm->getQuarterAverage(),
+		dm->getQuarterProjection(),
+		dm->getHourAverage(),
+		dm->getHourProjection(),
+		dm->getPeakAverage(),
+		dm->getPeakThreshold(),
+		dm->isPeakWarning() ? "true" : "false",
 		price == PRICE_NO_VALUE ? "false" : "true",
 		priceRegion.c_str(),
 		priceCurrency.c_str(),
@@ -916,6 +926,26 @@ void AmsWebServer::monthplotJson() {
 	}
 }
 
+void AmsWebServer::quarterplotJson() {
+	if(!checkSecurity(2))
+		return;
+
+	if(ds == NULL) {
+		notFound();
+	} else {
+		uint16_t offset = server.hasArg(F("offset")) ? server.arg(F("offset")).toInt() : 0;
+		uint16_t size = server.hasArg(F("size")) ? server.arg(F("size")).toInt() : QUARTER_PLOT_MAX;
+		AmsJsonGenerator::generateQuarterPlotJson(ds, buf, BufferSize, offset, size);
+		addConditionalCloudHeaders();
+		server.sendHeader(HEADER_CACHE_CONTROL, CACHE_CONTROL_NO_CACHE);
+		server.sendHeader(HEADER_PRAGMA, PRAGMA_NO_CACHE);
+		server.sendHeader(HEADER_EXPIRES, EXPIRES_OFF);
+
+		server.setContentLength(strlen(buf));
+		server.send(200, MIME_JSON, buf);
+	}
+}
+
 // Deprecated
 void AmsWebServer::energyPriceJson() {
 	if(!checkSecurity(2))
@@ -1019,12 +1049,13 @@ void AmsWebServer::temperatureJson() {
 		if(data == NULL) continue;
 
 		char* pos = buf+strlen(buf);
-		snprintf_P(pos, 72, PSTR("{\"i\":%d,\"a\":\"%s\",\"n\":\"%s\",\"c\":%d,\"v\":%.1f},"), 
+		snprintf_P(pos, 80, PSTR("{\"i\":%d,\"a\":\"%s\",\"n\":\"%s\",\"c\":%d,\"v\":%.1f,\"r\":%d},"), 
 			i,
 			toHex(data->address, 8).c_str(),
 			"",
 			1,
-			data->lastRead
+			data->lastRead,
+			data->requestedResolution > 0 ? data->requestedResolution : data->resolution
 		);
 		yield();
 	}
@@ -1201,7 +1232,8 @@ void AmsWebServer::configurationJson() {
 		eac->thresholds[7],
 		eac->thresholds[8],
 		eac->thresholds[9],
-		eac->hours
+		eac->hours,
+		eac->demandModel
 	);
 	server.sendContent(buf);
 	snprintf_P(buf, BufferSize, CONF_WIFI_JSON,
@@ -1301,7 +1333,8 @@ void AmsWebServer::configurationJson() {
 		ui.showPerPhasePower,
 		ui.showPowerFactor,
 		ui.darkMode,
-		ui.language
+		ui.language,
+		ui.realtimePlotWindow
 	);
 	server.sendContent(buf);
 	snprintf_P(buf, BufferSize, CONF_DOMOTICZ_JSON,
@@ -1463,6 +1496,9 @@ void AmsWebServer::handleSave() {
 	SystemConfig sys;
 	config->getSystemConfig(sys);
 
+	// All sections below are written with a single commit by save() or commit()
+	config->beginBatch();
+
 	bool success = true;
 	if(server.hasArg(F("v")) && server.arg(F("v")) == F("true")) {
 		int boardType = server.arg(F("vb")).toInt();
@@ -1759,6 +1795,13 @@ void AmsWebServer::handleSave() {
 		config->setGpioConfig(*gpioConfig);
 	}
 
+	if(server.hasArg(F("ts")) && server.arg(F("ts")) == F("true")) {
+		for(uint8_t i = 0; i < hw->getTempSensorCount(); i++) {
+			String arg = "tr" + String(i, 10);
+			if(server.hasArg(arg)) hw->setTempSensorResolution(i, server.arg(arg).toInt());
+		}
+	}
+
 	if(server.hasArg(F("idb"))) {
 		gpioConfig->ledBehaviour =  server.hasArg(F("idb")) && !server.arg(F("idb")).isEmpty() ? server.arg(F("idb")).toInt() : 0;
 		config->setGpioConfig(*gpioConfig);
@@ -1826,7 +1869,9 @@ void AmsWebServer::handleSave() {
 		ui.showPowerFactor = server.arg(F("uf")).toInt();
 		ui.darkMode = server.arg(F("uk")).toInt();
 		strcpy(ui.language, server.arg(F("ulang")).c_str());
+		ui.realtimePlotWindow = server.arg(F("uw")).toInt();
 		config->setUiConfig(ui);
+		if(rtp != NULL) rtp->setWindow(ui.realtimePlotWindow);
 	}
 
 	if(server.hasArg(F("p")) && server.arg(F("p")) == F("true")) {
@@ -1843,6 +1888,7 @@ void AmsWebServer::handleSave() {
 
 	if(server.hasArg(F("t")) && server.arg(F("t")) == F("true")) {
 		EnergyAccountingConfig eac;
+		config->getEnergyAccountingConfig(eac);
 		eac.thresholds[0] = server.arg(F("t0")).toInt();
 		eac.thresholds[1] = server.arg(F("t1")).toInt();
 		eac.thresholds[2] = server.arg(F("t2")).toInt();
@@ -1853,6 +1899,9 @@ void AmsWebServer::handleSave() {
 		eac.thresholds[7] = server.arg(F("t7")).toInt();
 		eac.thresholds[8] = server.arg(F("t8")).toInt();
 		eac.hours = server.arg(F("th")).toInt();
+		if(server.hasArg(F("tm"))) {
+			eac.demandModel = server.arg(F("tm")).toInt();
+		}
 		config->setEnergyAccountingConfig(eac);
 	}
 
@@ -1953,6 +2002,7 @@ void AmsWebServer::handleSave() {
 	// If vendor page and clear all config is selected
 	if(server.hasArg(F("v")) && server.arg(F("v")) == F("true") && server.hasArg(F("vr")) && server.arg(F("vr")) == F("true")) {
 		config->clear();
+		config->commit();
 	} else if(config->save()) {
 		#if defined(AMS_REMOTE_DEBUG)
 		if (debugger->isActive(RemoteDebug::INFO))
@@ -2402,6 +2452,19 @@ void AmsWebServer::tariffJson() {
 		peaks += String(buf);
 	}
 
+	EnergyDemand* dm = ea->getDemand();
+	String demandPeaks;
+	for(uint8_t x = 0; x < dm->getPeakCount(); x++) {
+		DemandPeak peak = dm->getPeak(x);
+		int len = snprintf_P(buf, BufferSize, PSTR("{\"s\":%u,\"v\":%u}"),
+			peak.start,
+			peak.value
+		);
+		buf[len] = '\0';
+		if(!demandPeaks.isEmpty()) demandPeaks += ",";
+		demandPeaks += String(buf);
+	}
+
 	snprintf_P(buf, BufferSize, TARIFF_JSON,
 		eac->thresholds[0],
 		eac->thresholds[1],
@@ -2415,7 +2478,9 @@ void AmsWebServer::tariffJson() {
 		eac->thresholds[9],
 		peaks.c_str(),
 		ea->getCurrentThreshold(),
-		ea->getMonthMax()
+		ea->getMonthMax(),
+		dm->getModel(),
+		demandPeaks.c_str()
 	);
 
 	addConditionalCloudHeaders();
@@ -2455,15 +2520,65 @@ void AmsWebServer::realtimeJson() {
 		offset = rtp->getSize();
 	}
 
-	uint16_t pos = snprintf_P(buf, BufferSize, PSTR("{\"offset\":%d,\"size\":%d,\"total\":%d,\"data\":["), offset, size, rtp->getSize());
+	// Values are read in batches and each batch goes out as its own chunk, so
+	// the buffer never limits the window size and the loop is not held up
+	int32_t values[REALTIME_CHUNK];
+	server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+	if(server.hasArg(F("format")) && server.arg(F("format")) == F("delta")) {
+		// Compact binary: offset, size and total as little-endian uint16, then one
+		// zigzag varint per value holding the difference to the previous value
+		// (the first is relative to 0)
+		server.send(200, MIME_OCTET_STREAM, "");
+		uint16_t pos = 0;
+		uint16_t header[] = { offset, size, (uint16_t) rtp->getSize() };
+		for(uint8_t i = 0; i < 3; i++) {
+			buf[pos++] = header[i] & 0xFF;
+			buf[pos++] = header[i] >> 8;
+		}
+		int32_t last = 0;
+		for(uint16_t i = 0; i < size; i += REALTIME_CHUNK) {
+			uint16_t count = rtp->getValues(offset + i, min((uint16_t) REALTIME_CHUNK, (uint16_t) (size - i)), values);
+			for(uint16_t j = 0; j < count; j++) {
+				int32_t delta = values[j] - last;
+				uint32_t zz = ((uint32_t) delta << 1) ^ (uint32_t) (delta >> 31);
+				while(zz >= 0x80) {
+					buf[pos++] = (zz & 0x7F) | 0x80;
+					zz >>= 7;
+				}
+				buf[pos++] = zz;
+				last = values[j];
+			}
+			server.sendContent(buf, pos);
+			pos = 0;
+			if(count == 0) break;
+		}
+		if(pos > 0) server.sendContent(buf, pos);
+		return;
+	}
+
+	// With minmax=true each element is [avg,min,max] for its bucket
+	bool minmax = server.hasArg(F("minmax")) && server.arg(F("minmax")) == F("true");
+	int32_t mins[REALTIME_CHUNK], maxs[REALTIME_CHUNK];
+
+	server.send(200, MIME_JSON, "");
+	uint16_t pos = snprintf_P(buf, BufferSize, PSTR("{\"offset\":%d,\"size\":%d,\"total\":%d,\"period\":%lu,\"data\":["), offset, size, rtp->getSize(), (unsigned long) rtp->getPeriod() / 1000);
 	bool first = true;
-	for(uint16_t i = 0; i < size; i++) {
-		pos += snprintf_P(buf+pos, BufferSize-pos, PSTR("%s%d"), first ? "" : ",", rtp->getValue(offset+i));
-		first = false;
-		delay(1);
+	for(uint16_t i = 0; i < size; i += REALTIME_CHUNK) {
+		uint16_t count = rtp->getValues(offset + i, min((uint16_t) REALTIME_CHUNK, (uint16_t) (size - i)), values, minmax ? mins : NULL, minmax ? maxs : NULL);
+		for(uint16_t j = 0; j < count; j++) {
+			if(minmax) {
+				pos += snprintf_P(buf+pos, BufferSize-pos, PSTR("%s[%d,%d,%d]"), first ? "" : ",", values[j], mins[j], maxs[j]);
+			} else {
+				pos += snprintf_P(buf+pos, BufferSize-pos, PSTR("%s%d"), first ? "" : ",", values[j]);
+			}
+			first = false;
+		}
+		server.sendContent(buf, pos);
+		pos = 0;
+		if(count == 0) break;
 	}
-	pos += snprintf_P(buf+pos, BufferSize-pos, PSTR("]}"));
-	server.send(200, MIME_JSON, buf);
+	if(pos > 0) server.sendContent(buf, pos);
+	server.sendContent_P(PSTR("]}"));
 }
 
 void AmsWebServer::setPriceSettings(String region, String currency) {
@@ -2730,7 +2845,7 @@ void AmsWebServer::configFileDownload() {
 		EnergyAccountingConfig eac;
 		config->getEnergyAccountingConfig(eac);
 
-		if(eac.thresholds[9] > 0) server.sendContent(buf, snprintf_P(buf, BufferSize, PSTR("thresholds %d %d %d %d %d %d %d %d %d %d %d\n"), 
+		if(eac.thresholds[9] > 0) server.sendContent(buf, snprintf_P(buf, BufferSize, PSTR("thresholds %d %d %d %d %d %d %d %d %d %d %d %d\n"), 
 			eac.thresholds[0],
 			eac.thresholds[1],
 			eac.thresholds[2],
@@ -2741,7 +2856,8 @@ void AmsWebServer::configFileDownload() {
 			eac.thresholds[7],
 			eac.thresholds[8],
 			eac.thresholds[9],
-			eac.hours
+			eac.hours,
+			eac.demandModel
 		));
 	}
 
@@ -49,6 +49,7 @@
 #include "LittleFS.h"
 
 #define WIFI_TEST_TIMEOUT 30000
+#define REALTIME_CHUNK 50 // realtime.json values per chunk
 
 class AmsWebServer {
 public:
@@ -147,6 +148,7 @@ private:
     void sysinfoJson();
     void dataJson();
 	void dayplotJson();
+	void quarterplotJson();
 	void monthplotJson();
 	void energyPriceJson(); // Deprecated
 	void importPriceJson();
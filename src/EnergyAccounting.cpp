@@ -65,6 +65,7 @@ bool EnergyAccounting::update(time_t now, uint64_t lastUpdatedMillis, uint8_t li
     tmElements_t local;
     breakTime(tz->toLocal(now), local);
 
+    demand.setModel(config->demandModel, config->hours);
     if(!init) {
         realtimeData->lastImportUpdateMillis = 0;
         realtimeData->lastExportUpdateMillis = 0;
@@ -89,6 +90,8 @@ bool EnergyAccounting::update(time_t now, uint64_t lastUpdatedMillis, uint8_t li
         calcDayCost();
     }
 
+    ret |= demand.update(tz->toLocal(now), local.Month, lastUpdatedMillis, activeImportPower);
+
     if(local.Hour != realtimeData->currentHour && (listType >= 3 || local.Minute == 1)) {
         tmElements_t oneHrAgo, oneHrAgoLocal;
         breakTime(now-3600, oneHrAgo);
@@ -153,6 +156,7 @@ bool EnergyAccounting::update(time_t now, uint64_t lastUpdatedMillis, uint8_t li
             data.incomeToday = realtimeData->incomeDay * 100;
             data.lastUpdated = now;
         }
+        updateTotals(now);
     }
 
     if(realtimeData->lastImportUpdateMillis < lastUpdatedMillis) {
@@ -213,14 +217,15 @@ void EnergyAccounting::calcDayCost() {
         }
         for(uint8_t i = calcFromHour; i < realtimeData->currentHour; i++) {
             breakTime(now - ((local.Hour - i) * 3600), utc);
+            time_t hourStart = now - (now % SECS_PER_HOUR) - ((local.Hour - i) * SECS_PER_HOUR);
 
-            float priceIn = ps->getPriceForRelativeHour(PRICE_DIRECTION_IMPORT, i - local.Hour);
+            float priceIn = getHourPrice(PRICE_DIRECTION_IMPORT, hourStart, i - local.Hour);
             if(priceIn != PRICE_NO_VALUE) {
                 int16_t wh = ds->getHourImport(utc.Hour);
                 realtimeData->costDay += priceIn * (wh / 1000.0);
             }
 
-            float priceOut = ps->getPriceForRelativeHour(PRICE_DIRECTION_EXPORT, i - local.Hour);
+            float priceOut = getHourPrice(PRICE_DIRECTION_EXPORT, hourStart, i - local.Hour);
             if(priceOut != PRICE_NO_VALUE) {
                 int16_t wh = ds->getHourExport(utc.Hour);
                 realtimeData->incomeDay += priceOut * (wh / 1000.0);
@@ -230,32 +235,71 @@ void EnergyAccounting::calcDayCost() {
     }
 }
 
-float EnergyAccounting::getUseThisHour() {
-    return realtimeData->use;
+// Price for an hour weighted by what went through the meter in each of its
+// quarters, so 15 minute prices are not averaged away. Falls back to the
+// plain average when the quarters are no longer in the history.
+float EnergyAccounting::getHourPrice(uint8_t direction, time_t hourStart, int8_t relativeHour) {
+    float sum = 0;
+    uint32_t total = 0;
+    if(ps->getResolutionInMinutes() < 60) {
+        for(uint8_t q = 0; q < SECS_PER_HOUR / QUARTER_SECONDS; q++) {
+            time_t start = hourStart + (q * QUARTER_SECONDS);
+            int16_t ago = ds->getQuarterAgo(start);
+            float price = ago < 0 ? PRICE_NO_VALUE : ps->getPriceForTime(direction, start);
+            if(price == PRICE_NO_VALUE) {
+                total = 0;
+                break;
+            }
+            uint32_t wh = direction == PRICE_DIRECTION_EXPORT ? ds->getQuarterExport(ago) : ds->getQuarterImport(ago);
+            sum += price * wh;
+            total += wh;
+        }
+    }
+    if(total > 0) return sum / total;
+    return ps->getPriceForRelativeHour(direction, relativeHour);
 }
 
-float EnergyAccounting::getUseToday() {
-    if(tz == NULL) return 0.0;
-    float ret = 0.0;
+bool EnergyAccounting::checkTotals() {
+    if(tz == NULL || ds == NULL) return false;
     time_t now = time(nullptr);
-    if(now < FirmwareVersion::BuildEpoch) return 0.0;
+    if(now < FirmwareVersion::BuildEpoch) return false;
+    if(!totalsValid || totalsRevision != ds->getRevision()) {
+        updateTotals(now);
+    }
+    return true;
+}
+
+void EnergyAccounting::updateTotals(time_t now) {
+    if(tz == NULL || ds == NULL) return;
     tmElements_t utc, local;
     breakTime(tz->toLocal(now), local);
+    useDay = produceDay = 0;
     for(uint8_t i = 0; i < realtimeData->currentHour; i++) {
         breakTime(now - ((local.Hour - i) * 3600), utc);
-        ret += ds->getHourImport(utc.Hour) / 1000.0;
+        useDay += ds->getHourImport(utc.Hour) / 1000.0;
+        produceDay += ds->getHourExport(utc.Hour) / 1000.0;
+    }
+    useMonth = produceMonth = 0;
+    for(uint8_t i = 1; i < realtimeData->currentDay; i++) {
+        useMonth += ds->getDayImport(i) / 1000.0;
+        produceMonth += ds->getDayExport(i) / 1000.0;
     }
-    return ret + getUseThisHour();
+    totalsRevision = ds->getRevision();
+    totalsValid = true;
+}
+
+float EnergyAccounting::getUseThisHour() {
+    return realtimeData->use;
+}
+
+float EnergyAccounting::getUseToday() {
+    if(!checkTotals()) return 0.0;
+    return useDay + getUseThisHour();
 }
 
 float EnergyAccounting::getUseThisMonth() {
-    time_t now = time(nullptr);
-    if(now < FirmwareVersion::BuildEpoch) return 0.0;
-    float ret = 0;
-    for(uint8_t i = 1; i < realtimeData->currentDay; i++) {
-        ret += ds->getDayImport(i) / 1000.0;
-    }
-    return ret + getUseToday();
+    if(!checkTotals()) return 0.0;
+    return useMonth + useDay + getUseThisHour();
 }
 
 float EnergyAccounting::getUseLastMonth() {
@@ -269,27 +313,13 @@ float EnergyAccounting::getProducedThisHour() {
 }
 
 float EnergyAccounting::getProducedToday() {
-    if(tz == NULL) return 0.0;
-    float ret = 0.0;
-    time_t now = time(nullptr);
-    if(now < FirmwareVersion::BuildEpoch) return 0.0;
-    tmElements_t utc, local;
-    breakTime(tz->toLocal(now), local);
-    for(uint8_t i = 0; i < realtimeData->currentHour; i++) {
-        breakTime(now - ((local.Hour - i) * 3600), utc);
-        ret += ds->getHourExport(utc.Hour) / 1000.0;
-    }
-    return ret + getProducedThisHour();
+    if(!checkTotals()) return 0.0;
+    return produceDay + getProducedThisHour();
 }
 
 float EnergyAccounting::getProducedThisMonth() {
-    time_t now = time(nullptr);
-    if(now < FirmwareVersion::BuildEpoch) return 0.0;
-    float ret = 0;
-    for(uint8_t i = 1; i < realtimeData->currentDay; i++) {
-        ret += ds->getDayExport(i) / 1000.0;
-    }
-    return ret + getProducedToday();
+    if(!checkTotals()) return 0.0;
+    return produceMonth + produceDay + getProducedThisHour();
 }
 
 float EnergyAccounting::getProducedLastMonth() {
@@ -410,17 +440,23 @@ EnergyAccountingPeak EnergyAccounting::getPeak(uint8_t num) {
     return EnergyAccountingPeak({0,0});
 }
 
+EnergyDemand* EnergyAccounting::getDemand() {
+    return &demand;
+}
+
+void EnergyAccounting::setJournal(AmsJournal* journal) {
+    this->journal = journal;
+}
+
 bool EnergyAccounting::load() {
-    if(!LittleFS.begin()) {
+    if(journal == NULL || !LittleFS.begin()) {
         return false;
     }
 
     bool ret = false;
-    if(LittleFS.exists(FILE_ENERGYACCOUNTING)) {
-        File file = LittleFS.open(FILE_ENERGYACCOUNTING, "r");
-        char buf[file.size()];
-        file.readBytes(buf, file.size());
-
+    // Zeroed and sized for the larger of the layouts
+    uint8_t buf[sizeof(EnergyAccountingData) > sizeof(EnergyAccountingData6) ? sizeof(EnergyAccountingData) : sizeof(EnergyAccountingData6)] = {};
+    if(journal->load(JournalEnergyAccounting, FILE_ENERGYACCOUNTING, buf, sizeof(buf)) > 0) {
         if(buf[0] == 7) {
             EnergyAccountingData* data = (EnergyAccountingData*) buf;
             memcpy(&this->data, data, sizeof(this->data));
@@ -447,27 +483,25 @@ bool EnergyAccounting::load() {
             };
             ret = true;
         }
+    }
 
-        file.close();
+    // Model first, peaks of another model are not taken
+    if(config != NULL) demand.setModel(config->demandModel, config->hours);
+    EnergyDemandData demandData = {};
+    if(journal->read(JournalDemand, &demandData, sizeof(demandData)) > 0) {
+        demand.setData(demandData);
     }
 
     return ret;
 }
 
 bool EnergyAccounting::save() {
-    if(!LittleFS.begin()) {
+    if(journal == NULL || !LittleFS.begin()) {
         return false;
     }
-    {
-        File file = LittleFS.open(FILE_ENERGYACCOUNTING, "w");
-        char buf[sizeof(data)];
-        memcpy(buf, &data, sizeof(data));
-        for(uint8_t i = 0; i < sizeof(buf); i++) {
-            file.write(buf[i]);
-        }
-        file.close();
-    }
-    return true;
+    EnergyDemandData demandData = demand.getData();
+    bool ret = journal->write(JournalDemand, &demandData, sizeof(demandData));
+    return journal->save(JournalEnergyAccounting, FILE_ENERGYACCOUNTING, &data, sizeof(data)) && ret;
 }
 
 EnergyAccountingData EnergyAccounting::getData() {
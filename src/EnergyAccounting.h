@@ -9,6 +9,7 @@
 
 #include "AmsDataStorage.h"
 #include "PriceService.h"
+#include "EnergyDemand.h"
 
 struct EnergyAccountingPeak {
     uint8_t day;
@@ -80,6 +81,8 @@ public:
     void setup(AmsDataStorage *ds, EnergyAccountingConfig *config);
     void setPriceService(PriceService *ps);
     void setTimezone(Timezone*);
+    // Where load() and save() keep the data, required for both
+    void setJournal(AmsJournal*);
     EnergyAccountingConfig* getConfig();
     bool update(time_t now, uint64_t lastUpdatedMillis, uint8_t listType, uint32_t activeImportPower, uint32_t activeExportPower);
     bool load();
@@ -111,6 +114,8 @@ public:
     float getMonthMax();
     uint8_t getCurrentThreshold();
     EnergyAccountingPeak getPeak(uint8_t);
+    // Running demand and its peaks, fed with every update()
+    EnergyDemand* getDemand();
 
     EnergyAccountingData getData();
     void setData(EnergyAccountingData&);
@@ -128,11 +133,23 @@ private:
     PriceService *ps = NULL;
     EnergyAccountingConfig *config = NULL;
     Timezone *tz = NULL;
+    AmsJournal *journal = NULL;
     EnergyAccountingData data = { 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
     EnergyAccountingRealtimeData* realtimeData = NULL;
+    EnergyDemand demand;
     String currency = "";
 
+    // Import and export over the completed hours of today and the completed
+    // days of this month, in kWh. Rebuilt by updateTotals() when the hour
+    // rolls over or the data storage changes, so the getters need no loops.
+    float useDay = 0, produceDay = 0, useMonth = 0, produceMonth = 0;
+    uint32_t totalsRevision = 0;
+    bool totalsValid = false;
+
+    bool checkTotals();
+    void updateTotals(time_t now);
     void calcDayCost();
+    float getHourPrice(uint8_t direction, time_t hourStart, int8_t relativeHour);
     bool updateMax(uint16_t val, uint8_t day, uint8_t hour);
 };
 
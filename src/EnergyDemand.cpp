@@ -0,0 +1,229 @@
+/**
+ * @copyright Utilitech AS 2023-2026
+ * License: Fair Source
+ *
+ */
+
+#include "EnergyDemand.h"
+#include <string.h>
+
+#define DEMAND_VERSION 1
+#define DEMAND_SECS_PER_DAY 86400
+
+void EnergyDemand::setModel(uint8_t model, uint8_t peaks) {
+    if(model > DEMAND_MODEL_MAX) model = DEMAND_MODEL_HOUR_DAILY;
+    if(model != this->model) {
+        // Peaks of another interval length say nothing about this one
+        this->model = model;
+        count = 0;
+    }
+    if(peaks < 1) peaks = 1;
+    if(peaks > DEMAND_PEAKS) peaks = DEMAND_PEAKS;
+    maxPeaks = peaks;
+    if(count > maxPeaks) count = maxPeaks;
+}
+
+uint8_t EnergyDemand::getModel() {
+    return model;
+}
+
+bool EnergyDemand::update(time_t local, uint8_t month, uint64_t millis, uint32_t importPower) {
+    uint32_t ms = 0;
+    if(lastMillis > 0 && millis > lastMillis && millis - lastMillis <= DEMAND_HOUR * 1000UL) {
+        ms = millis - lastMillis;
+    }
+    lastMillis = millis;
+    lastLocal = local;
+    power = importPower;
+
+    bool ret = false;
+    DemandPeak closed;
+    if(advance(quarter, DEMAND_QUARTER, local, ms, closed) && billedLength() == DEMAND_QUARTER) {
+        ret |= addPeak(closed.start, closed.value);
+    }
+    if(advance(hour, DEMAND_HOUR, local, ms, closed) && billedLength() == DEMAND_HOUR) {
+        ret |= addPeak(closed.start, closed.value);
+    }
+
+    // After closing, so the last interval of a month is billed with it
+    // and does not carry over into the next one
+    if(month != this->month) {
+        if(this->month != 0) {
+            lastMonthAverage = getPeakAverage();
+            if(count > 0) {
+                count = 0;
+                ret = true;
+            }
+        }
+        this->month = month;
+    }
+    return ret;
+}
+
+// Adds the ms up to local to the interval local falls in, closing the one
+// before it if local has moved on. ms spanning the boundary is split.
+bool EnergyDemand::advance(DemandInterval& interval, uint32_t length, uint32_t local, uint32_t ms, DemandPeak& closed) {
+    uint32_t start = local - (local % length);
+    if(ms > length * 1000UL) ms = 0;
+    uint32_t inCurrent = ms;
+    bool ret = false;
+    if(interval.start != start) {
+        if(interval.start != 0) {
+            uint32_t sinceStart = (local - start) * 1000UL;
+            if(inCurrent > sinceStart) inCurrent = sinceStart;
+            if(interval.start + length == start) {
+                interval.energy += (uint64_t) power * (ms - inCurrent);
+                interval.covered += ms - inCurrent;
+            }
+            // Too little of it seen to say what it was
+            if(interval.covered >= length * 1000UL / 3) {
+                closed = { interval.start, average(interval) };
+                ret = true;
+            }
+        }
+        interval = { start, 0, 0 };
+    }
+    interval.energy += (uint64_t) power * inCurrent;
+    interval.covered += inCurrent;
+    return ret;
+}
+
+uint32_t EnergyDemand::average(DemandInterval& interval) {
+    if(interval.covered == 0) return 0;
+    return interval.energy / interval.covered;
+}
+
+uint32_t EnergyDemand::projection(DemandInterval& interval, uint32_t length) {
+    if(interval.start == 0 || lastLocal < interval.start) return 0;
+    uint32_t elapsed = lastLocal - interval.start;
+    if(elapsed >= length) return average(interval);
+    return (((uint64_t) average(interval) * elapsed) + ((uint64_t) power * (length - elapsed))) / length;
+}
+
+uint32_t EnergyDemand::getQuarterAverage() {
+    return average(quarter);
+}
+
+uint32_t EnergyDemand::getQuarterProjection() {
+    return projection(quarter, DEMAND_QUARTER);
+}
+
+uint32_t EnergyDemand::getHourAverage() {
+    return average(hour);
+}
+
+uint32_t EnergyDemand::getHourProjection() {
+    return projection(hour, DEMAND_HOUR);
+}
+
+DemandInterval& EnergyDemand::billedInterval() {
+    return billedLength() == DEMAND_QUARTER ? quarter : hour;
+}
+
+uint32_t EnergyDemand::billedLength() {
+    return model == DEMAND_MODEL_QUARTER || model == DEMAND_MODEL_QUARTER_DAILY ? DEMAND_QUARTER : DEMAND_HOUR;
+}
+
+bool EnergyDemand::isDaily() {
+    return model == DEMAND_MODEL_HOUR_DAILY || model == DEMAND_MODEL_QUARTER_DAILY;
+}
+
+int8_t EnergyDemand::findSameDay(uint32_t start) {
+    for(uint8_t i = 0; i < count; i++) {
+        if(peaks[i].start / DEMAND_SECS_PER_DAY == start / DEMAND_SECS_PER_DAY) return i;
+    }
+    return -1;
+}
+
+// Peaks are kept highest first, so this is at most one pass over DEMAND_PEAKS
+bool EnergyDemand::addPeak(uint32_t start, uint32_t value) {
+    if(value == 0) return false;
+    int8_t idx = isDaily() ? findSameDay(start) : -1;
+    if(idx >= 0) {
+        if(value <= peaks[idx].value) return false;
+        for(uint8_t i = idx; i < count - 1; i++) {
+            peaks[i] = peaks[i+1];
+        }
+        count--;
+    } else if(count >= maxPeaks) {
+        if(value <= peaks[count-1].value) return false;
+        count = maxPeaks - 1;
+    }
+    uint8_t i = count;
+    while(i > 0 && peaks[i-1].value < value) {
+        peaks[i] = peaks[i-1];
+        i--;
+    }
+    peaks[i] = { start, value };
+    count++;
+    return true;
+}
+
+uint8_t EnergyDemand::getPeakCount() {
+    return count;
+}
+
+DemandPeak EnergyDemand::getPeak(uint8_t idx) {
+    if(idx >= count) return DemandPeak({0,0});
+    return peaks[idx];
+}
+
+uint32_t EnergyDemand::getPeakAverage() {
+    if(count == 0) return 0;
+    uint32_t sum = 0;
+    for(uint8_t i = 0; i < count; i++) {
+        sum += peaks[i].value;
+    }
+    return sum / count;
+}
+
+uint32_t EnergyDemand::getLastMonthPeakAverage() {
+    return lastMonthAverage;
+}
+
+uint32_t EnergyDemand::getPeakThreshold() {
+    if(isDaily()) {
+        // Today already has a peak, only beating it counts
+        int8_t idx = findSameDay(billedInterval().start);
+        if(idx >= 0) return peaks[idx].value;
+    }
+    if(count < maxPeaks) return 0;
+    return peaks[count-1].value;
+}
+
+bool EnergyDemand::isPeakWarning() {
+    uint32_t threshold = getPeakThreshold();
+    return threshold > 0 && projection(billedInterval(), billedLength()) > threshold;
+}
+
+EnergyDemandData EnergyDemand::getData() {
+    EnergyDemandData data;
+    memset(&data, 0, sizeof(data));
+    data.version = DEMAND_VERSION;
+    data.model = model;
+    data.month = month;
+    data.count = count;
+    for(uint8_t i = 0; i < DEMAND_PEAKS; i++) {
+        data.peaks[i] = i < count ? peaks[i] : DemandPeak({0,0});
+    }
+    return data;
+}
+
+void EnergyDemand::setData(EnergyDemandData& data) {
+    if(data.version != DEMAND_VERSION || data.model != model) return;
+    month = data.month;
+    count = data.count > maxPeaks ? maxPeaks : data.count;
+    for(uint8_t i = 0; i < count; i++) {
+        peaks[i] = data.peaks[i];
+    }
+}
+
+void EnergyDemand::reset() {
+    count = 0;
+    lastMonthAverage = 0;
+    quarter = { 0, 0, 0 };
+    hour = { 0, 0, 0 };
+    lastMillis = 0;
+    lastLocal = 0;
+    power = 0;
+}
@@ -0,0 +1,100 @@
+/**
+ * @copyright Utilitech AS 2023-2026
+ * License: Fair Source
+ *
+ */
+
+#ifndef _ENERGYDEMAND_H
+#define _ENERGYDEMAND_H
+
+#include <stdint.h>
+#include <time.h>
+
+#define DEMAND_PEAKS 5
+#define DEMAND_QUARTER 900
+#define DEMAND_HOUR 3600
+
+// What a capacity tariff bills on, always the average of the top N intervals of the month
+#define DEMAND_MODEL_HOUR_DAILY 0 // Hours, at most one per day (Norway, most of Sweden)
+#define DEMAND_MODEL_HOUR 1 // Hours, any day
+#define DEMAND_MODEL_QUARTER 2 // Quarter-hours, any day (Belgium with N = 1)
+#define DEMAND_MODEL_QUARTER_DAILY 3 // Quarter-hours, at most one per day
+#define DEMAND_MODEL_MAX 3
+
+struct DemandPeak {
+    uint32_t start; // Local time the interval started
+    uint32_t value; // Average import power, W
+};
+
+struct EnergyDemandData {
+    uint8_t version;
+    uint8_t model;
+    uint8_t month;
+    uint8_t count;
+    DemandPeak peaks[DEMAND_PEAKS];
+};
+
+// Running average of one clock-aligned interval
+struct DemandInterval {
+    uint32_t start; // Local time, 0 before the first sample
+    uint64_t energy; // Ws * 1000
+    uint32_t covered; // ms of the interval seen in samples
+};
+
+// Average import power over the running quarter-hour and hour, where they
+// are heading and the top peaks of the month for the configured tariff
+// model. Each sample costs the same regardless of how long it has run.
+class EnergyDemand {
+public:
+    void setModel(uint8_t model, uint8_t peaks);
+    uint8_t getModel();
+
+    // local is the local time of the sample and month its local month,
+    // millis when it was taken. True when the peaks changed.
+    bool update(time_t local, uint8_t month, uint64_t millis, uint32_t importPower);
+
+    // Average so far and projected end value, assuming the current power holds, in W
+    uint32_t getQuarterAverage();
+    uint32_t getQuarterProjection();
+    uint32_t getHourAverage();
+    uint32_t getHourProjection();
+
+    uint8_t getPeakCount();
+    DemandPeak getPeak(uint8_t idx); // Highest first
+    uint32_t getPeakAverage(); // What the tariff bills on, W
+    // What the month before billed on, W. Not persisted, 0 until a month has closed here
+    uint32_t getLastMonthPeakAverage();
+    // Value the running interval has to beat to become a peak, 0 while any will do
+    uint32_t getPeakThreshold();
+    // The running interval is projected to become a peak
+    bool isPeakWarning();
+
+    EnergyDemandData getData();
+    void setData(EnergyDemandData& data);
+    void reset();
+
+private:
+    uint8_t model = DEMAND_MODEL_HOUR_DAILY;
+    uint8_t maxPeaks = 3;
+    uint8_t count = 0;
+    DemandPeak peaks[DEMAND_PEAKS];
+
+    DemandInterval quarter = { 0, 0, 0 };
+    DemandInterval hour = { 0, 0, 0 };
+    uint32_t lastLocal = 0;
+    uint64_t lastMillis = 0;
+    uint32_t power = 0;
+    uint8_t month = 0;
+    uint32_t lastMonthAverage = 0;
+
+    bool advance(DemandInterval& interval, uint32_t length, uint32_t local, uint32_t ms, DemandPeak& closed);
+    uint32_t average(DemandInterval& interval);
+    uint32_t projection(DemandInterval& interval, uint32_t length);
+    DemandInterval& billedInterval();
+    uint32_t billedLength();
+    bool isDaily();
+    int8_t findSameDay(uint32_t start);
+    bool addPeak(uint32_t start, uint32_t value);
+};
+
+#endif
@@ -1,11 +1,21 @@
 /**
  * @copyright Utilitech AS 2023-2026
  * License: Fair Source
- * 
+ *
  */
 
 #include "EntsoeA44Parser.h"
-#include "HardwareSerial.h"
+
+#define A44_TAG_CURRENCY a44TagHash("currency_Unit.name")
+#define A44_TAG_MEASUREMENTUNIT a44TagHash("price_Measure_Unit.name")
+#define A44_TAG_RESOLUTION a44TagHash("resolution")
+#define A44_TAG_POSITION a44TagHash("position")
+#define A44_TAG_AMOUNT a44TagHash("price.amount")
+#define A44_TAG_PERIOD_END a44TagHash("/Period")
+
+#define A44_MAX_NUMBER 100000000 // Further digits are dropped, only ever fractions in practice
+
+static const double A44_POW10[] = { 1, 10, 100, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9 };
 
 EntsoeA44Parser::EntsoeA44Parser(PricesContainer *container) {
     this->container = container;
@@ -32,95 +42,145 @@ void EntsoeA44Parser::flush() {
 }
 
 size_t EntsoeA44Parser::write(const uint8_t *buffer, size_t size) {
-    for(size_t i = 0; i < size; i++) {
+    for(size_t i = 0; i < size && docPos != DOCPOS_DONE; i++) {
         write(buffer[i]);
     }
     return size;
 }
 
 size_t EntsoeA44Parser::write(uint8_t byte) {
-    if(pos >= 64) pos = 0;
-    if(docPos == DOCPOS_CURRENCY) {
-        buf[pos++] = byte;
-        if(pos == 3) {
-            buf[pos++] = '\0';
-            container->setCurrency(buf);
-            docPos = DOCPOS_SEEK;
-            pos = 0;
-        }
-    } else if(docPos == DOCPOS_MEASUREMENTUNIT) {
-        buf[pos++] = byte;
-        if(pos == 3) {
-            buf[pos++] = '\0';
-            if(strcmp_P(buf, PSTR("MWH"))) multiplier = 0.001;
-            docPos = DOCPOS_SEEK;
-            pos = 0;
-        }
-    } else if(docPos == DOCPOS_POSITION) {
-        if(byte == '<') {
-            buf[pos] = '\0';
-            long pn = String(buf).toInt() - 1;
-            if(pn < container->getNumberOfPoints()) {
-                pointNum = pn;
+    switch(docPos) {
+        case DOCPOS_DONE:
+            break;
+        case DOCPOS_SEEK:
+            if(byte == '<') startTag();
+            break;
+        case DOCPOS_TAG:
+            if(byte == '>') {
+                endTag();
+            } else if(inName) {
+                // Attributes are not part of the name
+                if(byte == ' ' || byte == '\t' || byte == '\r' || byte == '\n') {
+                    inName = false;
+                } else {
+                    hash = (hash ^ byte) * 16777619UL;
+                }
             }
-            docPos = DOCPOS_SEEK;
-            pos = 0;
-        } else {
-            buf[pos++] = byte;
-        }
-    } else if(docPos == DOCPOS_AMOUNT) {
-        if(byte == '<') {
-            buf[pos] = '\0';
-            float val = String(buf).toFloat();
-            for(uint8_t i = pointNum; i < container->getNumberOfPoints(); i++) {
-                container->setPrice(i, val * multiplier, PRICE_DIRECTION_IMPORT);
+            break;
+        case DOCPOS_POSITION:
+        case DOCPOS_AMOUNT:
+            if(byte == '<') {
+                endValue();
+                startTag();
+            } else if(byte >= '0' && byte <= '9') {
+                if(number < A44_MAX_NUMBER) {
+                    number = (number * 10) + (byte - '0');
+                    if(decimals >= 0) decimals++;
+                }
+            } else if(byte == '.') {
+                decimals = 0;
+            } else if(byte == '-') {
+                negative = true;
             }
-            docPos = DOCPOS_SEEK;
-            pos = 0;
-        } else {
-            buf[pos++] = byte;
-        }
-    } else if(docPos == DOCPOS_RESOLUTION) {
-        if(byte == '<') {
-            buf[pos] = '\0';
+            break;
+        default:
+            if(byte == '<') {
+                endValue();
+                if(docPos != DOCPOS_DONE) startTag();
+            } else if(pos < sizeof(buf) - 1) {
+                buf[pos++] = byte;
+            }
+            break;
+    }
+    return 1;
+}
 
-            // This happens if there are two time series in the XML. We are only interrested in the first one, so we ignore the rest of the document
-            if(container->hasPrice(0, PRICE_DIRECTION_IMPORT)) return 1;
+void EntsoeA44Parser::startTag() {
+    docPos = DOCPOS_TAG;
+    hash = a44TagHash("");
+    inName = true;
+}
 
-            if(strcmp_P(buf, PSTR("PT15M"))) {
+void EntsoeA44Parser::endTag() {
+    docPos = DOCPOS_SEEK;
+    switch(hash) {
+        case A44_TAG_CURRENCY:
+            startValue(DOCPOS_CURRENCY);
+            break;
+        case A44_TAG_MEASUREMENTUNIT:
+            startValue(DOCPOS_MEASUREMENTUNIT);
+            break;
+        case A44_TAG_RESOLUTION:
+            startValue(DOCPOS_RESOLUTION);
+            break;
+        case A44_TAG_POSITION:
+            pointNum = 0xFF;
+            startValue(DOCPOS_POSITION);
+            break;
+        case A44_TAG_AMOUNT:
+            startValue(DOCPOS_AMOUNT);
+            break;
+        case A44_TAG_PERIOD_END:
+            // Points omitted at the end of the period repeat the last price
+            fill(numberOfPoints);
+            break;
+    }
+}
+
+void EntsoeA44Parser::startValue(uint8_t docPos) {
+    this->docPos = docPos;
+    pos = 0;
+    number = 0;
+    decimals = -1;
+    negative = false;
+}
+
+void EntsoeA44Parser::endValue() {
+    uint8_t ended = docPos;
+    docPos = DOCPOS_SEEK;
+    buf[pos] = '\0';
+    switch(ended) {
+        case DOCPOS_CURRENCY:
+            buf[3] = '\0';
+            container->setCurrency(buf);
+            break;
+        case DOCPOS_MEASUREMENTUNIT:
+            if(strcmp_P(buf, PSTR("MWH")) == 0) multiplier = 0.001;
+            break;
+        case DOCPOS_RESOLUTION:
+            // This happens if there are two time series in the XML. We are only interrested in the first one, so we ignore the rest of the document
+            if(numberOfPoints > 0) {
+                docPos = DOCPOS_DONE;
+            } else if(strcmp_P(buf, PSTR("PT15M")) == 0) {
                 container->setup(15, 100, false);
-            } else if(strcmp_P(buf, PSTR("PT60M"))) {
+                numberOfPoints = 100;
+            } else if(strcmp_P(buf, PSTR("PT60M")) == 0) {
                 container->setup(60, 25, false);
+                numberOfPoints = 25;
             }
-            docPos = DOCPOS_SEEK;
-            pos = 0;
-        } else {
-            buf[pos++] = byte;
-        }
-    } else {
-        if(pos == 0) {
-            if(byte == '<') {
-                buf[pos++] = byte;
+            break;
+        case DOCPOS_POSITION:
+            if(number >= 1 && number <= numberOfPoints) {
+                pointNum = number - 1;
             }
-        } else if(byte == '>') {
-            buf[pos++] = byte;
-            buf[pos] = '\0';
-            if(strcmp_P(buf, PSTR("<currency_Unit.name>")) == 0) {
-                docPos = DOCPOS_CURRENCY;
-            } else if(strcmp(buf, PSTR("<price_Measure_Unit.name>")) == 0) {
-                docPos = DOCPOS_MEASUREMENTUNIT;
-            } else if(strcmp(buf, PSTR("<position>")) == 0) {
-                docPos = DOCPOS_POSITION;
-                pointNum = 0xFF;
-            } else if(strcmp(buf, PSTR("<price.amount>")) == 0) {
-                docPos = DOCPOS_AMOUNT;
-            } else if(strcmp(buf, PSTR("<resolution>")) == 0) {
-                docPos = DOCPOS_RESOLUTION;
+            break;
+        case DOCPOS_AMOUNT:
+            if(pointNum < numberOfPoints) {
+                // Curve type A03 leaves out points with the same price as the one before
+                fill(pointNum);
+                double val = number / A44_POW10[decimals > 0 ? decimals : 0];
+                lastValue = (negative ? -val : val) * multiplier;
+                container->setPrice(pointNum, lastValue, PRICE_DIRECTION_IMPORT);
+                lastPoint = pointNum;
             }
-            pos = 0;
-        } else {
-            buf[pos++] = byte;
-        }
+            break;
     }
-    return 1;
+}
+
+void EntsoeA44Parser::fill(int16_t to) {
+    if(lastPoint < 0) return;
+    for(int16_t i = lastPoint + 1; i < to; i++) {
+        container->setPrice(i, lastValue, PRICE_DIRECTION_IMPORT);
+    }
+    lastPoint = to - 1;
 }
@@ -1,7 +1,7 @@
 /**
  * @copyright Utilitech AS 2023-2026
  * License: Fair Source
- * 
+ *
  */
 
 #ifndef _ENTSOEA44PARSER_H
@@ -16,7 +16,16 @@
 #define DOCPOS_POSITION 3
 #define DOCPOS_AMOUNT 4
 #define DOCPOS_RESOLUTION 5
+#define DOCPOS_TAG 6 // Between < and >, hashing the name
+#define DOCPOS_DONE 7 // Rest of the document is ignored
 
+// FNV-1a of a tag name, so the tags of interest are constants in a switch
+constexpr uint32_t a44TagHash(const char* s, uint32_t hash = 2166136261UL) {
+    return *s ? a44TagHash(s + 1, (hash ^ (uint8_t) *s) * 16777619UL) : hash;
+}
+
+// Parses an ENTSO-E A44 (day-ahead prices) document as it is written to it,
+// in any chunk size, without buffering tags or allocating
 class EntsoeA44Parser: public Stream {
 public:
     EntsoeA44Parser(PricesContainer *container);
@@ -32,11 +41,28 @@ public:
 private:
     PricesContainer *container;
     float multiplier = 1.0;
+    uint8_t numberOfPoints = 0; // 0 until <resolution> has set up the container
 
-    char buf[64];
+    uint8_t docPos = DOCPOS_SEEK;
+    // Tag being read
+    uint32_t hash = 0;
+    bool inName = false;
+    // Text value being read, short ones kept as is, numbers accumulated
+    char buf[8];
     uint8_t pos = 0;
-    uint8_t docPos = 0;
-    uint8_t pointNum = 0;
+    int32_t number = 0;
+    int8_t decimals = -1; // -1 before the decimal point
+    bool negative = false;
+
+    uint8_t pointNum = 0xFF;
+    int16_t lastPoint = -1; // Last point given a price, later omitted points repeat it
+    float lastValue = 0;
+
+    void startTag();
+    void endTag();
+    void startValue(uint8_t docPos);
+    void endValue();
+    void fill(int16_t to);
 };
 
 #endif
@@ -290,70 +290,107 @@ TempSensorData* HwTools::getTempSensorData(uint8_t i) {
     return NULL;
 }
 
+bool HwTools::setTempSensorResolution(uint8_t i, uint8_t bits) {
+    if(i >= sensorCount || bits < TEMP_RESOLUTION_MIN || bits > TEMP_RESOLUTION_MAX) return false;
+    if(tempSensors[i]->resolution != bits) {
+        tempSensors[i]->requestedResolution = bits;
+    }
+    return true;
+}
+
 bool HwTools::updateTemperatures() {
     if(tempPin != 0xFF) {
         if(!tempSensorInit) {
             oneWire = new OneWire(tempPin);
             sensorApi = new DallasTemperature(this->oneWire);
             sensorApi->begin();
-            delay(100);
+            // requestTemperatures() only starts the conversion, it is read on a later call
+            sensorApi->setWaitForConversion(false);
             tempSensorInit = true;
+            tempConverting = false;
+            findTempSensors();
+        }
+        if(sensorCount == 0) {
+            return true;
+        }
 
-            DeviceAddress addr;
-            sensorApi->requestTemperatures();
-            int c = sensorApi->getDeviceCount();
-            if(this->tempSensors != NULL) {
-                delete this->tempSensors;
-            }
-            this->tempSensors = new TempSensorData*[c];
-            for(int i = 0; i < c; i++) {
-                bool found = false;
-                sensorApi->getAddress(addr, i);
-                float t = sensorApi->getTempC(addr);
-                for(int x = 0; x < sensorCount; x++) {
-                    TempSensorData *data = tempSensors[x];
-                    if(isSensorAddressEqual(data->address, addr)) {
-                        found = true;
-                        data->lastRead = t;
-                        if(t > -85) {
-                            data->changed = data->lastValidRead != t;
-                            data->lastValidRead = t;
-                        }
-                    }
-                }
-                if(!found) {
-                    TempSensorData *data = new TempSensorData();
-                    memcpy(data->address, addr, 8);
-                    data->lastRead = t;
-                    if(t > -85) {
-                        data->changed = data->lastValidRead != t;
-                        data->lastValidRead = t;
-                    }
-                    tempSensors[sensorCount++] = data;
-                }
-                yield();
-            }
-        } else {
-            if(sensorCount > 0) {
-                sensorApi->requestTemperatures();
-
-                for(int x = 0; x < sensorCount; x++) {
-                    TempSensorData *data = tempSensors[x];
-                    float t = sensorApi->getTempC(data->address);
-                    data->lastRead = t;
-                    if(t > -85) {
-                        data->changed = data->lastValidRead != t;
-                        data->lastValidRead = t;
-                    }
+        if(!tempConverting) {
+            tempConversionMs = 0;
+            for(int x = 0; x < sensorCount; x++) {
+                TempSensorData *data = tempSensors[x];
+                if(data->requestedResolution > 0) {
+                    sensorApi->setResolution(data->address, data->requestedResolution);
+                    data->resolution = sensorApi->getResolution(data->address);
+                    data->requestedResolution = 0;
                 }
+                // All sensors convert at once, the slowest decides
+                uint8_t bits = data->resolution < TEMP_RESOLUTION_MIN ? TEMP_RESOLUTION_MAX : data->resolution;
+                uint16_t ms = 750 >> (TEMP_RESOLUTION_MAX - bits);
+                if(ms > tempConversionMs) tempConversionMs = ms;
             }
+            sensorApi->requestTemperatures();
+            tempConversionStart = millis();
+            tempConverting = true;
+            return false;
         }
 
+        if(millis() - tempConversionStart < tempConversionMs) {
+            return false;
+        }
+        tempConverting = false;
+        for(int x = 0; x < sensorCount; x++) {
+            TempSensorData *data = tempSensors[x];
+            float t = sensorApi->getTempC(data->address);
+            data->lastRead = t;
+            if(t > -85) {
+                data->changed = data->lastValidRead != t;
+                data->lastValidRead = t;
+            }
+        }
         return true;
     }
     return false;
 }
 
+// Sensors on the bus, keeping the readings of those already known
+void HwTools::findTempSensors() {
+    TempSensorData** known = tempSensors;
+    uint8_t knownCount = sensorCount;
+
+    DeviceAddress addr;
+    int c = sensorApi->getDeviceCount();
+    tempSensors = new TempSensorData*[c];
+    sensorCount = 0;
+    for(int i = 0; i < c; i++) {
+        if(!sensorApi->getAddress(addr, i)) continue;
+        TempSensorData *data = NULL;
+        for(int x = 0; x < knownCount; x++) {
+            if(known[x] != NULL && isSensorAddressEqual(known[x]->address, addr)) {
+                data = known[x];
+                known[x] = NULL;
+                break;
+            }
+        }
+        if(data == NULL) {
+            data = new TempSensorData();
+            memcpy(data->address, addr, 8);
+            data->lastRead = DEVICE_DISCONNECTED_C;
+            data->lastValidRead = DEVICE_DISCONNECTED_C;
+        }
+        data->resolution = sensorApi->getResolution(addr);
+        data->requestedResolution = 0;
+        tempSensors[sensorCount++] = data;
+        yield();
+    }
+
+    if(known != NULL) {
+        for(int x = 0; x < knownCount; x++) {
+            if(known[x] != NULL) delete known[x];
+        }
+        delete[] known;
+    }
+}
+
 bool HwTools::isSensorAddressEqual(uint8_t a[8], uint8_t b[8]) {
     for(int i = 0; i < 8; i++) {
         if(a[i] != b[i]) return false;
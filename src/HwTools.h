@@ -25,11 +25,16 @@
 #define LED_BLUE 3
 #define LED_YELLOW 4
 
+#define TEMP_RESOLUTION_MIN 9
+#define TEMP_RESOLUTION_MAX 12
+
 struct TempSensorData {
     uint8_t address[8];
     float lastRead;
     float lastValidRead;
     bool changed;
+    uint8_t resolution; // Bits, as read from the sensor
+    uint8_t requestedResolution; // Written to the sensor before the next conversion, 0 for none
 };
 
 class HwTools {
@@ -40,6 +45,10 @@ public:
     void setMaxVcc(float maxVcc);
     uint8_t getTempSensorCount();
     TempSensorData* getTempSensorData(uint8_t);
+    // 9 to 12 bits, kept by the sensor itself. Conversion takes 94 to 750 ms.
+    bool setTempSensorResolution(uint8_t, uint8_t bits);
+    // Starts a conversion on one call and collects it on a later one, never
+    // waiting for it. True when new readings are in.
     bool updateTemperatures();
     float getTemperature();
     float getTemperatureAnalog();
@@ -73,6 +82,9 @@ private:
     DallasTemperature *sensorApi = NULL;
     uint8_t sensorCount = 0;
     TempSensorData** tempSensors = NULL;
+    bool tempConverting = false;
+    unsigned long tempConversionStart = 0;
+    uint16_t tempConversionMs = 0;
 
     bool bootSuccessful = false;
 
@@ -88,6 +100,7 @@ private:
     void applyLedDisablePin();
     bool ledColorAvailable(uint8_t color);
     bool isSensorAddressEqual(uint8_t a[8], uint8_t b[8]);
+    void findTempSensors();
 };
 
 #endif
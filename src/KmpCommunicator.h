@@ -29,7 +29,7 @@ public:
     #endif
     void configure(MeterConfig&);
     bool loop();
-    AmsData* getData(AmsData& meterState);
+    bool getData(AmsData& meterState, AmsData& data);
     int getLastError();
     void getCurrentConfig(MeterConfig& meterConfig) {
         meterConfig = this->meterConfig;
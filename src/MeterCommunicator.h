@@ -20,7 +20,9 @@ public:
     virtual ~MeterCommunicator() {};
     virtual void configure(MeterConfig&, Timezone*);
     virtual bool loop();
-    virtual AmsData* getData(AmsData& meterState);
+    // Decodes the latest frame into a caller-owned slot. Returns false when
+    // there is nothing new, in which case the slot is left untouched.
+    virtual bool getData(AmsData& meterState, AmsData& data);
     virtual int getLastError();
     virtual bool isConfigChanged();
     virtual void ackConfigChanged();
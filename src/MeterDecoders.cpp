@@ -0,0 +1,84 @@
+/**
+ * @copyright Utilitech AS 2023-2026
+ * License: Fair Source
+ * 
+ */
+
+#include "MeterDecoders.h"
+#include "IEC6205675.h"
+#include "LNG.h"
+#include "LNG2.h"
+
+// L&G proprietary format, a structure of an array of OBIS codes and the values
+static bool matchLng(const char* p) {
+    return p[0] == CosemTypeStructure && p[2] == CosemTypeArray && p[1] == p[3];
+}
+
+static bool decodeLng(DecoderInput& in, AmsData& data) {
+    LNG lngData = LNG(*in.state, in.payload, in.state->getMeterType(), in.meterConfig, *in.ctx);
+    if(lngData.getListType() < 1) return false;
+    data = AmsData();
+    data.apply(*in.state);
+    data.apply(lngData);
+    return true;
+}
+
+// L&G structure of long unsigned values
+static bool matchLng2(const char* p) {
+    return p[0] == CosemTypeStructure &&
+        p[2] == CosemTypeLongUnsigned &&
+        p[5] == CosemTypeLongUnsigned &&
+        p[8] == CosemTypeLongUnsigned &&
+        p[11] == CosemTypeLongUnsigned &&
+        p[14] == CosemTypeLongUnsigned &&
+        p[17] == CosemTypeLongUnsigned;
+}
+
+static bool decodeLng2(DecoderInput& in, AmsData& data) {
+    LNG2 lngData = LNG2(*in.state, in.payload, in.state->getMeterType(), in.meterConfig, *in.ctx);
+    if(lngData.getListType() < 1) return false;
+    data = AmsData();
+    data.apply(*in.state);
+    data.apply(lngData);
+    return true;
+}
+
+static bool matchKaifa(const char* p) {
+    return IEC6205675::getListFormat(p) == DlmsListKaifa;
+}
+
+static bool matchIskra(const char* p) {
+    return IEC6205675::getListFormat(p) == DlmsListIskra;
+}
+
+// Everything else, but not the L&G formats or the Kaifa and Iskra lists, so
+// that a cached DLMS decoder never takes a payload one of those would have
+static bool matchDlms(const char* p) {
+    return !matchLng(p) && !matchLng2(p) && IEC6205675::getListFormat(p) == DlmsListAuto;
+}
+
+static bool decodeDlms(DecoderInput& in, AmsData& data, uint8_t listFormat) {
+    IEC6205675 parsed(in.payload, in.tz, in.state->getMeterType(), in.meterConfig, *in.ctx, *in.state, in.debugger, listFormat);
+    data = parsed;
+    return true;
+}
+
+static bool decodeKaifa(DecoderInput& in, AmsData& data) {
+    return decodeDlms(in, data, DlmsListKaifa);
+}
+
+static bool decodeIskra(DecoderInput& in, AmsData& data) {
+    return decodeDlms(in, data, DlmsListIskra);
+}
+
+static bool decodeAuto(DecoderInput& in, AmsData& data) {
+    return decodeDlms(in, data, DlmsListAuto);
+}
+
+void addMeterDecoders(DecoderRegistry& registry) {
+    registry.add(MeterDecoderLng, "LNG", matchLng, decodeLng);
+    registry.add(MeterDecoderLng2, "LNG2", matchLng2, decodeLng2);
+    registry.add(MeterDecoderKaifa, "Kaifa", matchKaifa, decodeKaifa);
+    registry.add(MeterDecoderIskra, "Iskra", matchIskra, decodeIskra);
+    registry.add(MeterDecoderDlms, "DLMS", matchDlms, decodeAuto);
+}
@@ -0,0 +1,27 @@
+/**
+ * @copyright Utilitech AS 2023-2026
+ * License: Fair Source
+ * 
+ */
+
+#ifndef _METERDECODERS_H
+#define _METERDECODERS_H
+
+#include "DecoderRegistry.h"
+
+enum MeterDecoderId {
+    MeterDecoderLng = 1,
+    MeterDecoderLng2,
+    MeterDecoderKaifa,
+    MeterDecoderIskra,
+    MeterDecoderDlms
+};
+
+// Registers the DLMS application data formats, most specific first. The
+// generic DLMS decoder (OBIS codes and the Iskra/Kaifa lists selected in the
+// configuration) takes anything the others do not, Kaifa and Iskra list
+// identifiers excluded. No two signatures match
+// the same payload, so the cached decoder picks what a full scan would.
+void addMeterDecoders(DecoderRegistry& registry);
+
+#endif
@@ -6,12 +6,7 @@
 
 #include "PassiveMeterCommunicator.h"
 
-const uint32_t AUTO_BAUD_RATES[] = { 2400, 9600, 115200 };
-const uint8_t AUTO_BAUD_RATES_COUNT = sizeof(AUTO_BAUD_RATES) / sizeof(AUTO_BAUD_RATES[0]);
-#include "IEC6205675.h"
 #include "IEC6205621.h"
-#include "LNG.h"
-#include "LNG2.h"
 #include "hexutils.h"
 
 #if defined(ESP32)
@@ -21,21 +16,29 @@ const uint8_t AUTO_BAUD_RATES_COUNT = sizeof(AUTO_BAUD_RATES) / sizeof(AUTO_BAUD
 #if defined(AMS_REMOTE_DEBUG)
 PassiveMeterCommunicator::PassiveMeterCommunicator(RemoteDebug* debugger) {
     this->debugger = debugger;
+    addMeterDecoders(decoders);
 }
 #else
 PassiveMeterCommunicator::PassiveMeterCommunicator(Stream* debugger) {
     this->debugger = debugger;
+    addMeterDecoders(decoders);
 }
 #endif
 
 void PassiveMeterCommunicator::configure(MeterConfig& meterConfig, Timezone* tz) {
     this->meterConfig = meterConfig;
+    this->configChanged = false;
+    this->tz = tz;
+    decoders.reset();
 	if(meterConfig.baud == 0) {
 		autodetect = true;
+		validDataReceived = 0;
+		autodetector.begin(millis());
+		SerialSetting s = autodetector.current();
+		setupHanPort(s.baud, s.parity, s.invert);
+	} else {
+		setupHanPort(meterConfig.baud, meterConfig.parity, meterConfig.invert);
 	}
-    this->configChanged = false;
-    this->tz = tz;
-    setupHanPort(meterConfig.baud, meterConfig.parity, meterConfig.invert);
 	if(dsmrParser != NULL) {
 		delete dsmrParser;
 		dsmrParser = NULL;
@@ -62,13 +65,14 @@ bool PassiveMeterCommunicator::loop() {
     if(autodetect) handleAutodetect(now);
 
 	unsigned long start, end;
-	if(!hanSerial->available()) {
+	if(reader.getCarry() == 0 && !hanSource.available()) {
 		return false;
 	}
 
 	// Before reading, empty serial buffer to increase chance of getting first byte of a data transfer
 	if(!serialInit) {
 		hanSerial->readBytes(hanBuffer, hanBufferSize);
+		reader.flush();
 		serialInit = true;
 		return false;
 	}
@@ -77,21 +81,29 @@ bool PassiveMeterCommunicator::loop() {
 	ctx = {0,0,0,0};
 	memset(ctx.system_title, 0, 8);
     pos = DATA_PARSE_INCOMPLETE;
-	// For each byte received, check if we have a complete frame we can handle
+	// Read what the port has in chunks, and unwrap once a frame is complete
 	start = millis();
-	while(hanSerial->available() && pos == DATA_PARSE_INCOMPLETE) {
+	while(pos == DATA_PARSE_INCOMPLETE) {
 		// If buffer was overflowed, reset
-		if(len >= hanBufferSize) {
+		if(reader.isFull()) {
 			hanSerial->readBytes(hanBuffer, hanBufferSize);
-			len = 0;
+			reader.flush();
 			#if defined(AMS_REMOTE_DEBUG)
 			if (debugger->isActive(RemoteDebug::INFO))
 			#endif
 			debugger->printf_P(PSTR("Buffer overflow, resetting\n"));
 			return false;
 		}
-		hanBuffer[len++] = hanSerial->read();
-		ctx.length = len;
+		uint16_t from = reader.getLength();
+		if(reader.read(hanSource) == 0) break;
+		if(autodetect) {
+			for(uint16_t i = from; i < reader.getLength(); i++) autodetector.sample(hanBuffer[i], now);
+		}
+		if(!reader.isComplete()) {
+			yield();
+			continue;
+		}
+		ctx.length = reader.getLength();
 		pos = unwrapData((uint8_t *) hanBuffer, ctx);
 		if(ctx.type > 0 && pos >= 0) {
 			switch(ctx.type) {
@@ -137,7 +149,7 @@ bool PassiveMeterCommunicator::loop() {
 					if (debugger->isActive(RemoteDebug::ERROR))
 					#endif
 					debugger->printf_P(PSTR("Unknown tag %02X at pos %d\n"), ctx.type, pos);
-					len = 0;
+					reader.next();
 					return false;
 			}
 		}
@@ -159,6 +171,8 @@ bool PassiveMeterCommunicator::loop() {
 		#endif
 		debugger->printf_P(PSTR("Unknown data received\n"));
         lastError = pos;
+		// Rest of the transmission, overwriting anything carried over
+		int len = reader.getLength();
 		len = len + hanSerial->readBytes(hanBuffer+len, hanBufferSize-len);
 		#if defined(AMS_REMOTE_DEBUG)
 		if (debugger->isActive(RemoteDebug::VERBOSE))
@@ -167,15 +181,16 @@ bool PassiveMeterCommunicator::loop() {
 			debugger->printf_P(PSTR("  payload:\n"));
 			debugPrint(hanBuffer, 0, len, debugger);
 		}
-		len = 0;
+		reader.flush();
 		return false;
 	}
 	if(pos == DATA_PARSE_INTERMEDIATE_SEGMENT) {
-		len = 0;
+		reader.next();
 		return false;
 	} else if(pos < 0) {
         lastError = pos;
 		printHanReadError(pos);
+		int len = reader.getLength();
 		len += hanSerial->readBytes(hanBuffer+len, hanBufferSize-len);
         if(mqttDebug != NULL) {
             mqttDebug->publishRaw(hanBuffer, len);
@@ -188,7 +203,7 @@ bool PassiveMeterCommunicator::loop() {
 			debugPrint(hanBuffer, 0, len, debugger);
 		}
 		while(hanSerial->available()) hanSerial->read(); // Make sure it is all empty, in case we overflowed buffer above
-		len = 0;
+		reader.flush();
 		return false;
 	}
 
@@ -196,8 +211,9 @@ bool PassiveMeterCommunicator::loop() {
 		#if defined(AMS_REMOTE_DEBUG)
 		if (debugger->isActive(RemoteDebug::WARNING))
 		#endif
-		debugger->printf_P(PSTR("Ended up with context type %d, return code %d and length: %lu/%lu\n"), ctx.type, pos, ctx.length, len);
+		debugger->printf_P(PSTR("Ended up with context type %d, return code %d and length: %lu/%lu\n"), ctx.type, pos, ctx.length, reader.getLength());
         lastError = pos;
+		int len = reader.getLength();
 		len = len + hanSerial->readBytes(hanBuffer+len, hanBufferSize-len);
 		#if defined(AMS_REMOTE_DEBUG)
 		if (debugger->isActive(RemoteDebug::VERBOSE))
@@ -206,13 +222,15 @@ bool PassiveMeterCommunicator::loop() {
 			debugger->printf_P(PSTR("  payload:\n"));
 			debugPrint(hanBuffer, 0, len, debugger);
 		}
-		len = 0;
+		reader.flush();
 		return false;
 	}
 
-	// Data is valid, clear the rest of the buffer to avoid tainted parsing
-	for(int i = pos+ctx.length; i<hanBufferSize; i++) {
-		hanBuffer[i] = 0x00;
+	// Data is valid, clear the rest of the buffer to avoid tainted parsing,
+	// up to the start of the next frame if that was read already
+	int clearTo = payloadBuffer == hanBuffer ? hanBufferSize - reader.getCarry() : payloadBufferSize;
+	for(int i = pos+ctx.length; i<clearTo; i++) {
+		payloadBuffer[i] = 0x00;
 	}
     dataAvailable = true;
 	lastError = DATA_PARSE_OK;
@@ -220,16 +238,16 @@ bool PassiveMeterCommunicator::loop() {
     return true;
 }
 
-AmsData* PassiveMeterCommunicator::getData(AmsData& meterState) {
-    if(!dataAvailable) return NULL;
-	if(ctx.length > hanBufferSize) {
+bool PassiveMeterCommunicator::getData(AmsData& meterState, AmsData& data) {
+    if(!dataAvailable) return false;
+	if(ctx.length > payloadBufferSize) {
         debugger->printf_P(PSTR("Invalid context length\n"));
 		dataAvailable = false;
-		return NULL;
+		return false;
 	}
     
-    AmsData* data = NULL;
-	char* payload = ((char *) (hanBuffer)) + pos;
+    bool decoded = false;
+	char* payload = ((char *) (payloadBuffer)) + pos;
 	if(maxDetectedPayloadSize < pos) maxDetectedPayloadSize = pos;
 	if(ctx.type == DATA_TAG_DLMS) {
         if(mqttDebug != NULL) {
@@ -245,56 +263,26 @@ AmsData* PassiveMeterCommunicator::getData(AmsData& meterState) {
 		#endif
 		debugPrint((byte*) payload, 0, ctx.length, debugger);
 
-		// Rudimentary detector for L&G proprietary format, this is terrible code... Fix later
-		if(payload[0] == CosemTypeStructure && payload[2] == CosemTypeArray && payload[1] == payload[3]) {
-			#if defined(AMS_REMOTE_DEBUG)
-			if (debugger->isActive(RemoteDebug::VERBOSE))
-			#endif
-			debugger->printf_P(PSTR("LNG\n"));
-			LNG lngData = LNG(meterState, payload, meterState.getMeterType(), &meterConfig, ctx);
-			if(lngData.getListType() >= 1) {
-				data = new AmsData();
-				data->apply(meterState);
-				data->apply(lngData);
-			}
-		} else if(payload[0] == CosemTypeStructure && 
-			payload[2] == CosemTypeLongUnsigned && 
-			payload[5] == CosemTypeLongUnsigned && 
-			payload[8] == CosemTypeLongUnsigned && 
-			payload[11] == CosemTypeLongUnsigned && 
-			payload[14] == CosemTypeLongUnsigned && 
-			payload[17] == CosemTypeLongUnsigned
-		) {
-			#if defined(AMS_REMOTE_DEBUG)
-			if (debugger->isActive(RemoteDebug::VERBOSE))
-			#endif
-			debugger->printf_P(PSTR("LNG2\n"));
-			LNG2 lngData = LNG2(meterState, payload, meterState.getMeterType(), &meterConfig, ctx);
-			if(lngData.getListType() >= 1) {
-				data = new AmsData();
-				data->apply(meterState);
-				data->apply(lngData);
-			}
-		} else {
-			#if defined(AMS_REMOTE_DEBUG)
-			if (debugger->isActive(RemoteDebug::VERBOSE))
-			#endif
-			debugger->printf_P(PSTR("DLMS\n"));
-			// TODO: Split IEC6205675 into DataParserKaifa and DataParserObis. This way we can add other means of parsing, for those other proprietary formats
-			data = new IEC6205675(payload, tz, meterState.getMeterType(), &meterConfig, ctx, meterState, debugger);
-		}
+		DecoderInput in = { payload, tz, &meterConfig, &ctx, &meterState, debugger };
+		decoded = decoders.decode(in, data);
+		#if defined(AMS_REMOTE_DEBUG)
+		if (debugger->isActive(RemoteDebug::VERBOSE))
+		#endif
+		debugger->printf_P(PSTR("%s\n"), decoders.getLast() != NULL ? decoders.getLast()->name : "No decoder");
 	} else if(ctx.type == DATA_TAG_DSMR) {
-		data = new IEC6205621(payload, tz, &meterConfig);
+		IEC6205621 parsed(payload, tz, &meterConfig);
+		data = parsed;
+		decoded = true;
 	}
-	len = 0;
-    if(data != NULL) {
-        if(data->getListType() > 0) {
+	reader.next();
+    if(decoded) {
+        if(data.getListType() > 0) {
             validDataReceived++;
             if(rxBufferErrors > 0) rxBufferErrors--;
         }
     }
 	dataAvailable = false;
-    return data;
+    return decoded;
 }
 
 int PassiveMeterCommunicator::getLastError() {
@@ -337,21 +325,23 @@ int16_t PassiveMeterCommunicator::unwrapData(uint8_t *buf, DataParserContext &co
 	uint16_t end = hanBufferSize;
 	uint8_t tag = (*buf);
 	uint8_t lastTag = DATA_TAG_NONE;
+	payloadBuffer = buf;
+	payloadBufferSize = hanBufferSize;
 	while(tag != DATA_TAG_NONE) {
 		int16_t curLen = context.length;
 		int8_t res = 0;
 		switch(tag) {
 			case DATA_TAG_HDLC:
-				if(hdlcParser == NULL) hdlcParser = new HDLCParser();
+				if(hdlcParser == NULL) hdlcParser = new HDLCParser(&reassembly);
 				res = hdlcParser->parse(buf, context);
 				if(context.length < 3) doRet = true;
 				break;
 			case DATA_TAG_MBUS:
-				if(mbusParser == NULL) mbusParser =  new MBUSParser();
+				if(mbusParser == NULL) mbusParser = new MBUSParser(&reassembly);
 				res = mbusParser->parse(buf, context);
 				break;
 			case DATA_TAG_GBT:
-				if(gbtParser == NULL) gbtParser = new GBTParser();
+				if(gbtParser == NULL) gbtParser = new GBTParser(&reassembly);
 				res = gbtParser->parse(buf, context);
 				break;
 			case DATA_TAG_GCM:
@@ -393,7 +383,7 @@ int16_t PassiveMeterCommunicator::unwrapData(uint8_t *buf, DataParserContext &co
 		if(res == DATA_PARSE_INCOMPLETE) {
 			return res;
 		}
-		if(context.length > end) {
+		if(res != DATA_PARSE_FINAL_SEGMENT && context.length > end) {
 			#if defined(AMS_REMOTE_DEBUG)
 				if (debugger->isActive(RemoteDebug::VERBOSE))
 				#endif
@@ -478,9 +468,12 @@ int16_t PassiveMeterCommunicator::unwrapData(uint8_t *buf, DataParserContext &co
 		#endif
 		debugPrint(buf, 0, curLen, debugger);
 		if(res == DATA_PARSE_FINAL_SEGMENT) {
-			if(tag == DATA_TAG_MBUS) {
-				res = mbusParser->write(buf, context);
-			}
+			// Carry on with the reassembled APDU where it is
+			buf = payloadBuffer = reassembly.getData();
+			end = payloadBufferSize = reassembly.getSize();
+			ret = 0;
+			tag = (*buf);
+			continue;
 		}
 
 		if(res < 0) {
@@ -586,7 +579,7 @@ void PassiveMeterCommunicator::setupHanPort(uint32_t baud, uint8_t parityOrdinal
 	int8_t txpin = passive ? -1 : meterConfig.txPin;
 
 	if(baud == 0) {
-		autodetectBaud = baud = 2400;
+		baud = 2400;
 	}
 
 	if(parityOrdinal == 0) {
@@ -766,6 +759,8 @@ void PassiveMeterCommunicator::setupHanPort(uint32_t baud, uint8_t parityOrdinal
 	}
 	hanBufferSize = max(64 * meterConfig.bufferSize * 3, 512);
 	hanBuffer = (uint8_t*) malloc(hanBufferSize);
+	reader.begin(hanBuffer, hanBufferSize);
+	hanSource.setStream(hanSerial);
 
 	// The library automatically sets the pullup in Serial.begin()
 	if(!meterConfig.rxPinPullup) {
@@ -833,6 +828,7 @@ void PassiveMeterCommunicator::rxerr(int err) {
 			if (debugger->isActive(RemoteDebug::WARNING))
 			#endif
 			debugger->printf_P(PSTR("Serial frame error\n"));
+			if(autodetect) autodetector.error();
 			break;
 		case 5:
 			#if defined(AMS_REMOTE_DEBUG)
@@ -841,7 +837,7 @@ void PassiveMeterCommunicator::rxerr(int err) {
 			debugger->printf_P(PSTR("Serial parity error\n"));
 		    unsigned long now = millis();
 			if(autodetect) {
-				meterAutodetectLastChange = 0;
+				autodetector.error();
 			} else if(validDataReceived > 2) {
 				meterConfig.parity = getNextParity(meterConfig.parity);
 				configChanged = true;
@@ -854,41 +850,34 @@ void PassiveMeterCommunicator::rxerr(int err) {
 
 void PassiveMeterCommunicator::handleAutodetect(unsigned long now) {
     if(!autodetect) return;
-	if(now - meterAutodetectLastChange < 12000) return;
-
-	if(validDataReceived < 2) {
-		if(meterConfig.baud == 0 || meterConfig.parity == 0) {
-			autodetect = true;
-			if(lastError == 95) { // If parity error, switch parity
-				autodetectParity = getNextParity(autodetectParity);
-				lastError = 0;
-			} else {
-				autodetectCount++;
-			}
-			if(autodetectCount == sizeof(AUTO_BAUD_RATES)/sizeof(AUTO_BAUD_RATES[0]))  {
-				autodetectInvert = !autodetectInvert;
-				autodetectCount = 0;
-			}
-			autodetectBaud = AUTO_BAUD_RATES[autodetectCount];
-			#if defined(AMS_REMOTE_DEBUG)
-			if (debugger->isActive(RemoteDebug::INFO))
-			#endif
-			debugger->printf_P(PSTR("Meter serial autodetect, swapping to: %d, %d, %s\n"), autodetectBaud, autodetectParity, autodetectInvert ? "true" : "false");
-			meterConfig.bufferSize = max((uint32_t) 1, autodetectBaud / 14400);
-			setupHanPort(autodetectBaud, autodetectParity, autodetectInvert);
-			meterAutodetectLastChange = now;
-		}
-	} else if(autodetect) {
+
+	#if defined(ESP8266)
+	// The ESP32 UART reports these through rxerr, here they have to be polled
+	if(hwSerial != NULL && hwSerial->hasRxError()) autodetector.error();
+	#endif
+
+	SerialSetting s = autodetector.current();
+	if(validDataReceived > 0) {
 		#if defined(AMS_REMOTE_DEBUG)
 		if (debugger->isActive(RemoteDebug::INFO))
 		#endif
-		debugger->printf_P(PSTR("Meter serial autodetected, saving: %d, %d, %s\n"), autodetectBaud, autodetectParity, autodetectInvert ? "true" : "false");
+		debugger->printf_P(PSTR("Meter serial autodetected, saving: %d, %d, %s\n"), s.baud, s.parity, s.invert ? "true" : "false");
 		autodetect = false;
-		meterConfig.baud = autodetectBaud;
-		meterConfig.parity = autodetectParity;
-		meterConfig.invert = autodetectInvert;
+		meterConfig.baud = s.baud;
+		meterConfig.parity = s.parity;
+		meterConfig.invert = s.invert;
 		configChanged = true;
 		setupHanPort(meterConfig.baud, meterConfig.parity, meterConfig.invert);
+	} else if(autodetector.update(now)) {
+		s = autodetector.current();
+		#if defined(AMS_REMOTE_DEBUG)
+		if (debugger->isActive(RemoteDebug::INFO))
+		#endif
+		debugger->printf_P(PSTR("Meter serial autodetect, swapping to: %d, %d, %s%s\n"), s.baud, s.parity, s.invert ? "true" : "false", autodetector.isConfirming() ? " (confirming)" : "");
+		meterConfig.bufferSize = max((uint32_t) 1, s.baud / 14400);
+		setupHanPort(s.baud, s.parity, s.invert);
+		// Whatever was received under the previous setting is of no use
+		reader.flush();
 	}
 }
 
@@ -13,6 +13,10 @@
 #endif
 #include "AmsConfiguration.h"
 #include "DataParsers.h"
+#include "SerialAutodetect.h"
+#include "FrameReader.h"
+#include "MeterDecoders.h"
+#include "StreamByteSource.h"
 #include "Timezone.h"
 #include "AmsMqttHandler.h"
 
@@ -20,9 +24,6 @@
 #include "SoftwareSerial.h"
 #endif
 
-extern const uint32_t AUTO_BAUD_RATES[];
-extern const uint8_t AUTO_BAUD_RATES_COUNT;
-
 class PassiveMeterCommunicator : public MeterCommunicator  {
 public:
     #if defined(AMS_REMOTE_DEBUG)
@@ -32,7 +33,7 @@ public:
     #endif
     void configure(MeterConfig&, Timezone*);
     bool loop();
-    AmsData* getData(AmsData& meterState);
+    bool getData(AmsData& meterState, AmsData& data);
     int getLastError();
     bool isConfigChanged();
     void ackConfigChanged();
@@ -56,7 +57,13 @@ protected:
 
     uint8_t *hanBuffer = NULL;
     uint16_t hanBufferSize = 0;
+    // Multi-segment APDUs are assembled here and parsed in place, so the
+    // payload is either in hanBuffer or in the arena
+    ReassemblyArena reassembly;
+    uint8_t *payloadBuffer = NULL;
+    uint16_t payloadBufferSize = 0;
     Stream *hanSerial;
+    StreamByteSource hanSource;
     #if defined(ESP8266)
     SoftwareSerial *swSerial = NULL;
     #endif
@@ -64,22 +71,19 @@ protected:
     uint8_t rxBufferErrors = 0;
 
     bool autodetect = false;
+    SerialAutodetect autodetector;
     uint8_t validDataReceived = 0;
-    unsigned long meterAutodetectLastChange = 0;
     long rate = 10000;
-    uint32_t autodetectBaud = 0;
-    uint8_t autodetectParity = 11; // 8E1
-    bool autodetectInvert = false;
-    uint8_t autodetectCount = 0;
 
     bool dataAvailable = false;
-    int len = 0;
     int pos = DATA_PARSE_INCOMPLETE;
     int lastError = DATA_PARSE_OK;
     bool serialInit = false;
     bool maxDetectPayloadDetectDone = false;
     uint8_t maxDetectedPayloadSize = 64;
     DataParserContext ctx = {0,0,0,0};
+    FrameReader reader;
+    DecoderRegistry decoders;
 
     HDLCParser *hdlcParser = NULL;
     MBUSParser *mbusParser = NULL;
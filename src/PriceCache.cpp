@@ -0,0 +1,80 @@
+/**
+ * @copyright Utilitech AS 2023-2026
+ * License: Fair Source
+ * 
+ */
+
+#include "PriceCache.h"
+#include <string.h>
+
+PriceCache::PriceCache(const char* area, const char* currency, uint8_t resolutionInMinutes) {
+    memset(&header, 0, sizeof(header));
+    header.version = PRICE_CACHE_VERSION;
+    strncpy(header.area, area, sizeof(header.area) - 1);
+    strncpy(header.currency, currency, sizeof(header.currency) - 1);
+    header.resolutionInMinutes = resolutionInMinutes;
+}
+
+uint16_t PriceCache::write(uint8_t* buf, uint16_t size, uint32_t day, PricesContainer* today, PricesContainer* tomorrow) {
+    PricesContainer* days[2] = { today, tomorrow };
+    PriceCacheHeader h = header;
+    uint16_t length = sizeof(h);
+    for(uint8_t i = 0; i < 2; i++) {
+        if(days[i] == NULL) continue;
+        length += sizeof(PriceCacheDay) + (days[i]->getPointsLength() * sizeof(int32_t));
+        h.days++;
+    }
+    if(length > size) return 0;
+
+    memcpy(buf, &h, sizeof(h));
+    uint16_t pos = sizeof(h);
+    for(uint8_t i = 0; i < 2; i++) {
+        if(days[i] == NULL) continue;
+        PriceCacheDay cached;
+        memset(&cached, 0, sizeof(cached));
+        cached.day = day + i;
+        memcpy(cached.source, days[i]->getSource(), sizeof(cached.source));
+        memcpy(cached.currency, days[i]->getCurrency(), sizeof(cached.currency));
+        cached.resolutionInMinutes = days[i]->getResolutionInMinutes();
+        cached.numberOfPoints = days[i]->getNumberOfPoints();
+        cached.differentExportPrices = days[i]->isExportPricesDifferentFromImport();
+        memcpy(buf + pos, &cached, sizeof(cached));
+        pos += sizeof(cached);
+        uint16_t bytes = days[i]->getPointsLength() * sizeof(int32_t);
+        memcpy(buf + pos, days[i]->getPoints(), bytes);
+        pos += bytes;
+    }
+    return length;
+}
+
+bool PriceCache::read(const uint8_t* buf, uint16_t length, uint32_t day, PricesContainer*& today, PricesContainer*& tomorrow) {
+    PriceCacheHeader h;
+    if(length < sizeof(h)) return false;
+    memcpy(&h, buf, sizeof(h));
+    // Prices for another area, currency or resolution are not used
+    if(h.version != PRICE_CACHE_VERSION || strncmp(h.area, header.area, sizeof(h.area)) != 0
+            || strncmp(h.currency, header.currency, sizeof(h.currency)) != 0 || h.resolutionInMinutes != header.resolutionInMinutes) {
+        return false;
+    }
+
+    uint16_t pos = sizeof(h);
+    for(uint8_t i = 0; i < h.days && pos + sizeof(PriceCacheDay) <= length; i++) {
+        PriceCacheDay cached;
+        memcpy(&cached, buf + pos, sizeof(cached));
+        pos += sizeof(cached);
+        uint16_t bytes = cached.numberOfPoints * (cached.differentExportPrices ? 2 : 1) * sizeof(int32_t);
+        if(pos + bytes > length) break;
+
+        if(cached.day == day || cached.day == day + 1) {
+            PricesContainer* container = new PricesContainer(cached.source);
+            container->setup(cached.resolutionInMinutes, cached.numberOfPoints, cached.differentExportPrices);
+            container->setCurrency(cached.currency);
+            memcpy(container->getPoints(), buf + pos, bytes);
+            PricesContainer*& target = cached.day == day ? today : tomorrow;
+            if(target != NULL) delete target;
+            target = container;
+        }
+        pos += bytes;
+    }
+    return true;
+}
@@ -0,0 +1,61 @@
+/**
+ * @copyright Utilitech AS 2023-2026
+ * License: Fair Source
+ * 
+ */
+
+#ifndef _PRICECACHE_H
+#define _PRICECACHE_H
+
+#include <stdint.h>
+#include <time.h>
+#include "PricesContainer.h"
+
+#define PRICE_CACHE_VERSION 1
+
+// Fetched prices as kept in the journal, only used while the configuration matches
+struct PriceCacheHeader {
+    uint8_t version;
+    char area[17];
+    char currency[4];
+    uint8_t resolutionInMinutes;
+    uint8_t days;
+};
+
+// One day of prices in the cache, followed by its points as PricesContainer stores them
+struct PriceCacheDay {
+    uint32_t day; // Days since epoch in CE(S)T
+    char source[4];
+    char currency[4];
+    uint8_t resolutionInMinutes;
+    uint8_t numberOfPoints;
+    bool differentExportPrices;
+};
+
+struct PriceCacheCurrency {
+    uint8_t version;
+    char from[4];
+    char to[4];
+    float multiplier;
+    time_t validUntil;
+};
+
+// The journal record of prices for one area, currency and resolution. Works
+// on a buffer the caller owns, so PriceService can use the shared one.
+class PriceCache {
+public:
+    PriceCache(const char* area, const char* currency, uint8_t resolutionInMinutes);
+
+    // Writes today and tomorrow, either may be NULL, as the prices of day and
+    // day + 1. Returns the length, or 0 if it does not fit in size.
+    uint16_t write(uint8_t* buf, uint16_t size, uint32_t day, PricesContainer* today, PricesContainer* tomorrow);
+    // Replaces today and tomorrow with the prices of day and day + 1 found in
+    // the record. Returns false if the record is for another area, currency or
+    // resolution.
+    bool read(const uint8_t* buf, uint16_t length, uint32_t day, PricesContainer*& today, PricesContainer*& tomorrow);
+
+private:
+    PriceCacheHeader header;
+};
+
+#endif
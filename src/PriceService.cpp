@@ -21,11 +21,12 @@
 #endif
 
 #if defined(AMS_REMOTE_DEBUG)
-PriceService::PriceService(RemoteDebug* Debug) : priceConfig(std::vector<PriceConfig>()) {
+PriceService::PriceService(RemoteDebug* Debug, uint8_t* buf) : priceConfig(std::vector<PriceConfig>()) {
 #else
-PriceService::PriceService(Stream* Debug) : priceConfig(std::vector<PriceConfig>()) {
+PriceService::PriceService(Stream* Debug, uint8_t* buf) : priceConfig(std::vector<PriceConfig>()) {
 #endif
     debugger = Debug;
+    this->buf = buf;
 
     // Entso-E uses CET/CEST
     TimeChangeRule CEST = {"CEST", Last, Sun, Mar, 2, 120};
@@ -46,9 +47,11 @@ void PriceService::setup(PriceServiceConfig& config) {
     }
 
     lastTodayFetch = lastTomorrowFetch = lastCurrencyFetch = 0;
+    cacheLoaded = false;
     if(today != NULL) delete today;
     if(tomorrow != NULL) delete tomorrow;
     today = tomorrow = NULL;
+    priceTableValid = false;
 
     if(http != NULL) {
         delete http;
@@ -77,6 +80,11 @@ void PriceService::setup(PriceServiceConfig& config) {
 
 void PriceService::setTimezone(Timezone* tz) {
     this->tz = tz;
+    priceTableValid = false;
+}
+
+void PriceService::setJournal(AmsJournal* journal) {
+    this->journal = journal;
 }
 
 char* PriceService::getToken() {
@@ -129,6 +137,34 @@ bool PriceService::isExportPricesDifferentFromImport() {
 }
 
 float PriceService::getPricePoint(uint8_t direction, uint8_t point) {
+    if(direction != PRICE_DIRECTION_IMPORT && direction != PRICE_DIRECTION_EXPORT) {
+        return calculatePricePoint(direction, point);
+    }
+    if(!priceTableValid) {
+        buildPriceTable();
+    }
+    if(point >= priceTablePoints) {
+        return calculatePricePoint(direction, point);
+    }
+    return priceTable[(direction == PRICE_DIRECTION_EXPORT ? priceTablePoints : 0) + point];
+}
+
+void PriceService::buildPriceTable() {
+    uint8_t points = getNumberOfPointsAvailable();
+    if(priceTable == NULL || points > priceTableCapacity) {
+        if(priceTable != NULL) delete[] priceTable;
+        priceTable = new float[points * 2];
+        priceTableCapacity = points;
+    }
+    priceTablePoints = points;
+    for(uint8_t i = 0; i < points; i++) {
+        priceTable[i] = calculatePricePoint(PRICE_DIRECTION_IMPORT, i);
+        priceTable[points + i] = calculatePricePoint(PRICE_DIRECTION_EXPORT, i);
+    }
+    priceTableValid = true;
+}
+
+float PriceService::calculatePricePoint(uint8_t direction, uint8_t point) {
     float value = getFixedPrice(direction, point);
     if(value == PRICE_NO_VALUE) value = getEnergyPricePoint(direction, point);
     if(value == PRICE_NO_VALUE) return PRICE_NO_VALUE;
@@ -237,6 +273,22 @@ float PriceService::getPriceForRelativeHour(uint8_t direction, int8_t hour) {
     return valueSum / valueCount;
 }
 
+float PriceService::getPriceForTime(uint8_t direction, time_t ts) {
+    tmElements_t tm;
+    breakTime(entsoeTz->toLocal(time(nullptr)), tm);
+    tm.Hour = tm.Minute = tm.Second = 0;
+    time_t startOfDay = entsoeTz->toUTC(makeTime(tm));
+    if(ts < startOfDay) {
+        return PRICE_NO_VALUE;
+    }
+
+    uint32_t point = (ts - startOfDay) / (SECS_PER_MIN * getResolutionInMinutes());
+    if(point > UINT8_MAX) {
+        return PRICE_NO_VALUE;
+    }
+    return getPricePoint(direction, point);
+}
+
 float PriceService::getFixedPrice(uint8_t direction, int8_t point) {
     time_t ts = time(nullptr);
 
@@ -272,6 +324,11 @@ bool PriceService::loop() {
         return false;
     }
 
+    if(!cacheLoaded) {
+        cacheLoaded = true;
+        if(config->enabled) loadCache(t);
+    }
+
     tmElements_t tm;
     breakTime(entsoeTz->toLocal(t), tm);
 
@@ -282,6 +339,7 @@ bool PriceService::loop() {
         debugger->printf_P(PSTR("(PriceService) Day init\n"));
         currentDay = tm.Day;
         currentPricePoint = getCurrentPricePointIndex();
+        priceTableValid = false;
     }
     
     if(currentDay != tm.Day) {
@@ -296,6 +354,7 @@ bool PriceService::loop() {
         }
         currentDay = tm.Day;
         currentPricePoint = getCurrentPricePointIndex();
+        priceTableValid = false;
         return today != NULL || (!config->enabled && priceConfig.capacity() != 0); // Only trigger MQTT publish if we have todays prices.
     } else if(currentPricePoint != getCurrentPricePointIndex()) {
         #if defined(AMS_REMOTE_DEBUG)
@@ -309,6 +368,11 @@ bool PriceService::loop() {
     if(!config->enabled)
         return false;
 
+    // Refresh the exchange rate from here rather than from whichever getter rebuilds the price table next
+    if(today != NULL && strcmp(today->getCurrency(), config->currency) != 0) {
+        getCurrencyMultiplier(today->getCurrency(), config->currency, t);
+    }
+
     #ifndef AMS2MQTT_PRICE_KEY
     if(strlen(getToken()) == 0) {
         return false;
@@ -327,6 +391,7 @@ bool PriceService::loop() {
         try {
             lastTodayFetch = now;
             today = fetchPrices(t);
+            if(today != NULL) saveCache(t);
         } catch(const std::exception& e) {
             if(lastError == 0) {
                 lastError = 900;
@@ -334,6 +399,7 @@ bool PriceService::loop() {
             }
             today = NULL;
         }
+        priceTableValid = false;
         currentPricePoint = getCurrentPricePointIndex();
         return today != NULL && !readyToFetchForTomorrow; // Only trigger MQTT publish if we have todays prices and we are not immediately ready to fetch price for tomorrow.
     }
@@ -344,6 +410,7 @@ bool PriceService::loop() {
         try {
             lastTomorrowFetch = now;
             tomorrow = fetchPrices(t+SECS_PER_DAY);
+            if(tomorrow != NULL) saveCache(t);
         } catch(const std::exception& e) {
             if(lastError == 0) {
                 lastError = 900;
@@ -351,6 +418,7 @@ bool PriceService::loop() {
             }
             tomorrow = NULL;
         }
+        priceTableValid = false;
         currentPricePoint = getCurrentPricePointIndex();
         return tomorrow != NULL;
     }
@@ -455,7 +523,9 @@ float PriceService::getCurrencyMultiplier(const char* from, const char* to, time
             tmElements_t tm;
             breakTime(t, tm);
             lastCurrencyFetch = now + (SECS_PER_DAY * 1000) - (((((tm.Hour * 60) + tm.Minute) * 60) + tm.Second) * 1000) + (3600000 * 6) + (tomorrowFetchMinute * 60);
+            if(this->currencyMultiplier != currencyMultiplier) priceTableValid = false;
             this->currencyMultiplier = currencyMultiplier;
+            saveCurrency(from, to, t + ((lastCurrencyFetch - now) / 1000));
         } else {
             #if defined(AMS_REMOTE_DEBUG)
             if (debugger->isActive(RemoteDebug::WARNING))
@@ -657,12 +727,13 @@ void PriceService::setPriceConfig(uint8_t index, PriceConfig &priceConfig) {
         this->priceConfig[index] = priceConfig;
     else   
         this->priceConfig.push_back(priceConfig);
+    priceTableValid = false;
 }
 
 void PriceService::cropPriceConfig(uint8_t size) {
     this->priceConfig.resize(size);
     this->priceConfig.shrink_to_fit();
-
+    priceTableValid = false;
 }
 
 bool PriceService::save() {
@@ -714,6 +785,7 @@ bool PriceService::load() {
     debugger->printf_P(PSTR("(PriceService) Loading price config\n"));
 
     this->priceConfig.clear();
+    priceTableValid = false;
 
     PriceConfig pc;
     File file = LittleFS.open(FILE_PRICE_CONF, "r");
@@ -728,6 +800,55 @@ bool PriceService::load() {
 }
 
 
+uint32_t PriceService::getDayNumber(time_t t) {
+    return entsoeTz->toLocal(t) / SECS_PER_DAY;
+}
+
+void PriceService::loadCache(time_t t) {
+    if(journal == NULL) return;
+
+    PriceCache cache(config->area, config->currency, config->resolutionInMinutes);
+    uint16_t length = journal->read(JournalPrices, buf, JOURNAL_MAX_RECORD);
+    cache.read(buf, length, getDayNumber(t), today, tomorrow);
+
+    PriceCacheCurrency currency;
+    if(today != NULL && journal->read(JournalCurrency, &currency, sizeof(currency)) == sizeof(currency) && currency.version == PRICE_CACHE_VERSION && currency.validUntil > t
+            && strncmp(currency.from, today->getCurrency(), sizeof(currency.from)) == 0 && strncmp(currency.to, config->currency, sizeof(currency.to)) == 0) {
+        currencyMultiplier = currency.multiplier;
+        lastCurrencyFetch = millis64() + ((uint64_t) (currency.validUntil - t) * 1000);
+    }
+
+    #if defined(AMS_REMOTE_DEBUG)
+    if (debugger->isActive(RemoteDebug::INFO))
+    #endif
+    debugger->printf_P(PSTR("(PriceService) Loaded from cache, today: %s, tomorrow: %s, currency multiplier: %.4f\n"), today == NULL ? "no" : "yes", tomorrow == NULL ? "no" : "yes", currencyMultiplier);
+    priceTableValid = false;
+}
+
+void PriceService::saveCache(time_t t) {
+    if(journal == NULL) return;
+
+    PriceCache cache(config->area, config->currency, config->resolutionInMinutes);
+    uint16_t length = cache.write(buf, JOURNAL_MAX_RECORD, getDayNumber(t), today, tomorrow);
+    if(length == 0) return;
+    if(!journal->write(JournalPrices, buf, length)) {
+        #if defined(AMS_REMOTE_DEBUG)
+        if (debugger->isActive(RemoteDebug::WARNING))
+        #endif
+        debugger->printf_P(PSTR("(PriceService) Unable to cache prices\n"));
+    }
+}
+
+void PriceService::saveCurrency(const char* from, const char* to, time_t validUntil) {
+    if(journal == NULL) return;
+    PriceCacheCurrency currency = { PRICE_CACHE_VERSION };
+    strncpy(currency.from, from, sizeof(currency.from));
+    strncpy(currency.to, to, sizeof(currency.to));
+    currency.multiplier = currencyMultiplier;
+    currency.validUntil = validUntil;
+    journal->write(JournalCurrency, &currency, sizeof(currency));
+}
+
 bool PriceService::timeIsInPeriod(tmElements_t tm, PriceConfig pc) {
     uint8_t day = 0x01 << ((tm.Wday+5)%7);
     uint32_t hrs = 0x01 << tm.Hour;
@@ -16,6 +16,8 @@
 #endif
 #include "AmsConfiguration.h"
 #include "EntsoeA44Parser.h"
+#include "AmsJournal.h"
+#include "PriceCache.h"
 
 #if defined(ESP8266)
 	#include <ESP8266HTTPClient.h>
@@ -64,13 +66,16 @@ struct AmsPriceV2Header {
 
 class PriceService {
 public:
+    // buf is the shared buffer, at least JOURNAL_MAX_RECORD bytes, the price cache goes through it
     #if defined(AMS_REMOTE_DEBUG)
-    PriceService(RemoteDebug*);
+    PriceService(RemoteDebug*, uint8_t* buf);
     #else
-    PriceService(Stream*);
+    PriceService(Stream*, uint8_t* buf);
     #endif
     void setup(PriceServiceConfig&);
     void setTimezone(Timezone* tz);
+    // Where fetched prices and the exchange rate are kept across reboots
+    void setJournal(AmsJournal* journal);
     bool loop();
 
     char* getToken();
@@ -91,6 +96,7 @@ public:
     float getCurrentPrice(uint8_t direction);
     float getPricePoint(uint8_t direction, uint8_t point);
     float getPriceForRelativeHour(uint8_t direction, int8_t hour); // If not 60min interval, average
+    float getPriceForTime(uint8_t direction, time_t ts); // The price point covering ts, from today on
 
     std::vector<PriceConfig>& getPriceConfig();
     void setPriceConfig(uint8_t index, PriceConfig &priceConfig);
@@ -109,6 +115,9 @@ private:
     #endif
     PriceServiceConfig* config = NULL;
     HTTPClient* http = NULL;
+    AmsJournal* journal = NULL;
+    uint8_t* buf = NULL;
+    bool cacheLoaded = false;
 
     uint8_t currentDay = 0, currentPricePoint = 0;
     uint8_t tomorrowFetchMinute = 15; // How many minutes over 13:00 should it fetch prices
@@ -130,6 +139,12 @@ private:
 
     float currencyMultiplier = 0;
 
+    // Effective price per point for today and tomorrow, import points followed by
+    // export points. Rebuilt on first use after prices, modifiers, currency or timezone change.
+    float* priceTable = NULL;
+    uint8_t priceTableCapacity = 0, priceTablePoints = 0;
+    bool priceTableValid = false;
+
     int16_t lastError = 0;
 
     PricesContainer* fetchPrices(time_t);
@@ -138,5 +153,11 @@ private:
     bool timeIsInPeriod(tmElements_t tm, PriceConfig pc);
     float getFixedPrice(uint8_t direction, int8_t point);
     float getEnergyPricePoint(uint8_t direction, uint8_t point);
+    float calculatePricePoint(uint8_t direction, uint8_t point);
+    void buildPriceTable();
+    uint32_t getDayNumber(time_t t);
+    void loadCache(time_t t);
+    void saveCache(time_t t);
+    void saveCurrency(const char* from, const char* to, time_t validUntil);
 };
 #endif
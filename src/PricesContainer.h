@@ -31,6 +31,14 @@ public:
     uint8_t getResolutionInMinutes();
     uint8_t getNumberOfPoints();
 
+    // Points as stored, import followed by export if they differ
+    int32_t* getPoints() {
+        return points;
+    }
+    uint16_t getPointsLength() {
+        return numberOfPoints * (differentExportPrices ? 2 : 1);
+    }
+
     void setPrice(uint8_t point, float value, uint8_t direction);
     bool hasPrice(uint8_t point, uint8_t direction);
     float getPrice(uint8_t point, uint8_t direction); // int32_t / 10_000
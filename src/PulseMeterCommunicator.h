@@ -24,7 +24,7 @@ public:
     #endif
     void configure(MeterConfig& config, Timezone* tz);
     bool loop();
-    AmsData* getData(AmsData& meterState);
+    bool getData(AmsData& meterState, AmsData& data);
     int getLastError();
     bool isConfigChanged();
     void ackConfigChanged();
@@ -7,20 +7,98 @@
 #include "Arduino.h"
 #include "RealtimePlot.h"
 #include <stdlib.h>
+#if defined(ESP32) && defined(BOARD_HAS_PSRAM)
+#include <esp_heap_caps.h>
+#endif
 
-RealtimePlot::RealtimePlot() {
-    values = (int8_t*) malloc(REALTIME_SIZE);
-    scaling = (uint8_t*) malloc(REALTIME_SIZE);
-    memset(values, 0, REALTIME_SIZE);
-    memset(scaling, 0, REALTIME_SIZE);
+RealtimePlot::RealtimePlot() {}
+
+RealtimePlot::~RealtimePlot() {
+    if(buckets != NULL) free(buckets);
+}
+
+bool RealtimePlot::setup(uint32_t periodMs, uint16_t size) {
+    if(periodMs == 0 || size == 0) return false;
+    if(buckets != NULL) free(buckets);
+    size_t bytes = sizeof(RealtimeBucket) * size;
+    #if defined(ESP32) && defined(BOARD_HAS_PSRAM)
+    buckets = (RealtimeBucket*) heap_caps_malloc(bytes, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    if(buckets == NULL) buckets = (RealtimeBucket*) malloc(bytes);
+    #else
+    buckets = (RealtimeBucket*) malloc(bytes);
+    #endif
+    if(buckets == NULL) {
+        this->size = 0;
+        return false;
+    }
+    memset(buckets, 0, bytes);
+    this->period = periodMs;
+    this->size = size;
+    shift = 0;
+    lastMillis = 0;
+    count = 0;
+    return true;
+}
+
+bool RealtimePlot::setWindow(uint8_t window) {
+    // 21 KB, too much for internal RAM
+    bool fine = window == REALTIME_WINDOW_FINE;
+    #if defined(ESP32) && defined(BOARD_HAS_PSRAM)
+    fine = fine && heap_caps_get_total_size(MALLOC_CAP_SPIRAM) > 0;
+    #else
+    fine = false;
+    #endif
+    uint32_t periodMs = fine ? REALTIME_SAMPLE_FINE : REALTIME_SAMPLE;
+    uint16_t length = fine ? REALTIME_SIZE_FINE : REALTIME_SIZE;
+    if(buckets != NULL && period == periodMs && size == length) return true;
+    return setup(periodMs, length);
+}
+
+void RealtimePlot::fit(int32_t val) {
+    while((val >> shift) > INT16_MAX || (val >> shift) < INT16_MIN) {
+        // Halve the resolution of everything already stored
+        shift++;
+        for(uint16_t i = 0; i < size; i++) {
+            buckets[i].avg >>= 1;
+            buckets[i].min >>= 1;
+            buckets[i].max >>= 1;
+        }
+    }
+}
+
+void RealtimePlot::shrink() {
+    while(shift > 0) {
+        // Back to the finer scale once everything in the ring fits it again
+        for(uint16_t i = 0; i < size; i++) {
+            if(buckets[i].min < INT16_MIN / 2 || buckets[i].max > INT16_MAX / 2) return;
+        }
+        shift--;
+        for(uint16_t i = 0; i < size; i++) {
+            buckets[i].avg *= 2;
+            buckets[i].min *= 2;
+            buckets[i].max *= 2;
+        }
+    }
+}
+
+void RealtimePlot::store(uint16_t pos, int32_t avg, int32_t min, int32_t max) {
+    // min and max bound avg, so once they fit the scale is settled
+    fit(min);
+    fit(max);
+    buckets[pos].avg = avg >> shift;
+    buckets[pos].min = min >> shift;
+    buckets[pos].max = max >> shift;
 }
 
 void RealtimePlot::update(AmsData& data) {
+    if(buckets == NULL && !setup(REALTIME_SAMPLE, REALTIME_SIZE)) return;
+
     unsigned long now = millis();
-    uint16_t pos = (now / REALTIME_SAMPLE) % REALTIME_SIZE;
+    uint16_t pos = (now / period) % size;
+    int64_t reading = (int64_t) ((data.getActiveImportCounter() - data.getActiveExportCounter()) * 1000);
     if(lastMillis == 0) {
         lastMillis = now;
-        lastReading = data.getActiveImportCounter() - data.getActiveExportCounter();
+        lastReading = reading;
         lastPos = pos;
         return;
     }
@@ -29,55 +107,85 @@ void RealtimePlot::update(AmsData& data) {
     unsigned long ms = now - lastMillis;
     int32_t val; // A bit hacky this one, but just to avoid spikes at end of hour. Will mostly be correct
     if(data.isCounterEstimated()) {
-        val = ((data.getActiveImportCounter() - data.getActiveExportCounter() - lastReading) * 1000) / (((float) ms) / 3600000.0);
+        val = ms == 0 ? 0 : (int32_t) (((reading - lastReading) * 3600000) / (int64_t) ms);
     } else {
-        val = data.getActiveImportPower() - data.getActiveExportPower();
-    }
-    uint8_t scale = 0;
-    int32_t update = val / pow(10, scale);
-    while(update > INT8_MAX || update < INT8_MIN) {
-        update = val / pow(10, ++scale);
+        val = (int32_t) data.getActiveImportPower() - (int32_t) data.getActiveExportPower();
     }
-    if(pos < lastPos) {
-        for(uint16_t i = lastPos+1; i < REALTIME_SIZE; i++) {
-            values[i] = update;
-            scaling[i] = scale;
-        }
-        for(uint16_t i = 0; i <= pos; i++) {
-            values[i] = update;
-            scaling[i] = scale;
-        }
-    } else {
-        for(uint16_t i = lastPos+1; i <= pos; i++) {
-            values[i] = update;
-            scaling[i] = scale;
+
+    if(pos != lastPos) {
+        // New bucket, buckets skipped since the last reading get this value
+        for(uint16_t i = (lastPos + 1) % size; i != pos; i = (i + 1) % size) {
+            store(i, val, val, val);
         }
+        // What this bucket held a ring ago is gone, so it no longer holds up the scale
+        buckets[pos] = { 0, 0, 0 };
+        shrink();
+        count = 0;
+    }
+    if(count == 0) {
+        sum = 0;
+        curMin = curMax = val;
     }
+    sum += val;
+    count++;
+    if(val < curMin) curMin = val;
+    if(val > curMax) curMax = val;
+    store(pos, (int32_t) (sum / count), curMin, curMax);
 
     lastMillis = now;
-    lastReading = data.getActiveImportCounter() - data.getActiveExportCounter();
+    lastReading = reading;
     lastPos = pos;
 }
 
-int32_t RealtimePlot::getValue(uint16_t req) {
-    if(req > REALTIME_SIZE) return 0;
+int32_t RealtimePlot::decode(int16_t val) {
+    return (int32_t) val * (1 << shift);
+}
 
-    unsigned long now = millis();
-    if(req * REALTIME_SAMPLE > now) return 0;
-    unsigned long reqTime = now - (req * REALTIME_SAMPLE);
+uint16_t RealtimePlot::getPos(uint16_t req, unsigned long now, uint16_t pos) {
+    if(req > size) return UINT16_MAX;
+    if(req * period > now) return UINT16_MAX;
+    unsigned long reqTime = now - (req * period);
 
-    uint16_t pos = (now / REALTIME_SAMPLE) % REALTIME_SIZE;
-    uint16_t getPos;
     if(reqTime > lastMillis) {
-        getPos = lastPos;
+        return lastPos;
     } else if(req > pos) {
-        getPos = REALTIME_SIZE + pos - req;
+        return size + pos - req;
     } else {
-        getPos = pos - req;
+        return pos - req;
     }
-    return values[getPos] * pow(10, scaling[getPos]);
+}
+
+int32_t RealtimePlot::getValue(uint16_t req) {
+    if(buckets == NULL) return 0;
+    unsigned long now = millis();
+    uint16_t p = getPos(req, now, (now / period) % size);
+    return p == UINT16_MAX ? 0 : decode(buckets[p].avg);
+}
+
+uint16_t RealtimePlot::getValues(uint16_t offset, uint16_t length, int32_t* out, int32_t* min, int32_t* max) {
+    if(buckets == NULL) return 0;
+    unsigned long now = millis();
+    uint16_t pos = (now / period) % size;
+    uint16_t i = 0;
+    for(; i < length && offset + i <= size; i++) {
+        uint16_t p = getPos(offset + i, now, pos);
+        if(p == UINT16_MAX) {
+            out[i] = 0;
+            if(min != NULL) min[i] = 0;
+            if(max != NULL) max[i] = 0;
+            continue;
+        }
+        out[i] = decode(buckets[p].avg);
+        if(min != NULL) min[i] = decode(buckets[p].min);
+        if(max != NULL) max[i] = decode(buckets[p].max);
+    }
+    return i;
 }
 
 int16_t RealtimePlot::getSize() {
-    return REALTIME_SIZE;
+    return buckets == NULL ? REALTIME_SIZE : size;
+}
+
+uint32_t RealtimePlot::getPeriod() {
+    return period;
 }
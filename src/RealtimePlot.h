@@ -1,7 +1,7 @@
 /**
  * @copyright Utilitech AS 2023-2026
  * License: Fair Source
- * 
+ *
  */
 
 #ifndef _REALTIMEPLOT_H
@@ -11,20 +11,58 @@
 
 #define REALTIME_SAMPLE 10000
 #define REALTIME_SIZE 360
+#define REALTIME_SAMPLE_FINE 1000
+#define REALTIME_SIZE_FINE 3600
+
+#define REALTIME_WINDOW_DEFAULT 0 // One hour in 10 s buckets
+#define REALTIME_WINDOW_FINE 1 // One hour in 1 s buckets, only taken on boards with PSRAM
+
+// One bucket of the plot. Values are stored as value >> shift so they fit in
+// 16 bits; shift stays 0 (1 W resolution) until a value exceeds +/-32 kW, and
+// goes back down once the values needing it have left the ring.
+struct RealtimeBucket {
+    int16_t avg;
+    int16_t min;
+    int16_t max;
+};
 
 class RealtimePlot {
 public:
     RealtimePlot();
+    ~RealtimePlot();
+    // Allocates a ring of size buckets of periodMs each, dropping what was
+    // recorded so far. Called with the defaults on first update if not done.
+    bool setup(uint32_t periodMs, uint16_t size);
+    // Sets up the ring for one of the REALTIME_WINDOW_* settings, leaving it
+    // alone if it already has that shape
+    bool setWindow(uint8_t window);
     void update(AmsData& data);
     int32_t getValue(uint16_t req);
+    // Fills out with the average for ages offset .. offset+length-1, and min/max
+    // if given, using a single clock reading. Returns the number of values written.
+    uint16_t getValues(uint16_t offset, uint16_t length, int32_t* out, int32_t* min = NULL, int32_t* max = NULL);
     int16_t getSize();
+    uint32_t getPeriod();
 
 private:
-    int8_t* values;
-    uint8_t* scaling;
+    RealtimeBucket* buckets = NULL;
+    uint32_t period = REALTIME_SAMPLE;
+    uint16_t size = 0;
+    uint8_t shift = 0;
 
     unsigned long lastMillis = 0;
-    double lastReading = 0;
+    int64_t lastReading = 0; // Wh
     uint16_t lastPos = 0;
+
+    // Running figures for the bucket being filled
+    int64_t sum = 0;
+    int32_t curMin = 0, curMax = 0;
+    uint16_t count = 0;
+
+    void fit(int32_t val);
+    void shrink();
+    int32_t decode(int16_t val);
+    void store(uint16_t pos, int32_t avg, int32_t min, int32_t max);
+    uint16_t getPos(uint16_t req, unsigned long now, uint16_t pos);
 };
 #endif
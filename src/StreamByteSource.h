@@ -0,0 +1,36 @@
+/**
+ * @copyright Utilitech AS 2023-2026
+ * License: Fair Source
+ * 
+ */
+
+#ifndef _STREAMBYTESOURCE_H
+#define _STREAMBYTESOURCE_H
+
+#include <Arduino.h>
+#include "ByteSource.h"
+
+// The HAN serial port as a ByteSource. Only asks the stream for what it
+// already has, so readBytes does not sit out the stream timeout.
+class StreamByteSource : public ByteSource {
+public:
+    void setStream(Stream* stream) {
+        this->stream = stream;
+    }
+
+    int available() {
+        return stream == NULL ? 0 : stream->available();
+    }
+
+    uint16_t readBytes(uint8_t* buf, uint16_t length) {
+        int n = available();
+        if(n <= 0) return 0;
+        if(n < length) length = n;
+        return stream->readBytes(buf, length);
+    }
+
+private:
+    Stream* stream = NULL;
+};
+
+#endif
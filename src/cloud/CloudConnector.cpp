@@ -266,8 +266,8 @@ void CloudConnector::update(AmsData& data, EnergyAccounting& ea) {
             timezone,
             data.getMeterType(),
             meterManufacturer(data.getMeterType()).c_str(),
-            data.getMeterModel().c_str(),
-            data.getMeterId().c_str(),
+            data.getMeterModel(),
+            data.getMeterId(),
             distributionSystemStr(distributionSystem).c_str(),
             mainFuse,
             maxPwr,
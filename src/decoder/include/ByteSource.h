@@ -0,0 +1,39 @@
+/**
+ * @copyright Utilitech AS 2023-2026
+ * License: Fair Source
+ * 
+ */
+
+#ifndef _BYTESOURCE_H
+#define _BYTESOURCE_H
+
+#include <stdint.h>
+
+// Where the HAN bytes come from. On the device this is the serial port, in
+// native tests and benchmarks a capture in memory.
+class ByteSource {
+public:
+    virtual ~ByteSource() {}
+    // Bytes that can be read right away
+    virtual int available() = 0;
+    // Reads up to length bytes of what is available, without waiting for more
+    virtual uint16_t readBytes(uint8_t* buf, uint16_t length) = 0;
+};
+
+// Hands out a buffer, at most chunk bytes per call if set, as a UART FIFO
+// would when polled
+class MemoryByteSource : public ByteSource {
+public:
+    MemoryByteSource(const uint8_t* data, uint16_t length, uint16_t chunk = 0);
+    int available();
+    uint16_t readBytes(uint8_t* buf, uint16_t length);
+    uint16_t getPosition();
+
+private:
+    const uint8_t* data;
+    uint16_t length;
+    uint16_t chunk;
+    uint16_t position = 0;
+};
+
+#endif
@@ -7,8 +7,11 @@
 #ifndef _COSEM_H
 #define _COSEM_H
 
+#include <stddef.h>
 #include "byteorder.h"
 
+#define COSEM_MAX_WALK 900
+
 // Blue book, Table 2
 enum CosemType {
     CosemTypeNull = 0x00,
@@ -99,4 +102,29 @@ typedef union {
 
 time_t decodeCosemDateTime(CosemDateTime timestamp);
 
+// Number of bytes the item occupies in a flat payload, containers count only
+// their own header so a walk visits their elements next
+uint16_t cosemItemSize(const CosemData* item);
+
+// Forward-only walk over a flat COSEM payload. Reading a positional list in
+// order costs one step per item, where looking up each index from the start
+// of the payload costs a walk per item. Stops COSEM_MAX_WALK bytes in.
+class CosemCursor {
+public:
+    CosemCursor(const char* ptr) : ptr(ptr), pos(ptr) {}
+    // Item at the cursor, or NULL past the end of the walk
+    CosemData* peek();
+    // Item at the cursor, then steps past it
+    CosemData* next();
+    void skip(uint8_t count);
+    // Item at the given index, which must not be behind the cursor
+    CosemData* at(uint8_t index);
+    uint16_t index() { return idx; }
+
+private:
+    const char* ptr;
+    const char* pos;
+    uint16_t idx = 0;
+};
+
 #endif
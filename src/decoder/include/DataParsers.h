@@ -14,6 +14,7 @@
 #include "GbtParser.h"
 #include "GcmParser.h"
 #include "LlcParser.h"
+#include "FrameAssembler.h"
 
 #endif
 
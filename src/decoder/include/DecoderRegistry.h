@@ -0,0 +1,69 @@
+/**
+ * @copyright Utilitech AS 2023-2026
+ * License: Fair Source
+ * 
+ */
+
+#ifndef _DECODERREGISTRY_H
+#define _DECODERREGISTRY_H
+
+#include "AmsData.h"
+#include "AmsConfiguration.h"
+#include "DataParser.h"
+#include "Timezone.h"
+#if defined(AMS_REMOTE_DEBUG)
+#include "RemoteDebug.h"
+#endif
+
+#define DECODER_REGISTRY_SIZE 8
+
+// What a decoder has to work with besides the application data
+struct DecoderInput {
+    const char* payload;
+    Timezone* tz;
+    MeterConfig* meterConfig;
+    DataParserContext* ctx;
+    AmsData* state;
+    #if defined(AMS_REMOTE_DEBUG)
+    RemoteDebug* debugger;
+    #else
+    Stream* debugger;
+    #endif
+};
+
+// Cheap look at the first items of the payload, nothing is decoded
+typedef bool (*DecoderMatch)(const char* payload);
+// Returns false if the payload did not decode after all
+typedef bool (*DecoderDecode)(DecoderInput& in, AmsData& data);
+
+struct DecoderEntry {
+    uint8_t id;
+    const char* name;
+    DecoderMatch match;
+    DecoderDecode decode;
+};
+
+// The payload formats the communicator can decode. Formats are tried in the
+// order they were added and the first one whose signature matches decodes.
+// A meter sticks to its format, so the one that decoded last is tried first
+// and, as long as its signature matches, the others are not looked at.
+class DecoderRegistry {
+public:
+    // Returns false if the registry is full
+    bool add(uint8_t id, const char* name, DecoderMatch match, DecoderDecode decode);
+    bool decode(DecoderInput& in, AmsData& data);
+    // Entry that decoded last, NULL until one has
+    const DecoderEntry* getCached();
+    // Entry the last payload went to, NULL if none matched
+    const DecoderEntry* getLast();
+    // Forgets the cached entry, for when the meter may have changed
+    void reset();
+
+private:
+    DecoderEntry entries[DECODER_REGISTRY_SIZE];
+    uint8_t count = 0;
+    int8_t cached = -1;
+    int8_t last = -1;
+};
+
+#endif
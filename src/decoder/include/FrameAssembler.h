@@ -0,0 +1,37 @@
+/**
+ * @copyright Utilitech AS 2023-2026
+ * License: Fair Source
+ * 
+ */
+
+#ifndef _FRAMEASSEMBLER_H
+#define _FRAMEASSEMBLER_H
+
+#include <stdint.h>
+#include "DataParser.h"
+
+// Tracks the outer frame (HDLC, M-Bus or DSMR) while it is received byte by
+// byte, so the unwrap pipeline (and with it CRC and GCM) only has to run once
+// the frame boundary has arrived instead of rescanning the buffer per byte.
+class FrameAssembler {
+public:
+    // Call after buf[len-1] was appended. A length of 1 starts a new frame.
+    // Returns true when the buffer holds a candidate frame that should be
+    // unwrapped. Formats without a known boundary return true for every byte.
+    bool append(const uint8_t* buf, uint16_t len);
+    // Same as calling append for each of buf[from..len-1]. Returns the length
+    // at which a candidate frame is complete, or 0 if it is not yet.
+    uint16_t scan(const uint8_t* buf, uint16_t from, uint16_t len);
+    // How many bytes can be read in one go with len in the buffer, without
+    // reading past a point where the frame may be complete. 0 means no limit.
+    uint16_t wanted(uint16_t len);
+    uint16_t getExpectedLength();
+    void reset();
+
+private:
+    uint8_t tag = DATA_TAG_NONE;
+    uint16_t expected = 0;
+    bool dsmrCrcLine = false;
+};
+
+#endif
@@ -0,0 +1,45 @@
+/**
+ * @copyright Utilitech AS 2023-2026
+ * License: Fair Source
+ * 
+ */
+
+#ifndef _FRAMEREADER_H
+#define _FRAMEREADER_H
+
+#include <stdint.h>
+#include "ByteSource.h"
+#include "FrameAssembler.h"
+
+// Fills the HAN buffer from a ByteSource in chunks instead of a byte at a
+// time. A chunk never goes past a frame boundary that is known from the header
+// (HDLC, M-Bus), so the frame ends exactly at the end of the buffer. DSMR is
+// read in bulk until its CRC line, and anything read after the end of the
+// telegram is carried over to the end of the buffer and fed to the next frame.
+class FrameReader {
+public:
+    void begin(uint8_t* buf, uint16_t size);
+    // Reads one chunk. Returns the number of bytes added to the frame, 0 if
+    // there is nothing to read or the buffer is full.
+    uint16_t read(ByteSource& source);
+    // The buffer holds a candidate frame that should be unwrapped
+    bool isComplete();
+    bool isFull();
+    uint16_t getLength();
+    // Bytes received after the frame, kept at the end of the buffer
+    uint16_t getCarry();
+    // The frame was handled, start the next one with what was carried over
+    void next();
+    // Drops the frame and anything carried over
+    void flush();
+
+private:
+    uint8_t* buf = NULL;
+    uint16_t size = 0;
+    uint16_t length = 0;
+    uint16_t carry = 0;
+    bool complete = false;
+    FrameAssembler assembler;
+};
+
+#endif
@@ -10,6 +10,7 @@
 #include <stdint.h>
 #include <stddef.h>
 #include "DataParser.h"
+#include "ReassemblyArena.h"
 
 #define GBT_TAG 0xE0
 
@@ -23,11 +24,13 @@ typedef struct GBTHeader {
 
 class GBTParser {
 public:
+    GBTParser(ReassemblyArena* arena = NULL) : arena(arena) {}
+    // Returns DATA_PARSE_FINAL_SEGMENT with the APDU in the arena and
+    // ctx.length set once the last block has arrived
     int8_t parse(uint8_t *buf, DataParserContext &ctx);
 private:
+    ReassemblyArena* arena;
     uint8_t lastSequenceNumber = 0;
-    uint16_t pos = 0;
-    uint8_t *buf  = NULL;
 };
 
 #endif
@@ -9,19 +9,37 @@
 
 #include <stdint.h>
 #include "DataParser.h"
+#if defined(ESP8266)
+#include "bearssl/bearssl.h"
+#elif defined(ESP32) || (defined(NATIVE_TEST) && defined(HAVE_MBEDTLS))
+#include "mbedtls/gcm.h"
+#endif
 
 #define GCM_TAG 0xDB
 #define GCM_AUTH_FAILED -51
 #define GCM_DECRYPT_FAILED -52
 #define GCM_ENCRYPTION_KEY_FAILED -53
 
+// The AES key schedule is set up once in the constructor and reused for every
+// frame; the ciphertext is decrypted in place in the caller's buffer.
 class GCMParser {
 public:
     GCMParser(uint8_t *encryption_key, uint8_t *authentication_key);
+    ~GCMParser();
+    GCMParser(const GCMParser&) = delete;
+    GCMParser& operator=(const GCMParser&) = delete;
     int8_t parse(uint8_t *buf, DataParserContext &ctx, bool hastag = true);
 private:
     uint8_t encryption_key[16];
     uint8_t authentication_key[16];
+    bool authenticate = false;
+    bool keyReady = false;
+    #if defined(ESP8266)
+    br_aes_ct_ctr_keys aesKeys;
+    br_gcm_context gcmCtx;
+    #elif defined(ESP32) || (defined(NATIVE_TEST) && defined(HAVE_MBEDTLS))
+    mbedtls_gcm_context gcmCtx;
+    #endif
 };
 
 #endif
@@ -10,6 +10,7 @@
 #include <stdint.h>
 #include <stddef.h>
 #include "DataParser.h"
+#include "ReassemblyArena.h"
 
 #define HDLC_FLAG 0x7E
 
@@ -30,12 +31,14 @@ typedef struct HDLC3CtrlHcs {
 
 class HDLCParser {
 public:
+    HDLCParser(ReassemblyArena* arena = NULL) : arena(arena) {}
+    // Returns DATA_PARSE_FINAL_SEGMENT when the last segment of a segmented
+    // APDU completed it, the APDU is then in the arena with ctx.length set
     int8_t parse(uint8_t *buf, DataParserContext &ctx);
 
 private:
+    ReassemblyArena* arena;
     uint8_t lastSequenceNumber = 0;
-    uint16_t pos = 0;
-    uint8_t *buf  = NULL;
 };
 
 #endif
@@ -12,13 +12,37 @@
 #include "Timezone.h"
 #include "AmsConfiguration.h"
 
+// Fields picked out of a P1 telegram, in the order of P1_FIELDS in the .cpp.
+// The four accumulated registers (1.8.x - 4.8.x) follow, nine tariffs each.
+enum P1Field {
+    P1MeterId, P1MeterId2, P1MeterModel, P1MeterModel2, P1Timestamp,
+    P1ActiveImport, P1ActiveExport, P1ReactiveImport, P1ReactiveExport,
+    P1L1Voltage, P1L2Voltage, P1L3Voltage,
+    P1L1Current, P1L2Current, P1L3Current,
+    P1L1ActiveImport, P1L2ActiveImport, P1L3ActiveImport,
+    P1L1ActiveExport, P1L2ActiveExport, P1L3ActiveExport,
+    P1Counters,
+    P1FieldCount = P1Counters + 4 * 9
+};
+
+// Position of a field value inside the telegram, between the parentheses.
+// offset 0 means the code was not seen.
+struct P1Value {
+    uint16_t offset;
+    uint8_t length;
+};
+
 class IEC6205621 : public AmsData {
 public:
     IEC6205621(const char* payload, Timezone* tz, MeterConfig* meterConfig);
 
 private:
-    String extract(String payload, String obis);
-    double extractDouble(String payload, String obis);
-    float extractFloat(String payload, String obis);
+    const char* telegram = NULL;
+    P1Value fields[P1FieldCount];
+
+    void tokenize(const char* start, const char* end);
+    uint8_t extract(P1Field field, char* target, uint8_t size);
+    double extractDouble(uint8_t field);
+    float extractFloat(uint8_t field);
 };
 #endif
@@ -11,6 +11,7 @@
 #include "AmsConfiguration.h"
 #include "DataParser.h"
 #include "Cosem.h"
+#include "ObisIndex.h"
 #include "Timezone.h"
 #if defined(AMS_REMOTE_DEBUG)
 #include "RemoteDebug.h"
@@ -23,16 +24,61 @@ struct AmsOctetTimestamp {
     CosemDateTime dt;
 } __attribute__((packed));
 
+// Where an item of a vendor list without OBIS codes ends up. The lists are
+// described by PositionalValue tables in the .cpp and read in one pass.
+enum PositionalField {
+    PosSkip, PosMeterId, PosMeterModel,
+    PosActiveImport, PosActiveExport, PosReactiveImport, PosReactiveExport,
+    PosL1Voltage, PosL2Voltage, PosL3Voltage,
+    PosL1Current, PosL2Current, PosL3Current,
+    PosPowerFactor,
+    PosL1ActiveImport, PosL2ActiveImport, PosL3ActiveImport,
+    PosL1ActiveExport, PosL2ActiveExport, PosL3ActiveExport,
+    PosActiveImportCounter, PosActiveImportCounterT1, PosActiveImportCounterT2,
+    PosActiveExportCounter, PosActiveExportCounterT1, PosActiveExportCounterT2,
+    PosReactiveImportCounter, PosReactiveExportCounter
+};
+
+// One list item: its target, the COSEM type it is read as (strings are read
+// as octet strings) and what the raw value is divided by
+struct PositionalValue {
+    uint8_t field;
+    uint8_t type;
+    uint16_t divisor;
+};
+
+// Vendor lists without OBIS codes that are known by their list identifier
+enum DlmsListFormat {
+    DlmsListAuto = 0,
+    DlmsListKaifa,
+    DlmsListIskra
+};
+
 class IEC6205675 : public AmsData {
 public:
+    // listFormat skips looking at the list identifier when the caller already did
     #if defined(AMS_REMOTE_DEBUG)
-    IEC6205675(const char* payload, Timezone* tz, uint8_t useMeterType, MeterConfig* meterConfig, DataParserContext &ctx, AmsData &state, RemoteDebug* debugger);
+    IEC6205675(const char* payload, Timezone* tz, uint8_t useMeterType, MeterConfig* meterConfig, DataParserContext &ctx, AmsData &state, RemoteDebug* debugger, uint8_t listFormat = DlmsListAuto);
     #else
-    IEC6205675(const char* payload, Timezone* tz, uint8_t useMeterType, MeterConfig* meterConfig, DataParserContext &ctx, AmsData &state, Stream* debugger);
+    IEC6205675(const char* payload, Timezone* tz, uint8_t useMeterType, MeterConfig* meterConfig, DataParserContext &ctx, AmsData &state, Stream* debugger, uint8_t listFormat = DlmsListAuto);
     #endif
 
+    // Kaifa or Iskra list from the list identifier in item 1, DlmsListAuto for anything else
+    static uint8_t getListFormat(const char* payload);
+
 private:
+    // Only valid while the constructor runs, the index lives on its stack
+    ObisIndex* obisIndex = NULL;
+
+    void readListId(const char* d);
+    void parseKaifa(const char* d, Timezone* tz);
+    void parseIskra(const char* d, AmsData& state);
+    void parseIskraConfigured(const char* d);
+    void identify(const char* d);
+    void parseObis(const char* d, float val, Timezone* tz, uint8_t useMeterType);
+
     CosemData* getCosemDataAt(uint8_t index, const char* ptr);
+    bool readPositional(CosemCursor& cursor, const PositionalValue* values, uint8_t count);
     CosemData* findObis(uint8_t* obis, int matchlength, const char* ptr);
     uint8_t getString(uint8_t* obis, int matchlength, const char* ptr, char* target);
     float getNumber(uint8_t* obis, int matchlength, const char* ptr);
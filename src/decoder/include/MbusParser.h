@@ -10,6 +10,7 @@
 #include <stdint.h>
 #include <stddef.h>
 #include "DataParser.h"
+#include "ReassemblyArena.h"
 
 #define MBUS_START 0x68
 #define MBUS_END 0x16
@@ -29,12 +30,13 @@ typedef struct MbusFooter {
 
 class MBUSParser {
 public:
+    MBUSParser(ReassemblyArena* arena = NULL) : arena(arena) {}
+    // Returns DATA_PARSE_FINAL_SEGMENT when the last segment of a segmented
+    // APDU completed it, the APDU is then in the arena with ctx.length set
     int8_t parse(uint8_t *buf, DataParserContext &ctx);
-	uint16_t write(const uint8_t* d, DataParserContext &ctx);
 private:
+    ReassemblyArena* arena;
     uint8_t lastSequenceNumber = 0;
-    uint16_t pos = 0;
-    uint8_t *buf  = NULL;
     uint8_t checksum(const uint8_t* p, int len);
 };
 
@@ -0,0 +1,39 @@
+/**
+ * @copyright Utilitech AS 2023-2026
+ * License: Fair Source
+ * 
+ */
+
+#ifndef _OBISINDEX_H
+#define _OBISINDEX_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "Cosem.h"
+
+#define OBIS_INDEX_BITS 6
+#define OBIS_INDEX_SLOTS (1 << OBIS_INDEX_BITS)
+#define OBIS_INDEX_MAX_ENTRIES 48
+#define OBIS_INDEX_MAX_WALK 900
+
+// Index from OBIS code (C.D.E.F) to the COSEM item that follows it in the
+// payload, built with a single walk so each lookup is constant time. Follows
+// the same walk and first-match rules as IEC6205675::findObis.
+class ObisIndex {
+public:
+    void build(const char* ptr);
+    // Returns false if the code could not be resolved by the index (it
+    // overflowed), in which case the caller has to walk the payload itself
+    bool lookup(const uint8_t* obis, CosemData** item);
+
+private:
+    const char* ptr = NULL;
+    uint32_t keys[OBIS_INDEX_SLOTS];
+    uint16_t offsets[OBIS_INDEX_SLOTS];
+    uint8_t count = 0;
+    bool overflow = false;
+
+    uint8_t slot(uint32_t key);
+};
+
+#endif
@@ -0,0 +1,39 @@
+/**
+ * @copyright Utilitech AS 2023-2026
+ * License: Fair Source
+ * 
+ */
+
+#ifndef _REASSEMBLYARENA_H
+#define _REASSEMBLYARENA_H
+
+#include <stdint.h>
+#include "DataParser.h"
+
+#define REASSEMBLY_ARENA_SIZE 1024
+
+// Buffer that HDLC, M-Bus and GBT collect the segments of a multi-segment
+// APDU in. Owned by the communicator and shared by its parsers, only one APDU
+// is assembled at a time. The parser that started it (by its tag) is the only
+// one allowed to append, and nothing is written past REASSEMBLY_ARENA_SIZE.
+// Once complete, the APDU is parsed where it is, it is not copied back.
+class ReassemblyArena {
+public:
+    // Starts a new APDU for owner, dropping anything collected so far
+    void begin(uint8_t owner);
+    // Returns false if owner did not start the APDU, or if the segment does
+    // not fit, which drops the APDU
+    bool append(uint8_t owner, const uint8_t* segment, uint16_t length);
+    void reset();
+
+    uint8_t* getData();
+    uint16_t getLength();
+    uint16_t getSize();
+
+private:
+    uint8_t buf[REASSEMBLY_ARENA_SIZE];
+    uint16_t length = 0;
+    uint8_t owner = DATA_TAG_NONE;
+};
+
+#endif
@@ -0,0 +1,102 @@
+/**
+ * @copyright Utilitech AS 2023-2026
+ * License: Fair Source
+ * 
+ */
+
+#ifndef _SERIALAUTODETECT_H
+#define _SERIALAUTODETECT_H
+
+#include <stdint.h>
+
+#define AUTODETECT_HEADER_MAX 16
+// Silence before a byte that makes it the start of a frame
+#define AUTODETECT_SYNC_GAP 100
+// Bytes that are enough to judge a setting by
+#define AUTODETECT_SAMPLE_BYTES 256
+// Silence that ends a burst, meters send one frame and then pause
+#define AUTODETECT_BURST_GAP 500
+// More than one error per this many bytes means the setting is wrong
+#define AUTODETECT_ERROR_RATIO 16
+// Parities to try on a baud rate that shows frame headers with errors
+#define AUTODETECT_PARITY_CHANGES 2
+// Time to wait on a setting if nothing arrives at all
+#define AUTODETECT_MAX_DWELL 12000
+// Time to wait for a decodable frame once a setting looks right
+#define AUTODETECT_CONFIRM_TIMEOUT 30000
+// Bytes of a burst before its rate and content are judged
+#define AUTODETECT_BURST_BYTES 32
+// Time a burst has to last before its byte rate is judged
+#define AUTODETECT_RATE_TIME 100
+// Falling edges in a byte on the line, about; a UART set too fast makes a byte of each
+#define AUTODETECT_EDGES_PER_BYTE 3
+
+struct SerialSetting {
+    uint32_t baud;
+    uint8_t parity; // Same ordinals as MeterConfig, 3 = 8N1, 10 = 7E1, 11 = 8E1
+    bool invert;
+};
+
+// What the bytes received under one setting looked like
+struct SerialScore {
+    uint16_t bytes;
+    uint16_t errors;      // Framing and parity errors reported by the UART
+    uint16_t printable;   // ASCII text, as in DSMR telegrams
+    uint16_t printable7;  // ASCII text when the 8th bit is ignored
+    uint8_t headers;      // HDLC headers with a valid HCS, M-Bus long frame headers, DSMR identification lines
+    uint8_t headers7;     // DSMR identification lines when the 8th bit is ignored
+};
+
+// Finds the serial setting of an unknown meter from the bytes it receives.
+// Each candidate is scored from what arrives while it is active, and a frame
+// header seen under a setting decides it on the spot. Headers or text with
+// frequent errors mean the baud rate is right and the parity is not, and text that
+// only reads with the 8th bit masked means 7E1, so those jump straight to
+// the setting that fits. Garbage that comes slower than the baud rate set is
+// a meter sending at a lower rate, and garbage at the full rate of the fastest
+// candidate an inverted line, so those jump to the baud rate the byte rate
+// points at without waiting for the burst to end. The communicator then
+// confirms with one frame that decodes. No Arduino dependencies, so it runs
+// on native as well.
+class SerialAutodetect {
+public:
+    void begin(unsigned long now);
+    // Every byte received under current()
+    void sample(uint8_t b, unsigned long now);
+    // Framing or parity error reported by the UART
+    void error();
+    // Returns true if the port has to be set up with current()
+    bool update(unsigned long now);
+    SerialSetting current();
+    bool isConfirming();
+    SerialScore getScore();
+
+private:
+    SerialSetting setting = { 0, 0, false };
+    SerialScore score;
+    uint8_t candidate = 0;
+    uint16_t tried = 0; // Bit per candidate
+    uint8_t parityChanges = 0;
+    bool confirming = false;
+    bool synced = false;
+    unsigned long started = 0, lastByte = 0;
+
+    // The burst in progress, synced or not
+    uint16_t burstBytes = 0, burstText = 0, burstErrors = 0;
+    unsigned long burstStart = 0;
+
+    uint8_t header[AUTODETECT_HEADER_MAX];
+    uint8_t headerLength = 0;
+    uint8_t tail[5];
+
+    void use(SerialSetting setting, unsigned long now);
+    void pick(uint8_t candidate, unsigned long now);
+    void next(unsigned long now);
+    bool jump(uint32_t baud, unsigned long now);
+    bool changeParity(unsigned long now);
+    bool garbage();
+    bool decide(unsigned long now);
+    bool hdlcHeader(uint8_t b);
+};
+
+#endif
@@ -9,7 +9,25 @@
 
 #include <stdint.h>
 
+// Number of lookup tables per polynomial, 1 (byte at a time), 4 or 8 (slice-by-4/8).
+// More slices process more bytes per step at the cost of 512 bytes of flash per table.
+#ifndef CRC_SLICES
+#define CRC_SLICES 1
+#endif
+#if CRC_SLICES != 1 && CRC_SLICES != 4 && CRC_SLICES != 8
+#error "CRC_SLICES must be 1, 4 or 8"
+#endif
+
+#define CRC16_INIT 0x0000
+#define CRC16_X25_INIT 0xFFFF
+
 uint16_t crc16(const uint8_t* p, int len);
 uint16_t crc16_x25(const uint8_t* p, int len);
 
+// Running state, so a checksum can be continued as more bytes arrive
+uint16_t crc16_update(uint16_t crc, const uint8_t* p, int len);
+uint16_t crc16_x25_update(uint16_t crc, const uint8_t* p, int len);
+// Value as transmitted in HDLC HCS/FCS, comparable to ntohs() of the field
+uint16_t crc16_x25_final(uint16_t crc);
+
 #endif
@@ -0,0 +1,31 @@
+/**
+ * @copyright Utilitech AS 2023-2026
+ * License: Fair Source
+ * 
+ */
+
+#include "ByteSource.h"
+#include <string.h>
+
+MemoryByteSource::MemoryByteSource(const uint8_t* data, uint16_t length, uint16_t chunk) {
+    this->data = data;
+    this->length = length;
+    this->chunk = chunk;
+}
+
+int MemoryByteSource::available() {
+    uint16_t left = length - position;
+    return chunk > 0 && chunk < left ? chunk : left;
+}
+
+uint16_t MemoryByteSource::readBytes(uint8_t* buf, uint16_t length) {
+    uint16_t n = available();
+    if(length < n) n = length;
+    memcpy(buf, data + position, n);
+    position += n;
+    return n;
+}
+
+uint16_t MemoryByteSource::getPosition() {
+    return position;
+}
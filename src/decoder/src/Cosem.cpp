@@ -27,4 +27,51 @@ time_t decodeCosemDateTime(CosemDateTime timestamp) {
         t += deviation * 60;
     }
     return t;
-}
\ No newline at end of file
+}
+uint16_t cosemItemSize(const CosemData* item) {
+    switch(item->base.type) {
+        case CosemTypeArray:
+        case CosemTypeStructure:
+            return 2;
+        case CosemTypeOctetString:
+        case CosemTypeString:
+            return 2 + item->base.length;
+        case CosemTypeLongSigned:
+        case CosemTypeLongUnsigned:
+            return 3;
+        case CosemTypeDLongSigned:
+        case CosemTypeDLongUnsigned:
+            return 5;
+        case CosemTypeLong64Signed:
+        case CosemTypeLong64Unsigned:
+            return 9;
+        case CosemTypeNull:
+            return 1;
+        default:
+            return 2;
+    }
+}
+
+CosemData* CosemCursor::peek() {
+    if(pos-ptr >= COSEM_MAX_WALK) return NULL;
+    return (CosemData*) pos;
+}
+
+CosemData* CosemCursor::next() {
+    CosemData* item = peek();
+    if(item != NULL) {
+        pos += cosemItemSize(item);
+        idx++;
+    }
+    return item;
+}
+
+void CosemCursor::skip(uint8_t count) {
+    while(count-- > 0 && next() != NULL);
+}
+
+CosemData* CosemCursor::at(uint8_t index) {
+    if(index < idx) return NULL;
+    skip(index - idx);
+    return idx == index ? peek() : NULL;
+}
@@ -0,0 +1,47 @@
+/**
+ * @copyright Utilitech AS 2023-2026
+ * License: Fair Source
+ * 
+ */
+
+#include "DecoderRegistry.h"
+
+bool DecoderRegistry::add(uint8_t id, const char* name, DecoderMatch match, DecoderDecode decode) {
+    if(count >= DECODER_REGISTRY_SIZE) return false;
+    entries[count++] = { id, name, match, decode };
+    return true;
+}
+
+bool DecoderRegistry::decode(DecoderInput& in, AmsData& data) {
+    if(cached >= 0) {
+        DecoderEntry& e = entries[cached];
+        if(e.match(in.payload)) {
+            last = cached;
+            bool decoded = e.decode(in, data);
+            // Nothing came out of it, look at all of them again next time
+            if(!decoded || data.getListType() == 0) cached = -1;
+            return decoded;
+        }
+    }
+    for(uint8_t i = 0; i < count; i++) {
+        if(!entries[i].match(in.payload)) continue;
+        last = i;
+        bool decoded = entries[i].decode(in, data);
+        cached = decoded && data.getListType() > 0 ? i : -1;
+        return decoded;
+    }
+    cached = last = -1;
+    return false;
+}
+
+const DecoderEntry* DecoderRegistry::getCached() {
+    return cached >= 0 ? &entries[cached] : NULL;
+}
+
+const DecoderEntry* DecoderRegistry::getLast() {
+    return last >= 0 ? &entries[last] : NULL;
+}
+
+void DecoderRegistry::reset() {
+    cached = -1;
+}
@@ -0,0 +1,85 @@
+/**
+ * @copyright Utilitech AS 2023-2026
+ * License: Fair Source
+ * 
+ */
+
+#include "FrameAssembler.h"
+#include "HdlcParser.h"
+#include "MbusParser.h"
+
+bool FrameAssembler::append(const uint8_t* buf, uint16_t len) {
+    if(len == 0) return false;
+    if(len == 1) {
+        reset();
+        tag = buf[0];
+    }
+
+    switch(tag) {
+        case DATA_TAG_HDLC:
+            if(len < 3) return false;
+            if(expected == 0) {
+                // Not frame format type 3, let the parser reject it
+                if((buf[1] & 0xF0) != 0xA0) return true;
+                // Length field (11 lsb of format) excludes the opening and closing flag
+                expected = ((((uint16_t) buf[1]) << 8 | buf[2]) & 0x7FF) + 2;
+            }
+            return len >= expected;
+        case DATA_TAG_MBUS:
+            if(len < 4) return false;
+            if(expected == 0) {
+                // Malformed or open length header, let the parser decide
+                if(buf[3] != MBUS_START || buf[1] != buf[2] || buf[1] == 0x00) return true;
+                expected = buf[1];
+                // Same rule as MBUSParser, lengths below the header size wrap (Austrian meters)
+                if(expected < sizeof(MbusHeader)) expected += 256;
+                expected += sizeof(MbusHeader) + sizeof(MbusFooter);
+            }
+            return len >= expected;
+        case DATA_TAG_DSMR:
+            // Telegram ends at the first LF after the '!' that starts the CRC line
+            if(len > 1 && buf[len-1] == '!') {
+                dsmrCrcLine = true;
+            } else if(dsmrCrcLine && buf[len-1] == 0x0A) {
+                return true;
+            }
+            return false;
+    }
+    return true;
+}
+
+uint16_t FrameAssembler::scan(const uint8_t* buf, uint16_t from, uint16_t len) {
+    for(uint16_t i = from; i < len; i++) {
+        // Once the length is known the bytes in between do not matter
+        if(expected > 0 && i > 0) return len >= expected ? (expected > i ? expected : i + 1) : 0;
+        if(append(buf, i + 1)) return i + 1;
+    }
+    return 0;
+}
+
+uint16_t FrameAssembler::wanted(uint16_t len) {
+    if(len == 0) return 1;
+    switch(tag) {
+        case DATA_TAG_HDLC:
+            if(len < 3) return 3 - len;
+            return expected > len ? expected - len : 1;
+        case DATA_TAG_MBUS:
+            if(len < 4) return 4 - len;
+            return expected > len ? expected - len : 1;
+        case DATA_TAG_DSMR:
+            // The CRC line is short, take it a byte at a time to stop at its LF
+            return dsmrCrcLine ? 1 : 0;
+    }
+    // Unknown framing is unwrapped after every byte
+    return 1;
+}
+
+uint16_t FrameAssembler::getExpectedLength() {
+    return expected;
+}
+
+void FrameAssembler::reset() {
+    tag = DATA_TAG_NONE;
+    expected = 0;
+    dsmrCrcLine = false;
+}
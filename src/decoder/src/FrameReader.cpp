@@ -0,0 +1,71 @@
+/**
+ * @copyright Utilitech AS 2023-2026
+ * License: Fair Source
+ * 
+ */
+
+#include "FrameReader.h"
+#include <string.h>
+
+void FrameReader::begin(uint8_t* buf, uint16_t size) {
+    this->buf = buf;
+    this->size = size;
+    flush();
+}
+
+uint16_t FrameReader::read(ByteSource& source) {
+    uint16_t space = size - length - carry;
+    if(space == 0) return 0;
+    uint16_t want = assembler.wanted(length);
+    if(want == 0 || want > space) want = space;
+
+    uint16_t from = length;
+    uint16_t n;
+    if(carry > 0) {
+        n = want < carry ? want : carry;
+        memmove(buf + length, buf + size - carry, n);
+        carry -= n;
+    } else {
+        n = source.readBytes(buf + length, want);
+        if(n == 0) return 0;
+    }
+    length += n;
+
+    uint16_t end = assembler.scan(buf, from, length);
+    complete = end > 0;
+    if(complete && end < length) {
+        // Start of the next frame, keep it behind anything already carried
+        uint16_t extra = length - end;
+        memmove(buf + size - carry - extra, buf + end, extra);
+        carry += extra;
+        length = end;
+    }
+    return length - from;
+}
+
+bool FrameReader::isComplete() {
+    return complete;
+}
+
+bool FrameReader::isFull() {
+    return length + carry >= size;
+}
+
+uint16_t FrameReader::getLength() {
+    return length;
+}
+
+uint16_t FrameReader::getCarry() {
+    return carry;
+}
+
+void FrameReader::next() {
+    length = 0;
+    complete = false;
+    assembler.reset();
+}
+
+void FrameReader::flush() {
+    carry = 0;
+    next();
+}
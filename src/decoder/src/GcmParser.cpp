@@ -6,12 +6,7 @@
 
 #include "GcmParser.h"
 #include "byteorder.h"
-#if defined(ESP8266)
-#include "bearssl/bearssl.h"
-#elif defined(ESP32)
-#include "mbedtls/gcm.h"
-#elif defined(NATIVE_TEST) && defined(HAVE_MBEDTLS)
-#include "mbedtls/gcm.h"   // host (native tests) — system mbedTLS (2.x or 3.x)
+#if defined(ESP32) || (defined(NATIVE_TEST) && defined(HAVE_MBEDTLS))
 #if defined(__has_include) && __has_include("mbedtls/build_info.h")
 #include "mbedtls/build_info.h"   // 3.x defines MBEDTLS_VERSION_MAJOR here
 #elif defined(__has_include) && __has_include("mbedtls/version.h")
@@ -23,6 +18,22 @@
 GCMParser::GCMParser(uint8_t *encryption_key, uint8_t *authentication_key) {
     memcpy(this->encryption_key, encryption_key, 16);
     memcpy(this->authentication_key, authentication_key, 16);
+    for(uint8_t i = 0; i < 16; i++) authenticate |= authentication_key[i] > 0;
+
+    #if defined(ESP8266)
+        br_aes_ct_ctr_init(&aesKeys, this->encryption_key, 16);
+        br_gcm_init(&gcmCtx, &aesKeys.vtable, br_ghash_ctmul32);
+        keyReady = true;
+    #elif defined(ESP32) || (defined(NATIVE_TEST) && defined(HAVE_MBEDTLS))
+        mbedtls_gcm_init(&gcmCtx);
+        keyReady = mbedtls_gcm_setkey(&gcmCtx, MBEDTLS_CIPHER_ID_AES, this->encryption_key, 128) == 0;
+    #endif
+}
+
+GCMParser::~GCMParser() {
+    #if defined(ESP32) || (defined(NATIVE_TEST) && defined(HAVE_MBEDTLS))
+        mbedtls_gcm_free(&gcmCtx);
+    #endif
 }
 
 int8_t GCMParser::parse(uint8_t *d, DataParserContext &ctx, bool hastag) {
@@ -95,7 +106,6 @@ int8_t GCMParser::parse(uint8_t *d, DataParserContext &ctx, bool hastag) {
     int footersize = 0;
 
     // Authentication enabled
-    bool authenticate = false;
     uint8_t authentication_tag[12];
     uint8_t authkeylen = 0, aadlen = 0;
     if((sec & 0x10) == 0x10) {
@@ -107,108 +117,57 @@ int8_t GCMParser::parse(uint8_t *d, DataParserContext &ctx, bool hastag) {
         footersize += authkeylen;
         memcpy(additional_authenticated_data + 1, authentication_key, 16);
         memcpy(authentication_tag, ptr + len - footersize - 5, authkeylen);
-        for(uint8_t i = 0; i < 16; i++) authenticate |= authentication_key[i] > 0;
     }
 
-    // Guard the ciphertext length (len - authkeylen - 5) against underflow so a
-    // short/garbage length can't blow the stack via the cipher_text buffer.
+    // Guard the ciphertext length (len - authkeylen - 5) against underflow
     if(len < (uint32_t)authkeylen + 5) return GCM_DECRYPT_FAILED;
+    size_t cipherlen = len - authkeylen - 5; // 5 == security tag and frame counter
+
+    if(!keyReady) return GCM_ENCRYPTION_KEY_FAILED;
 
     #if defined(ESP8266)
-        br_gcm_context gcmCtx;
-        br_aes_ct_ctr_keys bc;
-        br_aes_ct_ctr_init(&bc, encryption_key, 16);
-        br_gcm_init(&gcmCtx, &bc.vtable, br_ghash_ctmul32);
         br_gcm_reset(&gcmCtx, initialization_vector, sizeof(initialization_vector));
-        if(authenticate) {
+        if(authenticate && authkeylen > 0) {
             br_gcm_aad_inject(&gcmCtx, additional_authenticated_data, aadlen);
         }
         br_gcm_flip(&gcmCtx);
-        br_gcm_run(&gcmCtx, 0, (void*) (ptr), len - authkeylen - 5); // 5 == security tag and frame counter
+        br_gcm_run(&gcmCtx, 0, (void*) (ptr), cipherlen);
         if(authkeylen > 0 && br_gcm_check_tag_trunc(&gcmCtx, authentication_tag, authkeylen) != 1) {
             return GCM_AUTH_FAILED;
         }
-    #elif defined(ESP32)
-        uint8_t cipher_text[len - authkeylen - 5];
-        memcpy(cipher_text, ptr, len - authkeylen - 5);
-
-        mbedtls_gcm_context m_ctx;
-        mbedtls_gcm_init(&m_ctx);
-        int success = mbedtls_gcm_setkey(&m_ctx, MBEDTLS_CIPHER_ID_AES, encryption_key, 128);
-        if (0 != success) {
-            return GCM_ENCRYPTION_KEY_FAILED;
-        }
-        if (authenticate) {
-            success = mbedtls_gcm_auth_decrypt(&m_ctx, sizeof(cipher_text), initialization_vector, sizeof(initialization_vector),
-                additional_authenticated_data, aadlen, authentication_tag, authkeylen,
-                cipher_text, (unsigned char*)(ptr));
-            if (authkeylen > 0 && success == MBEDTLS_ERR_GCM_AUTH_FAILED) {
-                mbedtls_gcm_free(&m_ctx);
-                return GCM_AUTH_FAILED;
-            } else if(success == MBEDTLS_ERR_GCM_BAD_INPUT) {
-                mbedtls_gcm_free(&m_ctx);
-                return GCM_DECRYPT_FAILED;
-            }
-        } else {
-            success = mbedtls_gcm_starts(&m_ctx, MBEDTLS_GCM_DECRYPT, initialization_vector, sizeof(initialization_vector),NULL, 0);
-            if (0 != success) {
-                mbedtls_gcm_free(&m_ctx);
-                return GCM_DECRYPT_FAILED;
-            }
-            success = mbedtls_gcm_update(&m_ctx, sizeof(cipher_text), cipher_text, (unsigned char*)(ptr));
-            if (0 != success) {
-                mbedtls_gcm_free(&m_ctx);
-                return GCM_DECRYPT_FAILED;
-            }
-        }
-        mbedtls_gcm_free(&m_ctx);
-    #elif defined(NATIVE_TEST) && defined(HAVE_MBEDTLS)
-        // Native host tests with system mbedTLS (3.x API).
-        uint8_t cipher_text[len - authkeylen - 5];
-        memcpy(cipher_text, ptr, len - authkeylen - 5);
-
-        mbedtls_gcm_context m_ctx;
-        mbedtls_gcm_init(&m_ctx);
-        if (mbedtls_gcm_setkey(&m_ctx, MBEDTLS_CIPHER_ID_AES, encryption_key, 128) != 0) {
-            mbedtls_gcm_free(&m_ctx);
-            return GCM_ENCRYPTION_KEY_FAILED;
-        }
-        if (authenticate) {
-            int rc = mbedtls_gcm_auth_decrypt(&m_ctx, sizeof(cipher_text),
+    #elif defined(ESP32) || (defined(NATIVE_TEST) && defined(HAVE_MBEDTLS))
+        // mbedTLS allows input and output to be the same buffer
+        if (authenticate && authkeylen > 0) {
+            int rc = mbedtls_gcm_auth_decrypt(&gcmCtx, cipherlen,
                 initialization_vector, sizeof(initialization_vector),
                 additional_authenticated_data, aadlen,
                 authentication_tag, authkeylen,
-                cipher_text, (unsigned char*)(ptr));
-            if (authkeylen > 0 && rc == MBEDTLS_ERR_GCM_AUTH_FAILED) {
-                mbedtls_gcm_free(&m_ctx);
+                ptr, ptr);
+            if (rc == MBEDTLS_ERR_GCM_AUTH_FAILED) {
                 return GCM_AUTH_FAILED;
             } else if (rc != 0) {
-                mbedtls_gcm_free(&m_ctx);
                 return GCM_DECRYPT_FAILED;
             }
         } else {
         #if defined(MBEDTLS_VERSION_MAJOR) && MBEDTLS_VERSION_MAJOR >= 3
             size_t olen = 0;
-            if (mbedtls_gcm_starts(&m_ctx, MBEDTLS_GCM_DECRYPT,
+            if (mbedtls_gcm_starts(&gcmCtx, MBEDTLS_GCM_DECRYPT,
                     initialization_vector, sizeof(initialization_vector)) != 0 ||
-                mbedtls_gcm_update(&m_ctx, cipher_text, sizeof(cipher_text),
-                    (unsigned char*)(ptr), sizeof(cipher_text), &olen) != 0) {
-                mbedtls_gcm_free(&m_ctx);
+                mbedtls_gcm_update(&gcmCtx, ptr, cipherlen, ptr, cipherlen, &olen) != 0) {
                 return GCM_DECRYPT_FAILED;
             }
-        #else   // mbedTLS 2.x (e.g. Ubuntu libmbedtls-dev) — older API
-            if (mbedtls_gcm_starts(&m_ctx, MBEDTLS_GCM_DECRYPT,
+        #else   // mbedTLS 2.x (ESP32 Arduino core, Ubuntu libmbedtls-dev)
+            if (mbedtls_gcm_starts(&gcmCtx, MBEDTLS_GCM_DECRYPT,
                     initialization_vector, sizeof(initialization_vector), NULL, 0) != 0 ||
-                mbedtls_gcm_update(&m_ctx, sizeof(cipher_text),
-                    cipher_text, (unsigned char*)(ptr)) != 0) {
-                mbedtls_gcm_free(&m_ctx);
+                mbedtls_gcm_update(&gcmCtx, cipherlen, ptr, ptr) != 0) {
                 return GCM_DECRYPT_FAILED;
             }
         #endif
         }
-        mbedtls_gcm_free(&m_ctx);
     #else
         // Native / unsupported platform: decryption not available
+        (void) cipherlen;
+        (void) aadlen;
         return GCM_DECRYPT_FAILED;
     #endif
 
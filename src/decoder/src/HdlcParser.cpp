@@ -7,7 +7,6 @@
 #include "HdlcParser.h"
 #include "byteorder.h"
 #include <string.h>
-#include <stdlib.h>
 #include "crc.h"
 
 int8_t HDLCParser::parse(uint8_t *d, DataParserContext &ctx) {
@@ -26,6 +25,8 @@ int8_t HDLCParser::parse(uint8_t *d, DataParserContext &ctx) {
         len = (ntohs(h->format) & 0x7FF) + 2;
         if(len > ctx.length)
             return DATA_PARSE_INCOMPLETE;
+        if(len < (int) (sizeof *h + sizeof(HDLC3CtrlHcs) + sizeof(HDLCFooter)))
+            return DATA_PARSE_FAIL;
 
         HDLCFooter* f = (HDLCFooter*) (d + len - sizeof *f);
 
@@ -33,25 +34,31 @@ int8_t HDLCParser::parse(uint8_t *d, DataParserContext &ctx) {
         if(h->flag != HDLC_FLAG || f->flag != HDLC_FLAG)
             return DATA_PARSE_BOUNDARY_FLAG_MISSING;
 
-        // Verify FCS
+        // FCS covers everything between the flags, so a corrupt frame is rejected before any of its fields are read
         if(f->fcs > 0 && ntohs(f->fcs) != crc16_x25(d + 1, len - sizeof *f - 1))
             return DATA_PARSE_FOOTER_CHECKSUM_ERROR;
 
+        // Addresses must leave room for control and HCS
+        uint8_t* end = d + len - sizeof *f - sizeof(HDLC3CtrlHcs);
+
         // Skip destination address, LSB marks last byte
-        while(((*ptr) & 0x01) == 0x00) {
+        while(ptr < end && ((*ptr) & 0x01) == 0x00) {
             ptr++;
         }
         ptr++;
 
         // Skip source address, LSB marks last byte
-        while(((*ptr) & 0x01) == 0x00) {
+        while(ptr < end && ((*ptr) & 0x01) == 0x00) {
             ptr++;
         }
         ptr++;
 
+        if(ptr > end)
+            return DATA_PARSE_FAIL;
+
         HDLC3CtrlHcs* t3 = (HDLC3CtrlHcs*) (ptr);
 
-        // Verify HCS
+        // Verify HCS, it covers format, addresses and control
         if(t3->hcs > 0 && ntohs(t3->hcs) != crc16_x25(d + 1, ptr-d))
             return DATA_PARSE_HEADER_CHECKSUM_ERROR;
         ptr += 3;
@@ -64,41 +71,33 @@ int8_t HDLCParser::parse(uint8_t *d, DataParserContext &ctx) {
 
         // Payload incomplete
         if((h->format & 0x08) == 0x08) {
-            if(lastSequenceNumber == 0) {
-                if(buf == NULL) buf = (uint8_t *)malloc((size_t)1024);
-                pos = 0;
-            }
-
-            if(buf == NULL) return DATA_PARSE_FAIL;
+            if(arena == NULL) return DATA_PARSE_FAIL;
+            if(lastSequenceNumber == 0) arena->begin(DATA_TAG_HDLC);
 
             if((*ptr) == DATA_TAG_LLC) {
                 ptr += 3; // Skip LLC
                 ctx.length -= 3;
             }
 
-            memcpy(buf + pos, ptr, ctx.length);
-            pos += ctx.length;
+            if(!arena->append(DATA_TAG_HDLC, ptr, ctx.length)) {
+                lastSequenceNumber = 0;
+                return DATA_PARSE_FAIL;
+            }
 
             lastSequenceNumber++;
             return DATA_PARSE_INTERMEDIATE_SEGMENT;
         } else if(lastSequenceNumber > 0) {
             lastSequenceNumber = 0;
-            if(buf == NULL) return DATA_PARSE_FAIL;
+            if(arena == NULL) return DATA_PARSE_FAIL;
 
             if((*ptr) == DATA_TAG_LLC) {
                 ptr += 3; // Skip LLC
                 ctx.length -= 3;
             }
 
-            memcpy(buf + pos, ptr, ctx.length);
-            pos += ctx.length;
-
-            memcpy((uint8_t *) d, buf, pos);
-            free(buf);
-            buf = NULL;
-            ctx.length = pos;
-            pos = 0;
-            return DATA_PARSE_OK;
+            if(!arena->append(DATA_TAG_HDLC, ptr, ctx.length)) return DATA_PARSE_FAIL;
+            ctx.length = arena->getLength();
+            return DATA_PARSE_FINAL_SEGMENT;
         } else {
             return ptr-d;
         }
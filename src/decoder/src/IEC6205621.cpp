@@ -6,94 +6,165 @@
 
 #include "IEC6205621.h"
 #include "Uptime.h"
+#include <ctype.h>
+
+#define P1_COUNTER(reg, tariff) (P1Counters + ((reg) - 1) * 9 + (tariff))
+
+// OBIS C.D.E of each P1Field before P1Counters, packed as C << 16 | D << 8 | E
+static const uint32_t P1_FIELDS[P1Counters] = {
+	0x600100, // 96.1.0
+	0x000005, // 0.0.5
+	0x600101, // 96.1.1
+	0x600107, // 96.1.7
+	0x010000, // 1.0.0
+	0x010700, 0x020700, 0x030700, 0x040700,
+	0x200700, 0x340700, 0x480700,
+	0x1F0700, 0x330700, 0x470700,
+	0x150700, 0x290700, 0x3D0700,
+	0x160700, 0x2A0700, 0x3E0700
+};
+
+// Parses one group of an OBIS code the way it would be spelled in the
+// telegram: 1-3 digits, no leading zero, at most 255
+static bool parseGroup(const char*& ptr, const char* end, uint8_t& out) {
+	const char* start = ptr;
+	uint16_t val = 0;
+	while(ptr < end && *ptr >= '0' && *ptr <= '9') {
+		val = val * 10 + (*ptr - '0');
+		ptr++;
+		if(ptr - start > 3) return false;
+	}
+	if(ptr == start || val > 255) return false;
+	if(*start == '0' && ptr - start > 1) return false;
+	out = val;
+	return true;
+}
+
+// Maps the C.D.E between ':' and '(' to a P1Field, or -1 if not wanted
+static int8_t lookupField(const char* code, const char* end) {
+	uint8_t c, d, e;
+	if(!parseGroup(code, end, c) || code == end || *code++ != '.') return -1;
+	if(!parseGroup(code, end, d) || code == end || *code++ != '.') return -1;
+	if(!parseGroup(code, end, e) || code != end) return -1;
+
+	if(c >= 1 && c <= 4 && d == 8 && e <= 8) {
+		return P1_COUNTER(c, e);
+	}
+	uint32_t key = ((uint32_t) c << 16) | (d << 8) | e;
+	for(uint8_t i = 0; i < P1Counters; i++) {
+		if(P1_FIELDS[i] == key) return i;
+	}
+	return -1;
+}
+
+static long toInt(const char* str, uint8_t len) {
+	char tmp[8];
+	if(len >= sizeof(tmp)) len = sizeof(tmp) - 1;
+	memcpy(tmp, str, len);
+	tmp[len] = '\0';
+	return strtol(tmp, NULL, 10);
+}
 
 IEC6205621::IEC6205621(const char* p, Timezone* tz, MeterConfig* meterConfig) {
-	if(strlen(p) < 16)
+	size_t length = strlen(p);
+	if(length < 16)
 		return;
 
 	this->packageTimestamp = time(nullptr);
 
-	String payload(p+1);
+	// Everything after the leading '/', as the telegram is never copied
+	const char* payload = p + 1;
+	const char* end = p + length;
+	telegram = p;
+	tokenize(payload, end);
 
 	lastUpdateMillis = millis64();
-	listId = payload.substring(payload.startsWith("/") ? 1 : 0, payload.indexOf("\n"));
+	const char* firstLine = payload[0] == '/' ? payload + 1 : payload;
+	const char* firstLineEnd = (const char*) memchr(payload, '\n', end - payload);
+	if(firstLineEnd == NULL) firstLineEnd = end;
 
-	if(listId.startsWith(F("ADN"))) {
+	uint8_t idLength = 4;
+	if(strncmp(firstLine, "ADN", 3) == 0) {
 		meterType = AmsTypeAidon;
-		listId = listId.substring(0,4);
-	} else if(listId.startsWith(F("KFM"))) {
+	} else if(strncmp(firstLine, "KFM", 3) == 0) {
 		meterType = AmsTypeKaifa;
-		listId = listId.substring(0,4);
-	} else if(listId.startsWith(F("KMP"))) {
+	} else if(strncmp(firstLine, "KMP", 3) == 0) {
 		meterType = AmsTypeKamstrup;
-		listId = listId.substring(0,4);
-	} else if(listId.startsWith(F("KAM"))) {
+	} else if(strncmp(firstLine, "KAM", 3) == 0) {
 		meterType = AmsTypeKamstrup;
-		listId = listId.substring(0,4);
-	} else if(listId.startsWith(F("ISk"))) {
+	} else if(strncmp(firstLine, "ISk", 3) == 0) {
 		meterType = AmsTypeIskra;
-		listId = listId.substring(0,5);
-	} else if(listId.startsWith(F("XMX"))) {
+		idLength = 5;
+	} else if(strncmp(firstLine, "XMX", 3) == 0) {
 		meterType = AmsTypeLandisGyr;
-		listId = listId.substring(0,6);
-	} else if(listId.startsWith(F("Ene")) || listId.startsWith(F("EST"))) {
+		idLength = 6;
+	} else if(strncmp(firstLine, "Ene", 3) == 0 || strncmp(firstLine, "EST", 3) == 0) {
 		meterType = AmsTypeSagemcom;
-		listId = listId.substring(0,4);
-	} else if(listId.startsWith(F("LGF"))) {
+	} else if(strncmp(firstLine, "LGF", 3) == 0) {
 		meterType = AmsTypeLandisGyr;
-		listId = listId.substring(0,4);
 	} else {
 		meterType = AmsTypeUnknown;
-		listId = listId.substring(0,4);
 	}
-	
-	meterId = extract(payload, F("96.1.0"));
-	if(meterId.isEmpty()) {
-		meterId = extract(payload, F("0.0.5"));
+	if(firstLineEnd < firstLine) firstLineEnd = firstLine;
+	if(firstLineEnd - firstLine < idLength) idLength = firstLineEnd - firstLine;
+	memcpy(listId, firstLine, idLength);
+	listId[idLength] = '\0';
+
+	if(extract(P1MeterId, meterId, sizeof(meterId)) == 0) {
+		extract(P1MeterId2, meterId, sizeof(meterId));
 	}
 
-	meterModel = extract(payload, F("96.1.1"));
-	if(meterModel.isEmpty()) {
-		meterModel = extract(payload, F("96.1.7"));
-		if(meterModel.isEmpty()) {
-			meterModel = payload.substring(payload.indexOf(listId) + listId.length(), payload.indexOf(F("\n")));
-			meterModel.trim();
+	if(extract(P1MeterModel, meterModel, sizeof(meterModel)) == 0) {
+		if(extract(P1MeterModel2, meterModel, sizeof(meterModel)) == 0) {
+			// Remainder of the identification line
+			const char* model = strstr(payload, listId);
+			if(model != NULL) {
+				model += idLength;
+				const char* modelEnd = firstLineEnd;
+				while(model < modelEnd && isspace((unsigned char) *model)) model++;
+				while(modelEnd > model && isspace((unsigned char) modelEnd[-1])) modelEnd--;
+				size_t modelLength = modelEnd > model ? modelEnd - model : 0;
+				if(modelLength >= sizeof(meterModel)) modelLength = sizeof(meterModel) - 1;
+				memcpy(meterModel, model, modelLength);
+				meterModel[modelLength] = '\0';
+			}
 		}
 	}
 
 	tmElements_t tm { 0, 0, 0, 0, 0, 0, 0 };
-	String timestamp = extract(payload, F("1.0.0"));
-	if(timestamp.length() == 13) { // yyMMddHHmmssX
-		char x = timestamp.charAt(12);
+	const char* timestamp = telegram + fields[P1Timestamp].offset;
+	uint8_t tsLength = fields[P1Timestamp].offset == 0 ? 0 : fields[P1Timestamp].length;
+	if(tsLength == 13) { // yyMMddHHmmssX
+		char x = timestamp[12];
 		if(x == 'S' || x == 'W') {
-			tm.Year = (timestamp.substring(0,2).toInt() + 2000) - 1970;
-			tm.Month = timestamp.substring(2,4).toInt();
-			tm.Day = timestamp.substring(4,6).toInt();
-			tm.Hour = timestamp.substring(6,8).toInt();
-			tm.Minute = timestamp.substring(8,10).toInt();
-			tm.Second = timestamp.substring(10,12).toInt();
+			tm.Year = (toInt(timestamp, 2) + 2000) - 1970;
+			tm.Month = toInt(timestamp+2, 2);
+			tm.Day = toInt(timestamp+4, 2);
+			tm.Hour = toInt(timestamp+6, 2);
+			tm.Minute = toInt(timestamp+8, 2);
+			tm.Second = toInt(timestamp+10, 2);
 		}
-	} else if(timestamp.length() == 17) { // yyyyMMdd HH:mm:ss
-		char x = timestamp.charAt(11);
-		char y = timestamp.charAt(14);
+	} else if(tsLength == 17) { // yyyyMMdd HH:mm:ss
+		char x = timestamp[11];
+		char y = timestamp[14];
 		if(x == ':' && y == ':') {
-			tm.Year = (timestamp.substring(0,4).toInt()) - 1970;
-			tm.Month = timestamp.substring(4,6).toInt();
-			tm.Day = timestamp.substring(6,8).toInt();
-			tm.Hour = timestamp.substring(9,11).toInt();
-			tm.Minute = timestamp.substring(12,14).toInt();
-			tm.Second = timestamp.substring(15,17).toInt();
+			tm.Year = (toInt(timestamp, 4)) - 1970;
+			tm.Month = toInt(timestamp+4, 2);
+			tm.Day = toInt(timestamp+6, 2);
+			tm.Hour = toInt(timestamp+9, 2);
+			tm.Minute = toInt(timestamp+12, 2);
+			tm.Second = toInt(timestamp+15, 2);
 		}
-	} else if(timestamp.length() == 19) { // yyyy-MM-dd HH:mm:ss
-		char x = timestamp.charAt(4);
-		char y = timestamp.charAt(13);
+	} else if(tsLength == 19) { // yyyy-MM-dd HH:mm:ss
+		char x = timestamp[4];
+		char y = timestamp[13];
 		if(x == '-' && y == ':') {
-			tm.Year = (timestamp.substring(0,4).toInt()) - 1970;
-			tm.Month = timestamp.substring(5,7).toInt();
-			tm.Day = timestamp.substring(8,10).toInt();
-			tm.Hour = timestamp.substring(11,13).toInt();
-			tm.Minute = timestamp.substring(14,16).toInt();
-			tm.Second = timestamp.substring(17,19).toInt();
+			tm.Year = (toInt(timestamp, 4)) - 1970;
+			tm.Month = toInt(timestamp+5, 2);
+			tm.Day = toInt(timestamp+8, 2);
+			tm.Hour = toInt(timestamp+11, 2);
+			tm.Minute = toInt(timestamp+14, 2);
+			tm.Second = toInt(timestamp+17, 2);
 		}
 	} else {
 		meterTimestamp = 0;
@@ -103,71 +174,71 @@ IEC6205621::IEC6205621(const char* p, Timezone* tz, MeterConfig* meterConfig) {
 		if(tz != NULL) meterTimestamp = tz->toUTC(meterTimestamp);
 	}
 
-	activeImportPower = (uint16_t) (extractDouble(payload, F("1.7.0")));
-	activeExportPower = (uint16_t) (extractDouble(payload, F("2.7.0")));
-	reactiveImportPower = (uint16_t) (extractDouble(payload, F("3.7.0")));
-	reactiveExportPower = (uint16_t) (extractDouble(payload, F("4.7.0")));
+	activeImportPower = (uint16_t) (extractDouble(P1ActiveImport));
+	activeExportPower = (uint16_t) (extractDouble(P1ActiveExport));
+	reactiveImportPower = (uint16_t) (extractDouble(P1ReactiveImport));
+	reactiveExportPower = (uint16_t) (extractDouble(P1ReactiveExport));
 
 	if(activeImportPower > 0)
 		listType = 1;
 	
-	l1voltage = extractFloat(payload, F("32.7.0"));
-	l2voltage = extractFloat(payload, F("52.7.0"));
-	l3voltage = extractFloat(payload, F("72.7.0"));
+	l1voltage = extractFloat(P1L1Voltage);
+	l2voltage = extractFloat(P1L2Voltage);
+	l3voltage = extractFloat(P1L3Voltage);
 
-	l1current = extractFloat(payload, F("31.7.0"));
-	l2current = extractFloat(payload, F("51.7.0"));
-	l3current = extractFloat(payload, F("71.7.0"));
+	l1current = extractFloat(P1L1Current);
+	l2current = extractFloat(P1L2Current);
+	l3current = extractFloat(P1L3Current);
 
-	l1activeImportPower = extractFloat(payload, F("21.7.0"));
-	l2activeImportPower = extractFloat(payload, F("41.7.0"));
-	l3activeImportPower = extractFloat(payload, F("61.7.0"));
+	l1activeImportPower = extractFloat(P1L1ActiveImport);
+	l2activeImportPower = extractFloat(P1L2ActiveImport);
+	l3activeImportPower = extractFloat(P1L3ActiveImport);
 	
-	l1activeExportPower = extractFloat(payload, F("22.7.0"));
-	l2activeExportPower = extractFloat(payload, F("42.7.0"));
-	l3activeExportPower = extractFloat(payload, F("62.7.0"));
+	l1activeExportPower = extractFloat(P1L1ActiveExport);
+	l2activeExportPower = extractFloat(P1L2ActiveExport);
+	l3activeExportPower = extractFloat(P1L3ActiveExport);
 	
 	if(l1voltage > 0 || l2voltage > 0 || l3voltage > 0)
 		listType = 2;
 
 	double val = 0.0;
 	
-	double it1 = extractDouble(payload, F("1.8.1"));
-	double it2 = extractDouble(payload, F("1.8.2"));
+	double it1 = extractDouble(P1_COUNTER(1, 1));
+	double it2 = extractDouble(P1_COUNTER(1, 2));
 	if(it1 > 0) activeImportCounterTariff1 = it1 / 1000;
 	if(it2 > 0) activeImportCounterTariff2 = it2 / 1000;
-	val = extractDouble(payload, F("1.8.0"));
+	val = extractDouble(P1_COUNTER(1, 0));
 	if(val == 0) {
 		for(int i = 1; i < 9; i++) {
-			val += extractDouble(payload, "1.8." + String(i,10));
+			val += extractDouble(P1_COUNTER(1, i));
 		}
 	}
 	if(val > 0) activeImportCounter = val / 1000;
 
-	double et1 = extractDouble(payload, F("2.8.1"));
-	double et2 = extractDouble(payload, F("2.8.2"));
+	double et1 = extractDouble(P1_COUNTER(2, 1));
+	double et2 = extractDouble(P1_COUNTER(2, 2));
 	if(et1 > 0) activeExportCounterTariff1 = et1 / 1000;
 	if(et2 > 0) activeExportCounterTariff2 = et2 / 1000;
-	val = extractDouble(payload, F("2.8.0"));
+	val = extractDouble(P1_COUNTER(2, 0));
 	if(val == 0) {
 		for(int i = 1; i < 9; i++) {
-			val += extractDouble(payload, "2.8." + String(i,10));
+			val += extractDouble(P1_COUNTER(2, i));
 		}
 	}
 	if(val > 0) activeExportCounter = val / 1000;
 
-	val = extractDouble(payload, F("3.8.0"));
+	val = extractDouble(P1_COUNTER(3, 0));
 	if(val == 0) {
 		for(int i = 1; i < 9; i++) {
-			val += extractDouble(payload, "3.8." + String(i,10));
+			val += extractDouble(P1_COUNTER(3, i));
 		}
 	}
 	if(val > 0) reactiveImportCounter = val / 1000;
 
-	val = extractDouble(payload, F("4.8.0"));
+	val = extractDouble(P1_COUNTER(4, 0));
 	if(val == 0) {
 		for(int i = 1; i < 9; i++) {
-			val += extractDouble(payload, "4.8." + String(i,10));
+			val += extractDouble(P1_COUNTER(4, i));
 		}
 	}
 	if(val > 0) reactiveExportCounter = val / 1000;
@@ -209,39 +280,55 @@ IEC6205621::IEC6205621(const char* p, Timezone* tz, MeterConfig* meterConfig) {
 	twoPhase = (l1voltage > 0 && l2voltage > 0) || (l2voltage > 0 && l3voltage > 0) || (l3voltage > 0  && l1voltage > 0);
 }
 
-String IEC6205621::extract(String payload, String obis) {
-	int a = payload.indexOf(String(":" + obis + "("));
-	if(a > 0) {
-		int b = payload.indexOf(F(")"), a);
-		if(b > a) {
-			return payload.substring(a+obis.length()+2, b);
+// Walks the telegram once and notes where the value of each wanted code is.
+// A code is the digits and dots between a ':' and a '(', and its value runs
+// to the next ')'. The first occurrence of a code wins.
+void IEC6205621::tokenize(const char* start, const char* end) {
+	memset(fields, 0, sizeof(fields));
+	const char* open = start;
+	while((open = (const char*) memchr(open, '(', end - open)) != NULL) {
+		const char* code = open;
+		while(code > start && ((code[-1] >= '0' && code[-1] <= '9') || code[-1] == '.')) code--;
+		if(code - 1 > start && code[-1] == ':') {
+			int8_t field = lookupField(code, open);
+			if(field >= 0 && fields[field].offset == 0) {
+				const char* close = (const char*) memchr(open, ')', end - open);
+				if(close != NULL) {
+					fields[field].offset = open + 1 - telegram;
+					fields[field].length = close - open - 1 > UINT8_MAX ? UINT8_MAX : close - open - 1;
+				}
+			}
 		}
+		open++;
 	}
-	return "";
 }
 
-double IEC6205621::extractDouble(String payload, String obis) {
-	String str = extract(payload, obis);
-	if(str.isEmpty()) {
+uint8_t IEC6205621::extract(P1Field field, char* target, uint8_t size) {
+	uint8_t len = fields[field].offset == 0 ? 0 : fields[field].length;
+	if(len >= size) len = size - 1;
+	memcpy(target, telegram + fields[field].offset, len);
+	target[len] = '\0';
+	return len;
+}
+
+double IEC6205621::extractDouble(uint8_t field) {
+	if(fields[field].offset == 0 || fields[field].length == 0) {
 		return 0.0;
 	}
-
-	int a = str.indexOf(F("*"));
-	String val = str.substring(0,a);
-	String unit = str.substring(a+1);
-
-	return unit.startsWith(F("k")) ? val.toDouble() * 1000 : val.toDouble();
+	const char* str = telegram + fields[field].offset;
+	const char* unit = (const char*) memchr(str, '*', fields[field].length);
+	unit = unit == NULL ? str : unit + 1;
+	double val = strtod(str, NULL);
+	return *unit == 'k' ? val * 1000 : val;
 }
 
-float IEC6205621::extractFloat(String payload, String obis) {
-	String str = extract(payload, obis);
-	if(str.isEmpty()) {
+float IEC6205621::extractFloat(uint8_t field) {
+	if(fields[field].offset == 0 || fields[field].length == 0) {
 		return 0.0;
 	}
-
-	int a = str.indexOf(F("*"));
-	String val = str.substring(0,a);
-	String unit = str.substring(a+1);
-
-	return unit.startsWith(F("k")) ? val.toFloat() * 1000 : val.toFloat();
+	const char* str = telegram + fields[field].offset;
+	const char* unit = (const char*) memchr(str, '*', fields[field].length);
+	unit = unit == NULL ? str : unit + 1;
+	float val = (float) strtod(str, NULL);
+	return *unit == 'k' ? val * 1000 : val;
 }
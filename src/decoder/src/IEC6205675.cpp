@@ -10,1154 +10,202 @@
 #include "ntohll.h"
 #include "Uptime.h"
 #include "hexutils.h"
+#include <ctype.h>
+
+// In-place equivalent of String::trim()
+static void trim(char* str) {
+    char* start = str;
+    while(isspace((unsigned char) *start)) start++;
+    size_t len = strlen(start);
+    while(len > 0 && isspace((unsigned char) start[len - 1])) len--;
+    memmove(str, start, len);
+    str[len] = '\0';
+}
+
+#define POS_STR(field) { field, CosemTypeOctetString, 1 }
+#define POS_LU(field, divisor) { field, CosemTypeLongUnsigned, divisor }
+#define POS_DLU(field, divisor) { field, CosemTypeDLongUnsigned, divisor }
+#define POS_SKIP { PosSkip, CosemTypeNull, 1 }
+#define POS_COUNT(table) (sizeof(table) / sizeof(PositionalValue))
+
+// Kaifa KFM_001, three phase lists (0x0D, 0x12 with counters), from item 2
+static const PositionalValue KAIFA_LIST_3P[] = {
+    POS_STR(PosMeterId), POS_STR(PosMeterModel),
+    POS_DLU(PosActiveImport, 1), POS_DLU(PosActiveExport, 1), POS_DLU(PosReactiveImport, 1), POS_DLU(PosReactiveExport, 1),
+    POS_DLU(PosL1Current, 1000), POS_DLU(PosL2Current, 1000), POS_DLU(PosL3Current, 1000),
+    POS_DLU(PosL1Voltage, 10), POS_DLU(PosL2Voltage, 10), POS_DLU(PosL3Voltage, 10)
+};
+
+// Kaifa KFM_001, single phase lists (0x09, 0x0E with counters), from item 2
+static const PositionalValue KAIFA_LIST_1P[] = {
+    POS_STR(PosMeterId), POS_STR(PosMeterModel),
+    POS_DLU(PosActiveImport, 1), POS_DLU(PosActiveExport, 1), POS_DLU(PosReactiveImport, 1), POS_DLU(PosReactiveExport, 1),
+    POS_DLU(PosL1Current, 1000),
+    POS_DLU(PosL1Voltage, 10)
+};
+
+// Kaifa KFM_001, what follows the meter timestamp in list 3
+static const PositionalValue KAIFA_COUNTERS[] = {
+    POS_DLU(PosActiveImportCounter, 1000), POS_DLU(PosActiveExportCounter, 1000),
+    POS_DLU(PosReactiveImportCounter, 1000), POS_DLU(PosReactiveExportCounter, 1000)
+};
+
+// Iskra ISK lists, from item 1. Item 1 is 42.0.0, the logical device name
+static const PositionalValue ISKRA_LIST_18[] = {
+    POS_SKIP, POS_STR(PosMeterId), // 96.1.3
+    POS_DLU(PosActiveImport, 1), POS_DLU(PosActiveExport, 1), POS_DLU(PosReactiveImport, 1), POS_DLU(PosReactiveExport, 1),
+    POS_LU(PosL1Voltage, 10), POS_LU(PosL2Voltage, 10), POS_LU(PosL3Voltage, 10),
+    POS_LU(PosL1Current, 100), POS_LU(PosL2Current, 100), POS_LU(PosL3Current, 100),
+    POS_DLU(PosL1ActiveImport, 1), POS_DLU(PosL2ActiveImport, 1), POS_DLU(PosL3ActiveImport, 1),
+    POS_DLU(PosL1ActiveExport, 1), POS_DLU(PosL2ActiveExport, 1), POS_DLU(PosL3ActiveExport, 1)
+};
+
+static const PositionalValue ISKRA_LIST_12_COUNTERS[] = {
+    POS_SKIP, POS_STR(PosMeterId), // 96.1.3
+    POS_SKIP, POS_SKIP, // 96.3.10 disconnect control, 96.14.0 active tariff
+    POS_DLU(PosActiveImportCounter, 1000), POS_SKIP, POS_SKIP, // 1.8.0, 1.8.1, 1.8.2
+    POS_DLU(PosActiveExportCounter, 1000), POS_SKIP, POS_SKIP, // 2.8.0, 2.8.1, 2.8.2
+    POS_DLU(PosReactiveImportCounter, 1000), POS_DLU(PosReactiveExportCounter, 1000)
+};
+
+static const PositionalValue ISKRA_LIST_12_3P[] = {
+    POS_SKIP, POS_STR(PosMeterId), // 96.1.2
+    POS_LU(PosL1Voltage, 10), POS_LU(PosL2Voltage, 10), POS_LU(PosL3Voltage, 10),
+    POS_LU(PosL1Current, 100), POS_LU(PosL2Current, 100), POS_LU(PosL3Current, 100),
+    POS_DLU(PosActiveImport, 1), POS_DLU(PosActiveExport, 1), POS_DLU(PosReactiveImport, 1), POS_DLU(PosReactiveExport, 1)
+};
+
+static const PositionalValue ISKRA_LIST_10_1P[] = {
+    POS_SKIP, POS_STR(PosMeterId), // 96.1.2
+    POS_DLU(PosActiveImport, 1), POS_DLU(PosActiveExport, 1), POS_DLU(PosReactiveImport, 1), POS_DLU(PosReactiveExport, 1),
+    POS_LU(PosL1Voltage, 10), POS_LU(PosL1Current, 100),
+    POS_DLU(PosL1ActiveImport, 1), POS_DLU(PosL1ActiveExport, 1)
+};
+
+// Followed by 3.8.1, 3.8.2, 4.8.1 and 4.8.2, which are summed in code
+static const PositionalValue ISKRA_LIST_10_TARIFFS[] = {
+    POS_SKIP, POS_STR(PosMeterId), // 96.1.3
+    POS_DLU(PosActiveImportCounterT1, 1000), POS_DLU(PosActiveImportCounterT2, 1000),
+    POS_DLU(PosActiveExportCounterT1, 1000), POS_DLU(PosActiveExportCounterT2, 1000)
+};
+
+static const PositionalValue ISKRA_LIST_9_1P[] = {
+    POS_SKIP, POS_STR(PosMeterId), // 96.1.2
+    POS_DLU(PosActiveImport, 1), POS_DLU(PosActiveExport, 1), POS_DLU(PosReactiveImport, 1), POS_DLU(PosReactiveExport, 1),
+    POS_LU(PosL1Voltage, 10),
+    POS_DLU(PosActiveExportCounterT1, 1000), POS_DLU(PosActiveExportCounterT2, 1000)
+};
+
+static const PositionalValue ISKRA_LIST_9_COUNTERS[] = {
+    POS_SKIP,
+    POS_DLU(PosActiveImport, 1), POS_DLU(PosActiveExport, 1),
+    POS_DLU(PosActiveImportCounter, 1000), POS_SKIP, POS_SKIP, // 1.8.0, 1.8.1, 1.8.2
+    POS_DLU(PosActiveExportCounter, 1000) // 2.8.0
+};
+
+static const PositionalValue ISKRA_LIST_8[] = {
+    POS_SKIP, POS_STR(PosMeterId), // 96.1.2
+    POS_LU(PosL1Voltage, 10), POS_LU(PosL1Current, 100),
+    POS_DLU(PosActiveImport, 1), POS_DLU(PosActiveExport, 1), POS_DLU(PosReactiveImport, 1), POS_DLU(PosReactiveExport, 1)
+};
+
+static const PositionalValue ISKRA_LIST_4[] = {
+    POS_SKIP, POS_SKIP,
+    POS_DLU(PosActiveImportCounter, 1000), POS_DLU(PosActiveExportCounter, 1000)
+};
+
+// Iskra selected in the configuration, lists without a list identifier. From item 4
+static const PositionalValue ISKRA_LIST_33[] = {
+    POS_DLU(PosActiveImportCounter, 1000), POS_SKIP, POS_SKIP, // 1.8.0, 1.8.1, 1.8.2
+    POS_DLU(PosActiveExportCounter, 1000), POS_SKIP, POS_SKIP, // 2.8.0, 2.8.1, 2.8.2
+    POS_SKIP, POS_SKIP, POS_SKIP, POS_SKIP, // 5.8.0 - 8.8.0
+    POS_DLU(PosActiveImport, 1), POS_DLU(PosActiveExport, 1),
+    POS_DLU(PosPowerFactor, 1000),
+    POS_DLU(PosL1ActiveImport, 1), POS_DLU(PosL2ActiveImport, 1), POS_DLU(PosL3ActiveImport, 1),
+    POS_DLU(PosL1ActiveExport, 1), POS_DLU(PosL2ActiveExport, 1), POS_DLU(PosL3ActiveExport, 1),
+    POS_LU(PosL1Voltage, 10), POS_LU(PosL2Voltage, 10), POS_LU(PosL3Voltage, 10),
+    POS_LU(PosL1Current, 100), POS_LU(PosL2Current, 100), POS_LU(PosL3Current, 100)
+};
+
+// From item 4
+static const PositionalValue ISKRA_LIST_28[] = {
+    POS_DLU(PosActiveImportCounter, 1000), POS_SKIP, POS_SKIP, // 1.8.0, 1.8.1, 1.8.2
+    POS_DLU(PosActiveExportCounter, 1000), POS_SKIP, POS_SKIP, // 2.8.0, 2.8.1, 2.8.2
+    POS_DLU(PosActiveImport, 1), POS_DLU(PosActiveExport, 1),
+    POS_DLU(PosL1ActiveImport, 1), POS_DLU(PosL2ActiveImport, 1), POS_DLU(PosL3ActiveImport, 1),
+    POS_DLU(PosL1ActiveExport, 1), POS_DLU(PosL2ActiveExport, 1), POS_DLU(PosL3ActiveExport, 1),
+    POS_LU(PosL1Voltage, 10), POS_LU(PosL2Voltage, 10), POS_LU(PosL3Voltage, 10),
+    POS_LU(PosL1Current, 100), POS_LU(PosL2Current, 100), POS_LU(PosL3Current, 100)
+};
+
+// From item 1, up to the meter timestamp. The last item is an empty octet string
+static const PositionalValue ISKRA_LIST_15_COUNTERS[] = {
+    POS_DLU(PosActiveImportCounter, 1000), POS_SKIP, POS_SKIP,
+    POS_DLU(PosActiveExportCounter, 1000), POS_SKIP, POS_SKIP,
+    POS_SKIP
+};
+
+// After the meter timestamp, 52.7.0 is not in the list
+static const PositionalValue ISKRA_LIST_15_INSTANT[] = {
+    POS_DLU(PosActiveExport, 1), POS_DLU(PosActiveImport, 1),
+    POS_LU(PosL1Current, 100), POS_LU(PosL2Current, 100), POS_LU(PosL3Current, 100),
+    POS_LU(PosL1Voltage, 10), POS_LU(PosL3Voltage, 10)
+};
+
+// Any other length, from item 5
+static const PositionalValue ISKRA_LIST_OTHER[] = {
+    POS_DLU(PosActiveImportCounter, 1000), POS_DLU(PosActiveExportCounter, 1000),
+    POS_DLU(PosReactiveImportCounter, 1000), POS_DLU(PosReactiveExportCounter, 1000),
+    POS_DLU(PosActiveImport, 1), POS_DLU(PosActiveExport, 1)
+};
+
+// Kept off the stack, the parser itself already lives on it. One payload is
+// decoded at a time, and the constructor lets go of it before returning.
+static ObisIndex sharedIndex;
 
 #if defined(AMS_REMOTE_DEBUG)
-IEC6205675::IEC6205675(const char* d, Timezone* tz, uint8_t useMeterType, MeterConfig* meterConfig, DataParserContext &ctx, AmsData &state, RemoteDebug* debugger) {
+IEC6205675::IEC6205675(const char* d, Timezone* tz, uint8_t useMeterType, MeterConfig* meterConfig, DataParserContext &ctx, AmsData &state, RemoteDebug* debugger, uint8_t listFormat) {
 #else
-IEC6205675::IEC6205675(const char* d, Timezone* tz, uint8_t useMeterType, MeterConfig* meterConfig, DataParserContext &ctx, AmsData &state, Stream* debugger) {
+IEC6205675::IEC6205675(const char* d, Timezone* tz, uint8_t useMeterType, MeterConfig* meterConfig, DataParserContext &ctx, AmsData &state, Stream* debugger, uint8_t listFormat) {
 #endif
     float val;
     char str[64];
 
+    // One walk over the payload, all OBIS lookups below are resolved from it
+    sharedIndex.build(d);
+    obisIndex = &sharedIndex;
+
     this->packageTimestamp = time(nullptr); // ctx.timestamp is mostly garbage, so we use current time as package timestamp
 
     val = getNumber(AMS_OBIS_ACTIVE_IMPORT, sizeof(AMS_OBIS_ACTIVE_IMPORT), ((char *) (d)));
     if(val == NOVALUE) {
-        CosemData* data = getCosemDataAt(1, ((char *) (d)));
-
-        String listId = "";
-        if(data->base.type == CosemTypeOctetString) { // Assuming first string is a list identifier
-            memcpy(str, data->oct.data, data->oct.length);
-            str[data->oct.length] = 0x00;
-            listId = String(str);
-        }
-        
-        if(listId.startsWith(F("KFM_001"))) {
-            this->listId = listId;
-            meterType = AmsTypeKaifa;
-
-            uint8_t idx = 0;
-            data = getCosemDataAt(idx, ((char *) (d)));
-            idx+=2;
-            if(data->base.length == 0x0D || data->base.length == 0x12) {
-                listType = data->base.length == 0x12 ? 3 : 2;
-
-                data = getCosemDataAt(idx++, ((char *) (d)));
-                memcpy(str, data->oct.data, data->oct.length);
-                str[data->oct.length] = 0x00;
-                meterId = String(str);
-
-                data = getCosemDataAt(idx++, ((char *) (d)));
-                memcpy(str, data->oct.data, data->oct.length);
-                str[data->oct.length] = 0x00;
-                meterModel = String(str);
-
-                data = getCosemDataAt(idx++, ((char *) (d)));
-                activeImportPower = ntohl(data->dlu.data);
-                data = getCosemDataAt(idx++, ((char *) (d)));
-                activeExportPower = ntohl(data->dlu.data);
-
-                data = getCosemDataAt(idx++, ((char *) (d)));
-                reactiveImportPower = ntohl(data->dlu.data);
-                data = getCosemDataAt(idx++, ((char *) (d)));
-                reactiveExportPower = ntohl(data->dlu.data);
-
-                data = getCosemDataAt(idx++, ((char *) (d)));
-                l1current = ntohl(data->dlu.data) / 1000.0;
-                data = getCosemDataAt(idx++, ((char *) (d)));
-                l2current = ntohl(data->dlu.data) / 1000.0;
-                data = getCosemDataAt(idx++, ((char *) (d)));
-                l3current = ntohl(data->dlu.data) / 1000.0;
-
-                data = getCosemDataAt(idx++, ((char *) (d)));
-                l1voltage = ntohl(data->dlu.data) / 10.0;
-                data = getCosemDataAt(idx++, ((char *) (d)));
-                l2voltage = ntohl(data->dlu.data) / 10.0;
-                data = getCosemDataAt(idx++, ((char *) (d)));
-                l3voltage = ntohl(data->dlu.data) / 10.0;
-            } else if(data->base.length == 0x09 || data->base.length == 0x0E) {
-                listType = data->base.length == 0x0E ? 3 : 2;
-
-                data = getCosemDataAt(idx++, ((char *) (d)));
-                memcpy(str, data->oct.data, data->oct.length);
-                str[data->oct.length] = 0x00;
-                meterId = String(str);
-
-                data = getCosemDataAt(idx++, ((char *) (d)));
-                memcpy(str, data->oct.data, data->oct.length);
-                str[data->oct.length] = 0x00;
-                meterModel = String(str);
-
-                data = getCosemDataAt(idx++, ((char *) (d)));
-                activeImportPower = ntohl(data->dlu.data);
-                data = getCosemDataAt(idx++, ((char *) (d)));
-                activeExportPower = ntohl(data->dlu.data);
-
-                data = getCosemDataAt(idx++, ((char *) (d)));
-                reactiveImportPower = ntohl(data->dlu.data);
-                data = getCosemDataAt(idx++, ((char *) (d)));
-                reactiveExportPower = ntohl(data->dlu.data);
-
-                data = getCosemDataAt(idx++, ((char *) (d)));
-                l1current = ntohl(data->dlu.data) / 1000.0;
-
-                data = getCosemDataAt(idx++, ((char *) (d)));
-                l1voltage = ntohl(data->dlu.data) / 10.0;
-            }
-
-            if(listType >= 2 && memcmp(meterModel.c_str(), "MA304T3", 7) == 0) {
-                l2voltage = sqrt(pow(l1voltage - l3voltage * cos(60 * (PI/180)), 2) + pow(l3voltage * sin(60 * (PI/180)),2));
-                l2currentMissing = true;
-            }
-
-            if(listType == 3) {
-                data = getCosemDataAt(idx++, ((char *) (d)));
-                switch(data->base.type) {
-                    case CosemTypeOctetString: {
-                        if(data->oct.length == 0x0C) {
-                            AmsOctetTimestamp* amst = (AmsOctetTimestamp*) data;
-                            time_t ts = decodeCosemDateTime(amst->dt);
-                            meterTimestamp = tz != NULL ? tz->toUTC(ts) : ts;
-                        }
-                    }
-                }
-
-                data = getCosemDataAt(idx++, ((char *) (d)));
-                activeImportCounter = ntohl(data->dlu.data) / 1000.0;
-                data = getCosemDataAt(idx++, ((char *) (d)));
-                activeExportCounter = ntohl(data->dlu.data) / 1000.0;
-
-                data = getCosemDataAt(idx++, ((char *) (d)));
-                reactiveImportCounter = ntohl(data->dlu.data) / 1000.0;
-                data = getCosemDataAt(idx++, ((char *) (d)));
-                reactiveExportCounter = ntohl(data->dlu.data) / 1000.0;
-            }
-
-            lastUpdateMillis = millis64();
-        } else if(listId.startsWith("ISK")) { // Iskra special case
-            this->listId = listId;
-            meterType = AmsTypeIskra;
-
-            uint8_t idx = 0;
-            data = getCosemDataAt(idx++, ((char *) (d)));
-            if(data->base.length == 0x12) {
-                apply(state);
-                listType = state.getListType() > 4 ? state.getListType() : 4;
-
-                // 42.0.0 COSEM logical device name
-                idx++;
-
-                // 96.1.3 Device ID 4
-                data = getCosemDataAt(idx++, ((char *) (d)));
-                memcpy(str, data->oct.data, data->oct.length);
-                str[data->oct.length] = 0x00;
-                meterId = String(str);
-
-                // 1.7.0
-                data = getCosemDataAt(idx++, ((char *) (d)));
-                activeImportPower = ntohl(data->dlu.data);
-
-                // 2.7.0
-                data = getCosemDataAt(idx++, ((char *) (d)));
-                activeExportPower = ntohl(data->dlu.data);
-
-                // 3.7.0
-                data = getCosemDataAt(idx++, ((char *) (d)));
-                reactiveImportPower = ntohl(data->dlu.data);
-
-                // 4.7.0
-                data = getCosemDataAt(idx++, ((char *) (d)));
-                reactiveExportPower = ntohl(data->dlu.data);
-
-                // 32.7.0
-                data = getCosemDataAt(idx++, ((char *) (d)));
-                l1voltage = ntohs(data->lu.data) / 10.0;
-
-                // 52.7.0
-                data = getCosemDataAt(idx++, ((char *) (d)));
-                l2voltage = ntohs(data->lu.data) / 10.0;
-
-                // 72.7.0
-                data = getCosemDataAt(idx++, ((char *) (d)));
-                l3voltage = ntohs(data->lu.data) / 10.0;
-
-                // 31.7.0
-                data = getCosemDataAt(idx++, ((char *) (d)));
-                l1current = ntohs(data->lu.data) / 100.0;
-
-                // 51.7.0
-                data = getCosemDataAt(idx++, ((char *) (d)));
-                l2current = ntohs(data->lu.data) / 100.0;
-
-                // 71.7.0
-                data = getCosemDataAt(idx++, ((char *) (d)));
-                l3current = ntohs(data->lu.data) / 100.0;
-
-                // 21.7.0
-                data = getCosemDataAt(idx++, ((char *) (d)));
-                l1activeImportPower = ntohl(data->dlu.data);
-
-                // 41.7.0
-                data = getCosemDataAt(idx++, ((char *) (d)));
-                l2activeImportPower = ntohl(data->dlu.data);
-
-                // 61.7.0
-                data = getCosemDataAt(idx++, ((char *) (d)));
-                l3activeImportPower = ntohl(data->dlu.data);
-
-                // 22.7.0
-                data = getCosemDataAt(idx++, ((char *) (d)));
-                l1activeExportPower = ntohl(data->dlu.data);
-
-                // 42.7.0
-                data = getCosemDataAt(idx++, ((char *) (d)));
-                l2activeExportPower = ntohl(data->dlu.data);
-
-                // 62.7.0
-                data = getCosemDataAt(idx++, ((char *) (d)));
-                l3activeExportPower = ntohl(data->dlu.data);
-                
-                lastUpdateMillis = millis64();
-            } else if(data->base.length == 0x0C) {
-                CosemData* no3 = getCosemDataAt(3, ((char *) (d)));
-                if(no3->base.type == CosemTypeBoolean) {
-                    apply(state);
-                    listType = state.getListType() > 3 ? state.getListType() : 3;
-
-                    // 42.0.0 COSEM logical device name
-                    idx++;
-
-                    // 96.1.3 Device ID 4
-                    data = getCosemDataAt(idx++, ((char *) (d)));
-                    memcpy(str, data->oct.data, data->oct.length);
-                    str[data->oct.length] = 0x00;
-                    meterId = String(str);
-
-                    // 96.3.10 Disconnect control
-                    // 96.14.0 Currently acrive energy tariff
-                    idx += 2;
-
-                    // 1.8.0
-                    data = getCosemDataAt(idx++, ((char *) (d)));
-                    activeImportCounter = ntohl(data->dlu.data) / 1000.0;
-
-                    // 1.8.1
-                    // 1.8.2
-                    idx += 2;
-                    
-                    // 2.8.0
-                    data = getCosemDataAt(idx++, ((char *) (d)));
-                    activeExportCounter = ntohl(data->dlu.data) / 1000.0;
-
-                    // 2.8.1
-                    // 2.8.2
-                    idx += 2;
-
-                    // 3.8.0
-                    data = getCosemDataAt(idx++, ((char *) (d)));
-                    reactiveImportCounter = ntohl(data->dlu.data) / 1000.0;
-
-                    // 4.8.0
-                    data = getCosemDataAt(idx++, ((char *) (d)));
-                    reactiveExportCounter = ntohl(data->dlu.data) / 1000.0;
-
-                    lastUpdateMillis = millis64();
-                } else if(no3->base.type == CosemTypeLongUnsigned) {
-                    apply(state);
-                    listType = state.getListType() > 2 ? state.getListType() : 2;
-
-                    // 42.0.0 COSEM logical device name
-                    idx++;
-
-                    // 96.1.2 Device ID 3
-                    data = getCosemDataAt(idx++, ((char *) (d)));
-                    memcpy(str, data->oct.data, data->oct.length);
-                    str[data->oct.length] = 0x00;
-                    meterId = String(str);
-
-                    // 32.7.0
-                    data = getCosemDataAt(idx++, ((char *) (d)));
-                    l1voltage = ntohs(data->lu.data) / 10.0;
-
-                    // 52.7.0
-                    data = getCosemDataAt(idx++, ((char *) (d)));
-                    l2voltage = ntohs(data->lu.data) / 10.0;
-
-                    // 72.7.0
-                    data = getCosemDataAt(idx++, ((char *) (d)));
-                    l3voltage = ntohs(data->lu.data) / 10.0;
-
-                    // 31.7.0
-                    data = getCosemDataAt(idx++, ((char *) (d)));
-                    l1current = ntohs(data->lu.data) / 100.0;
-
-                    // 51.7.0
-                    data = getCosemDataAt(idx++, ((char *) (d)));
-                    l2current = ntohs(data->lu.data) / 100.0;
-
-                    // 71.7.0
-                    data = getCosemDataAt(idx++, ((char *) (d)));
-                    l3current = ntohs(data->lu.data) / 100.0;
-
-                    // 1.7.0
-                    data = getCosemDataAt(idx++, ((char *) (d)));
-                    activeImportPower = ntohl(data->dlu.data);
-
-                    // 2.7.0
-                    data = getCosemDataAt(idx++, ((char *) (d)));
-                    activeExportPower = ntohl(data->dlu.data);
-
-                    // 3.7.0
-                    data = getCosemDataAt(idx++, ((char *) (d)));
-                    reactiveImportPower = ntohl(data->dlu.data);
-
-                    // 4.7.0
-                    data = getCosemDataAt(idx++, ((char *) (d)));
-                    reactiveExportPower = ntohl(data->dlu.data);
-
-                    lastUpdateMillis = millis64();
-                }
-            } else if(data->base.length ==  0x0A) {
-                CosemData* no7 = getCosemDataAt(7, ((char *) (d)));
-                if(no7->base.type == CosemTypeLongUnsigned) {
-                    apply(state);
-                    listType = state.getListType() > 4 ? state.getListType() : 4;
-
-                    // 42.0.0 COSEM logical device name
-                    idx++;
-                    
-                    // 96.1.2 Device ID 3
-                    data = getCosemDataAt(idx++, ((char *) (d)));
-                    memcpy(str, data->oct.data, data->oct.length);
-                    str[data->oct.length] = 0x00;
-                    meterId = String(str);
-
-                    // 1.7.0
-                    data = getCosemDataAt(idx++, ((char *) (d)));
-                    activeImportPower = ntohl(data->dlu.data);
-
-                    // 2.7.0
-                    data = getCosemDataAt(idx++, ((char *) (d)));
-                    activeExportPower = ntohl(data->dlu.data);
-
-                    // 3.7.0
-                    data = getCosemDataAt(idx++, ((char *) (d)));
-                    reactiveImportPower = ntohl(data->dlu.data);
-
-                    // 4.7.0
-                    data = getCosemDataAt(idx++, ((char *) (d)));
-                    reactiveExportPower = ntohl(data->dlu.data);
-
-                    // 32.7.0
-                    data = getCosemDataAt(idx++, ((char *) (d)));
-                    l1voltage = ntohs(data->lu.data) / 10.0;
-
-                    // 31.7.0
-                    data = getCosemDataAt(idx++, ((char *) (d)));
-                    l1current = ntohs(data->lu.data) / 100.0;
-
-                    // 21.7.0
-                    data = getCosemDataAt(idx++, ((char *) (d)));
-                    l1activeImportPower = ntohl(data->dlu.data);
-
-                    // 22.7.0
-                    data = getCosemDataAt(idx++, ((char *) (d)));
-                    l1activeExportPower = ntohl(data->dlu.data);
-
-                    lastUpdateMillis = millis64();
-                } else if(no7->base.type == CosemTypeDLongUnsigned) {
-                    apply(state);
-                    listType = state.getListType() > 3 ? state.getListType() : 3;
-
-                    // 42.0.0 COSEM logical device name
-                    idx++;
-                    
-                    // 96.1.3 Device ID 4
-                    data = getCosemDataAt(idx++, ((char *) (d)));
-                    memcpy(str, data->oct.data, data->oct.length);
-                    str[data->oct.length] = 0x00;
-                    meterId = String(str);
-
-                    // 1.8.1
-                    data = getCosemDataAt(idx++, ((char *) (d)));
-                    double obis181 = ntohl(data->dlu.data) / 1000.0;
-
-                    // 1.8.2
-                    data = getCosemDataAt(idx++, ((char *) (d)));
-                    double obis182 = ntohl(data->dlu.data) / 1000.0;
-
-                    activeImportCounterTariff1 = obis181;
-                    activeImportCounterTariff2 = obis182;
-                    if(activeImportCounter < obis181 + obis182)
-                        activeImportCounter = obis181 + obis182;
-
-                    // 2.8.1
-                    data = getCosemDataAt(idx++, ((char *) (d)));
-                    double obis281 = ntohl(data->dlu.data) / 1000.0;
-
-                    // 2.8.2
-                    data = getCosemDataAt(idx++, ((char *) (d)));
-                    double obis282 = ntohl(data->dlu.data) / 1000.0;
-
-                    activeExportCounterTariff1 = obis281;
-                    activeExportCounterTariff2 = obis282;
-                    if(activeExportCounter < obis281 + obis282)
-                        activeExportCounter = obis281 + obis282;
-
-                    // 3.8.1
-                    data = getCosemDataAt(idx++, ((char *) (d)));
-                    double obis381 = ntohl(data->dlu.data) / 1000.0;
-
-                    // 3.8.2
-                    data = getCosemDataAt(idx++, ((char *) (d)));
-                    double obis382 = ntohl(data->dlu.data) / 1000.0;
-
-                    if(reactiveImportCounter < obis381 + obis382)
-                        reactiveImportCounter = obis381 + obis382;
-
-                    // 4.8.1
-                    data = getCosemDataAt(idx++, ((char *) (d)));
-                    double obis481 = ntohl(data->dlu.data) / 1000.0;
-
-                    // 4.8.2
-                    data = getCosemDataAt(idx++, ((char *) (d)));
-                    double obis482 = ntohl(data->dlu.data) / 1000.0;
-
-                    if(reactiveExportCounter < obis481 + obis482)
-                        reactiveExportCounter = obis481 + obis482;
-
-                    lastUpdateMillis = millis64();
-                }
-            } else if(data->base.length == 0x09) {
-                CosemData* no7 = getCosemDataAt(7, ((char *) (d)));
-                if(no7->base.type == CosemTypeLongUnsigned) {
-                    apply(state);
-                    listType = state.getListType() > 3 ? state.getListType() : 3;
-
-                    // 42.0.0 COSEM logical device name
-                    idx++;
-                    
-                    // 96.1.2 Device ID 3
-                    data = getCosemDataAt(idx++, ((char *) (d)));
-                    memcpy(str, data->oct.data, data->oct.length);
-                    str[data->oct.length] = 0x00;
-                    meterId = String(str);
-
-                    // 1.7.0
-                    data = getCosemDataAt(idx++, ((char *) (d)));
-                    activeImportPower = ntohl(data->dlu.data);
-
-                    // 2.7.0
-                    data = getCosemDataAt(idx++, ((char *) (d)));
-                    activeExportPower = ntohl(data->dlu.data);
-
-                    // 3.7.0
-                    data = getCosemDataAt(idx++, ((char *) (d)));
-                    reactiveImportPower = ntohl(data->dlu.data);
-
-                    // 4.7.0
-                    data = getCosemDataAt(idx++, ((char *) (d)));
-                    reactiveExportPower = ntohl(data->dlu.data);
-
-                    // 32.7.0
-                    data = getCosemDataAt(idx++, ((char *) (d)));
-                    l1voltage = ntohs(data->lu.data) / 10.0;
-
-                    // 2.8.1
-                    data = getCosemDataAt(idx++, ((char *) (d)));
-                    double obis281 = ntohl(data->dlu.data) / 1000.0;
-
-                    // 2.8.2
-                    data = getCosemDataAt(idx++, ((char *) (d)));
-                    double obis282 = ntohl(data->dlu.data) / 1000.0;
-
-                    activeExportCounterTariff1 = obis281;
-                    activeExportCounterTariff2 = obis282;
-                    activeExportCounter = obis281 + obis282;
-
-                    lastUpdateMillis = millis64();
-                } else if(no7->base.type == CosemTypeDLongUnsigned) {
-                    apply(state);
-                    listType = state.getListType() > 3 ? state.getListType() : 3;
-
-                    // 42.0.0 COSEM logical device name?
-                    idx++;
-
-                    // 1.7.0?
-                    data = getCosemDataAt(idx++, ((char *) (d)));
-                    activeImportPower = ntohl(data->dlu.data);
-
-                    // 2.7.0?
-                    data = getCosemDataAt(idx++, ((char *) (d)));
-                    activeExportPower = ntohl(data->dlu.data);
-
-                    // 1.8.0?
-                    data = getCosemDataAt(idx++, ((char *) (d)));
-                    activeImportCounter = ntohl(data->dlu.data) / 1000.0;
-
-                    // 1.8.1?
-                    // 1.8.2?
-                    idx += 2;
-                    
-                    // 2.8.0?
-                    data = getCosemDataAt(idx++, ((char *) (d)));
-                    activeExportCounter = ntohl(data->dlu.data) / 1000.0;
-
-                    // 2.8.1?
-                    // 2.8.2?
-                    idx += 2;
-
-                    lastUpdateMillis = millis64();
-                }
-            } else if(data->base.length == 0x08) {
-                // 42.0.0 COSEM logical device name
-                idx++;
-
-                // 96.1.2 Device ID 3
-                data = getCosemDataAt(idx++, ((char *) (d)));
-                memcpy(str, data->oct.data, data->oct.length);
-                str[data->oct.length] = 0x00;
-                meterId = String(str);
-
-                // 32.7.0
-                data = getCosemDataAt(idx++, ((char *) (d)));
-                l1voltage = ntohs(data->lu.data) / 10.0;
-
-                // 31.7.0
-                data = getCosemDataAt(idx++, ((char *) (d)));
-                l1current = ntohs(data->lu.data) / 100.0;
-
-                // 1.7.0
-                data = getCosemDataAt(idx++, ((char *) (d)));
-                activeImportPower = ntohl(data->dlu.data);
-
-                // 2.7.0
-                data = getCosemDataAt(idx++, ((char *) (d)));
-                activeExportPower = ntohl(data->dlu.data);
-
-                // 3.7.0
-                data = getCosemDataAt(idx++, ((char *) (d)));
-                reactiveImportPower = ntohl(data->dlu.data);
-
-                // 4.7.0
-                data = getCosemDataAt(idx++, ((char *) (d)));
-                reactiveExportPower = ntohl(data->dlu.data);
-
-                lastUpdateMillis = millis64();
-            } else if(data->base.length == 0x04) {
-                // ?
-                idx++;
-
-                // ?
-                idx++;
-
-                // 1.8.0?
-                data = getCosemDataAt(idx++, ((char *) (d)));
-                activeImportCounter = ntohl(data->dlu.data) / 1000.0;
-
-                // 2.8.0?
-                data = getCosemDataAt(idx++, ((char *) (d)));
-                activeExportCounter = ntohl(data->dlu.data) / 1000.0;
-            }
+        if(listFormat == DlmsListAuto) listFormat = getListFormat(d);
+        if(listFormat == DlmsListKaifa) {
+            parseKaifa(d, tz);
+        } else if(listFormat == DlmsListIskra) {
+            parseIskra(d, state);
         } else if(useMeterType == AmsTypeIskra) { // Iskra special case
-            meterType = AmsTypeIskra;
-            uint8_t idx = 0;
-            data = getCosemDataAt(idx, ((char *) (d)));
-
             #if defined(AMS_REMOTE_DEBUG)
             if (debugger->isActive(RemoteDebug::DEBUG))
             #endif
-            debugger->printf_P(PSTR("Iskra, length 0x%02x\n"), data->base.length);
-
-            if(data->base.length == 0x21) {
-                idx = 4;
-
-                // 1.8.0
-                data = getCosemDataAt(idx++, ((char *) (d)));
-                activeImportCounter = ntohl(data->dlu.data) / 1000.0;
-
-                // 1.8.1
-                // 1.8.2
-                idx += 2;
-                
-                // 2.8.0
-                data = getCosemDataAt(idx++, ((char *) (d)));
-                activeExportCounter = ntohl(data->dlu.data) / 1000.0;
-
-                // 2.8.1
-                // 2.8.2
-                idx += 2;
-
-                // 5.8.0
-                // 6.8.0
-                // 7.8.0
-                // 8.8.0
-                idx += 4;
-
-                // 1.7.0
-                data = getCosemDataAt(idx++, ((char *) (d)));
-                activeImportPower = ntohl(data->dlu.data);
-
-                // 2.7.0
-                data = getCosemDataAt(idx++, ((char *) (d)));
-                activeExportPower = ntohl(data->dlu.data);
-
-                // 13.7.0
-                data = getCosemDataAt(idx++, ((char *) (d)));
-                powerFactor= ntohl(data->dlu.data) / 1000.0;
-
-                // 21.7.0
-                data = getCosemDataAt(idx++, ((char *) (d)));
-                l1activeImportPower = ntohl(data->dlu.data);
-
-                // 41.7.0
-                data = getCosemDataAt(idx++, ((char *) (d)));
-                l2activeImportPower = ntohl(data->dlu.data);
-
-                // 61.7.0
-                data = getCosemDataAt(idx++, ((char *) (d)));
-                l3activeImportPower = ntohl(data->dlu.data);
-
-                // 22.7.0
-                data = getCosemDataAt(idx++, ((char *) (d)));
-                l1activeExportPower = ntohl(data->dlu.data);
-
-                // 42.7.0
-                data = getCosemDataAt(idx++, ((char *) (d)));
-                l2activeExportPower = ntohl(data->dlu.data);
-
-                // 62.7.0
-                data = getCosemDataAt(idx++, ((char *) (d)));
-                l3activeExportPower = ntohl(data->dlu.data);
-
-                // 32.7.0
-                data = getCosemDataAt(idx++, ((char *) (d)));
-                l1voltage = ntohs(data->lu.data) / 10.0;
-
-                // 52.7.0
-                data = getCosemDataAt(idx++, ((char *) (d)));
-                l2voltage = ntohs(data->lu.data) / 10.0;
-
-                // 72.7.0
-                data = getCosemDataAt(idx++, ((char *) (d)));
-                l3voltage = ntohs(data->lu.data) / 10.0;
-
-                // 31.7.0
-                data = getCosemDataAt(idx++, ((char *) (d)));
-                l1current = ntohs(data->lu.data) / 100.0;
-
-                // 51.7.0
-                data = getCosemDataAt(idx++, ((char *) (d)));
-                l2current = ntohs(data->lu.data) / 100.0;
-
-                // 71.7.0
-                data = getCosemDataAt(idx++, ((char *) (d)));
-                l3current = ntohs(data->lu.data) / 100.0;
-
-                listType = 4;
-                lastUpdateMillis = millis64();
-            } else if(data->base.length == 0x1C) {
-                idx = 4;
-
-                // 1.8.0
-                data = getCosemDataAt(idx++, ((char *) (d)));
-                activeImportCounter = ntohl(data->dlu.data) / 1000.0;
-
-                // 1.8.1
-                // 1.8.2
-                idx += 2;
-                
-                // 2.8.0
-                data = getCosemDataAt(idx++, ((char *) (d)));
-                activeExportCounter = ntohl(data->dlu.data) / 1000.0;
-
-                // 2.8.1
-                // 2.8.2
-                idx += 2;
-
-                // 1.7.0
-                data = getCosemDataAt(idx++, ((char *) (d)));
-                activeImportPower = ntohl(data->dlu.data);
-
-                // 2.7.0
-                data = getCosemDataAt(idx++, ((char *) (d)));
-                activeExportPower = ntohl(data->dlu.data);
-
-                // 21.7.0
-                data = getCosemDataAt(idx++, ((char *) (d)));
-                l1activeImportPower = ntohl(data->dlu.data);
-
-                // 41.7.0
-                data = getCosemDataAt(idx++, ((char *) (d)));
-                l2activeImportPower = ntohl(data->dlu.data);
-
-                // 61.7.0
-                data = getCosemDataAt(idx++, ((char *) (d)));
-                l3activeImportPower = ntohl(data->dlu.data);
-
-                // 22.7.0
-                data = getCosemDataAt(idx++, ((char *) (d)));
-                l1activeExportPower = ntohl(data->dlu.data);
-
-                // 42.7.0
-                data = getCosemDataAt(idx++, ((char *) (d)));
-                l2activeExportPower = ntohl(data->dlu.data);
-
-                // 62.7.0
-                data = getCosemDataAt(idx++, ((char *) (d)));
-                l3activeExportPower = ntohl(data->dlu.data);
-
-                // 32.7.0
-                data = getCosemDataAt(idx++, ((char *) (d)));
-                l1voltage = ntohs(data->lu.data) / 10.0;
-
-                // 52.7.0
-                data = getCosemDataAt(idx++, ((char *) (d)));
-                l2voltage = ntohs(data->lu.data) / 10.0;
-
-                // 72.7.0
-                data = getCosemDataAt(idx++, ((char *) (d)));
-                l3voltage = ntohs(data->lu.data) / 10.0;
-
-                // 31.7.0
-                data = getCosemDataAt(idx++, ((char *) (d)));
-                l1current = ntohs(data->lu.data) / 100.0;
-
-                // 51.7.0
-                data = getCosemDataAt(idx++, ((char *) (d)));
-                l2current = ntohs(data->lu.data) / 100.0;
-
-                // 71.7.0
-                data = getCosemDataAt(idx++, ((char *) (d)));
-                l3current = ntohs(data->lu.data) / 100.0;
-
-                listType = 4;
-                lastUpdateMillis = millis64();
-            } else if(data->base.length == 0x0F) {
-                idx = 1;
-
-                // 1.8.0 ?
-                data = getCosemDataAt(idx++, ((char *) (d)));
-                activeImportCounter = ntohl(data->dlu.data) / 1000.0;
-
-                // 1.8.1 ?
-                // 1.8.2 ?
-                idx += 2;
-
-                // 2.8.0 ?
-                data = getCosemDataAt(idx++, ((char *) (d)));
-                activeExportCounter = ntohl(data->dlu.data) / 1000.0;
-
-                // 2.8.1 ?
-                // 2.8.2 ?
-                idx += 2;
-
-                idx++; // Unknown empty octet string
-
-                CosemData* meterTs = getCosemDataAt(idx++, ((char *) (d)));
-                if(meterTs != NULL) {
-                    AmsOctetTimestamp* amst = (AmsOctetTimestamp*) meterTs;
-                    time_t ts = decodeCosemDateTime(amst->dt);
-                    meterTimestamp = ts;
-                }
-
-                // 2.7.0 ?
-                data = getCosemDataAt(idx++, ((char *) (d)));
-                activeExportPower = ntohl(data->dlu.data);
-
-                // 1.7.0 ?
-                data = getCosemDataAt(idx++, ((char *) (d)));
+            debugger->printf_P(PSTR("Iskra, length 0x%02x\n"), ((CosemData*) d)->base.length);
+            parseIskraConfigured(d);
+        } else if(useMeterType == AmsTypeKaifa) { // Kaifa special case
+            CosemData* data = getCosemDataAt(1, ((char *) (d)));
+            if(data->base.type == CosemTypeDLongUnsigned) {
+                listType = 1;
+                meterType = AmsTypeKaifa;
                 activeImportPower = ntohl(data->dlu.data);
-
-                // 31.7.0 ?
-                data = getCosemDataAt(idx++, ((char *) (d)));
-                l1current = ntohs(data->lu.data) / 100.0;
-
-                // 51.7.0 ?
-                data = getCosemDataAt(idx++, ((char *) (d)));
-                l2current = ntohs(data->lu.data) / 100.0;
-
-                // 71.7.0 ?
-                data = getCosemDataAt(idx++, ((char *) (d)));
-                l3current = ntohs(data->lu.data) / 100.0;
-
-                // 32.7.0 ?
-                data = getCosemDataAt(idx++, ((char *) (d)));
-                l1voltage = ntohs(data->lu.data) / 10.0;
-
-                // 72.7.0 ?
-                data = getCosemDataAt(idx++, ((char *) (d)));
-                l3voltage = ntohs(data->lu.data) / 10.0;
-
-                // 52.7.0 missing?
-                l2voltage = sqrt(pow(l1voltage - l3voltage * cos(60 * (PI/180)), 2) + pow(l3voltage * sin(60 * (PI/180)),2));
-
-                listType = 3;
-                lastUpdateMillis = millis64();
-            } else {
-                idx = 5;
-
-                data = getCosemDataAt(idx++, ((char *) (d)));
-                if(data != NULL) {
-                    activeImportCounter = ntohl(data->dlu.data) / 1000.0;
-                }
-    
-                data = getCosemDataAt(idx++, ((char *) (d)));
-                if(data != NULL) {
-                    activeExportCounter = ntohl(data->dlu.data) / 1000.0;
-                }
-    
-                data = getCosemDataAt(idx++, ((char *) (d)));
-                if(data != NULL) {
-                    reactiveImportCounter = ntohl(data->dlu.data) / 1000.0;
-                }
-    
-                data = getCosemDataAt(idx++, ((char *) (d)));
-                if(data != NULL) {
-                    reactiveExportCounter = ntohl(data->dlu.data) / 1000.0;
-                }
-
-                data = getCosemDataAt(idx++, ((char *) (d)));
-                if(data != NULL) {
-                    activeImportPower = ntohl(data->dlu.data);
-                }
-
-                data = getCosemDataAt(idx++, ((char *) (d)));
-                if(data != NULL) {
-                    activeExportPower = ntohl(data->dlu.data);
-                }
-
-                uint8_t str_len = 0;
-                str_len = getString(AMS_OBIS_UNKNOWN_1, sizeof(AMS_OBIS_UNKNOWN_1), ((char *) (d)), str);
-                if(str_len > 0) {
-                    meterId = String(str);
-                }
-
-                listType = 4;
                 lastUpdateMillis = millis64();
             }
-        } else if(useMeterType == AmsTypeKaifa && data->base.type == CosemTypeDLongUnsigned) { // Kaifa special case
-            listType = 1;
-            meterType = AmsTypeKaifa;
-            activeImportPower = ntohl(data->dlu.data);
-            lastUpdateMillis = millis64();
         }
-        
+
         if(meterType == AmsTypeUnknown && useMeterType == AmsTypeUnknown) {
             debugger->println("AMS unknown meter type, trying to identify...");
-            CosemData* d1 = getCosemDataAt(1, ((char *) (d)));
-            CosemData* d2 = getCosemDataAt(2, ((char *) (d)));
-            CosemData* d3 = getCosemDataAt(3, ((char *) (d)));
-            CosemData* d7 = getCosemDataAt(7, ((char *) (d)));
-            CosemData* d8 = getCosemDataAt(8, ((char *) (d)));
-
-            if(d1->base.type == CosemTypeDLongUnsigned &&
-                d2->base.type == CosemTypeDLongUnsigned &&
-                d3->base.type == CosemTypeDLongUnsigned &&
-                d7->base.type == CosemTypeOctetString &&
-                d8->base.type == CosemTypeOctetString
-            ) {
-                meterType = AmsTypeIskra;
-                lastUpdateMillis = millis64();
-                listType = 3;
-            } else if(d1->base.type == CosemTypeOctetString && d2->base.type == CosemTypeOctetString && d3->base.type == CosemTypeOctetString) {
-                meterType = AmsTypeIskra;
-                lastUpdateMillis = millis64();
-                listType = 3;
-            } else {
-                uint8_t str_len = 0;
-                str_len = getString(AMS_OBIS_UNKNOWN_1, sizeof(AMS_OBIS_UNKNOWN_1), ((char *) (d)), str);
-                if(str_len > 0) {
-                    meterType = AmsTypeIskra;
-                    meterId = String(str);
-                    lastUpdateMillis = millis64();
-                    listType = 3;
-                }
-            }
-        }
-    } else { // OBIS code parsing
-        listType = 1;
-        activeImportPower = val;
-
-        meterType = AmsTypeUnknown;
-        CosemData* version = findObis(AMS_OBIS_VERSION, sizeof(AMS_OBIS_VERSION), d);
-        if(version != NULL && (version->base.type == CosemTypeString || version->base.type == CosemTypeOctetString)) {
-            if(memcmp(version->str.data, "AIDON", 5) == 0) {
-                meterType = AmsTypeAidon;
-            } else if(memcmp(version->str.data, "Kamstrup", 8) == 0) {
-                meterType = AmsTypeKamstrup;
-            } else if(memcmp(version->str.data, "KFM", 3) == 0) {
-                meterType = AmsTypeKaifa;
-            }
-        } else {
-            version = getCosemDataAt(1, ((char *) (d)));
-            if(version->base.type == CosemTypeString) {
-                if(memcmp(version->str.data, "Kamstrup", 8) == 0) {
-                    meterType = AmsTypeKamstrup;
-                }
-            } 
-        }
-
-        uint8_t str_len = 0;
-        str_len = getString(AMS_OBIS_VERSION, sizeof(AMS_OBIS_VERSION), ((char *) (d)), str);
-        if(str_len > 0) {
-            listId = String(str);
-        }
-
-        val = getNumber(AMS_OBIS_ACTIVE_EXPORT, sizeof(AMS_OBIS_ACTIVE_EXPORT), ((char *) (d)));
-        if(val != NOVALUE) {
-            activeExportPower = val;
-        }
-
-        val = getNumber(AMS_OBIS_REACTIVE_IMPORT, sizeof(AMS_OBIS_REACTIVE_IMPORT), ((char *) (d)));
-        if(val != NOVALUE) {
-            reactiveImportPower = val;
-        }
-
-        val = getNumber(AMS_OBIS_REACTIVE_EXPORT, sizeof(AMS_OBIS_REACTIVE_EXPORT), ((char *) (d)));
-        if(val != NOVALUE) {
-            reactiveExportPower = val;
-        }
-
-        val = getNumber(AMS_OBIS_VOLTAGE_L1, sizeof(AMS_OBIS_VOLTAGE_L1), ((char *) (d)));
-        if(val != NOVALUE) {
-            listType = 2;
-            l1voltage = val;
-        }
-        val = getNumber(AMS_OBIS_VOLTAGE_L2, sizeof(AMS_OBIS_VOLTAGE_L2), ((char *) (d)));
-        if(val != NOVALUE) {
-            listType = 2;
-            l2voltage = val;
-        }
-        val = getNumber(AMS_OBIS_VOLTAGE_L3, sizeof(AMS_OBIS_VOLTAGE_L3), ((char *) (d)));
-        if(val != NOVALUE) {
-            listType = 2;
-            l3voltage = val;
-        }
-
-        val = getNumber(AMS_OBIS_CURRENT_L1, sizeof(AMS_OBIS_CURRENT_L1), ((char *) (d)));
-        if(val != NOVALUE) {
-            listType = 2;
-            l1current = val;
-        }
-        val = getNumber(AMS_OBIS_CURRENT_L2, sizeof(AMS_OBIS_CURRENT_L2), ((char *) (d)));
-        if(val != NOVALUE) {
-            listType = 2;
-            l2current = val;
-        } else if(listType == 2) {
-            l2currentMissing = true;
-        }
-        val = getNumber(AMS_OBIS_CURRENT_L3, sizeof(AMS_OBIS_CURRENT_L3), ((char *) (d)));
-        if(val != NOVALUE) {
-            listType = 2;
-            l3current = val;
-        }
-
-        val = getNumber(AMS_OBIS_ACTIVE_IMPORT_COUNT, sizeof(AMS_OBIS_ACTIVE_IMPORT_COUNT), ((char *) (d)));
-        if(val != NOVALUE) {
-            listType = 3;
-            activeImportCounter = val / 1000.0;
-        }
-        val = getNumber(AMS_OBIS_ACTIVE_IMPORT_COUNT_T1, sizeof(AMS_OBIS_ACTIVE_IMPORT_COUNT_T1), ((char *) (d)));
-        if(val != NOVALUE) {
-            listType = 3;
-            activeImportCounterTariff1 = val / 1000.0;
-        }
-        val = getNumber(AMS_OBIS_ACTIVE_IMPORT_COUNT_T2, sizeof(AMS_OBIS_ACTIVE_IMPORT_COUNT_T2), ((char *) (d)));
-        if(val != NOVALUE) {
-            listType = 3;
-            activeImportCounterTariff2 = val / 1000.0;
-        }
-        val = getNumber(AMS_OBIS_ACTIVE_EXPORT_COUNT, sizeof(AMS_OBIS_ACTIVE_EXPORT_COUNT), ((char *) (d)));
-        if(val != NOVALUE) {
-            listType = 3;
-            activeExportCounter = val / 1000.0;
-        }
-        val = getNumber(AMS_OBIS_ACTIVE_EXPORT_COUNT_T1, sizeof(AMS_OBIS_ACTIVE_EXPORT_COUNT_T1), ((char *) (d)));
-        if(val != NOVALUE) {
-            listType = 3;
-            activeExportCounterTariff1 = val / 1000.0;
-        }
-        val = getNumber(AMS_OBIS_ACTIVE_EXPORT_COUNT_T2, sizeof(AMS_OBIS_ACTIVE_EXPORT_COUNT_T2), ((char *) (d)));
-        if(val != NOVALUE) {
-            listType = 3;
-            activeExportCounterTariff2 = val / 1000.0;
-        }
-        val = getNumber(AMS_OBIS_REACTIVE_IMPORT_COUNT, sizeof(AMS_OBIS_REACTIVE_IMPORT_COUNT), ((char *) (d)));
-        if(val != NOVALUE) {
-            listType = 3;
-            reactiveImportCounter = val / 1000.0;
-        }
-        val = getNumber(AMS_OBIS_REACTIVE_EXPORT_COUNT, sizeof(AMS_OBIS_REACTIVE_EXPORT_COUNT), ((char *) (d)));
-        if(val != NOVALUE) {
-            listType = 3;
-            reactiveExportCounter = val / 1000.0;
-        }
-
-        str_len = getString(AMS_OBIS_METER_MODEL, sizeof(AMS_OBIS_METER_MODEL), ((char *) (d)), str);
-        if(str_len > 0) {
-            meterModel = String(str);
-        } else {
-            str_len = getString(AMS_OBIS_METER_MODEL_2, sizeof(AMS_OBIS_METER_MODEL_2), ((char *) (d)), str);
-            if(str_len > 0) {
-                meterModel = String(str);
-            }
-        }
-
-        str_len = getString(AMS_OBIS_METER_ID, sizeof(AMS_OBIS_METER_ID), ((char *) (d)), str);
-        if(str_len > 0) {
-            meterId = String(str);
-        } else {
-            str_len = getString(AMS_OBIS_METER_ID_2, sizeof(AMS_OBIS_METER_ID_2), ((char *) (d)), str);
-            if(str_len > 0) {
-                meterId = String(str);
-            }
-        }
-
-        CosemData* meterTs = findObis(AMS_OBIS_METER_TIMESTAMP, sizeof(AMS_OBIS_METER_TIMESTAMP), ((char *) (d)));
-        if(meterTs != NULL) {
-            AmsOctetTimestamp* amst = (AmsOctetTimestamp*) meterTs;
-            this->meterTimestamp = adjustForKnownIssues(amst->dt, tz, meterType == AmsTypeUnknown ? useMeterType : meterType);
-        }
-
-        val = getNumber(AMS_OBIS_POWER_FACTOR, sizeof(AMS_OBIS_POWER_FACTOR), ((char *) (d)));
-        if(val != NOVALUE) {
-            listType = 4;
-            powerFactor = val;
-        }
-        val = getNumber(AMS_OBIS_POWER_FACTOR_L1, sizeof(AMS_OBIS_POWER_FACTOR_L1), ((char *) (d)));
-        if(val != NOVALUE) {
-            listType = 4;
-            l1PowerFactor = val;
-        }
-        val = getNumber(AMS_OBIS_POWER_FACTOR_L2, sizeof(AMS_OBIS_POWER_FACTOR_L2), ((char *) (d)));
-        if(val != NOVALUE) {
-            listType = 4;
-            l2PowerFactor = val;
-        }
-        val = getNumber(AMS_OBIS_POWER_FACTOR_L3, sizeof(AMS_OBIS_POWER_FACTOR_L3), ((char *) (d)));
-        if(val != NOVALUE) {
-            listType = 4;
-            l3PowerFactor = val;
-        }
-
-        val = getNumber(AMS_OBIS_ACTIVE_IMPORT_L1, sizeof(AMS_OBIS_ACTIVE_IMPORT_L1), ((char *) (d)));
-        if (val != NOVALUE) {
-            listType = 4;
-            l1activeImportPower = val;
-        }
-        val = getNumber(AMS_OBIS_ACTIVE_IMPORT_L2, sizeof(AMS_OBIS_ACTIVE_IMPORT_L2), ((char *) (d)));
-        if (val != NOVALUE) {
-            listType = 4;
-            l2activeImportPower = val;
+            identify(d);
         }
-        val = getNumber(AMS_OBIS_ACTIVE_IMPORT_L3, sizeof(AMS_OBIS_ACTIVE_IMPORT_L3), ((char *) (d)));
-        if (val != NOVALUE) {
-            listType = 4;
-            l3activeImportPower = val;
-        }
-
-        val = getNumber(AMS_OBIS_ACTIVE_EXPORT_L1, sizeof(AMS_OBIS_ACTIVE_EXPORT_L1), ((char *) (d)));
-        if (val != NOVALUE) {
-            listType = 4;
-            l1activeExportPower = val;
-        }
-        val = getNumber(AMS_OBIS_ACTIVE_EXPORT_L2, sizeof(AMS_OBIS_ACTIVE_EXPORT_L2), ((char *) (d)));
-        if (val != NOVALUE) {
-            listType = 4;
-            l2activeExportPower = val;
-        }
-        val = getNumber(AMS_OBIS_ACTIVE_EXPORT_L3, sizeof(AMS_OBIS_ACTIVE_EXPORT_L3), ((char *) (d)));
-        if (val != NOVALUE) {
-            listType = 4;
-            l3activeExportPower = val;
-        }
-        val = getNumber(AMS_OBIS_ACTIVE_IMPORT_L1_COUNT, sizeof(AMS_OBIS_ACTIVE_IMPORT_L1_COUNT), ((char *) (d)));
-        if (val != NOVALUE) {
-            listType = 4;
-            l1activeImportCounter = val/1000;
-        }
-        val = getNumber(AMS_OBIS_ACTIVE_IMPORT_L2_COUNT, sizeof(AMS_OBIS_ACTIVE_IMPORT_L2_COUNT), ((char *) (d)));
-        if (val != NOVALUE) {
-            listType = 4;
-            l2activeImportCounter = val/1000;
-        }
-        val = getNumber(AMS_OBIS_ACTIVE_IMPORT_L3_COUNT, sizeof(AMS_OBIS_ACTIVE_IMPORT_L3_COUNT), ((char *) (d)));
-        if (val != NOVALUE) {
-            listType = 4;
-            l3activeImportCounter = val/1000;
-        }
-        val = getNumber(AMS_OBIS_ACTIVE_EXPORT_L1_COUNT, sizeof(AMS_OBIS_ACTIVE_EXPORT_L1_COUNT), ((char *) (d)));
-        if (val != NOVALUE) {
-            listType = 4;
-            l1activeExportCounter = val/1000;
-        }
-        val = getNumber(AMS_OBIS_ACTIVE_EXPORT_L2_COUNT, sizeof(AMS_OBIS_ACTIVE_EXPORT_L2_COUNT), ((char *) (d)));
-        if (val != NOVALUE) {
-            listType = 4;
-            l2activeExportCounter = val/1000;
-        }
-        val = getNumber(AMS_OBIS_ACTIVE_EXPORT_L2_COUNT, sizeof(AMS_OBIS_ACTIVE_EXPORT_L2_COUNT), ((char *) (d)));
-        if (val != NOVALUE) {
-            listType = 4;
-            l3activeExportCounter = val/1000;
-        }
-
-
-
-        if(meterType == AmsTypeKamstrup) {
-            if(listType >= 3) {
-                activeImportCounter *= 10;
-                activeExportCounter *= 10;
-                reactiveImportCounter *= 10;
-                reactiveExportCounter *= 10;
-                l1activeImportCounter *= 10;
-                l2activeImportCounter *= 10;
-                l3activeImportCounter *= 10;
-                l1activeExportCounter *= 10;
-                l2activeExportCounter *= 10;
-                l3activeExportCounter *= 10;
-            }
-            if(l1current != 0)
-                l1current /= 100;
-            if(l2current != 0)
-                l2current /= 100;
-            if(l3current != 0)
-                l3current /= 100;
-            if(powerFactor != 0)
-                powerFactor /= 100;
-            if(l1PowerFactor != 0)
-                l1PowerFactor /= 100;
-            if(l2PowerFactor != 0)
-                l2PowerFactor /= 100;
-            if(l3PowerFactor != 0)
-                l3PowerFactor /= 100;
-        } else if(meterType == AmsTypeSagemcom) {
-            CosemData* meterTs = getCosemDataAt(1, ((char *) (d)));
-            if(meterTs != NULL) {
-                AmsOctetTimestamp* amst = (AmsOctetTimestamp*) meterTs;
-                time_t ts = decodeCosemDateTime(amst->dt);
-                meterTimestamp = ts;
-            }
-
-            CosemData* mid = getCosemDataAt(58, ((char *) (d))); // TODO: Get last item
-            if(mid != NULL) {
-                switch(mid->base.type) {
-                    case CosemTypeString:
-                        memcpy(str, mid->oct.data, mid->oct.length);
-                        str[mid->oct.length] = 0x00;
-                        meterId = String(str);
-                        break;
-                    case CosemTypeOctetString:
-                        memcpy(str, mid->str.data, mid->str.length);
-                        str[mid->str.length] = 0x00;
-                        meterId = String(str);
-                        break;
-                }
-            }
-        }
-
-        lastUpdateMillis = millis64();
+    } else {
+        parseObis(d, val, tz, useMeterType);
     }
 
     // Try system title
@@ -1170,9 +218,11 @@ IEC6205675::IEC6205675(const char* d, Timezone* tz, uint8_t useMeterType, MeterC
             meterType = AmsTypeIskra;
         }
 
-        if(meterId.isEmpty() && meterType != AmsTypeUnknown) {
+        if(meterId[0] == '\0' && meterType != AmsTypeUnknown) {
         	stripNonAscii((uint8_t*) ctx.system_title, 8);
-            meterId = String((const char*)ctx.system_title);
+            memcpy(str, ctx.system_title, 8);
+            str[8] = 0x00;
+            setMeterId(str);
         }
     }
 
@@ -1220,50 +270,586 @@ IEC6205675::IEC6205675(const char* d, Timezone* tz, uint8_t useMeterType, MeterC
             threePhase = true;
         }
     }
-    meterId.trim();
+    trim(meterId);
+    obisIndex = NULL;
+}
+
+uint8_t IEC6205675::getListFormat(const char* d) {
+    // Item 1 of the vendor lists without OBIS codes is the list identifier
+    CosemCursor cursor(d);
+    CosemData* data = cursor.at(1);
+    if(data == NULL || data->base.type != CosemTypeOctetString) return DlmsListAuto;
+    if(data->oct.length >= 7 && memcmp(data->oct.data, "KFM_001", 7) == 0) return DlmsListKaifa;
+    if(data->oct.length >= 3 && memcmp(data->oct.data, "ISK", 3) == 0) return DlmsListIskra;
+    return DlmsListAuto;
+}
+
+void IEC6205675::readListId(const char* d) {
+    char listId[AMS_LIST_ID_LENGTH];
+    CosemData* data = getCosemDataAt(1, d);
+    uint8_t len = data->oct.length < AMS_LIST_ID_LENGTH - 1 ? data->oct.length : AMS_LIST_ID_LENGTH - 1;
+    memcpy(listId, data->oct.data, len);
+    listId[len] = 0x00;
+    setListId(listId);
+}
+
+void IEC6205675::parseKaifa(const char* d, Timezone* tz) {
+    readListId(d);
+    meterType = AmsTypeKaifa;
+
+    CosemCursor cursor(d);
+    CosemData* data = cursor.peek();
+    cursor.skip(2);
+    if(data->base.length == 0x0D || data->base.length == 0x12) {
+        listType = data->base.length == 0x12 ? 3 : 2;
+        readPositional(cursor, KAIFA_LIST_3P, POS_COUNT(KAIFA_LIST_3P));
+    } else if(data->base.length == 0x09 || data->base.length == 0x0E) {
+        listType = data->base.length == 0x0E ? 3 : 2;
+        readPositional(cursor, KAIFA_LIST_1P, POS_COUNT(KAIFA_LIST_1P));
+    }
+
+    if(listType >= 2 && memcmp(meterModel, "MA304T3", 7) == 0) {
+        l2voltage = sqrt(pow(l1voltage - l3voltage * cos(60 * (PI/180)), 2) + pow(l3voltage * sin(60 * (PI/180)),2));
+        l2currentMissing = true;
+    }
+
+    if(listType == 3) {
+        data = cursor.next();
+        if(data != NULL && data->base.type == CosemTypeOctetString && data->oct.length == 0x0C) {
+            AmsOctetTimestamp* amst = (AmsOctetTimestamp*) data;
+            time_t ts = decodeCosemDateTime(amst->dt);
+            meterTimestamp = tz != NULL ? tz->toUTC(ts) : ts;
+        }
+        readPositional(cursor, KAIFA_COUNTERS, POS_COUNT(KAIFA_COUNTERS));
+    }
+
+    lastUpdateMillis = millis64();
+}
+
+void IEC6205675::parseIskra(const char* d, AmsData& state) {
+    readListId(d);
+    meterType = AmsTypeIskra;
+
+    CosemCursor cursor(d);
+    CosemData* data = cursor.next();
+    if(data->base.length == 0x12) {
+        apply(state);
+        listType = state.getListType() > 4 ? state.getListType() : 4;
+        readPositional(cursor, ISKRA_LIST_18, POS_COUNT(ISKRA_LIST_18));
+        lastUpdateMillis = millis64();
+    } else if(data->base.length == 0x0C) {
+        CosemData* no3 = getCosemDataAt(3, d);
+        if(no3->base.type == CosemTypeBoolean) {
+            apply(state);
+            listType = state.getListType() > 3 ? state.getListType() : 3;
+            readPositional(cursor, ISKRA_LIST_12_COUNTERS, POS_COUNT(ISKRA_LIST_12_COUNTERS));
+            lastUpdateMillis = millis64();
+        } else if(no3->base.type == CosemTypeLongUnsigned) {
+            apply(state);
+            listType = state.getListType() > 2 ? state.getListType() : 2;
+            readPositional(cursor, ISKRA_LIST_12_3P, POS_COUNT(ISKRA_LIST_12_3P));
+            lastUpdateMillis = millis64();
+        }
+    } else if(data->base.length ==  0x0A) {
+        CosemData* no7 = getCosemDataAt(7, d);
+        if(no7->base.type == CosemTypeLongUnsigned) {
+            apply(state);
+            listType = state.getListType() > 4 ? state.getListType() : 4;
+            readPositional(cursor, ISKRA_LIST_10_1P, POS_COUNT(ISKRA_LIST_10_1P));
+            lastUpdateMillis = millis64();
+        } else if(no7->base.type == CosemTypeDLongUnsigned) {
+            apply(state);
+            listType = state.getListType() > 3 ? state.getListType() : 3;
+            readPositional(cursor, ISKRA_LIST_10_TARIFFS, POS_COUNT(ISKRA_LIST_10_TARIFFS));
+
+            double sum = activeImportCounterTariff1 + activeImportCounterTariff2;
+            if(activeImportCounter < sum)
+                activeImportCounter = sum;
+
+            sum = activeExportCounterTariff1 + activeExportCounterTariff2;
+            if(activeExportCounter < sum)
+                activeExportCounter = sum;
+
+            // 3.8.1 + 3.8.2, 4.8.1 + 4.8.2, no tariff registers for these
+            CosemData* t1 = cursor.next();
+            CosemData* t2 = cursor.next();
+            if(t1 != NULL && t2 != NULL) {
+                sum = ntohl(t1->dlu.data) / 1000.0 + ntohl(t2->dlu.data) / 1000.0;
+                if(reactiveImportCounter < sum)
+                    reactiveImportCounter = sum;
+            }
+
+            t1 = cursor.next();
+            t2 = cursor.next();
+            if(t1 != NULL && t2 != NULL) {
+                sum = ntohl(t1->dlu.data) / 1000.0 + ntohl(t2->dlu.data) / 1000.0;
+                if(reactiveExportCounter < sum)
+                    reactiveExportCounter = sum;
+            }
+
+            lastUpdateMillis = millis64();
+        }
+    } else if(data->base.length == 0x09) {
+        CosemData* no7 = getCosemDataAt(7, d);
+        if(no7->base.type == CosemTypeLongUnsigned) {
+            apply(state);
+            listType = state.getListType() > 3 ? state.getListType() : 3;
+            readPositional(cursor, ISKRA_LIST_9_1P, POS_COUNT(ISKRA_LIST_9_1P));
+            activeExportCounter = activeExportCounterTariff1 + activeExportCounterTariff2;
+            lastUpdateMillis = millis64();
+        } else if(no7->base.type == CosemTypeDLongUnsigned) {
+            apply(state);
+            listType = state.getListType() > 3 ? state.getListType() : 3;
+            readPositional(cursor, ISKRA_LIST_9_COUNTERS, POS_COUNT(ISKRA_LIST_9_COUNTERS));
+            lastUpdateMillis = millis64();
+        }
+    } else if(data->base.length == 0x08) {
+        readPositional(cursor, ISKRA_LIST_8, POS_COUNT(ISKRA_LIST_8));
+        lastUpdateMillis = millis64();
+    } else if(data->base.length == 0x04) {
+        readPositional(cursor, ISKRA_LIST_4, POS_COUNT(ISKRA_LIST_4));
+    }
+}
+
+// Iskra selected in the configuration, lists without a list identifier
+void IEC6205675::parseIskraConfigured(const char* d) {
+    char str[64];
+    meterType = AmsTypeIskra;
+    CosemCursor cursor(d);
+    CosemData* data = cursor.peek();
+
+    if(data->base.length == 0x21) {
+        cursor.skip(4);
+        readPositional(cursor, ISKRA_LIST_33, POS_COUNT(ISKRA_LIST_33));
+        listType = 4;
+        lastUpdateMillis = millis64();
+    } else if(data->base.length == 0x1C) {
+        cursor.skip(4);
+        readPositional(cursor, ISKRA_LIST_28, POS_COUNT(ISKRA_LIST_28));
+        listType = 4;
+        lastUpdateMillis = millis64();
+    } else if(data->base.length == 0x0F) {
+        cursor.skip(1);
+        readPositional(cursor, ISKRA_LIST_15_COUNTERS, POS_COUNT(ISKRA_LIST_15_COUNTERS));
+
+        CosemData* meterTs = cursor.next();
+        if(meterTs != NULL) {
+            AmsOctetTimestamp* amst = (AmsOctetTimestamp*) meterTs;
+            time_t ts = decodeCosemDateTime(amst->dt);
+            meterTimestamp = ts;
+        }
+
+        readPositional(cursor, ISKRA_LIST_15_INSTANT, POS_COUNT(ISKRA_LIST_15_INSTANT));
+
+        // 52.7.0 missing?
+        l2voltage = sqrt(pow(l1voltage - l3voltage * cos(60 * (PI/180)), 2) + pow(l3voltage * sin(60 * (PI/180)),2));
+
+        listType = 3;
+        lastUpdateMillis = millis64();
+    } else {
+        cursor.skip(5);
+        readPositional(cursor, ISKRA_LIST_OTHER, POS_COUNT(ISKRA_LIST_OTHER));
+
+        uint8_t str_len = 0;
+        str_len = getString(AMS_OBIS_UNKNOWN_1, sizeof(AMS_OBIS_UNKNOWN_1), ((char *) (d)), str);
+        if(str_len > 0) {
+            setMeterId(str);
+        }
+
+        listType = 4;
+        lastUpdateMillis = millis64();
+    }
+}
+
+// Nothing in the configuration or the payload says what meter this is
+void IEC6205675::identify(const char* d) {
+    char str[64];
+    CosemCursor cursor(d);
+    CosemData* d1 = cursor.at(1);
+    CosemData* d2 = cursor.at(2);
+    CosemData* d3 = cursor.at(3);
+    CosemData* d7 = cursor.at(7);
+    CosemData* d8 = cursor.at(8);
+
+    if(d1->base.type == CosemTypeDLongUnsigned &&
+        d2->base.type == CosemTypeDLongUnsigned &&
+        d3->base.type == CosemTypeDLongUnsigned &&
+        d7->base.type == CosemTypeOctetString &&
+        d8->base.type == CosemTypeOctetString
+    ) {
+        meterType = AmsTypeIskra;
+        lastUpdateMillis = millis64();
+        listType = 3;
+    } else if(d1->base.type == CosemTypeOctetString && d2->base.type == CosemTypeOctetString && d3->base.type == CosemTypeOctetString) {
+        meterType = AmsTypeIskra;
+        lastUpdateMillis = millis64();
+        listType = 3;
+    } else {
+        uint8_t str_len = 0;
+        str_len = getString(AMS_OBIS_UNKNOWN_1, sizeof(AMS_OBIS_UNKNOWN_1), ((char *) (d)), str);
+        if(str_len > 0) {
+            meterType = AmsTypeIskra;
+            setMeterId(str);
+            lastUpdateMillis = millis64();
+            listType = 3;
+        }
+    }
+}
+
+void IEC6205675::parseObis(const char* d, float val, Timezone* tz, uint8_t useMeterType) {
+    char str[64];
+    listType = 1;
+    activeImportPower = val;
+
+    meterType = AmsTypeUnknown;
+    CosemData* version = findObis(AMS_OBIS_VERSION, sizeof(AMS_OBIS_VERSION), d);
+    if(version != NULL && (version->base.type == CosemTypeString || version->base.type == CosemTypeOctetString)) {
+        if(memcmp(version->str.data, "AIDON", 5) == 0) {
+            meterType = AmsTypeAidon;
+        } else if(memcmp(version->str.data, "Kamstrup", 8) == 0) {
+            meterType = AmsTypeKamstrup;
+        } else if(memcmp(version->str.data, "KFM", 3) == 0) {
+            meterType = AmsTypeKaifa;
+        }
+    } else {
+        version = getCosemDataAt(1, ((char *) (d)));
+        if(version->base.type == CosemTypeString) {
+            if(memcmp(version->str.data, "Kamstrup", 8) == 0) {
+                meterType = AmsTypeKamstrup;
+            }
+        } 
+    }
+
+    uint8_t str_len = 0;
+    str_len = getString(AMS_OBIS_VERSION, sizeof(AMS_OBIS_VERSION), ((char *) (d)), str);
+    if(str_len > 0) {
+        setListId(str);
+    }
+
+    val = getNumber(AMS_OBIS_ACTIVE_EXPORT, sizeof(AMS_OBIS_ACTIVE_EXPORT), ((char *) (d)));
+    if(val != NOVALUE) {
+        activeExportPower = val;
+    }
+
+    val = getNumber(AMS_OBIS_REACTIVE_IMPORT, sizeof(AMS_OBIS_REACTIVE_IMPORT), ((char *) (d)));
+    if(val != NOVALUE) {
+        reactiveImportPower = val;
+    }
+
+    val = getNumber(AMS_OBIS_REACTIVE_EXPORT, sizeof(AMS_OBIS_REACTIVE_EXPORT), ((char *) (d)));
+    if(val != NOVALUE) {
+        reactiveExportPower = val;
+    }
+
+    val = getNumber(AMS_OBIS_VOLTAGE_L1, sizeof(AMS_OBIS_VOLTAGE_L1), ((char *) (d)));
+    if(val != NOVALUE) {
+        listType = 2;
+        l1voltage = val;
+    }
+    val = getNumber(AMS_OBIS_VOLTAGE_L2, sizeof(AMS_OBIS_VOLTAGE_L2), ((char *) (d)));
+    if(val != NOVALUE) {
+        listType = 2;
+        l2voltage = val;
+    }
+    val = getNumber(AMS_OBIS_VOLTAGE_L3, sizeof(AMS_OBIS_VOLTAGE_L3), ((char *) (d)));
+    if(val != NOVALUE) {
+        listType = 2;
+        l3voltage = val;
+    }
+
+    val = getNumber(AMS_OBIS_CURRENT_L1, sizeof(AMS_OBIS_CURRENT_L1), ((char *) (d)));
+    if(val != NOVALUE) {
+        listType = 2;
+        l1current = val;
+    }
+    val = getNumber(AMS_OBIS_CURRENT_L2, sizeof(AMS_OBIS_CURRENT_L2), ((char *) (d)));
+    if(val != NOVALUE) {
+        listType = 2;
+        l2current = val;
+    } else if(listType == 2) {
+        l2currentMissing = true;
+    }
+    val = getNumber(AMS_OBIS_CURRENT_L3, sizeof(AMS_OBIS_CURRENT_L3), ((char *) (d)));
+    if(val != NOVALUE) {
+        listType = 2;
+        l3current = val;
+    }
+
+    val = getNumber(AMS_OBIS_ACTIVE_IMPORT_COUNT, sizeof(AMS_OBIS_ACTIVE_IMPORT_COUNT), ((char *) (d)));
+    if(val != NOVALUE) {
+        listType = 3;
+        activeImportCounter = val / 1000.0;
+    }
+    val = getNumber(AMS_OBIS_ACTIVE_IMPORT_COUNT_T1, sizeof(AMS_OBIS_ACTIVE_IMPORT_COUNT_T1), ((char *) (d)));
+    if(val != NOVALUE) {
+        listType = 3;
+        activeImportCounterTariff1 = val / 1000.0;
+    }
+    val = getNumber(AMS_OBIS_ACTIVE_IMPORT_COUNT_T2, sizeof(AMS_OBIS_ACTIVE_IMPORT_COUNT_T2), ((char *) (d)));
+    if(val != NOVALUE) {
+        listType = 3;
+        activeImportCounterTariff2 = val / 1000.0;
+    }
+    val = getNumber(AMS_OBIS_ACTIVE_EXPORT_COUNT, sizeof(AMS_OBIS_ACTIVE_EXPORT_COUNT), ((char *) (d)));
+    if(val != NOVALUE) {
+        listType = 3;
+        activeExportCounter = val / 1000.0;
+    }
+    val = getNumber(AMS_OBIS_ACTIVE_EXPORT_COUNT_T1, sizeof(AMS_OBIS_ACTIVE_EXPORT_COUNT_T1), ((char *) (d)));
+    if(val != NOVALUE) {
+        listType = 3;
+        activeExportCounterTariff1 = val / 1000.0;
+    }
+    val = getNumber(AMS_OBIS_ACTIVE_EXPORT_COUNT_T2, sizeof(AMS_OBIS_ACTIVE_EXPORT_COUNT_T2), ((char *) (d)));
+    if(val != NOVALUE) {
+        listType = 3;
+        activeExportCounterTariff2 = val / 1000.0;
+    }
+    val = getNumber(AMS_OBIS_REACTIVE_IMPORT_COUNT, sizeof(AMS_OBIS_REACTIVE_IMPORT_COUNT), ((char *) (d)));
+    if(val != NOVALUE) {
+        listType = 3;
+        reactiveImportCounter = val / 1000.0;
+    }
+    val = getNumber(AMS_OBIS_REACTIVE_EXPORT_COUNT, sizeof(AMS_OBIS_REACTIVE_EXPORT_COUNT), ((char *) (d)));
+    if(val != NOVALUE) {
+        listType = 3;
+        reactiveExportCounter = val / 1000.0;
+    }
+
+    str_len = getString(AMS_OBIS_METER_MODEL, sizeof(AMS_OBIS_METER_MODEL), ((char *) (d)), str);
+    if(str_len > 0) {
+        setMeterModel(str);
+    } else {
+        str_len = getString(AMS_OBIS_METER_MODEL_2, sizeof(AMS_OBIS_METER_MODEL_2), ((char *) (d)), str);
+        if(str_len > 0) {
+            setMeterModel(str);
+        }
+    }
+
+    str_len = getString(AMS_OBIS_METER_ID, sizeof(AMS_OBIS_METER_ID), ((char *) (d)), str);
+    if(str_len > 0) {
+        setMeterId(str);
+    } else {
+        str_len = getString(AMS_OBIS_METER_ID_2, sizeof(AMS_OBIS_METER_ID_2), ((char *) (d)), str);
+        if(str_len > 0) {
+            setMeterId(str);
+        }
+    }
+
+    CosemData* meterTs = findObis(AMS_OBIS_METER_TIMESTAMP, sizeof(AMS_OBIS_METER_TIMESTAMP), ((char *) (d)));
+    if(meterTs != NULL) {
+        AmsOctetTimestamp* amst = (AmsOctetTimestamp*) meterTs;
+        this->meterTimestamp = adjustForKnownIssues(amst->dt, tz, meterType == AmsTypeUnknown ? useMeterType : meterType);
+    }
+
+    val = getNumber(AMS_OBIS_POWER_FACTOR, sizeof(AMS_OBIS_POWER_FACTOR), ((char *) (d)));
+    if(val != NOVALUE) {
+        listType = 4;
+        powerFactor = val;
+    }
+    val = getNumber(AMS_OBIS_POWER_FACTOR_L1, sizeof(AMS_OBIS_POWER_FACTOR_L1), ((char *) (d)));
+    if(val != NOVALUE) {
+        listType = 4;
+        l1PowerFactor = val;
+    }
+    val = getNumber(AMS_OBIS_POWER_FACTOR_L2, sizeof(AMS_OBIS_POWER_FACTOR_L2), ((char *) (d)));
+    if(val != NOVALUE) {
+        listType = 4;
+        l2PowerFactor = val;
+    }
+    val = getNumber(AMS_OBIS_POWER_FACTOR_L3, sizeof(AMS_OBIS_POWER_FACTOR_L3), ((char *) (d)));
+    if(val != NOVALUE) {
+        listType = 4;
+        l3PowerFactor = val;
+    }
+
+    val = getNumber(AMS_OBIS_ACTIVE_IMPORT_L1, sizeof(AMS_OBIS_ACTIVE_IMPORT_L1), ((char *) (d)));
+    if (val != NOVALUE) {
+        listType = 4;
+        l1activeImportPower = val;
+    }
+    val = getNumber(AMS_OBIS_ACTIVE_IMPORT_L2, sizeof(AMS_OBIS_ACTIVE_IMPORT_L2), ((char *) (d)));
+    if (val != NOVALUE) {
+        listType = 4;
+        l2activeImportPower = val;
+    }
+    val = getNumber(AMS_OBIS_ACTIVE_IMPORT_L3, sizeof(AMS_OBIS_ACTIVE_IMPORT_L3), ((char *) (d)));
+    if (val != NOVALUE) {
+        listType = 4;
+        l3activeImportPower = val;
+    }
+
+    val = getNumber(AMS_OBIS_ACTIVE_EXPORT_L1, sizeof(AMS_OBIS_ACTIVE_EXPORT_L1), ((char *) (d)));
+    if (val != NOVALUE) {
+        listType = 4;
+        l1activeExportPower = val;
+    }
+    val = getNumber(AMS_OBIS_ACTIVE_EXPORT_L2, sizeof(AMS_OBIS_ACTIVE_EXPORT_L2), ((char *) (d)));
+    if (val != NOVALUE) {
+        listType = 4;
+        l2activeExportPower = val;
+    }
+    val = getNumber(AMS_OBIS_ACTIVE_EXPORT_L3, sizeof(AMS_OBIS_ACTIVE_EXPORT_L3), ((char *) (d)));
+    if (val != NOVALUE) {
+        listType = 4;
+        l3activeExportPower = val;
+    }
+    val = getNumber(AMS_OBIS_ACTIVE_IMPORT_L1_COUNT, sizeof(AMS_OBIS_ACTIVE_IMPORT_L1_COUNT), ((char *) (d)));
+    if (val != NOVALUE) {
+        listType = 4;
+        l1activeImportCounter = val/1000;
+    }
+    val = getNumber(AMS_OBIS_ACTIVE_IMPORT_L2_COUNT, sizeof(AMS_OBIS_ACTIVE_IMPORT_L2_COUNT), ((char *) (d)));
+    if (val != NOVALUE) {
+        listType = 4;
+        l2activeImportCounter = val/1000;
+    }
+    val = getNumber(AMS_OBIS_ACTIVE_IMPORT_L3_COUNT, sizeof(AMS_OBIS_ACTIVE_IMPORT_L3_COUNT), ((char *) (d)));
+    if (val != NOVALUE) {
+        listType = 4;
+        l3activeImportCounter = val/1000;
+    }
+    val = getNumber(AMS_OBIS_ACTIVE_EXPORT_L1_COUNT, sizeof(AMS_OBIS_ACTIVE_EXPORT_L1_COUNT), ((char *) (d)));
+    if (val != NOVALUE) {
+        listType = 4;
+        l1activeExportCounter = val/1000;
+    }
+    val = getNumber(AMS_OBIS_ACTIVE_EXPORT_L2_COUNT, sizeof(AMS_OBIS_ACTIVE_EXPORT_L2_COUNT), ((char *) (d)));
+    if (val != NOVALUE) {
+        listType = 4;
+        l2activeExportCounter = val/1000;
+    }
+    val = getNumber(AMS_OBIS_ACTIVE_EXPORT_L2_COUNT, sizeof(AMS_OBIS_ACTIVE_EXPORT_L2_COUNT), ((char *) (d)));
+    if (val != NOVALUE) {
+        listType = 4;
+        l3activeExportCounter = val/1000;
+    }
+
+
+
+    if(meterType == AmsTypeKamstrup) {
+        if(listType >= 3) {
+            activeImportCounter *= 10;
+            activeExportCounter *= 10;
+            reactiveImportCounter *= 10;
+            reactiveExportCounter *= 10;
+            l1activeImportCounter *= 10;
+            l2activeImportCounter *= 10;
+            l3activeImportCounter *= 10;
+            l1activeExportCounter *= 10;
+            l2activeExportCounter *= 10;
+            l3activeExportCounter *= 10;
+        }
+        if(l1current != 0)
+            l1current /= 100;
+        if(l2current != 0)
+            l2current /= 100;
+        if(l3current != 0)
+            l3current /= 100;
+        if(powerFactor != 0)
+            powerFactor /= 100;
+        if(l1PowerFactor != 0)
+            l1PowerFactor /= 100;
+        if(l2PowerFactor != 0)
+            l2PowerFactor /= 100;
+        if(l3PowerFactor != 0)
+            l3PowerFactor /= 100;
+    } else if(meterType == AmsTypeSagemcom) {
+        CosemCursor cursor(d);
+        CosemData* meterTs = cursor.at(1);
+        if(meterTs != NULL) {
+            AmsOctetTimestamp* amst = (AmsOctetTimestamp*) meterTs;
+            time_t ts = decodeCosemDateTime(amst->dt);
+            meterTimestamp = ts;
+        }
+
+        CosemData* mid = cursor.at(58); // TODO: Get last item
+        if(mid != NULL) {
+            switch(mid->base.type) {
+                case CosemTypeString:
+                    memcpy(str, mid->oct.data, mid->oct.length);
+                    str[mid->oct.length] = 0x00;
+                    setMeterId(str);
+                    break;
+                case CosemTypeOctetString:
+                    memcpy(str, mid->str.data, mid->str.length);
+                    str[mid->str.length] = 0x00;
+                    setMeterId(str);
+                    break;
+            }
+        }
+    }
+
+    lastUpdateMillis = millis64();
 }
 
 CosemData* IEC6205675::getCosemDataAt(uint8_t index, const char* ptr) {
-    CosemData* item = (CosemData*) ptr;
-    int i = 0;
-    char* pos = (char*) ptr;
-    while(pos-ptr < 900) {
-        item = (CosemData*) pos;
-        if(i == index) return item;
-        switch(item->base.type) {
-            case CosemTypeArray:
-            case CosemTypeStructure:
-                pos += 2;
-                break;
-            case CosemTypeOctetString:
-            case CosemTypeString:
-                pos += 2 + item->base.length;
-                break;
-            case CosemTypeLongSigned:
-            case CosemTypeLongUnsigned:
-                pos += 3;
-                break;
-            case CosemTypeDLongSigned:
-            case CosemTypeDLongUnsigned:
-                pos += 5;
-                break;
-            case CosemTypeLong64Signed:
-            case CosemTypeLong64Unsigned:
-                pos += 9;
-                break;
-            case CosemTypeNull:
-                pos += 1;
-                break;
-            default:
-                pos += 2;
+    CosemCursor cursor(ptr);
+    return cursor.at(index);
+}
+
+// Reads count items at the cursor into the fields the table maps them to.
+// Returns false if the payload ran out first.
+bool IEC6205675::readPositional(CosemCursor& cursor, const PositionalValue* values, uint8_t count) {
+    char str[64];
+    for(uint8_t i = 0; i < count; i++) {
+        const PositionalValue& v = values[i];
+        CosemData* data = cursor.next();
+        if(data == NULL) return false;
+
+        if(v.type == CosemTypeOctetString) {
+            uint8_t len = data->oct.length < sizeof(str) ? data->oct.length : sizeof(str) - 1;
+            memcpy(str, data->oct.data, len);
+            str[len] = 0x00;
+            if(v.field == PosMeterId) setMeterId(str);
+            else if(v.field == PosMeterModel) setMeterModel(str);
+            continue;
+        }
+
+        uint32_t raw;
+        if(v.type == CosemTypeLongUnsigned) raw = ntohs(data->lu.data);
+        else if(v.type == CosemTypeDLongUnsigned) raw = ntohl(data->dlu.data);
+        else continue;
+        double val = raw / (double) v.divisor;
+
+        switch(v.field) {
+            case PosActiveImport: activeImportPower = raw; break;
+            case PosActiveExport: activeExportPower = raw; break;
+            case PosReactiveImport: reactiveImportPower = raw; break;
+            case PosReactiveExport: reactiveExportPower = raw; break;
+            case PosL1Voltage: l1voltage = val; break;
+            case PosL2Voltage: l2voltage = val; break;
+            case PosL3Voltage: l3voltage = val; break;
+            case PosL1Current: l1current = val; break;
+            case PosL2Current: l2current = val; break;
+            case PosL3Current: l3current = val; break;
+            case PosPowerFactor: powerFactor = val; break;
+            case PosL1ActiveImport: l1activeImportPower = raw; break;
+            case PosL2ActiveImport: l2activeImportPower = raw; break;
+            case PosL3ActiveImport: l3activeImportPower = raw; break;
+            case PosL1ActiveExport: l1activeExportPower = raw; break;
+            case PosL2ActiveExport: l2activeExportPower = raw; break;
+            case PosL3ActiveExport: l3activeExportPower = raw; break;
+            case PosActiveImportCounter: activeImportCounter = val; break;
+            case PosActiveImportCounterT1: activeImportCounterTariff1 = val; break;
+            case PosActiveImportCounterT2: activeImportCounterTariff2 = val; break;
+            case PosActiveExportCounter: activeExportCounter = val; break;
+            case PosActiveExportCounterT1: activeExportCounterTariff1 = val; break;
+            case PosActiveExportCounterT2: activeExportCounterTariff2 = val; break;
+            case PosReactiveImportCounter: reactiveImportCounter = val; break;
+            case PosReactiveExportCounter: reactiveExportCounter = val; break;
         }
-        i++;
     }
-    return NULL;
+    return true;
 }
 
 CosemData* IEC6205675::findObis(uint8_t* obis, int matchlength, const char* ptr) {
-    CosemData* item = (CosemData*) ptr;
+    CosemData* item = NULL;
+    if(obisIndex != NULL && matchlength == 4 && obisIndex->lookup(obis, &item)) {
+        return item;
+    }
+
+    item = (CosemData*) ptr;
     int ret = 0;
     char* pos = (char*) ptr;
     while(pos-ptr < 900) {
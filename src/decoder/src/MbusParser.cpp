@@ -6,7 +6,6 @@
 
 #include "MbusParser.h"
 #include <string.h>
-#include <stdlib.h>
 
 int8_t MBUSParser::parse(uint8_t *d, DataParserContext &ctx) {
     int len;
@@ -58,35 +57,26 @@ int8_t MBUSParser::parse(uint8_t *d, DataParserContext &ctx) {
     //      0 0 0 Finished  Sequence number
     uint8_t sequenceNumber = (ci & 0x0F);
     if((ci & 0x10) == 0x00) { // Not finished yet
+        if(arena == NULL) return DATA_PARSE_FAIL;
         if(sequenceNumber == 0) {
-            if(buf == NULL) buf = (uint8_t *)malloc((size_t)1024); // TODO find out from first package ?
-            pos = 0;
-        } else if(buf == NULL || pos + len > 1024 || sequenceNumber != (lastSequenceNumber + 1)) {
+            arena->begin(DATA_TAG_MBUS);
+        } else if(sequenceNumber != (lastSequenceNumber + 1)) {
             return DATA_PARSE_FAIL;
         }
-        memcpy(buf+pos, ptr, len);
-        pos += len;
+        if(!arena->append(DATA_TAG_MBUS, ptr, len)) return DATA_PARSE_FAIL;
         lastSequenceNumber = sequenceNumber;
         return DATA_PARSE_INTERMEDIATE_SEGMENT;
     } else if(sequenceNumber > 0) { // This is the last frame of multiple, assembly needed
-        if(buf == NULL || pos + len > 1024 || sequenceNumber != (lastSequenceNumber + 1)) {
+        if(arena == NULL || sequenceNumber != (lastSequenceNumber + 1)) {
             return DATA_PARSE_FAIL;
         }
-        memcpy(buf+pos, ptr, len);
-        pos += len;
+        if(!arena->append(DATA_TAG_MBUS, ptr, len)) return DATA_PARSE_FAIL;
+        ctx.length = arena->getLength();
         return DATA_PARSE_FINAL_SEGMENT;
     }
     return ptr-d;
 }
 
-uint16_t MBUSParser::write(const uint8_t* d, DataParserContext &ctx) {
-    if(buf != NULL) {
-        memcpy((uint8_t *) d, buf, pos);
-        ctx.length = pos;
-    }
-    return 0;
-}
-
 uint8_t MBUSParser::checksum(const uint8_t* p, int len) {
     uint8_t ret = 0;
     while(len--)
@@ -0,0 +1,69 @@
+/**
+ * @copyright Utilitech AS 2023-2026
+ * License: Fair Source
+ * 
+ */
+
+#include "ObisIndex.h"
+#include <string.h>
+
+#define OBIS_INDEX_EMPTY 0xFFFF
+#define OBIS_INDEX_NOITEM 0xFFFE
+
+void ObisIndex::build(const char* ptr) {
+    this->ptr = ptr;
+    memset(offsets, 0xFF, sizeof(offsets));
+    count = 0;
+    overflow = false;
+
+    uint32_t pending = 0;
+    bool hasPending = false;
+    const char* pos = ptr;
+    while(pos-ptr < OBIS_INDEX_MAX_WALK) {
+        CosemData* item = (CosemData*) pos;
+        if(hasPending) {
+            offsets[slot(pending)] = pos-ptr;
+            hasPending = false;
+        }
+        if(item->base.type == CosemTypeOctetString) {
+            // Same bytes as findObis compares, C.D.E.F of a 6 byte code
+            uint8_t* d = item->oct.data;
+            uint32_t key = ((uint32_t) d[2] << 24) | ((uint32_t) d[3] << 16) | ((uint32_t) d[4] << 8) | d[5];
+            uint8_t s = slot(key);
+            if(offsets[s] == OBIS_INDEX_EMPTY) {
+                if(count < OBIS_INDEX_MAX_ENTRIES) {
+                    keys[s] = key;
+                    // Resolved on the next iteration, if the following item is still within the walk
+                    offsets[s] = OBIS_INDEX_NOITEM;
+                    pending = key;
+                    hasPending = true;
+                    count++;
+                } else {
+                    overflow = true;
+                }
+            }
+        }
+        pos += cosemItemSize(item);
+    }
+}
+
+bool ObisIndex::lookup(const uint8_t* obis, CosemData** item) {
+    if(ptr == NULL) return false;
+    uint32_t key = ((uint32_t) obis[0] << 24) | ((uint32_t) obis[1] << 16) | ((uint32_t) obis[2] << 8) | obis[3];
+    uint16_t offset = offsets[slot(key)];
+    if(offset == OBIS_INDEX_EMPTY) {
+        *item = NULL;
+        return !overflow;
+    }
+    *item = offset == OBIS_INDEX_NOITEM ? NULL : (CosemData*) (ptr + offset);
+    return true;
+}
+
+// Open addressing with linear probing, returns the slot holding key or the empty slot where it belongs
+uint8_t ObisIndex::slot(uint32_t key) {
+    uint8_t s = (key * 2654435761u) >> (32 - OBIS_INDEX_BITS);
+    while(offsets[s] != OBIS_INDEX_EMPTY && keys[s] != key) {
+        s = (s + 1) & (OBIS_INDEX_SLOTS - 1);
+    }
+    return s;
+}
@@ -0,0 +1,41 @@
+/**
+ * @copyright Utilitech AS 2023-2026
+ * License: Fair Source
+ * 
+ */
+
+#include "ReassemblyArena.h"
+#include <string.h>
+
+void ReassemblyArena::begin(uint8_t owner) {
+    this->owner = owner;
+    length = 0;
+}
+
+bool ReassemblyArena::append(uint8_t owner, const uint8_t* segment, uint16_t length) {
+    if(this->owner != owner || this->owner == DATA_TAG_NONE) return false;
+    if(length > REASSEMBLY_ARENA_SIZE - this->length) {
+        reset();
+        return false;
+    }
+    memcpy(buf + this->length, segment, length);
+    this->length += length;
+    return true;
+}
+
+void ReassemblyArena::reset() {
+    owner = DATA_TAG_NONE;
+    length = 0;
+}
+
+uint8_t* ReassemblyArena::getData() {
+    return buf;
+}
+
+uint16_t ReassemblyArena::getLength() {
+    return length;
+}
+
+uint16_t ReassemblyArena::getSize() {
+    return REASSEMBLY_ARENA_SIZE;
+}
\ No newline at end of file
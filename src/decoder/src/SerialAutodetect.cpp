@@ -0,0 +1,268 @@
+/**
+ * @copyright Utilitech AS 2023-2026
+ * License: Fair Source
+ * 
+ */
+
+#include "SerialAutodetect.h"
+#include "DataParser.h"
+#include "crc.h"
+#include <string.h>
+
+// Every wrong candidate costs a burst, so one per baud rate in the order they
+// are most common: HDLC/M-Bus at 2400 8E1, DSMR 5 at 115200 8N1 and older
+// DSMR at 9600 7E1. Parity is inferred from what arrives at the right baud
+// rate, the other parities only come after the inverted lines.
+static const SerialSetting AUTODETECT_CANDIDATES[] = {
+    { 2400, 11, false },
+    { 115200, 3, false },
+    { 9600, 10, false },
+    { 2400, 11, true },
+    { 115200, 3, true },
+    { 9600, 10, true },
+    { 2400, 3, false },
+    { 9600, 11, false },
+    { 9600, 3, false },
+    { 115200, 11, false },
+    { 2400, 3, true },
+    { 9600, 11, true },
+    { 9600, 3, true },
+    { 115200, 11, true },
+};
+#define AUTODETECT_CANDIDATE_COUNT (sizeof(AUTODETECT_CANDIDATES) / sizeof(AUTODETECT_CANDIDATES[0]))
+
+static bool isText(uint8_t b) {
+    return (b >= 0x20 && b < 0x7F) || b == '\r' || b == '\n';
+}
+
+static bool isAlpha(uint8_t b) {
+    return (b >= 'A' && b <= 'Z') || (b >= 'a' && b <= 'z');
+}
+
+// DSMR identification line starts with '/', a three letter manufacturer code and a digit
+static bool isIdentification(const uint8_t* t, uint8_t mask) {
+    return (t[0] & mask) == '/' && isAlpha(t[1] & mask) && isAlpha(t[2] & mask) && isAlpha(t[3] & mask)
+        && (t[4] & mask) >= '0' && (t[4] & mask) <= '9';
+}
+
+// How far apart two baud rates are, on a log scale
+static uint32_t distance(uint32_t a, uint32_t b) {
+    return a > b ? a * 16 / b : b * 16 / a;
+}
+
+void SerialAutodetect::begin(unsigned long now) {
+    tried = 0;
+    pick(0, now);
+}
+
+void SerialAutodetect::pick(uint8_t candidate, unsigned long now) {
+    this->candidate = candidate;
+    tried |= 1 << candidate;
+    parityChanges = 0;
+    use(AUTODETECT_CANDIDATES[candidate], now);
+}
+
+void SerialAutodetect::use(SerialSetting setting, unsigned long now) {
+    this->setting = setting;
+    memset(&score, 0, sizeof(score));
+    memset(tail, 0, sizeof(tail));
+    headerLength = 0;
+    confirming = false;
+    synced = false;
+    started = lastByte = burstStart = now;
+    burstBytes = burstText = burstErrors = 0;
+}
+
+void SerialAutodetect::next(unsigned long now) {
+    uint8_t c = (candidate + 1) % AUTODETECT_CANDIDATE_COUNT;
+    while(c != candidate && (tried & (1 << c))) c = (c + 1) % AUTODETECT_CANDIDATE_COUNT;
+    if(c == candidate) {
+        // All tried, another sweep
+        tried = 0;
+        c = (candidate + 1) % AUTODETECT_CANDIDATE_COUNT;
+    }
+    pick(c, now);
+}
+
+// First candidate not tried yet at this baud rate
+bool SerialAutodetect::jump(uint32_t baud, unsigned long now) {
+    for(uint8_t c = 0; c < AUTODETECT_CANDIDATE_COUNT; c++) {
+        if(AUTODETECT_CANDIDATES[c].baud == baud && !(tried & (1 << c))) {
+            pick(c, now);
+            return true;
+        }
+    }
+    return false;
+}
+
+bool SerialAutodetect::changeParity(unsigned long now) {
+    if(parityChanges >= AUTODETECT_PARITY_CHANGES) {
+        next(now);
+        return true;
+    }
+    parityChanges++;
+    SerialSetting s = setting;
+    // 7E1 with errors had 8 data bits, of those 8E1 is the most common
+    s.parity = s.parity == 11 ? 3 : 11;
+    use(s, now);
+    confirming = true;
+    return true;
+}
+
+void SerialAutodetect::sample(uint8_t b, unsigned long now) {
+    if(burstBytes == 0 || now - lastByte > AUTODETECT_BURST_GAP) {
+        burstStart = now;
+        burstBytes = burstText = burstErrors = 0;
+    }
+    if(burstBytes < UINT16_MAX) burstBytes++;
+    if(isText(b)) burstText++;
+
+    // Switched in the middle of a frame, judge from the start of the next one
+    if(!synced) {
+        if(now - lastByte < AUTODETECT_SYNC_GAP) {
+            lastByte = now;
+            return;
+        }
+        synced = true;
+    }
+    lastByte = now;
+    if(score.bytes < UINT16_MAX) score.bytes++;
+    if(isText(b)) score.printable++;
+    if(isText(b & 0x7F)) score.printable7++;
+
+    memmove(tail, tail + 1, sizeof(tail) - 1);
+    tail[sizeof(tail) - 1] = b;
+
+    bool found = hdlcHeader(b);
+    // M-Bus long frame, 68 L L 68
+    if(tail[1] == 0x68 && tail[4] == 0x68 && tail[2] == tail[3] && tail[2] >= 3) found = true;
+    // Only near the start of mostly text, to not take noise for an identification line
+    if(isIdentification(tail, 0xFF) && score.printable * 8 >= score.bytes * 7) found = true;
+    else if(isIdentification(tail, 0x7F) && score.printable7 * 8 >= score.bytes * 7) score.headers7++;
+    if(found) score.headers++;
+}
+
+// Collects 7E, format, addresses and control, then checks the HCS against them
+bool SerialAutodetect::hdlcHeader(uint8_t b) {
+    if(headerLength == 0) {
+        if(b == DATA_TAG_HDLC) header[headerLength++] = b;
+        return false;
+    }
+    header[headerLength++] = b;
+    if(headerLength == 2 && (b & 0xF0) != 0xA0) {
+        // Not frame format type 3, a flag may start the next header
+        headerLength = 0;
+        if(b == DATA_TAG_HDLC) header[headerLength++] = b;
+        return false;
+    }
+
+    // Destination and source address end with a byte that has its LSB set
+    uint8_t pos = 3, addresses = 0;
+    while(pos < headerLength && addresses < 2) {
+        if(header[pos] & 0x01) addresses++;
+        pos++;
+    }
+    if(addresses < 2 || pos - 3 > 8) {
+        if(pos - 3 > 8 || headerLength == AUTODETECT_HEADER_MAX) headerLength = 0;
+        return false;
+    }
+    // Control and the two HCS bytes
+    if(headerLength < pos + 3) return false;
+
+    uint16_t hcs = crc16_x25(header + 1, pos);
+    bool valid = ((header[pos + 1] << 8) | header[pos + 2]) == hcs;
+    headerLength = 0;
+    return valid;
+}
+
+void SerialAutodetect::error() {
+    if(score.errors < UINT16_MAX) score.errors++;
+    if(burstErrors < UINT16_MAX) burstErrors++;
+}
+
+// Enough of the burst in progress to judge it, and too many errors in it
+bool SerialAutodetect::garbage() {
+    return burstBytes >= AUTODETECT_BURST_BYTES && burstErrors * AUTODETECT_ERROR_RATIO > burstBytes;
+}
+
+bool SerialAutodetect::update(unsigned long now) {
+    if(confirming) {
+        // Headers or text still come with errors, the parity guessed was wrong as well
+        if(score.headers > 0 && score.errors * AUTODETECT_ERROR_RATIO > score.bytes) return decide(now);
+        if(garbage() && burstText * 8 >= burstBytes * 7) return changeParity(now);
+        if(now - started < AUTODETECT_CONFIRM_TIMEOUT) return false;
+        // Looked right but nothing decoded, carry on from where the sweep was
+        next(now);
+        return true;
+    }
+    return decide(now);
+}
+
+bool SerialAutodetect::decide(unsigned long now) {
+    if(score.headers > 0) {
+        // A few errors are expected from switching in the middle of a byte
+        if(score.errors * AUTODETECT_ERROR_RATIO <= score.bytes) {
+            // Nothing to change, hold on to it until a frame decodes
+            confirming = true;
+            started = now;
+            return false;
+        }
+        // Frame headers come through, but with errors: baud rate right, parity wrong
+        return changeParity(now);
+    }
+    if(score.headers7 > 0 && setting.parity != 10) {
+        SerialSetting s = setting;
+        s.parity = 10;
+        use(s, now);
+        confirming = true;
+        return true;
+    }
+
+    // The rest only needs the bytes and their timing, not the start of a frame
+    bool wrong = garbage();
+    if(wrong && burstText * 8 >= burstBytes * 7) {
+        // Text with errors, parity wrong as above
+        return changeParity(now);
+    }
+    // Measured once the burst lasted long enough, filled a sample or is over
+    unsigned long span = lastByte - burstStart;
+    bool measured = span >= AUTODETECT_RATE_TIME
+        || (span > 0 && (burstBytes >= AUTODETECT_SAMPLE_BYTES || now - lastByte > AUTODETECT_BURST_GAP));
+    uint32_t bitRate = measured ? burstBytes * 10000UL / span : 0;
+    if(wrong && bitRate > 0 && bitRate * 2 < setting.baud) {
+        // Less than this baud rate carries: the meter sends slower, and every
+        // falling edge in its bytes made a byte here
+        uint32_t estimate = bitRate / AUTODETECT_EDGES_PER_BYTE + 1, baud = 0;
+        for(uint8_t c = 0; c < AUTODETECT_CANDIDATE_COUNT; c++) {
+            uint32_t b = AUTODETECT_CANDIDATES[c].baud;
+            if(b < setting.baud && (baud == 0 || distance(b, estimate) < distance(baud, estimate))) baud = b;
+        }
+        if(jump(baud, now)) return true;
+    }
+
+    bool enough = synced && score.bytes >= AUTODETECT_SAMPLE_BYTES;
+    bool burstEnded = synced && score.bytes > 0 && now - lastByte > AUTODETECT_BURST_GAP;
+    if(enough || burstEnded || now - started > AUTODETECT_MAX_DWELL) {
+        // Full rate garbage at the fastest baud rate: nothing faster to try, the line is inverted
+        bool fastest = true;
+        for(uint8_t c = 0; c < AUTODETECT_CANDIDATE_COUNT; c++) {
+            if(AUTODETECT_CANDIDATES[c].baud > setting.baud) fastest = false;
+        }
+        if(wrong && fastest && bitRate * 2 >= setting.baud && jump(setting.baud, now)) return true;
+        next(now);
+        return true;
+    }
+    return false;
+}
+
+SerialSetting SerialAutodetect::current() {
+    return setting;
+}
+
+bool SerialAutodetect::isConfirming() {
+    return confirming;
+}
+
+SerialScore SerialAutodetect::getScore() {
+    return score;
+}
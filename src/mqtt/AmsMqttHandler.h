@@ -15,6 +15,7 @@
 #include "HwTools.h"
 #include "PriceService.h"
 #include "AmsFirmwareUpdater.h"
+#include "AmsPublishContext.h"
 
 #if defined(ESP32)
 #include <esp_task_wdt.h>
@@ -53,7 +54,7 @@ public:
     virtual uint8_t getFormat() { return 0; };
 
     virtual bool postConnect() { return false; };
-    virtual bool publish(AmsData* data, AmsData* previousState, EnergyAccounting* ea, PriceService* ps) { return false; };
+    virtual bool publish(AmsPublishContext& ctx) { return false; };
     virtual bool publishTemperatures(AmsConfiguration*, HwTools*) { return false; };
     virtual bool publishPrices(PriceService* ps) { return false; };
     virtual bool publishSystem(HwTools*, PriceService*, EnergyAccounting*) { return false; };
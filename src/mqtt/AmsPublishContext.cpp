@@ -0,0 +1,87 @@
+/**
+ * @copyright Utilitech AS 2023-2026
+ * License: Fair Source
+ * 
+ */
+
+#include "AmsPublishContext.h"
+
+AmsPublishContext::AmsPublishContext(AmsData* update, AmsData* meterState, EnergyAccounting* ea, PriceService* ps, HwTools* hw, uint8_t sinks) {
+    this->update = update;
+    this->meterState = meterState;
+    this->ea = ea;
+    this->ps = ps;
+    this->sinks = sinks;
+    memset(payloads, 0, sizeof(payloads));
+
+    vcc = hw->getVcc();
+    rssi = hw->getWifiRssi();
+    temperature = hw->getTemperature();
+
+    eaInitialized = ea->isInitialized();
+    monthMax = ea->getMonthMax();
+    threshold = ea->getCurrentThreshold();
+    peakCount = ea->getConfig()->hours;
+    if(peakCount > 5) peakCount = 5;
+    for(uint8_t i = 0; i < peakCount; i++) {
+        peaks[i] = ea->getPeak(i+1).value / 100.0;
+    }
+    useThisHour = ea->getUseThisHour();
+    useToday = ea->getUseToday();
+    useThisMonth = ea->getUseThisMonth();
+    costThisHour = ea->getCostThisHour();
+    costToday = ea->getCostToday();
+    costThisMonth = ea->getCostThisMonth();
+    producedThisHour = ea->getProducedThisHour();
+    producedToday = ea->getProducedToday();
+    producedThisMonth = ea->getProducedThisMonth();
+    incomeThisHour = ea->getIncomeThisHour();
+    incomeToday = ea->getIncomeToday();
+    incomeThisMonth = ea->getIncomeThisMonth();
+
+    EnergyDemand* dm = ea->getDemand();
+    demandQuarter = dm->getQuarterAverage();
+    demandQuarterProjection = dm->getQuarterProjection();
+    demandHour = dm->getHourAverage();
+    demandHourProjection = dm->getHourProjection();
+    demandBilled = dm->getPeakAverage();
+    demandThreshold = dm->getPeakThreshold();
+    demandWarning = dm->isPeakWarning();
+}
+
+AmsPublishContext::~AmsPublishContext() {
+    for(uint8_t i = 0; i < PUBLISH_PAYLOAD_SLOTS; i++) {
+        if(payloads[i].buf != NULL) free(payloads[i].buf);
+    }
+}
+
+const char* AmsPublishContext::getPayload(uint8_t format, AmsData* data, uint16_t& length) {
+    for(uint8_t i = 0; i < PUBLISH_PAYLOAD_SLOTS; i++) {
+        AmsPublishPayload& p = payloads[i];
+        if(p.buf != NULL && p.format == format && p.data == data) {
+            length = p.length;
+            return p.buf;
+        }
+    }
+    return NULL;
+}
+
+// Copied, since the handlers render into a buffer they share with each other
+void AmsPublishContext::setPayload(uint8_t format, AmsData* data, const char* buf, uint16_t length) {
+    if(sinks < 2) return;
+    AmsPublishPayload* slot = NULL;
+    for(uint8_t i = 0; i < PUBLISH_PAYLOAD_SLOTS; i++) {
+        if(payloads[i].buf == NULL) {
+            slot = &payloads[i];
+            break;
+        }
+    }
+    if(slot == NULL) return;
+    slot->buf = (char*) malloc(length + 1);
+    if(slot->buf == NULL) return;
+    memcpy(slot->buf, buf, length);
+    slot->buf[length] = '\0';
+    slot->format = format;
+    slot->data = data;
+    slot->length = length;
+}
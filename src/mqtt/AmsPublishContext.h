@@ -0,0 +1,69 @@
+/**
+ * @copyright Utilitech AS 2023-2026
+ * License: Fair Source
+ * 
+ */
+
+#ifndef _AMSPUBLISHCONTEXT_H
+#define _AMSPUBLISHCONTEXT_H
+
+#include "AmsData.h"
+#include "EnergyAccounting.h"
+#include "HwTools.h"
+#include "PriceService.h"
+
+#define PUBLISH_PAYLOAD_JSON 1
+#define PUBLISH_PAYLOAD_JSON_FLAT 2 // Payload format 6, no "data" object and realtime fields prefixed
+#define PUBLISH_PAYLOAD_SLOTS 2
+
+struct AmsPublishPayload {
+    uint8_t format;
+    AmsData* data;
+    char* buf;
+    uint16_t length;
+};
+
+// What the MQTT sinks publish for one meter frame. The values derived from
+// energy accounting and the hardware are read once when it is created, and
+// the first sink to render a payload format leaves it here for the others.
+class AmsPublishContext {
+public:
+    // sinks is how many handlers will be given this context, payloads are
+    // only kept when there is more than one
+    AmsPublishContext(AmsData* update, AmsData* meterState, EnergyAccounting* ea, PriceService* ps, HwTools* hw, uint8_t sinks);
+    ~AmsPublishContext();
+
+    AmsData* update; // Fields of this frame only
+    AmsData* meterState; // Merged state after this frame
+    EnergyAccounting* ea;
+    PriceService* ps;
+
+    float vcc;
+    int rssi;
+    float temperature;
+
+    bool eaInitialized;
+    float monthMax;
+    uint8_t threshold;
+    uint8_t peakCount;
+    double peaks[5]; // kWh, in the order of EnergyAccounting::getPeak()
+    float useThisHour, useToday, useThisMonth;
+    float costThisHour, costToday, costThisMonth;
+    float producedThisHour, producedToday, producedThisMonth;
+    float incomeThisHour, incomeToday, incomeThisMonth;
+
+    uint32_t demandQuarter, demandQuarterProjection;
+    uint32_t demandHour, demandHourProjection;
+    uint32_t demandBilled, demandThreshold;
+    bool demandWarning;
+
+    // Payload of a format rendered from data by an earlier sink, NULL if none
+    const char* getPayload(uint8_t format, AmsData* data, uint16_t& length);
+    void setPayload(uint8_t format, AmsData* data, const char* buf, uint16_t length);
+
+private:
+    uint8_t sinks;
+    AmsPublishPayload payloads[PUBLISH_PAYLOAD_SLOTS];
+};
+
+#endif
@@ -8,27 +8,24 @@
 #include "json/domoticz_json.h"
 #include "Uptime.h"
 
-bool DomoticzMqttHandler::publish(AmsData* update, AmsData* previousState, EnergyAccounting* ea, PriceService* ps) {
+bool DomoticzMqttHandler::publish(AmsPublishContext& ctx) {
     bool ret = false;
 
-    AmsData data;
+    AmsData* data = ctx.update;
     if(mqttConfig.stateUpdate) {
         uint64_t now = millis64();
         if(now-lastStateUpdate < mqttConfig.stateUpdateInterval * 1000) return false;
-        data.apply(*previousState);
-        data.apply(*update);
+        data = ctx.meterState;
         lastStateUpdate = now;
-    } else {
-        data = *update;
     }
 
     if (config.elidx > 0) {
-        if(data.getActiveImportCounter() > 1.0 && !data.isCounterEstimated()) {
-            energy = data.getActiveImportCounter();
+        if(data->getActiveImportCounter() > 1.0 && !data->isCounterEstimated()) {
+            energy = data->getActiveImportCounter();
         }
         if(energy > 0.0) {
             char val[16];
-            snprintf_P(val, 16, PSTR("%.1f;%.1f"), (data.getActiveImportPower()/1.0), energy*1000.0);
+            snprintf_P(val, 16, PSTR("%.1f;%.1f"), (data->getActiveImportPower()/1.0), energy*1000.0);
             snprintf_P(json, BufferSize, DOMOTICZ_JSON,
                 config.elidx,
                 val
@@ -38,12 +35,12 @@ bool DomoticzMqttHandler::publish(AmsData* update, AmsData* previousState, Energ
         }
     }
 
-    if(data.getListType() == 1)
+    if(data->getListType() == 1)
         return ret;
 
     if (config.vl1idx > 0){				
         char val[16];
-        snprintf_P(val, 16, PSTR("%.2f"), data.getL1Voltage());
+        snprintf_P(val, 16, PSTR("%.2f"), data->getL1Voltage());
         snprintf_P(json, BufferSize, DOMOTICZ_JSON,
             config.vl1idx,
             val
@@ -54,7 +51,7 @@ bool DomoticzMqttHandler::publish(AmsData* update, AmsData* previousState, Energ
 
     if (config.vl2idx > 0){				
         char val[16];
-        snprintf_P(val, 16, PSTR("%.2f"), data.getL2Voltage());
+        snprintf_P(val, 16, PSTR("%.2f"), data->getL2Voltage());
         snprintf_P(json, BufferSize, DOMOTICZ_JSON,
             config.vl2idx,
             val
@@ -65,7 +62,7 @@ bool DomoticzMqttHandler::publish(AmsData* update, AmsData* previousState, Energ
 
     if (config.vl3idx > 0){				
         char val[16];
-        snprintf(val, 16, "%.2f", data.getL3Voltage());
+        snprintf(val, 16, "%.2f", data->getL3Voltage());
         snprintf_P(json, BufferSize, DOMOTICZ_JSON,
             config.vl3idx,
             val
@@ -76,7 +73,7 @@ bool DomoticzMqttHandler::publish(AmsData* update, AmsData* previousState, Energ
 
     if (config.cl1idx > 0){				
         char val[16];
-        snprintf(val, 16, "%.1f;%.1f;%.1f", data.getL1Current(), data.getL2Current(), data.getL3Current());
+        snprintf(val, 16, "%.1f;%.1f;%.1f", data->getL1Current(), data->getL2Current(), data->getL3Current());
         snprintf_P(json, BufferSize, DOMOTICZ_JSON,
             config.cl1idx,
             val
@@ -21,7 +21,7 @@ public:
         this->config = config;
     };
     #endif
-    bool publish(AmsData* data, AmsData* previousState, EnergyAccounting* ea, PriceService* ps);
+    bool publish(AmsPublishContext& ctx);
     bool publishTemperatures(AmsConfiguration*, HwTools*);
     bool publishPrices(PriceService*);
     bool publishSystem(HwTools* hw, PriceService* ps, EnergyAccounting* ea);
@@ -87,42 +87,39 @@ bool HomeAssistantMqttHandler::postConnect() {
     return ret;
 }
 
-bool HomeAssistantMqttHandler::publish(AmsData* update, AmsData* previousState, EnergyAccounting* ea, PriceService* ps) {
+bool HomeAssistantMqttHandler::publish(AmsPublishContext& ctx) {
 	if(pubTopic.isEmpty() || !connected())
 		return false;
 
     if(time(nullptr) < FirmwareVersion::BuildEpoch)
         return false;
 
-    AmsData data;
+    AmsData* data = ctx.update;
     if(mqttConfig.stateUpdate) {
         uint64_t now = millis64();
         if(now-lastStateUpdate < mqttConfig.stateUpdateInterval * 1000) return false;
-        data.apply(*previousState);
-        data.apply(*update);
+        data = ctx.meterState;
         lastStateUpdate = now;
-    } else {
-        data = *update;
     }
 
-    if(data.getListType() >= 3 && !data.isCounterEstimated()) { // publish energy counts
-        publishList3(&data, ea);
+    if(data->getListType() >= 3 && !data->isCounterEstimated()) { // publish energy counts
+        publishList3(data, ctx.ea);
         mqtt.loop();
     }
 
-    if(data.getListType() == 1) { // publish power counts
-        publishList1(&data, ea);
+    if(data->getListType() == 1) { // publish power counts
+        publishList1(data, ctx.ea);
         mqtt.loop();
-    } else if(data.getListType() <= 3) { // publish power counts and volts/amps
-        publishList2(&data, ea);
+    } else if(data->getListType() <= 3) { // publish power counts and volts/amps
+        publishList2(data, ctx.ea);
         mqtt.loop();
-    } else if(data.getListType() == 4) { // publish power counts and volts/amps/phase power and PF
-        publishList4(&data, ea);
+    } else if(data->getListType() == 4) { // publish power counts and volts/amps/phase power and PF
+        publishList4(data, ctx.ea);
         mqtt.loop();
     }
 
-    if(ea->isInitialized()) {
-        publishRealtime(&data, ea, ps);
+    if(ctx.eaInitialized) {
+        publishRealtime(ctx);
         mqtt.loop();
     }
     loop();
@@ -147,8 +144,8 @@ bool HomeAssistantMqttHandler::publishList2(AmsData* data, EnergyAccounting* ea)
     toJsonIsoTimestamp(data->getPackageTimestamp(), pt, sizeof(pt));
 
     snprintf_P(json, BufferSize, HA3_JSON,
-        data->getListId().c_str(),
-        data->getMeterId().c_str(),
+        data->getListId(),
+        data->getMeterId(),
         getMeterModel(data).c_str(),
         data->getActiveImportPower(),
         data->getReactiveImportPower(),
@@ -195,8 +192,8 @@ bool HomeAssistantMqttHandler::publishList4(AmsData* data, EnergyAccounting* ea)
     toJsonIsoTimestamp(data->getPackageTimestamp(), pt, sizeof(pt));
 
     snprintf_P(json, BufferSize, HA4_JSON,
-        data->getListId().c_str(),
-        data->getMeterId().c_str(),
+        data->getListId(),
+        data->getMeterId(),
         getMeterModel(data).c_str(),
         data->getActiveImportPower(),
         data->getL1ActiveImportPower(),
@@ -235,37 +232,35 @@ String HomeAssistantMqttHandler::getMeterModel(AmsData* data) {
     return meterModel;
 }
 
-bool HomeAssistantMqttHandler::publishRealtime(AmsData* data, EnergyAccounting* ea, PriceService* ps) {
-    publishRealtimeSensors(ea, ps);
-    if(ea->getProducedThisHour() > 0.0 || ea->getProducedToday() > 0.0 || ea->getProducedThisMonth() > 0.0) publishRealtimeExportSensors(ea, ps);
+bool HomeAssistantMqttHandler::publishRealtime(AmsPublishContext& ctx) {
+    publishRealtimeSensors(ctx.ea, ctx.ps);
+    if(ctx.producedThisHour > 0.0 || ctx.producedToday > 0.0 || ctx.producedThisMonth > 0.0) publishRealtimeExportSensors(ctx.ea, ctx.ps);
     if(lastThresholdPublish == 0) publishThresholdSensors();
     String peaks = "";
-    uint8_t peakCount = ea->getConfig()->hours;
-    if(peakCount > 5) peakCount = 5;
-    for(uint8_t i = 1; i <= peakCount; i++) {
+    for(uint8_t i = 0; i < ctx.peakCount; i++) {
         if(!peaks.isEmpty()) peaks += ",";
-        peaks += String(ea->getPeak(i).value / 100.0, 2);
+        peaks += String(ctx.peaks[i], 2);
     }
     uint16_t pos = snprintf_P(json, BufferSize, PSTR("{\"max\":%.1f,\"peaks\":[%s],\"threshold\":%d,\"hour\":{\"use\":%.2f,\"cost\":%.2f,\"produced\":%.2f,\"income\":%.2f},\"day\":{\"use\":%.2f,\"cost\":%.2f,\"produced\":%.2f,\"income\":%.2f},\"month\":{\"use\":%.2f,\"cost\":%.2f,\"produced\":%.2f,\"income\":%.2f}"),
-        ea->getMonthMax(),
+        ctx.monthMax,
         peaks.c_str(),
-        ea->getCurrentThreshold(),
-        ea->getUseThisHour(),
-        ea->getCostThisHour(),
-        ea->getProducedThisHour(),
-        ea->getIncomeThisHour(),
-        ea->getUseToday(),
-        ea->getCostToday(),
-        ea->getProducedToday(),
-        ea->getIncomeToday(),
-        ea->getUseThisMonth(),
-        ea->getCostThisMonth(),
-        ea->getProducedThisMonth(),
-        ea->getIncomeThisMonth()
+        ctx.threshold,
+        ctx.useThisHour,
+        ctx.costThisHour,
+        ctx.producedThisHour,
+        ctx.incomeThisHour,
+        ctx.useToday,
+        ctx.costToday,
+        ctx.producedToday,
+        ctx.incomeToday,
+        ctx.useThisMonth,
+        ctx.costThisMonth,
+        ctx.producedThisMonth,
+        ctx.incomeThisMonth
     );
     uint32_t ms = millis();
     if(lastThresholdPublish == 0 || ms-lastThresholdPublish > 3600000) {
-        EnergyAccountingConfig* conf = ea->getConfig();
+        EnergyAccountingConfig* conf = ctx.ea->getConfig();
         pos += snprintf_P(json+pos, BufferSize-pos, PSTR(",\"thresholds\": [%d,%d,%d,%d,%d,%d,%d,%d,%d]"),
             conf->thresholds[0],
             conf->thresholds[1],
@@ -23,7 +23,7 @@ public:
         this->hw = hw;
         setHomeAssistantConfig(config, hostname);
     };
-    bool publish(AmsData* data, AmsData* previousState, EnergyAccounting* ea, PriceService* ps);
+    bool publish(AmsPublishContext& ctx);
     bool publishTemperatures(AmsConfiguration*, HwTools*);
     bool publishPrices(PriceService*);
     bool publishSystem(HwTools* hw, PriceService* ps, EnergyAccounting* ea);
@@ -63,7 +63,7 @@ private:
     bool publishList3(AmsData* data, EnergyAccounting* ea);
     bool publishList4(AmsData* data, EnergyAccounting* ea);
     String getMeterModel(AmsData* data);
-    bool publishRealtime(AmsData* data, EnergyAccounting* ea, PriceService* ps);
+    bool publishRealtime(AmsPublishContext& ctx);
     void publishSensor(const HomeAssistantSensor sensor);
     void publishList1Sensors();
     void publishList1ExportSensors();
@@ -10,7 +10,7 @@
 #include "Uptime.h"
 #include "AmsJsonGenerator.h"
 
-bool JsonMqttHandler::publish(AmsData* update, AmsData* previousState, EnergyAccounting* ea, PriceService* ps) {
+bool JsonMqttHandler::publish(AmsPublishContext& ctx) {
     if(strlen(mqttConfig.publishTopic) == 0) {
         return false;
     }
@@ -18,39 +18,49 @@ bool JsonMqttHandler::publish(AmsData* update, AmsData* previousState, EnergyAcc
 		return false;
     }
 
-    bool ret = false;
-    memset(json, 0, BufferSize);
-
-    AmsData data;
+    AmsData* data = ctx.update;
     if(mqttConfig.stateUpdate) {
         uint64_t now = millis64();
         if(now-lastStateUpdate < mqttConfig.stateUpdateInterval * 1000) return false;
-        data.apply(*previousState);
-        data.apply(*update);
+        data = ctx.meterState;
         lastStateUpdate = now;
+    }
+
+    uint8_t listType = data->getListType();
+    if(listType < 1 || listType > 4) {
+        loop();
+        return false;
+    }
+
+    // Everything after the header is the same for all handlers publishing this frame in the same format
+    uint8_t format = mqttConfig.payloadFormat == 6 ? PUBLISH_PAYLOAD_JSON_FLAT : PUBLISH_PAYLOAD_JSON;
+    uint16_t pos = appendJsonHeader(data, ctx);
+    uint16_t length = 0;
+    const char* body = ctx.getPayload(format, data, length);
+    if(body != NULL && pos + length < BufferSize) {
+        memcpy(json+pos, body, length + 1);
+        pos += length;
     } else {
-        data = *update;
+        uint16_t start = pos;
+        pos = appendJsonBody(data, ctx, pos);
+        ctx.setPayload(format, data, json+start, pos-start);
     }
 
-    if(data.getListType() == 1) {
-        ret = publishList1(&data, ea);
-        mqtt.loop();
-    } else if(data.getListType() == 2) {
-        ret = publishList2(&data, ea);
-        mqtt.loop();
-    } else if(data.getListType() == 3) {
-        ret = publishList3(&data, ea);
-        mqtt.loop();
-    } else if(data.getListType() == 4) {
-        ret = publishList4(&data, ea);
-        mqtt.loop();
+    bool ret = false;
+    if(mqttConfig.payloadFormat == 5) {
+        char topic[192];
+        snprintf_P(topic, 192, PSTR("%s/list%d"), mqttConfig.publishTopic, listType);
+        ret = mqtt.publish(topic, json);
+    } else {
+        ret = mqtt.publish(mqttConfig.publishTopic, json);
     }
+    mqtt.loop();
 
-    if(data.getListType() >= 2 && data.getActiveExportPower() > 0.0) {
+    if(listType >= 2 && data->getActiveExportPower() > 0.0) {
         hasExport = true;
     }
 
-    if(data.getListType() >= 3 && data.getActiveExportCounter() > 0.0) {
+    if(listType >= 3 && data->getActiveExportCounter() > 0.0) {
         hasExport = true;
     }
 
@@ -58,19 +68,43 @@ bool JsonMqttHandler::publish(AmsData* update, AmsData* previousState, EnergyAcc
     return ret;
 }
 
-uint16_t JsonMqttHandler::appendJsonHeader(AmsData* data) {
+uint16_t JsonMqttHandler::appendJsonHeader(AmsData* data, AmsPublishContext& ctx) {
     return snprintf_P(json, BufferSize, PSTR("{\"id\":\"%s\",\"name\":\"%s\",\"up\":%u,\"t\":%lu,\"vcc\":%.3f,\"rssi\":%d,\"temp\":%.2f,"),
         WiFi.macAddress().c_str(),
         mqttConfig.clientId,
         (uint32_t) (millis64()/1000),
         data->getPackageTimestamp(),
-        hw->getVcc(),
-        hw->getWifiRssi(),
-        hw->getTemperature()
+        ctx.vcc,
+        ctx.rssi,
+        ctx.temperature
     );
 }
 
-uint16_t JsonMqttHandler::appendJsonFooter(EnergyAccounting* ea, uint16_t pos) {
+uint16_t JsonMqttHandler::appendJsonBody(AmsData* data, AmsPublishContext& ctx, uint16_t pos) {
+    if(mqttConfig.payloadFormat != 6) {
+        pos += snprintf_P(json+pos, BufferSize-pos, PSTR("\"data\":{"));
+    }
+    switch(data->getListType()) {
+        case 1:
+            pos += appendList1(data, pos);
+            break;
+        case 2:
+            pos += appendList2(data, pos);
+            break;
+        case 3:
+            pos += appendList3(data, pos);
+            break;
+        case 4:
+            pos += appendList4(data, pos);
+            break;
+    }
+    pos += appendJsonFooter(ctx, pos);
+    json[pos++] = '}';
+    json[pos] = '\0';
+    return pos;
+}
+
+uint16_t JsonMqttHandler::appendJsonFooter(AmsPublishContext& ctx, uint16_t pos) {
     char pf[4];
     if(mqttConfig.payloadFormat == 6) {
         strcpy_P(pf, PSTR("rt_"));
@@ -79,62 +113,49 @@ uint16_t JsonMqttHandler::appendJsonFooter(EnergyAccounting* ea, uint16_t pos) {
     }
 
     String peaks = "";
-    uint8_t peakCount = ea->getConfig()->hours;
-    if(peakCount > 5) peakCount = 5;
-    for(uint8_t i = 1; i <= peakCount; i++) {
+    for(uint8_t i = 0; i < ctx.peakCount; i++) {
         if(!peaks.isEmpty()) peaks += ",";
-        peaks += String(ea->getPeak(i).value / 100.0, 2);
+        peaks += String(ctx.peaks[i], 2);
     }
-    
-    return snprintf_P(json+pos, BufferSize-pos, PSTR("%s\"%sh\":%.3f,\"%sd\":%.2f,\"%sm\":%.1f,\"%st\":%d,\"%sx\":%.2f,\"%she\":%.3f,\"%sde\":%.2f,\"%sme\":%.1f,\"peaks\":[%s]%s"),
+
+    return snprintf_P(json+pos, BufferSize-pos, PSTR("%s\"%sh\":%.3f,\"%sd\":%.2f,\"%sm\":%.1f,\"%st\":%d,\"%sx\":%.2f,\"%she\":%.3f,\"%sde\":%.2f,\"%sme\":%.1f,\"peaks\":[%s],\"demand\":{\"q\":%u,\"qp\":%u,\"h\":%u,\"hp\":%u,\"b\":%u,\"l\":%u,\"w\":%s}%s"),
         strlen(pf) == 0 ? "},\"realtime\":{" : ",",
         pf,
-        ea->getUseThisHour(),
+        ctx.useThisHour,
         pf,
-        ea->getUseToday(),
+        ctx.useToday,
         pf,
-        ea->getUseThisMonth(),
+        ctx.useThisMonth,
         pf,
-        ea->getCurrentThreshold(),
+        ctx.threshold,
         pf,
-        ea->getMonthMax(),
+        ctx.monthMax,
         pf,
-        ea->getProducedThisHour(),
+        ctx.producedThisHour,
         pf,
-        ea->getProducedToday(),
+        ctx.producedToday,
         pf,
-        ea->getProducedThisMonth(),
+        ctx.producedThisMonth,
         peaks.c_str(),
+        ctx.demandQuarter,
+        ctx.demandQuarterProjection,
+        ctx.demandHour,
+        ctx.demandHourProjection,
+        ctx.demandBilled,
+        ctx.demandThreshold,
+        ctx.demandWarning ? "true" : "false",
         strlen(pf) == 0 ? "}" : ""
     );
 }
 
-bool JsonMqttHandler::publishList1(AmsData* data, EnergyAccounting* ea) {
-    uint16_t pos = appendJsonHeader(data);
-    if(mqttConfig.payloadFormat != 6) {
-        pos += snprintf_P(json+pos, BufferSize-pos, PSTR("\"data\":{"));
-    }
-    pos += snprintf_P(json+pos, BufferSize-pos, PSTR("\"P\":%d"), data->getActiveImportPower());
-    pos += appendJsonFooter(ea, pos);
-    json[pos++] = '}';
-    json[pos] = '\0';
-    if(mqttConfig.payloadFormat == 5) {
-        char topic[192];
-        snprintf_P(topic, 192, PSTR("%s/list1"), mqttConfig.publishTopic);
-        return mqtt.publish(topic, json);
-    } else {
-        return mqtt.publish(mqttConfig.publishTopic, json);
-    }
+uint16_t JsonMqttHandler::appendList1(AmsData* data, uint16_t pos) {
+    return snprintf_P(json+pos, BufferSize-pos, PSTR("\"P\":%d"), data->getActiveImportPower());
 }
 
-bool JsonMqttHandler::publishList2(AmsData* data, EnergyAccounting* ea) {
-    uint16_t pos = appendJsonHeader(data);
-    if(mqttConfig.payloadFormat != 6) {
-        pos += snprintf_P(json+pos, BufferSize-pos, PSTR("\"data\":{"));
-    }
-    pos += snprintf_P(json+pos, BufferSize-pos, PSTR("\"lv\":\"%s\",\"meterId\":\"%s\",\"type\":\"%s\",\"P\":%d,\"Q\":%d,\"PO\":%d,\"QO\":%d,\"I1\":%.2f,\"I2\":%.2f,\"I3\":%.2f,\"U1\":%.2f,\"U2\":%.2f,\"U3\":%.2f"),
-        data->getListId().c_str(),
-        data->getMeterId().c_str(),
+uint16_t JsonMqttHandler::appendList2(AmsData* data, uint16_t pos) {
+    return snprintf_P(json+pos, BufferSize-pos, PSTR("\"lv\":\"%s\",\"meterId\":\"%s\",\"type\":\"%s\",\"P\":%d,\"Q\":%d,\"PO\":%d,\"QO\":%d,\"I1\":%.2f,\"I2\":%.2f,\"I3\":%.2f,\"U1\":%.2f,\"U2\":%.2f,\"U3\":%.2f"),
+        data->getListId(),
+        data->getMeterId(),
         getMeterModel(data).c_str(),
         data->getActiveImportPower(),
         data->getReactiveImportPower(),
@@ -147,26 +168,12 @@ bool JsonMqttHandler::publishList2(AmsData* data, EnergyAccounting* ea) {
         data->getL2Voltage(),
         data->getL3Voltage()
     );
-    pos += appendJsonFooter(ea, pos);
-    json[pos++] = '}';
-    json[pos] = '\0';
-    if(mqttConfig.payloadFormat == 5) {
-        char topic[192];
-        snprintf_P(topic, 192, PSTR("%s/list2"), mqttConfig.publishTopic);
-        return mqtt.publish(topic, json);
-    } else {
-        return mqtt.publish(mqttConfig.publishTopic, json);
-    }
 }
 
-bool JsonMqttHandler::publishList3(AmsData* data, EnergyAccounting* ea) {
-    uint16_t pos = appendJsonHeader(data);
-    if(mqttConfig.payloadFormat != 6) {
-        pos += snprintf_P(json+pos, BufferSize-pos, PSTR("\"data\":{"));
-    }
-    pos += snprintf_P(json+pos, BufferSize-pos, PSTR("\"lv\":\"%s\",\"meterId\":\"%s\",\"type\":\"%s\",\"P\":%d,\"Q\":%d,\"PO\":%d,\"QO\":%d,\"I1\":%.2f,\"I2\":%.2f,\"I3\":%.2f,\"U1\":%.2f,\"U2\":%.2f,\"U3\":%.2f,\"tPI\":%.3f,\"tPIT1\":%.3f,\"tPIT2\":%.3f,\"tPO\":%.3f,\"tPOT1\":%.3f,\"tPOT2\":%.3f,\"tQI\":%.3f,\"tQO\":%.3f,\"rtc\":%lu"),
-        data->getListId().c_str(),
-        data->getMeterId().c_str(),
+uint16_t JsonMqttHandler::appendList3(AmsData* data, uint16_t pos) {
+    return snprintf_P(json+pos, BufferSize-pos, PSTR("\"lv\":\"%s\",\"meterId\":\"%s\",\"type\":\"%s\",\"P\":%d,\"Q\":%d,\"PO\":%d,\"QO\":%d,\"I1\":%.2f,\"I2\":%.2f,\"I3\":%.2f,\"U1\":%.2f,\"U2\":%.2f,\"U3\":%.2f,\"tPI\":%.3f,\"tPIT1\":%.3f,\"tPIT2\":%.3f,\"tPO\":%.3f,\"tPOT1\":%.3f,\"tPOT2\":%.3f,\"tQI\":%.3f,\"tQO\":%.3f,\"rtc\":%lu"),
+        data->getListId(),
+        data->getMeterId(),
         getMeterModel(data).c_str(),
         data->getActiveImportPower(),
         data->getReactiveImportPower(),
@@ -188,26 +195,12 @@ bool JsonMqttHandler::publishList3(AmsData* data, EnergyAccounting* ea) {
         data->getReactiveExportCounter(),
         data->getMeterTimestamp()
     );
-    pos += appendJsonFooter(ea, pos);
-    json[pos++] = '}';
-    json[pos] = '\0';
-    if(mqttConfig.payloadFormat == 5) {
-        char topic[192];
-        snprintf_P(topic, 192, PSTR("%s/list3"), mqttConfig.publishTopic);
-        return mqtt.publish(topic, json);
-    } else {
-        return mqtt.publish(mqttConfig.publishTopic, json);
-    }
 }
 
-bool JsonMqttHandler::publishList4(AmsData* data, EnergyAccounting* ea) {
-    uint16_t pos = appendJsonHeader(data);
-    if(mqttConfig.payloadFormat != 6) {
-        pos += snprintf_P(json+pos, BufferSize-pos, PSTR("\"data\":{"));
-    }
-    pos += snprintf_P(json+pos, BufferSize-pos, PSTR("\"lv\":\"%s\",\"meterId\":\"%s\",\"type\":\"%s\",\"P\":%d,\"P1\":%d,\"P2\":%d,\"P3\":%d,\"Q\":%d,\"PO\":%d,\"PO1\":%d,\"PO2\":%d,\"PO3\":%d,\"QO\":%d,\"I1\":%.2f,\"I2\":%.2f,\"I3\":%.2f,\"U1\":%.2f,\"U2\":%.2f,\"U3\":%.2f,\"PF\":%.2f,\"PF1\":%.2f,\"PF2\":%.2f,\"PF3\":%.2f,\"tPI\":%.3f,\"tPIT1\":%.3f,\"tPIT2\":%.3f,\"tPO\":%.3f,\"tPOT1\":%.3f,\"tPOT2\":%.3f,\"tQI\":%.3f,\"tQO\":%.3f,\"tPI1\":%.3f,\"tPI2\":%.3f,\"tPI3\":%.3f,\"tPO1\":%.3f,\"tPO2\":%.3f,\"tPO3\":%.3f,\"rtc\":%lu"),
-        data->getListId().c_str(),
-        data->getMeterId().c_str(),
+uint16_t JsonMqttHandler::appendList4(AmsData* data, uint16_t pos) {
+    return snprintf_P(json+pos, BufferSize-pos, PSTR("\"lv\":\"%s\",\"meterId\":\"%s\",\"type\":\"%s\",\"P\":%d,\"P1\":%d,\"P2\":%d,\"P3\":%d,\"Q\":%d,\"PO\":%d,\"PO1\":%d,\"PO2\":%d,\"PO3\":%d,\"QO\":%d,\"I1\":%.2f,\"I2\":%.2f,\"I3\":%.2f,\"U1\":%.2f,\"U2\":%.2f,\"U3\":%.2f,\"PF\":%.2f,\"PF1\":%.2f,\"PF2\":%.2f,\"PF3\":%.2f,\"tPI\":%.3f,\"tPIT1\":%.3f,\"tPIT2\":%.3f,\"tPO\":%.3f,\"tPOT1\":%.3f,\"tPOT2\":%.3f,\"tQI\":%.3f,\"tQO\":%.3f,\"tPI1\":%.3f,\"tPI2\":%.3f,\"tPI3\":%.3f,\"tPO1\":%.3f,\"tPO2\":%.3f,\"tPO3\":%.3f,\"rtc\":%lu"),
+        data->getListId(),
+        data->getMeterId(),
         getMeterModel(data).c_str(),
         data->getActiveImportPower(),
         data->getL1ActiveImportPower(),
@@ -245,16 +238,6 @@ bool JsonMqttHandler::publishList4(AmsData* data, EnergyAccounting* ea) {
         data->getL3ActiveExportCounter(),
         data->getMeterTimestamp()
     );
-    pos += appendJsonFooter(ea, pos);
-    json[pos++] = '}';
-    json[pos] = '\0';
-    if(mqttConfig.payloadFormat == 5) {
-        char topic[192];
-        snprintf_P(topic, 192, PSTR("%s/list4"), mqttConfig.publishTopic);
-        return mqtt.publish(topic, json);
-    } else {
-        return mqtt.publish(mqttConfig.publishTopic, json);
-    }
 }
 
 String JsonMqttHandler::getMeterModel(AmsData* data) {
@@ -549,6 +532,12 @@ void JsonMqttHandler::onMessage(String &topic, String &payload) {
             AmsJsonGenerator::generateMonthPlotJson(ds, json, BufferSize);
             bool ret = mqtt.publish(pubTopic, json);
             loop();
+        } else if(payload.equals("quarterplot")) {
+            char pubTopic[192];
+            snprintf_P(pubTopic, 192, PSTR("%s/quarterplot"), mqttConfig.publishTopic);
+            AmsJsonGenerator::generateQuarterPlotJson(ds, json, BufferSize, 0, QUARTER_PLOT_MAX);
+            bool ret = mqtt.publish(pubTopic, json);
+            loop();
         }
     }
 }
@@ -19,7 +19,7 @@ public:
         this->hw = hw;
         this->ds = ds;
     };
-    bool publish(AmsData* data, AmsData* previousState, EnergyAccounting* ea, PriceService* ps);
+    bool publish(AmsPublishContext& ctx);
     bool publishTemperatures(AmsConfiguration*, HwTools*);
     bool publishPrices(PriceService*);
     bool publishSystem(HwTools* hw, PriceService* ps, EnergyAccounting* ea);
@@ -35,12 +35,13 @@ private:
     bool hasExport = false;
     AmsDataStorage* ds;
 
-    uint16_t appendJsonHeader(AmsData* data);
-    uint16_t appendJsonFooter(EnergyAccounting* ea, uint16_t pos);
-    bool publishList1(AmsData* data, EnergyAccounting* ea);
-    bool publishList2(AmsData* data, EnergyAccounting* ea);
-    bool publishList3(AmsData* data, EnergyAccounting* ea);
-    bool publishList4(AmsData* data, EnergyAccounting* ea);
+    uint16_t appendJsonHeader(AmsData* data, AmsPublishContext& ctx);
+    uint16_t appendJsonBody(AmsData* data, AmsPublishContext& ctx, uint16_t pos);
+    uint16_t appendJsonFooter(AmsPublishContext& ctx, uint16_t pos);
+    uint16_t appendList1(AmsData* data, uint16_t pos);
+    uint16_t appendList2(AmsData* data, uint16_t pos);
+    uint16_t appendList3(AmsData* data, uint16_t pos);
+    uint16_t appendList4(AmsData* data, uint16_t pos);
     String getMeterModel(AmsData* data);
     void toJsonIsoTimestamp(time_t t, char* buf, size_t buflen);
 };
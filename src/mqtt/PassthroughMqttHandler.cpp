@@ -7,7 +7,7 @@
 #include "PassthroughMqttHandler.h"
 #include "hexutils.h"
 
-bool PassthroughMqttHandler::publish(AmsData* data, AmsData* previousState, EnergyAccounting* ea, PriceService* ps) {
+bool PassthroughMqttHandler::publish(AmsPublishContext& ctx) {
     return false;
 }
 
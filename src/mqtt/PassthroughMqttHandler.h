@@ -20,7 +20,7 @@ public:
         this->topic = String(mqttConfig.publishTopic);
     };
     #endif
-    bool publish(AmsData* data, AmsData* previousState, EnergyAccounting* ea, PriceService* ps);
+    bool publish(AmsPublishContext& ctx);
     bool publishTemperatures(AmsConfiguration*, HwTools*);
     bool publishPrices(PriceService*);
     bool publishSystem(HwTools* hw, PriceService* ps, EnergyAccounting* ea);
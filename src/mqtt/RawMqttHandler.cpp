@@ -9,104 +9,106 @@
 #include "Uptime.h"
 #include "FirmwareVersion.h"
 
-bool RawMqttHandler::publish(AmsData* update, AmsData* previousState, EnergyAccounting* ea, PriceService* ps) {
+bool RawMqttHandler::publish(AmsPublishContext& ctx) {
 	if(topic.isEmpty() || !connected())
 		return false;
 
-    AmsData data;
+    // Collect the fields changed since the last publish. A gap in the
+    // generation means frames went by unseen, so send everything again.
+    pending |= ctx.meterState->changesSince(lastGeneration);
+
+    AmsData* data = ctx.update;
     if(mqttConfig.stateUpdate) {
         uint64_t now = millis64();
         if(now-lastStateUpdate < mqttConfig.stateUpdateInterval * 1000) return false;
-        data.apply(*previousState);
-        data.apply(*update);
+        data = ctx.meterState;
         lastStateUpdate = now;
-    } else {
-        data = *update;
     }
         
-    if(data.getPackageTimestamp() > 0) {
-        mqtt.publish(topic + "/meter/dlms/timestamp", String(data.getPackageTimestamp()));
+    if(data->getPackageTimestamp() > 0) {
+        mqtt.publish(topic + "/meter/dlms/timestamp", String(data->getPackageTimestamp()));
     }
-    switch(data.getListType()) {
+    switch(data->getListType()) {
         case 4:
-            publishList4(&data, previousState);
+            publishList4(data, pending);
             loop();
         case 3:
-            publishList3(&data, previousState);
+            publishList3(data, pending);
             loop();
         case 2:
-            publishList2(&data, previousState);
+            publishList2(data, pending);
             loop();
         case 1:
-            publishList1(&data, previousState);
+            publishList1(data, pending);
             loop();
     }
+    pending = 0;
 
-    if(data.getListType() >= 2 && data.getActiveExportPower() > 0.0) {
+    if(data->getListType() >= 2 && data->getActiveExportPower() > 0.0) {
         hasExport = true;
     }
 
-    if(data.getListType() >= 3 && data.getActiveExportCounter() > 0.0) {
+    if(data->getListType() >= 3 && data->getActiveExportCounter() > 0.0) {
         hasExport = true;
     }
 
-    if(ea->isInitialized()) {
-        publishRealtime(ea);
+    if(ctx.eaInitialized) {
+        publishRealtime(ctx);
         loop();
     }
     return true;
 }
 
-bool RawMqttHandler::publishList1(AmsData* data, AmsData* meterState) {
-    if(full || meterState->getActiveImportPower() != data->getActiveImportPower()) {
+bool RawMqttHandler::publishList1(AmsData* data, uint64_t changes) {
+    if(full || (changes & AMS_FIELD(AmsFieldActiveImportPower))) {
         mqtt.publish(topic + "/meter/import/active", String(data->getActiveImportPower()));
     }
     return true;
 }
 
-bool RawMqttHandler::publishList2(AmsData* data, AmsData* meterState) {
+bool RawMqttHandler::publishList2(AmsData* data, uint64_t changes) {
     // Only send data if changed. ID and Type is sent on the 10s interval only if changed
-    if(full || meterState->getMeterId() != data->getMeterId()) {
+    if(full || (changes & AMS_FIELD(AmsFieldMeterId))) {
         mqtt.publish(topic + "/meter/id", data->getMeterId());
     }
-    if(full || meterState->getMeterModel() != data->getMeterModel()) {
+    if(full || (changes & AMS_FIELD(AmsFieldMeterModel))) {
         mqtt.publish(topic + "/meter/type", data->getMeterModel());
     }
     loop();
-    if(full || meterState->getL1Current() != data->getL1Current()) {
+    if(full || (changes & AMS_FIELD(AmsFieldL1Current))) {
         mqtt.publish(topic + "/meter/l1/current", String(data->getL1Current(), 2));
     }
-    if(full || meterState->getL1Voltage() != data->getL1Voltage()) {
+    if(full || (changes & AMS_FIELD(AmsFieldL1Voltage))) {
         mqtt.publish(topic + "/meter/l1/voltage", String(data->getL1Voltage(), 2));
     }
     loop();
-    if(full || meterState->getL2Current() != data->getL2Current()) {
+    if(full || (changes & AMS_FIELD(AmsFieldL2Current))) {
         mqtt.publish(topic + "/meter/l2/current", String(data->getL2Current(), 2));
     }
-    if(full || meterState->getL2Voltage() != data->getL2Voltage()) {
+    if(full || (changes & AMS_FIELD(AmsFieldL2Voltage))) {
         mqtt.publish(topic + "/meter/l2/voltage", String(data->getL2Voltage(), 2));
     }
     loop();
-    if(full || meterState->getL3Current() != data->getL3Current()) {
+    if(full || (changes & AMS_FIELD(AmsFieldL3Current))) {
         mqtt.publish(topic + "/meter/l3/current", String(data->getL3Current(), 2));
     }
-    if(full || meterState->getL3Voltage() != data->getL3Voltage()) {
+    if(full || (changes & AMS_FIELD(AmsFieldL3Voltage))) {
         mqtt.publish(topic + "/meter/l3/voltage", String(data->getL3Voltage(), 2));
     }
     loop();
-    if(full || meterState->getReactiveExportPower() != data->getReactiveExportPower()) {
+    if(full || (changes & AMS_FIELD(AmsFieldReactiveExportPower))) {
         mqtt.publish(topic + "/meter/export/reactive", String(data->getReactiveExportPower()));
     }
-    if(full || meterState->getActiveExportPower() != data->getActiveExportPower()) {
+    if(full || (changes & AMS_FIELD(AmsFieldActiveExportPower))) {
         mqtt.publish(topic + "/meter/export/active", String(data->getActiveExportPower()));
     }
-    if(full || meterState->getReactiveImportPower() != data->getReactiveImportPower()) {
+    if(full || (changes & AMS_FIELD(AmsFieldReactiveImportPower))) {
         mqtt.publish(topic + "/meter/import/reactive", String(data->getReactiveImportPower()));
     }
     return true;
 }
 
-bool RawMqttHandler::publishList3(AmsData* data, AmsData* meterState) {
+bool RawMqttHandler::publishList3(AmsData* data, uint64_t changes) {
     // ID and type belongs to List 2, but I see no need to send that every 10s
     mqtt.publish(topic + "/meter/id", data->getMeterId(), true, 0);
     mqtt.publish(topic + "/meter/type", data->getMeterModel(), true, 0);
@@ -122,100 +124,112 @@ bool RawMqttHandler::publishList3(AmsData* data, AmsData* meterState) {
     return true;
 }
 
-bool RawMqttHandler::publishList4(AmsData* data, AmsData* meterState) {
-        if(full || meterState->getL1ActiveImportPower() != data->getL1ActiveImportPower()) {
+bool RawMqttHandler::publishList4(AmsData* data, uint64_t changes) {
+        if(full || (changes & AMS_FIELD(AmsFieldL1ActiveImportPower))) {
             mqtt.publish(topic + "/meter/import/l1", String(data->getL1ActiveImportPower()));
             mqtt.loop();
         }
-        if(full || meterState->getL2ActiveImportPower() != data->getL2ActiveImportPower()) {
+        if(full || (changes & AMS_FIELD(AmsFieldL2ActiveImportPower))) {
             mqtt.publish(topic + "/meter/import/l2", String(data->getL2ActiveImportPower()));
             mqtt.loop();
         }
-        if(full || meterState->getL3ActiveImportPower() != data->getL3ActiveImportPower()) {
+        if(full || (changes & AMS_FIELD(AmsFieldL3ActiveImportPower))) {
             mqtt.publish(topic + "/meter/import/l3", String(data->getL3ActiveImportPower()));
             mqtt.loop();
         }
-        if(full || meterState->getL1ActiveExportPower() != data->getL1ActiveExportPower()) {
+        if(full || (changes & AMS_FIELD(AmsFieldL1ActiveExportPower))) {
             mqtt.publish(topic + "/meter/export/l1", String(data->getL1ActiveExportPower()));
             mqtt.loop();
         }
-        if(full || meterState->getL2ActiveExportPower() != data->getL2ActiveExportPower()) {
+        if(full || (changes & AMS_FIELD(AmsFieldL2ActiveExportPower))) {
             mqtt.publish(topic + "/meter/export/l2", String(data->getL2ActiveExportPower()));
             mqtt.loop();
         }
-        if(full || meterState->getL3ActiveExportPower() != data->getL3ActiveExportPower()) {
+        if(full || (changes & AMS_FIELD(AmsFieldL3ActiveExportPower))) {
             mqtt.publish(topic + "/meter/export/l3", String(data->getL3ActiveExportPower()));
             mqtt.loop();
         }
-        if(full || meterState->getL1ActiveImportCounter() != data->getL1ActiveImportCounter()) {
+        if(full || (changes & AMS_FIELD(AmsFieldL1ActiveImportCounter))) {
             mqtt.publish(topic + "/meter/import/l1/accumulated", String(data->getL1ActiveImportCounter(), 2));
             mqtt.loop();
         }
-        if(full || meterState->getL2ActiveImportCounter() != data->getL2ActiveImportCounter()) {
+        if(full || (changes & AMS_FIELD(AmsFieldL2ActiveImportCounter))) {
             mqtt.publish(topic + "/meter/import/l2/accumulated", String(data->getL2ActiveImportCounter(), 2));
             mqtt.loop();
         }
-        if(full || meterState->getL3ActiveImportCounter() != data->getL3ActiveImportCounter()) {
+        if(full || (changes & AMS_FIELD(AmsFieldL3ActiveImportCounter))) {
             mqtt.publish(topic + "/meter/import/l3/accumulated", String(data->getL3ActiveImportCounter(), 2));
             mqtt.loop();
         }
-        if(full || meterState->getL1ActiveExportCounter() != data->getL1ActiveExportCounter()) {
+        if(full || (changes & AMS_FIELD(AmsFieldL1ActiveExportCounter))) {
             mqtt.publish(topic + "/meter/export/l1/accumulated", String(data->getL1ActiveExportCounter(), 2));
             mqtt.loop();
         }
-        if(full || meterState->getL2ActiveExportCounter() != data->getL2ActiveExportCounter()) {
+        if(full || (changes & AMS_FIELD(AmsFieldL2ActiveExportCounter))) {
             mqtt.publish(topic + "/meter/export/l2/accumulated", String(data->getL2ActiveExportCounter(), 2));
             mqtt.loop();
         }
-        if(full || meterState->getL3ActiveExportCounter() != data->getL3ActiveExportCounter()) {
+        if(full || (changes & AMS_FIELD(AmsFieldL3ActiveExportCounter))) {
             mqtt.publish(topic + "/meter/export/l3/accumulated", String(data->getL3ActiveExportCounter(), 2));
             mqtt.loop();
         }
-        if(full || meterState->getPowerFactor() != data->getPowerFactor()) {
+        if(full || (changes & AMS_FIELD(AmsFieldPowerFactor))) {
             mqtt.publish(topic + "/meter/powerfactor", String(data->getPowerFactor(), 2));
             mqtt.loop();
         }
-        if(full || meterState->getL1PowerFactor() != data->getL1PowerFactor()) {
+        if(full || (changes & AMS_FIELD(AmsFieldL1PowerFactor))) {
             mqtt.publish(topic + "/meter/l1/powerfactor", String(data->getL1PowerFactor(), 2));
             mqtt.loop();
         }
-        if(full || meterState->getL2PowerFactor() != data->getL2PowerFactor()) {
+        if(full || (changes & AMS_FIELD(AmsFieldL2PowerFactor))) {
             mqtt.publish(topic + "/meter/l2/powerfactor", String(data->getL2PowerFactor(), 2));
             mqtt.loop();
         }
-        if(full || meterState->getL3PowerFactor() != data->getL3PowerFactor()) {
+        if(full || (changes & AMS_FIELD(AmsFieldL3PowerFactor))) {
             mqtt.publish(topic + "/meter/l3/powerfactor", String(data->getL3PowerFactor(), 2));
             mqtt.loop();
         }
         return true;
 }
 
-bool RawMqttHandler::publishRealtime(EnergyAccounting* ea) {
-    mqtt.publish(topic + "/realtime/import/hour", String(ea->getUseThisHour(), 3));
+bool RawMqttHandler::publishRealtime(AmsPublishContext& ctx) {
+    mqtt.publish(topic + "/realtime/import/hour", String(ctx.useThisHour, 3));
     mqtt.loop();
-    mqtt.publish(topic + "/realtime/import/day", String(ea->getUseToday(), 2));
+    mqtt.publish(topic + "/realtime/import/day", String(ctx.useToday, 2));
     mqtt.loop();
-    mqtt.publish(topic + "/realtime/import/month", String(ea->getUseThisMonth(), 1));
+    mqtt.publish(topic + "/realtime/import/month", String(ctx.useThisMonth, 1));
     mqtt.loop();
-    uint8_t peakCount = ea->getConfig()->hours;
-    if(peakCount > 5) peakCount = 5;
-    for(uint8_t i = 1; i <= peakCount; i++) {
-        mqtt.publish(topic + "/realtime/import/peak/" + String(i, 10), String(ea->getPeak(i).value / 100.0, 10), true, 0);
+    for(uint8_t i = 0; i < ctx.peakCount; i++) {
+        mqtt.publish(topic + "/realtime/import/peak/" + String(i+1, 10), String(ctx.peaks[i], 10), true, 0);
         mqtt.loop();
     }
-    mqtt.publish(topic + "/realtime/import/threshold", String(ea->getCurrentThreshold(), 10), true, 0);
+    mqtt.publish(topic + "/realtime/import/threshold", String(ctx.threshold, 10), true, 0);
+    mqtt.loop();
+    mqtt.publish(topic + "/realtime/import/monthmax", String(ctx.monthMax, 3), true, 0);
+    mqtt.loop();
+    mqtt.publish(topic + "/realtime/import/demand/quarter", String(ctx.demandQuarter, 10));
+    mqtt.loop();
+    mqtt.publish(topic + "/realtime/import/demand/quarter/projected", String(ctx.demandQuarterProjection, 10));
+    mqtt.loop();
+    mqtt.publish(topic + "/realtime/import/demand/hour", String(ctx.demandHour, 10));
+    mqtt.loop();
+    mqtt.publish(topic + "/realtime/import/demand/hour/projected", String(ctx.demandHourProjection, 10));
+    mqtt.loop();
+    mqtt.publish(topic + "/realtime/import/demand/billed", String(ctx.demandBilled, 10), true, 0);
+    mqtt.loop();
+    mqtt.publish(topic + "/realtime/import/demand/threshold", String(ctx.demandThreshold, 10), true, 0);
     mqtt.loop();
-    mqtt.publish(topic + "/realtime/import/monthmax", String(ea->getMonthMax(), 3), true, 0);
+    mqtt.publish(topic + "/realtime/import/demand/warning", ctx.demandWarning ? "true" : "false");
     mqtt.loop();
-    mqtt.publish(topic + "/realtime/export/hour", String(ea->getProducedThisHour(), 3));
+    mqtt.publish(topic + "/realtime/export/hour", String(ctx.producedThisHour, 3));
     mqtt.loop();
-    mqtt.publish(topic + "/realtime/export/day", String(ea->getProducedToday(), 2));
+    mqtt.publish(topic + "/realtime/export/day", String(ctx.producedToday, 2));
     mqtt.loop();
-    mqtt.publish(topic + "/realtime/export/month", String(ea->getProducedThisMonth(), 1));
+    mqtt.publish(topic + "/realtime/export/month", String(ctx.producedThisMonth, 1));
     mqtt.loop();
     uint32_t now = millis();
     if(lastThresholdPublish == 0 || now-lastThresholdPublish > 3600000) {
-        EnergyAccountingConfig* conf = ea->getConfig();
+        EnergyAccountingConfig* conf = ctx.ea->getConfig();
         for(uint8_t i = 0; i < 9; i++) {
             mqtt.publish(topic + "/realtime/import/thresholds/" + String(i+1, 10), String(conf->thresholds[i], 10), true, 0);
             mqtt.loop();
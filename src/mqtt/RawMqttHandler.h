@@ -22,7 +22,7 @@ public:
         topic = String(mqttConfig.publishTopic);
     };
     #endif
-    bool publish(AmsData* data, AmsData* previousState, EnergyAccounting* ea, PriceService* ps);
+    bool publish(AmsPublishContext& ctx);
     bool publishTemperatures(AmsConfiguration*, HwTools*);
     bool publishPrices(PriceService*);
     bool publishSystem(HwTools* hw, PriceService* ps, EnergyAccounting* ea);
@@ -37,11 +37,13 @@ private:
     String topic;
     uint32_t lastThresholdPublish = 0;
     bool hasExport = false;
+    uint32_t lastGeneration = 0;
+    uint64_t pending = 0;
 
-    bool publishList1(AmsData* data, AmsData* meterState);
-    bool publishList2(AmsData* data, AmsData* meterState);
-    bool publishList3(AmsData* data, AmsData* meterState);
-    bool publishList4(AmsData* data, AmsData* meterState);
-    bool publishRealtime(EnergyAccounting* ea);
+    bool publishList1(AmsData* data, uint64_t changes);
+    bool publishList2(AmsData* data, uint64_t changes);
+    bool publishList3(AmsData* data, uint64_t changes);
+    bool publishList4(AmsData* data, uint64_t changes);
+    bool publishRealtime(AmsPublishContext& ctx);
 };
 #endif
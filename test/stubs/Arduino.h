@@ -26,8 +26,19 @@
 #ifndef PSTR
 #define PSTR(x) (x)
 #endif
+#ifndef strcmp_P
+#define strcmp_P strcmp
+#endif
 
 typedef uint8_t byte;
 typedef bool boolean;
 
+// As the ESP32 core does, the templates rather than the AVR macros
+#include <algorithm>
+using std::min;
+using std::max;
+
+// Defined by the test harness, a clock tests set themselves
+unsigned long millis();
+
 #endif
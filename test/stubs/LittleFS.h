@@ -0,0 +1,93 @@
+/**
+ * @copyright Utilitech AS 2023-2026
+ * License: Fair Source
+ *
+ * Native shim for <LittleFS.h>: an in-memory filesystem with the parts of the
+ * FS/File API the persistence code uses. Tests reach into files directly to
+ * truncate or corrupt them.
+ */
+#ifndef _NATIVE_LITTLEFS_H
+#define _NATIVE_LITTLEFS_H
+
+#include <stdint.h>
+#include <string.h>
+#include <map>
+#include <string>
+#include <vector>
+
+typedef std::map<std::string, std::vector<uint8_t>> NativeFiles;
+
+class File {
+public:
+    File() {}
+    File(NativeFiles* files, const std::string& path, bool writable, size_t pos)
+        : files(files), path(path), writable(writable), pos(pos) {}
+
+    operator bool() const { return files != NULL; }
+    size_t size() const { return files ? data().size() : 0; }
+    size_t position() const { return pos; }
+    bool seek(uint32_t to) {
+        if(!files || to > data().size()) return false;
+        pos = to;
+        return true;
+    }
+    size_t read(uint8_t* buf, size_t len) {
+        if(!files) return 0;
+        const std::vector<uint8_t>& d = data();
+        size_t n = pos + len > d.size() ? d.size() - pos : len;
+        memcpy(buf, d.data() + pos, n);
+        pos += n;
+        return n;
+    }
+    int read() {
+        uint8_t b;
+        return read(&b, 1) == 1 ? b : -1;
+    }
+    size_t readBytes(char* buf, size_t len) { return read((uint8_t*) buf, len); }
+    size_t write(const uint8_t* buf, size_t len) {
+        if(!files || !writable) return 0;
+        std::vector<uint8_t>& d = (*files)[path];
+        if(pos + len > d.size()) d.resize(pos + len);
+        memcpy(d.data() + pos, buf, len);
+        pos += len;
+        return len;
+    }
+    size_t write(uint8_t b) { return write(&b, 1); }
+    void close() { files = NULL; }
+
+private:
+    NativeFiles* files = NULL;
+    std::string path;
+    bool writable = false;
+    size_t pos = 0;
+
+    const std::vector<uint8_t>& data() const { return (*files)[path]; }
+};
+
+class NativeLittleFS {
+public:
+    NativeFiles files;
+
+    bool begin(bool /* formatOnFail */ = false) { return true; }
+    bool format() { files.clear(); return true; }
+    bool exists(const char* path) { return files.count(path) > 0; }
+    bool remove(const char* path) { return files.erase(path) > 0; }
+    bool rename(const char* from, const char* to) {
+        if(!exists(from)) return false;
+        files[to] = files[from];
+        files.erase(from);
+        return true;
+    }
+    File open(const char* path, const char* mode) {
+        if(mode[0] == 'r') {
+            if(!exists(path)) return File();
+            return File(&files, path, false, 0);
+        }
+        if(mode[0] == 'w') files[path].clear();
+        return File(&files, path, true, files[path].size());
+    }
+};
+
+inline NativeLittleFS LittleFS;
+
+#endif
@@ -0,0 +1,10 @@
+/**
+ * @copyright Utilitech AS 2023-2026
+ * License: Fair Source
+ *
+ * Native shim for <Stream.h>; Stream comes from DebugPrint.h via Arduino.h.
+ */
+#ifndef _NATIVE_STREAM_H
+#define _NATIVE_STREAM_H
+#include "Arduino.h"
+#endif
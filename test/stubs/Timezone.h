@@ -29,6 +29,18 @@ static inline time_t makeTime(const tmElements_t& te) {
     return timegm(&t);
 }
 
+static inline void breakTime(time_t timeInput, tmElements_t& tm) {
+    struct tm t;
+    gmtime_r(&timeInput, &t);
+    tm.Second = t.tm_sec;
+    tm.Minute = t.tm_min;
+    tm.Hour = t.tm_hour;
+    tm.Wday = t.tm_wday + 1;
+    tm.Day = t.tm_mday;
+    tm.Month = t.tm_mon + 1;
+    tm.Year = t.tm_year + 1900 - 1970;
+}
+
 class Timezone {
 public:
     time_t toUTC(time_t t) { return t; }
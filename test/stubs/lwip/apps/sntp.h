@@ -0,0 +1,3 @@
+/* Empty lwip/apps/sntp.h stub for native builds.
+ * AmsDataStorage includes it on device; nothing from it is used natively. */
+#pragma once
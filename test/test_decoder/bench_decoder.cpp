@@ -0,0 +1,219 @@
+/**
+ * @copyright Utilitech AS 2023-2026
+ * License: Fair Source
+ *
+ * Decoder benchmark — not a Unity test. Run the native test binary with
+ * `bench [file]` to replay every payload in test/payloads and every capture in
+ * frames/ through the harness and write the numbers as JSON (default
+ * bench.json). Per fixture: ns/frame, bytes/s, operator-new allocations per
+ * frame and peak stack; per layer (HDLC, M-Bus, ..., IEC6205675/IEC6205621):
+ * calls, ns/call and peak stack. Numbers only compare on the same host and
+ * build flags, so diff two files from the same machine.
+ */
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <dirent.h>
+#include <pthread.h>
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <vector>
+#include "AmsData.h"
+#include "decoder_harness.h"
+#include "fixtures_generated.h"
+
+#define COUNT(a) (sizeof(a) / sizeof((a)[0]))
+
+#define BENCH_STACK_SIZE (256 * 1024)
+#define BENCH_MIN_ITERATIONS 5
+#define BENCH_MAX_ITERATIONS 2000
+#define BENCH_MIN_NS 20000000ULL   // keep timing a fixture for at least 20 ms
+
+enum BenchMode { BENCH_DECODE, BENCH_DECODE_KEYED, BENCH_PROBE };
+
+struct BenchFixture {
+    std::string path;
+    BenchMode mode;
+    uint8_t ek[16], ak[16];
+    bool haveAk;
+};
+
+struct BenchResult {
+    int bytes;
+    bool decoded;
+    uint32_t iterations;
+    double nsPerFrame;
+    double allocsPerFrame;
+    uint32_t peakStack;
+};
+
+static uint8_t* s_stackLo = NULL;
+
+static uint64_t now_ns() {
+    using namespace std::chrono;
+    return (uint64_t)duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+// One decode of a working copy; parsers rewrite the buffer in place
+static bool run_once(const BenchFixture& f, const uint8_t* src, int n, uint8_t* work) {
+    memcpy(work, src, n);
+    if (f.mode == BENCH_PROBE) {
+        HarnessProbe probe;
+        harness_probe(work, (uint16_t)n, &probe);
+        return probe.reached_gcm;
+    }
+    // Reused slot, as in the firmware loop
+    static AmsData slot;
+    MeterConfig cfg;
+    memset(&cfg, 0, sizeof(cfg));
+    bool ok = f.mode == BENCH_DECODE_KEYED
+        ? harness_decode_into(work, (uint16_t)n, &cfg, f.ek, f.haveAk ? f.ak : NULL, slot)
+        : harness_decode_into(work, (uint16_t)n, &cfg, NULL, NULL, slot);
+    return ok && slot.getListType() >= 1;
+}
+
+static BenchResult bench_fixture(const BenchFixture& f, HarnessLayerStats* layers) {
+    static uint8_t src[4096], work[4096];
+    BenchResult r;
+    memset(&r, 0, sizeof(r));
+    r.bytes = harness_load_fixture(f.path.c_str(), src, sizeof(src));
+    if (r.bytes <= 0) return r;
+
+    // Timing pass: layer times accumulate, no stack painting in the way
+    r.decoded = run_once(f, src, r.bytes, work);
+    harness_set_layer_stats(layers, NULL);
+    uint64_t allocs = harness_alloc_count();
+    uint64_t start = now_ns(), elapsed = 0;
+    while (r.iterations < BENCH_MAX_ITERATIONS && (r.iterations < BENCH_MIN_ITERATIONS || elapsed < BENCH_MIN_NS)) {
+        run_once(f, src, r.bytes, work);
+        r.iterations++;
+        elapsed = now_ns() - start;
+    }
+    r.nsPerFrame = (double) elapsed / r.iterations;
+    r.allocsPerFrame = (double) (harness_alloc_count() - allocs) / r.iterations;
+
+    // Stack pass: one more decode on the painted stack, into a scratch block so
+    // the layer times are not skewed by the painting
+    HarnessLayerStats scratch[HARNESS_LAYERS];
+    memset(scratch, 0, sizeof(scratch));
+    harness_set_layer_stats(scratch, s_stackLo);
+    run_once(f, src, r.bytes, work);
+    harness_set_layer_stats(NULL, NULL);
+    r.peakStack = scratch[HARNESS_PIPELINE].peakStack;
+    for (int i = 0; i < HARNESS_LAYERS; i++) {
+        if (scratch[i].peakStack > layers[i].peakStack) layers[i].peakStack = scratch[i].peakStack;
+    }
+    return r;
+}
+
+static void collect(std::vector<BenchFixture>& out) {
+    for (size_t i = 0; i < COUNT(UNENC_OK); i++) out.push_back({ UNENC_OK[i].path, BENCH_DECODE, {}, {}, false });
+    for (size_t i = 0; i < COUNT(UNENC_EDGE); i++) out.push_back({ UNENC_EDGE[i].path, BENCH_DECODE, {}, {}, false });
+    for (size_t i = 0; i < COUNT(ENC_KEYED); i++) {
+        BenchFixture f = { ENC_KEYED[i].path, BENCH_PROBE, {}, {}, false };
+#if defined(HAVE_MBEDTLS)
+        if (harness_load_key(ENC_KEYED[i].ek_secret, f.ek)) {
+            f.mode = BENCH_DECODE_KEYED;
+            f.haveAk = ENC_KEYED[i].ak_secret && harness_load_key(ENC_KEYED[i].ak_secret, f.ak);
+        }
+#endif
+        out.push_back(f);
+    }
+    for (size_t i = 0; i < COUNT(ENC_NOKEY); i++) out.push_back({ ENC_NOKEY[i].path, BENCH_PROBE, {}, {}, false });
+
+    DIR* dir = opendir("frames");
+    if (!dir) return;
+    std::vector<std::string> raw;
+    struct dirent* e;
+    while ((e = readdir(dir)) != NULL) {
+        size_t len = strlen(e->d_name);
+        if (len > 4 && strcmp(e->d_name + len - 4, ".raw") == 0) raw.push_back(std::string("frames/") + e->d_name);
+    }
+    closedir(dir);
+    std::sort(raw.begin(), raw.end());
+    for (const std::string& p : raw) out.push_back({ p, BENCH_DECODE, {}, {}, false });
+}
+
+static const char* mode_name(BenchMode m) {
+    return m == BENCH_PROBE ? "probe" : m == BENCH_DECODE_KEYED ? "decrypt" : "decode";
+}
+
+struct BenchRun {
+    const char* outPath;
+    int ret;
+};
+
+static void* bench_thread(void* arg) {
+    BenchRun* run = (BenchRun*) arg;
+    std::vector<BenchFixture> fixtures;
+    collect(fixtures);
+
+    HarnessLayerStats layers[HARNESS_LAYERS];
+    memset(layers, 0, sizeof(layers));
+    std::vector<BenchResult> results;
+    harness_mute_stdout(true);
+    for (const BenchFixture& f : fixtures) results.push_back(bench_fixture(f, layers));
+    harness_mute_stdout(false);
+
+    FILE* out = fopen(run->outPath, "w");
+    if (!out) {
+        fprintf(stderr, "bench: cannot write %s\n", run->outPath);
+        run->ret = 1;
+        return NULL;
+    }
+
+    // One record per line, so two runs diff line by line
+    fprintf(out, "{\n\"fixtures\": [\n");
+    double totalNs = 0, totalBytes = 0;
+    for (size_t i = 0; i < fixtures.size(); i++) {
+        const BenchResult& r = results[i];
+        double bps = r.nsPerFrame > 0 ? r.bytes * 1e9 / r.nsPerFrame : 0;
+        fprintf(out, "{\"path\": \"%s\", \"mode\": \"%s\", \"bytes\": %d, \"decoded\": %s, \"iterations\": %u, "
+                     "\"ns_per_frame\": %.0f, \"bytes_per_s\": %.0f, \"allocs_per_frame\": %.2f, \"peak_stack\": %u}%s\n",
+            fixtures[i].path.c_str(), mode_name(fixtures[i].mode), r.bytes, r.decoded ? "true" : "false", r.iterations,
+            r.nsPerFrame, bps, r.allocsPerFrame, r.peakStack, i + 1 < fixtures.size() ? "," : "");
+        if (r.bytes > 0) {
+            totalNs += r.nsPerFrame;
+            totalBytes += r.bytes;
+        }
+        printf("  %-62s %8.0f ns/frame %6.2f MB/s %5.1f allocs %6u B stack\n",
+            fixtures[i].path.c_str(), r.nsPerFrame, bps / 1e6, r.allocsPerFrame, r.peakStack);
+    }
+    fprintf(out, "],\n\"layers\": [\n");
+    for (int i = 0; i < HARNESS_LAYERS; i++) {
+        const HarnessLayerStats& l = layers[i];
+        double nsPerCall = l.calls ? (double) l.ns / l.calls : 0;
+        fprintf(out, "{\"layer\": \"%s\", \"calls\": %u, \"ns_per_call\": %.0f, \"peak_stack\": %u}%s\n",
+            harness_layer_name(i), l.calls, nsPerCall, l.peakStack, i + 1 < HARNESS_LAYERS ? "," : "");
+        printf("  layer %-12s %8u calls %8.0f ns/call %6u B stack\n", harness_layer_name(i), l.calls, nsPerCall, l.peakStack);
+    }
+    fprintf(out, "],\n\"total\": {\"fixtures\": %zu, \"ns\": %.0f, \"bytes_per_s\": %.0f}\n}\n",
+        fixtures.size(), totalNs, totalNs > 0 ? totalBytes * 1e9 / totalNs : 0);
+    fclose(out);
+    printf("bench: %zu fixtures, results written to %s\n", fixtures.size(), run->outPath);
+    run->ret = 0;
+    return NULL;
+}
+
+// Runs the suite on a thread whose stack we own, so it can be painted to
+// measure how deep each layer goes.
+int decoder_bench(const char* outPath) {
+    BenchRun run = { outPath, 1 };
+    void* stack = NULL;
+    if (posix_memalign(&stack, 4096, BENCH_STACK_SIZE) != 0) return 1;
+    s_stackLo = (uint8_t*) stack;
+
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    pthread_attr_setstack(&attr, stack, BENCH_STACK_SIZE);
+    pthread_t t;
+    if (pthread_create(&t, &attr, bench_thread, &run) == 0) {
+        pthread_join(t, NULL);
+    } else {
+        fprintf(stderr, "bench: cannot start thread\n");
+    }
+    pthread_attr_destroy(&attr);
+    free(stack);
+    return run.ret;
+}
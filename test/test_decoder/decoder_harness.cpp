@@ -15,6 +15,8 @@
 #include "DlmsParser.h"
 #include "DsmrParser.h"
 #include "GcmParser.h"
+#include "FrameAssembler.h"
+#include "FrameReader.h"
 #include "Cosem.h"
 #include "Timezone.h"
 #include "AmsData.h"
@@ -22,8 +24,11 @@
 #include "IEC6205621.h"
 #include "LNG.h"
 #include "LNG2.h"
+#include "MeterDecoders.h"
 #include "Uptime.h"
+#include "FirmwareVersion.h"
 #include <chrono>
+#include <new>
 
 // millis64() lives in Uptime.cpp (Arduino-only). Provide a native definition
 // so the decoder links; tests don't assert on it.
@@ -32,6 +37,22 @@ uint64_t millis64() {
     return (uint64_t)duration_cast<milliseconds>(steady_clock::now().time_since_epoch()).count();
 }
 
+// millis() stands still until a test moves it
+static unsigned long s_millis = 0;
+
+unsigned long millis() {
+    return s_millis;
+}
+
+void harness_set_millis(unsigned long ms) {
+    s_millis = ms;
+}
+
+// FirmwareVersion.cpp needs the version header the device build generates.
+// Any time after the epoch counts as after the build here.
+long FirmwareVersion::BuildEpoch = 0;
+const char* FirmwareVersion::VersionString = "native";
+
 int harness_load_fixture(const char* path, uint8_t* out, int cap) {
     FILE* f = fopen(path, "rb");
     if (!f) return -1;
@@ -45,9 +66,16 @@ int harness_load_fixture(const char* path, uint8_t* out, int cap) {
         int c;
         while ((c = fgetc(f)) != EOF && n < cap) out[n++] = (uint8_t)c;
     } else {
-        // hex dump — collect hex nibbles, ignore everything else
-        int hi = -1, c;
+        // hex dump — collect hex nibbles, ignore everything else, including
+        // the // annotations in the hand-commented captures under frames/
+        int hi = -1, c, prev = 0;
         while ((c = fgetc(f)) != EOF && n < cap) {
+            if (c == '/' && prev == '/') {
+                while ((c = fgetc(f)) != EOF && c != '\n');
+                prev = 0;
+                continue;
+            }
+            prev = c;
             int v;
             if (c >= '0' && c <= '9') v = c - '0';
             else if (c >= 'a' && c <= 'f') v = c - 'a' + 10;
@@ -64,7 +92,9 @@ int harness_load_fixture(const char* path, uint8_t* out, int cap) {
 // fd-level stdout suppression around the (chatty) decode
 #ifndef DECODER_HARNESS_VERBOSE
 static int s_saved = -1;
+static int s_muted = 0;
 static void mute_stdout() {
+    if (s_muted++ > 0) return;
     fflush(stdout);
     s_saved = dup(STDOUT_FILENO);
     int dn = open("/dev/null", O_WRONLY);
@@ -72,6 +102,7 @@ static void mute_stdout() {
     close(dn);
 }
 static void unmute_stdout() {
+    if (s_muted == 0 || --s_muted > 0) return;
     fflush(stdout);
     if (s_saved >= 0) { dup2(s_saved, STDOUT_FILENO); close(s_saved); s_saved = -1; }
 }
@@ -80,25 +111,168 @@ static void mute_stdout() {}
 static void unmute_stdout() {}
 #endif
 
+void harness_mute_stdout(bool mute) {
+    if (mute) mute_stdout();
+    else unmute_stdout();
+}
+
+// ----- benchmark instrumentation -----
+// Counts every operator new in the process; malloc() (used by the segment
+// reassembly buffers) is not seen. Every form of new and delete is replaced,
+// sized and nothrow included, and all of them go through harness_malloc()
+// and harness_free(). The attribute tells the compiler those two are a pair,
+// so it does not take free() on memory from operator new for a mismatch.
+static uint64_t s_allocs = 0;
+
+static void harness_free(void* p) {
+    free(p);
+}
+
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 11
+__attribute__((malloc, malloc(harness_free, 1)))
+#endif
+static void* harness_malloc(size_t n) {
+    s_allocs++;
+    return malloc(n ? n : 1);
+}
+
+void* operator new(size_t n) {
+    void* p = harness_malloc(n);
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+void* operator new[](size_t n) { return operator new(n); }
+void* operator new(size_t n, const std::nothrow_t&) noexcept { return harness_malloc(n); }
+void* operator new[](size_t n, const std::nothrow_t&) noexcept { return harness_malloc(n); }
+void operator delete(void* p) noexcept { harness_free(p); }
+void operator delete[](void* p) noexcept { harness_free(p); }
+void operator delete(void* p, size_t) noexcept { harness_free(p); }
+void operator delete[](void* p, size_t) noexcept { harness_free(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { harness_free(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { harness_free(p); }
+
+uint64_t harness_alloc_count() {
+    return s_allocs;
+}
+
+static const char* LAYER_NAMES[HARNESS_LAYERS] = {
+    "hdlc", "mbus", "llc", "gbt", "gcm", "dlms", "dsmr",
+    "iec6205675", "iec6205621", "lng", "lng2", "pipeline"
+};
+
+const char* harness_layer_name(uint8_t layer) {
+    return layer < HARNESS_LAYERS ? LAYER_NAMES[layer] : "?";
+}
+
+static HarnessLayerStats* s_layers = NULL;
+static uint8_t* s_stackLo = NULL;
+static uint8_t* s_lowest = NULL;   // deepest byte written since the innermost open probe painted
+
+void harness_set_layer_stats(HarnessLayerStats* stats, uint8_t* stackLo) {
+    s_layers = stats;
+    s_stackLo = stats ? stackLo : NULL;
+    s_lowest = NULL;
+}
+
+#define HARNESS_STACK_PAINT 0xA5
+
+// Fills the stack from stackLo up to just below this function's own frame, so
+// whatever the next call writes shows up as a hole in the pattern.
+__attribute__((noinline, no_sanitize_address))
+static void paint_stack() {
+    volatile uint8_t* top = (uint8_t*) __builtin_frame_address(0) - 128;
+    for (volatile uint8_t* p = s_stackLo; p < top; p++) *p = HARNESS_STACK_PAINT;
+}
+
+__attribute__((noinline, no_sanitize_address))
+static uint8_t* lowest_touched(uint8_t* top) {
+    volatile uint8_t* p = s_stackLo;
+    while (p < top && *p == HARNESS_STACK_PAINT) p++;
+    return (uint8_t*) p;
+}
+
+static uint64_t now_ns() {
+    using namespace std::chrono;
+    return (uint64_t)duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+// Scope guard around one layer: time and stack use from construction to
+// destruction. Probes nest (the pipeline probe encloses the parser probes), and
+// an inner probe repaints the stack, so whatever the enclosing probe had seen so
+// far is folded into s_lowest first and handed back out when the inner one ends.
+class LayerProbe {
+public:
+    explicit LayerProbe(uint8_t layer) : layer(layer) {
+        if (!s_layers) return;
+        if (s_stackLo) {
+            ref = (uint8_t*) __builtin_frame_address(0);
+            if (s_lowest) {
+                uint8_t* low = lowest_touched(ref);
+                if (low < s_lowest) s_lowest = low;
+            }
+            saved = s_lowest;
+            s_lowest = ref;
+            paint_stack();
+        }
+        start = now_ns();
+    }
+    // Attribute the time to another layer, once it is known which one ran
+    void setLayer(uint8_t layer) { this->layer = layer; }
+    ~LayerProbe() {
+        if (!s_layers) return;
+        HarnessLayerStats& st = s_layers[layer];
+        st.ns += now_ns() - start;
+        st.calls++;
+        if (ref) {
+            uint8_t* low = lowest_touched(ref);
+            if (low < s_lowest) s_lowest = low;
+            uint32_t used = (uint32_t)(ref - s_lowest);
+            if (used > st.peakStack) st.peakStack = used;
+            if (saved && saved < s_lowest) s_lowest = saved;
+            if (!saved) s_lowest = NULL;
+        }
+    }
+private:
+    uint8_t layer;
+    uint8_t* ref = NULL;
+    uint8_t* saved = NULL;
+    uint64_t start = 0;
+};
+
 // Mirror of PassiveMeterCommunicator::unwrapData (sans debug/MQTT). Returns the
 // offset to the payload start (>=0) with ctx.type/length set, or <0 on failure.
+// Like PassiveMeterCommunicator, keep one GCMParser (and its key schedule)
+// for as long as the keys stay the same
+static GCMParser* cached_gcm(const uint8_t* enc_key, const uint8_t* auth_key) {
+    static GCMParser* gcm = NULL;
+    static uint8_t cachedEk[16], cachedAk[16];
+    uint8_t ek[16], ak[16];
+    memcpy(ek, enc_key, 16);
+    memset(ak, 0, 16);
+    if (auth_key) memcpy(ak, auth_key, 16);
+    if (gcm == NULL || memcmp(ek, cachedEk, 16) != 0 || memcmp(ak, cachedAk, 16) != 0) {
+        delete gcm;
+        gcm = new GCMParser(ek, ak);
+        memcpy(cachedEk, ek, 16);
+        memcpy(cachedAk, ak, 16);
+    }
+    return gcm;
+}
+
 static int16_t unwrap(uint8_t* buf, DataParserContext& ctx, MeterConfig* cfg,
                       const uint8_t* enc_key, const uint8_t* auth_key,
-                      bool* reachedGcm = NULL, bool stopAfterGcm = false) {
-    HDLCParser hdlc;
-    MBUSParser mbus;
-    GBTParser gbt;
+                      bool* reachedGcm = NULL, bool stopAfterGcm = false,
+                      uint8_t** payloadBuffer = NULL) {
+    // One arena for all segmented layers, as PassiveMeterCommunicator owns one
+    static ReassemblyArena arena;
+    HDLCParser hdlc(&arena);
+    MBUSParser mbus(&arena);
+    GBTParser gbt(&arena);
+    if (payloadBuffer) *payloadBuffer = buf;
     LLCParser llc;
     DLMSParser dlms;
-    GCMParser* gcm = NULL;
+    GCMParser* gcm = enc_key ? cached_gcm(enc_key, auth_key) : NULL;
     DSMRParser* dsmr = NULL;
-    if (enc_key) {
-        uint8_t ek[16], ak[16];
-        memcpy(ek, enc_key, 16);
-        memset(ak, 0, 16);
-        if (auth_key) memcpy(ak, auth_key, 16);
-        gcm = new GCMParser(ek, ak);
-    }
 
     static NullStream dbg;
     int16_t ret = 0;
@@ -115,23 +289,28 @@ static int16_t unwrap(uint8_t* buf, DataParserContext& ctx, MeterConfig* cfg,
             case DATA_TAG_HDLC:
                 hdlcStart = buf;
                 hdlcLen = (int16_t)((((buf[1] << 8) | buf[2]) & 0x7FF) + 2);
-                res = hdlc.parse(buf, ctx); if (ctx.length < 3) doRet = true; break;
-            case DATA_TAG_MBUS: res = mbus.parse(buf, ctx); break;
-            case DATA_TAG_GBT:  res = gbt.parse(buf, ctx); break;
-            case DATA_TAG_LLC:  res = llc.parse(buf, ctx); break;
+                { LayerProbe p(HARNESS_HDLC); res = hdlc.parse(buf, ctx); }
+                if (ctx.length < 3) doRet = true;
+                break;
+            case DATA_TAG_MBUS: { LayerProbe p(HARNESS_MBUS); res = mbus.parse(buf, ctx); } break;
+            case DATA_TAG_GBT:  { LayerProbe p(HARNESS_GBT); res = gbt.parse(buf, ctx); } break;
+            case DATA_TAG_LLC:  { LayerProbe p(HARNESS_LLC); res = llc.parse(buf, ctx); } break;
             case DATA_TAG_GCM:
                 if (reachedGcm) *reachedGcm = true;
                 if (!gcm) { delete dsmr; return DATA_PARSE_UNKNOWN_DATA; }
-                res = gcm->parse(buf, ctx);
+                { LayerProbe p(HARNESS_GCM); res = gcm->parse(buf, ctx); }
                 // Probe mode: the GCM header (incl. system title) is now parsed;
                 // stop before decoding the plaintext (which, with a dummy key, is
                 // garbage and not worth parsing).
-                if (stopAfterGcm) { delete gcm; delete dsmr; return res; }
+                if (stopAfterGcm) { delete dsmr; return res; }
+                break;
+            case DATA_TAG_DLMS:
+                { LayerProbe p(HARNESS_DLMS); res = dlms.parse(buf, ctx); }
+                if (res >= 0) doRet = true;
                 break;
-            case DATA_TAG_DLMS: res = dlms.parse(buf, ctx); if (res >= 0) doRet = true; break;
             case DATA_TAG_DSMR:
                 if (!dsmr) dsmr = new DSMRParser(gcm);
-                res = dsmr->parse(buf, ctx, lastTag != DATA_TAG_NONE, &dbg);
+                { LayerProbe p(HARNESS_DSMR); res = dsmr->parse(buf, ctx, lastTag != DATA_TAG_NONE, &dbg); }
                 if (res >= 0) doRet = true;
                 break;
             case DATA_TAG_SNRM:
@@ -139,11 +318,11 @@ static int16_t unwrap(uint8_t* buf, DataParserContext& ctx, MeterConfig* cfg,
             case DATA_TAG_RES:
                 res = DATA_PARSE_OK; doRet = true; break;
             default:
-                delete gcm; delete dsmr;
+                delete dsmr;
                 return DATA_PARSE_UNKNOWN_DATA;
         }
         lastTag = tag;
-        if (res == DATA_PARSE_INCOMPLETE) { delete gcm; delete dsmr; return res; }
+        if (res == DATA_PARSE_INCOMPLETE) { delete dsmr; return res; }
 
         // Multi-segment M-Bus: the parser accumulates each frame internally.
         // In the firmware each frame arrives in its own read; here the whole
@@ -155,44 +334,42 @@ static int16_t unwrap(uint8_t* buf, DataParserContext& ctx, MeterConfig* cfg,
             tag = *buf;
             continue;
         }
-        if (tag == DATA_TAG_MBUS && res == DATA_PARSE_FINAL_SEGMENT) {
-            mbus.write(buf, ctx);     // assembles into buf, sets ctx.length
-            end = (int16_t)ctx.length;
-            tag = *buf;               // continue parsing the assembled payload
-            continue;
-        }
 
         // Multi-frame GBT (General Block Transfer): each block sits inside its
         // own HDLC frame and the parser accumulates them. Jump to the next HDLC
-        // frame (firmware gets each in a separate read); the final block returns
-        // OK with the reassembled DLMS in place.
+        // frame (firmware gets each in a separate read).
         if (tag == DATA_TAG_GBT && res == DATA_PARSE_INTERMEDIATE_SEGMENT) {
-            if (!hdlcStart) { delete gcm; delete dsmr; return DATA_PARSE_FAIL; }
+            if (!hdlcStart) { delete dsmr; return DATA_PARSE_FAIL; }
             int16_t delta = (int16_t)((hdlcStart + hdlcLen) - buf);
-            if (delta <= 0 || delta >= end) { delete gcm; delete dsmr; return DATA_PARSE_INCOMPLETE; }
+            if (delta <= 0 || delta >= end) { delete dsmr; return DATA_PARSE_INCOMPLETE; }
             buf += delta; end -= delta; ret += delta;
             ctx.length = (uint16_t)end;   // next frame's per-read budget (mirrors a fresh serial read)
             tag = *buf;
             continue;
         }
-        if (tag == DATA_TAG_GBT && res == DATA_PARSE_OK) {
-            end = (int16_t)ctx.length;   // reassembled DLMS now at buf
+        // Last segment of any of them: carry on with the reassembled APDU
+        // where it is, in the arena
+        if (res == DATA_PARSE_FINAL_SEGMENT) {
+            buf = arena.getData();
+            end = (int16_t)arena.getSize();
+            ret = 0;
+            if (payloadBuffer) *payloadBuffer = buf;
             tag = *buf;
             continue;
         }
 
-        if ((int16_t)ctx.length > end) { delete gcm; delete dsmr; return DATA_PARSE_FAIL; }
-        if (res < 0) { delete gcm; delete dsmr; return res; }
+        if ((int16_t)ctx.length > end) { delete dsmr; return DATA_PARSE_FAIL; }
+        if (res < 0) { delete dsmr; return res; }
         buf += res; end -= res; ret += res;
-        if (doRet) { ctx.type = tag; delete gcm; delete dsmr; return ret; }
+        if (doRet) { ctx.type = tag; delete dsmr; return ret; }
         tag = *buf;
     }
-    delete gcm; delete dsmr;
+    delete dsmr;
     return DATA_PARSE_UNKNOWN_DATA;
 }
 
-AmsData* harness_decode(uint8_t* buf, uint16_t len, MeterConfig* cfg,
-                        const uint8_t* enc_key, const uint8_t* auth_key) {
+bool harness_decode_into(uint8_t* buf, uint16_t len, MeterConfig* cfg,
+                         const uint8_t* enc_key, const uint8_t* auth_key, AmsData& data) {
     DataParserContext ctx;
     ctx.type = *buf;
     ctx.length = len;
@@ -200,33 +377,49 @@ AmsData* harness_decode(uint8_t* buf, uint16_t len, MeterConfig* cfg,
     memset(ctx.system_title, 0, sizeof(ctx.system_title));
 
     mute_stdout();
-    int16_t pos = unwrap(buf, ctx, cfg, enc_key, auth_key);
-    if (pos < 0) { unmute_stdout(); return NULL; }
+    LayerProbe pipeline(HARNESS_PIPELINE);
+    uint8_t* base = buf;
+    int16_t pos = unwrap(buf, ctx, cfg, enc_key, auth_key, NULL, false, &base);
+    if (pos < 0) { unmute_stdout(); return false; }
 
-    char* payload = ((char*)buf) + pos;
+    // Same dispatch as PassiveMeterCommunicator::getData
+    char* payload = ((char*)base) + pos;
     static Timezone tz;
     static NullStream dbg;
     AmsData state;
-    AmsData* data = NULL;
+    bool decoded = false;
 
     if (ctx.type == DATA_TAG_DLMS) {
-        if (payload[0] == CosemTypeStructure && payload[2] == CosemTypeArray &&
-            payload[1] == payload[3]) {
-            LNG lng(state, payload, state.getMeterType(), cfg, ctx);
-            if (lng.getListType() >= 1) { data = new AmsData(); data->apply(state); data->apply(lng); }
-        } else if (payload[0] == CosemTypeStructure &&
-                   payload[2] == CosemTypeLongUnsigned && payload[5] == CosemTypeLongUnsigned &&
-                   payload[8] == CosemTypeLongUnsigned && payload[11] == CosemTypeLongUnsigned &&
-                   payload[14] == CosemTypeLongUnsigned && payload[17] == CosemTypeLongUnsigned) {
-            LNG2 lng(state, payload, state.getMeterType(), cfg, ctx);
-            if (lng.getListType() >= 1) { data = new AmsData(); data->apply(state); data->apply(lng); }
-        } else {
-            data = new IEC6205675(payload, &tz, state.getMeterType(), cfg, ctx, state, &dbg);
+        // One registry across decodes, as one communicator sees one meter
+        static DecoderRegistry decoders;
+        static bool registered = false;
+        if (!registered) {
+            addMeterDecoders(decoders);
+            registered = true;
         }
+        LayerProbe p(HARNESS_IEC6205675);
+        DecoderInput in = { payload, &tz, cfg, &ctx, &state, &dbg };
+        decoded = decoders.decode(in, data);
+        const DecoderEntry* used = decoders.getLast();
+        if (used && used->id == MeterDecoderLng) p.setLayer(HARNESS_LNG);
+        if (used && used->id == MeterDecoderLng2) p.setLayer(HARNESS_LNG2);
     } else if (ctx.type == DATA_TAG_DSMR) {
-        data = new IEC6205621(payload, &tz, cfg);
+        LayerProbe p(HARNESS_IEC6205621);
+        IEC6205621 parsed(payload, &tz, cfg);
+        data = parsed;
+        decoded = true;
     }
     unmute_stdout();
+    return decoded;
+}
+
+AmsData* harness_decode(uint8_t* buf, uint16_t len, MeterConfig* cfg,
+                        const uint8_t* enc_key, const uint8_t* auth_key) {
+    AmsData* data = new AmsData();
+    if (!harness_decode_into(buf, len, cfg, enc_key, auth_key, *data)) {
+        delete data;
+        return NULL;
+    }
     return data;
 }
 
@@ -240,28 +433,155 @@ AmsData* harness_decode_fixture(const char* path) {
 }
 
 void harness_probe_fixture(const char* path, HarnessProbe* out) {
+    static uint8_t buf[4096];
+    int n = harness_load_fixture(path, buf, sizeof(buf));
+    if (n <= 0) {
+        out->reached_gcm = false;
+        memset(out->system_title, 0, sizeof(out->system_title));
+        out->unwrap_result = DATA_PARSE_FAIL;
+        return;
+    }
+    harness_probe(buf, (uint16_t)n, out);
+}
+
+void harness_probe(uint8_t* buf, uint16_t n, HarnessProbe* out) {
     out->reached_gcm = false;
     memset(out->system_title, 0, sizeof(out->system_title));
     out->unwrap_result = DATA_PARSE_FAIL;
 
-    static uint8_t buf[4096];
-    int n = harness_load_fixture(path, buf, sizeof(buf));
-    if (n <= 0) return;
-
     // Dummy key: the GCM header (incl. system title) is parsed before any
     // decryption, so framing/header coverage works without the real key.
     uint8_t zero[16];
     memset(zero, 0, sizeof(zero));
     DataParserContext ctx;
     ctx.type = buf[0];
-    ctx.length = (uint16_t)n;
+    ctx.length = n;
     ctx.timestamp = 0;
     memset(ctx.system_title, 0, sizeof(ctx.system_title));
 
     bool reached = false;
     mute_stdout();
-    out->unwrap_result = unwrap(buf, ctx, NULL, zero, zero, &reached, /*stopAfterGcm=*/true);
+    {
+        LayerProbe pipeline(HARNESS_PIPELINE);
+        out->unwrap_result = unwrap(buf, ctx, NULL, zero, zero, &reached, /*stopAfterGcm=*/true);
+    }
     unmute_stdout();
     out->reached_gcm = reached;
     memcpy(out->system_title, ctx.system_title, sizeof(out->system_title));
 }
+
+void harness_stream_fixture(const char* path, bool assembled, HarnessStream* out) {
+    memset(out, 0, sizeof(*out));
+
+    static uint8_t buf[4096];
+    int n = harness_load_fixture(path, buf, sizeof(buf));
+    if (n <= 0) return;
+
+    // Stands in for hanBuffer: bytes are appended one by one and unwrapped in place
+    static uint8_t han[4096];
+    memset(han, 0, sizeof(han));
+    uint16_t len = 0;
+    FrameAssembler assembler;
+
+    mute_stdout();
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < n; i++) {
+        han[len++] = buf[i];
+        if (assembled && !assembler.append(han, len)) continue;
+
+        DataParserContext ctx;
+        ctx.type = 0;
+        ctx.length = len;
+        ctx.timestamp = 0;
+        memset(ctx.system_title, 0, sizeof(ctx.system_title));
+        int16_t res = unwrap(han, ctx, NULL, NULL, NULL);
+        out->unwraps++;
+        if (res == DATA_PARSE_INCOMPLETE) continue;
+
+        if (out->frames < HARNESS_STREAM_MAX_FRAMES) {
+            out->results[out->frames] = res;
+            out->types[out->frames] = ctx.type;
+            out->ends[out->frames] = (uint16_t)i;
+        }
+        out->frames++;
+        len = 0;
+    }
+    out->ns = (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - start).count();
+    unmute_stdout();
+    out->bytes = n;
+}
+
+void harness_stream_chunked(const char* path, uint16_t chunk, HarnessStream* out) {
+    memset(out, 0, sizeof(*out));
+
+    static uint8_t buf[4096];
+    int n = harness_load_fixture(path, buf, sizeof(buf));
+    if (n <= 0) return;
+
+    static uint8_t han[4096];
+    memset(han, 0, sizeof(han));
+    MemoryByteSource source(buf, (uint16_t)n, chunk);
+    FrameReader reader;
+    reader.begin(han, sizeof(han));
+
+    mute_stdout();
+    auto start = std::chrono::steady_clock::now();
+    while (reader.read(source) > 0) {
+        if (!reader.isComplete()) continue;
+
+        DataParserContext ctx;
+        ctx.type = 0;
+        ctx.length = reader.getLength();
+        ctx.timestamp = 0;
+        memset(ctx.system_title, 0, sizeof(ctx.system_title));
+        int16_t res = unwrap(han, ctx, NULL, NULL, NULL);
+        out->unwraps++;
+        if (res == DATA_PARSE_INCOMPLETE) continue;
+
+        if (out->frames < HARNESS_STREAM_MAX_FRAMES) {
+            out->results[out->frames] = res;
+            out->types[out->frames] = ctx.type;
+            out->ends[out->frames] = (uint16_t)(source.getPosition() - reader.getCarry() - 1);
+        }
+        out->frames++;
+        reader.next();
+    }
+    out->ns = (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - start).count();
+    unmute_stdout();
+    out->bytes = n;
+}
+
+static int hex16(const char* hex, uint8_t out[16]) {
+    int n = 0;
+    for (int i = 0; i < 16; i++) {
+        unsigned v;
+        if (sscanf(hex + i * 2, "%2x", &v) != 1) return 0;
+        out[i] = (uint8_t)v;
+        n++;
+    }
+    return n == 16;
+}
+
+bool harness_load_key(const char* secret, uint8_t out[16]) {
+    if (!secret) return false;
+    const char* env = getenv(secret);
+    if (env && strlen(env) >= 32) return hex16(env, out);
+
+    FILE* f = fopen("test/payloads/keys/keys.local.json", "rb");
+    if (!f) return false;
+    static char buf[8192];
+    size_t n = fread(buf, 1, sizeof(buf) - 1, f);
+    buf[n] = '\0';
+    fclose(f);
+    char needle[96];
+    snprintf(needle, sizeof(needle), "\"%s\"", secret);
+    char* p = strstr(buf, needle);
+    if (!p) return false;
+    p = strchr(p + strlen(needle), ':');
+    if (!p) return false;
+    p = strchr(p, '"');
+    if (!p) return false;
+    return hex16(p + 1, out);
+}
@@ -42,6 +42,11 @@ class AmsData;
 AmsData* harness_decode(uint8_t* buf, uint16_t len, MeterConfig* cfg,
                         const uint8_t* enc_key, const uint8_t* auth_key);
 
+// As harness_decode, but into a caller-owned slot like MeterCommunicator::getData.
+// Returns false (slot untouched) if nothing was decoded.
+bool harness_decode_into(uint8_t* buf, uint16_t len, MeterConfig* cfg,
+                         const uint8_t* enc_key, const uint8_t* auth_key, AmsData& data);
+
 // Convenience: load + decode a fixture (unencrypted). Returns NULL on failure.
 AmsData* harness_decode_fixture(const char* path);
 
@@ -55,5 +60,60 @@ struct HarnessProbe {
     int16_t unwrap_result;     // raw unwrap return (>=0 payload offset, <0 error)
 };
 void harness_probe_fixture(const char* path, HarnessProbe* out);
+void harness_probe(uint8_t* buf, uint16_t len, HarnessProbe* out);
+
+// Replays a fixture one byte at a time the way PassiveMeterCommunicator::loop()
+// receives it from the serial port. With `assembled` the FrameAssembler gates
+// the unwrap; without it every received byte triggers a full unwrap (the old
+// behaviour). Records where each frame ended and what the unwrap returned.
+#define HARNESS_STREAM_MAX_FRAMES 16
+struct HarnessStream {
+    int bytes;                                    // bytes fed
+    int unwraps;                                  // unwrap calls made
+    int frames;                                   // unwraps that did not return INCOMPLETE
+    int16_t results[HARNESS_STREAM_MAX_FRAMES];   // unwrap result per frame
+    uint8_t types[HARNESS_STREAM_MAX_FRAMES];     // ctx.type per frame
+    uint16_t ends[HARNESS_STREAM_MAX_FRAMES];     // byte offset the frame ended at
+    uint64_t ns;                                  // wall time spent feeding
+};
+void harness_stream_fixture(const char* path, bool assembled, HarnessStream* out);
+// Same, but read through FrameReader from a MemoryByteSource that hands out at
+// most chunk bytes per read (0 = all that is left), as loop() reads the port
+void harness_stream_chunked(const char* path, uint16_t chunk, HarnessStream* out);
+
+// Resolve a fixture key by secret name: environment first, then the gitignored
+// test/payloads/keys/keys.local.json. Returns false if the key is unknown.
+bool harness_load_key(const char* secret, uint8_t out[16]);
+
+// Keeps stdout muted across several decodes (nests with the per-decode mute),
+// so a timing loop does not pay for redirecting stdout on every call.
+void harness_mute_stdout(bool mute);
+
+// ----- benchmark instrumentation (bench_decoder.cpp) -----
+// Every stage unwrap/decode runs is a layer. While a stats block is installed
+// the harness records calls and wall time per layer; if a painted stack is
+// installed too, it also records the deepest stack use below the call site.
+enum HarnessLayer {
+    HARNESS_HDLC, HARNESS_MBUS, HARNESS_LLC, HARNESS_GBT, HARNESS_GCM,
+    HARNESS_DLMS, HARNESS_DSMR, HARNESS_IEC6205675, HARNESS_IEC6205621,
+    HARNESS_LNG, HARNESS_LNG2,
+    HARNESS_PIPELINE,   // the whole harness_decode / probe call
+    HARNESS_LAYERS
+};
+struct HarnessLayerStats {
+    uint32_t calls;
+    uint64_t ns;
+    uint32_t peakStack;   // bytes, 0 unless a painted stack was installed
+};
+const char* harness_layer_name(uint8_t layer);
+// stats: HARNESS_LAYERS entries (NULL disables). stackLo: lowest address of the
+// stack the decode runs on, painted before each layer (NULL: no stack probing).
+void harness_set_layer_stats(HarnessLayerStats* stats, uint8_t* stackLo);
+
+// Heap allocations made through operator new since start-up
+uint64_t harness_alloc_count();
+
+// Sets what millis() returns to code under test
+void harness_set_millis(unsigned long ms);
 
 #endif
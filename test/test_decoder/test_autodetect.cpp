@@ -0,0 +1,220 @@
+/**
+ * @copyright Utilitech AS 2023-2026
+ * License: Fair Source
+ *
+ * Serial autodetection: feeds SerialAutodetect the bytes a HAN port would see
+ * under the right and the wrong settings, and simulates the worst time to lock
+ * on for every candidate setting, bounded per setting and never slower than
+ * stepping through them on a 12 s timer.
+ */
+#include <unity.h>
+#include <stdio.h>
+#include <string.h>
+#include "SerialAutodetect.h"
+#include "decoder_harness.h"
+
+#define SIM_STEP 10
+#define SIM_TIMEOUT 600000UL
+#define OLD_STEP 12000UL
+
+static uint32_t sim_rand = 1;
+static uint8_t next_random() {
+    sim_rand = sim_rand * 1103515245 + 12345;
+    return (uint8_t) (sim_rand >> 16);
+}
+
+static uint8_t with_even_parity(uint8_t b) {
+    uint8_t p = 0;
+    for (uint8_t v = b & 0x7F; v; v >>= 1) p ^= v & 1;
+    return (b & 0x7F) | (p << 7);
+}
+
+void test_autodetect_locks_on_hdlc(void) {
+    static uint8_t buf[4096];
+    int n = harness_load_fixture("frames/Aidon-Sweden.raw", buf, sizeof(buf));
+    TEST_ASSERT_GREATER_THAN(0, n);
+
+    SerialAutodetect detector;
+    detector.begin(0);
+    SerialSetting first = detector.current();
+    for (int i = 0; i < n; i++) detector.sample(buf[i], 100);
+    TEST_ASSERT_GREATER_THAN(0, detector.getScore().headers);
+    // Nothing to change, wait there for a frame to decode
+    TEST_ASSERT_FALSE(detector.update(200));
+    TEST_ASSERT_TRUE(detector.isConfirming());
+    TEST_ASSERT_EQUAL(first.baud, detector.current().baud);
+    TEST_ASSERT_EQUAL(first.parity, detector.current().parity);
+
+    // Gives up on it if no frame decodes
+    TEST_ASSERT_FALSE(detector.update(200 + AUTODETECT_CONFIRM_TIMEOUT - 1));
+    TEST_ASSERT_TRUE(detector.update(200 + AUTODETECT_CONFIRM_TIMEOUT));
+    TEST_ASSERT_FALSE(detector.isConfirming());
+}
+
+void test_autodetect_infers_parity(void) {
+    static uint8_t buf[4096];
+    int n = harness_load_fixture("frames/Aidon-Sweden.raw", buf, sizeof(buf));
+    TEST_ASSERT_GREATER_THAN(0, n);
+
+    // HDLC headers intact, but every other byte with a framing error: 8E1 read as 8N1
+    SerialAutodetect detector;
+    detector.begin(0);
+    TEST_ASSERT_EQUAL(11, detector.current().parity);
+    for (int i = 0; i < n; i++) {
+        detector.sample(buf[i], 100);
+        if (i % 2) detector.error();
+    }
+    TEST_ASSERT_TRUE(detector.update(200));
+    TEST_ASSERT_TRUE(detector.isConfirming());
+    TEST_ASSERT_EQUAL(3, detector.current().parity);
+
+    // DSMR text with the parity bit in bit 7: 7E1 read as 8 data bits
+    n = harness_load_fixture("frames/dsmr.raw", buf, sizeof(buf));
+    TEST_ASSERT_GREATER_THAN(0, n);
+    detector.begin(0);
+    for (int i = 0; i < n; i++) detector.sample(with_even_parity(buf[i]), 100);
+    TEST_ASSERT_TRUE(detector.update(200));
+    TEST_ASSERT_EQUAL(10, detector.current().parity);
+
+    // Noise: moves on once a burst is over
+    detector.begin(0);
+    for (int i = 0; i < 100; i++) detector.sample(next_random(), 100);
+    TEST_ASSERT_FALSE(detector.update(100 + AUTODETECT_BURST_GAP));
+    TEST_ASSERT_TRUE(detector.update(101 + AUTODETECT_BURST_GAP));
+    TEST_ASSERT_FALSE(detector.isConfirming());
+    TEST_ASSERT_EQUAL(0, detector.getScore().bytes);
+}
+
+struct SimMeter {
+    SerialSetting setting;
+    const uint8_t* frame;
+    int length;
+    unsigned long interval;
+};
+
+// Falling edges in the line signal of one byte, start and stop bit included
+static int sim_edges(const SimMeter& m, int i) {
+    bool sevenBit = m.setting.parity == 10;
+    uint8_t b = sevenBit ? with_even_parity(m.frame[i]) : m.frame[i];
+    uint16_t bits = b << 1; // start bit
+    int n = 9;
+    if (m.setting.parity == 11) {
+        uint8_t p = 0;
+        for (uint8_t v = b; v; v >>= 1) p ^= v & 1;
+        bits |= p << n++;
+    }
+    bits |= 1 << n++; // stop bit
+    int edges = 0;
+    bool last = true; // idle
+    for (int k = 0; k < n; k++) {
+        bool level = (bits >> k) & 1;
+        if (last && !level) edges++;
+        last = level;
+    }
+    return edges;
+}
+
+// What the UART delivers for one byte of the meter's frame under setting c.
+// Returns false if nothing comes out, sets *error on framing/parity errors.
+static bool sim_receive(const SimMeter& m, const SerialSetting& c, int i, uint8_t* out, bool* error) {
+    const SerialSetting& t = m.setting;
+    bool sevenBit = t.parity == 10;
+    uint8_t b = sevenBit ? with_even_parity(m.frame[i]) : m.frame[i];
+    *error = false;
+    if (c.baud != t.baud || c.invert != t.invert) {
+        *out = next_random();
+        *error = (next_random() & 3) != 0;
+        return true;
+    }
+    bool cSeven = c.parity == 10;
+    if (sevenBit && cSeven) {
+        *out = m.frame[i];
+    } else if (sevenBit && !cSeven) {
+        *out = b;                         // parity bit read as the 8th data bit
+    } else if (!sevenBit && cSeven) {
+        *out = b & 0x7F;                  // 8th data bit read as parity
+        *error = (next_random() & 1) != 0;
+    } else if (t.parity != c.parity) {
+        *out = b;                         // 8E1 vs 8N1, parity bit against stop bit
+        *error = (next_random() & 1) != 0;
+    } else {
+        *out = b;
+    }
+    return true;
+}
+
+static bool same_setting(const SerialSetting& a, const SerialSetting& b) {
+    return a.baud == b.baud && a.parity == b.parity && a.invert == b.invert;
+}
+
+// Time from start until a whole frame was received under the meter's setting
+static unsigned long sim_lock(const SimMeter& m, unsigned long phase) {
+    SerialAutodetect detector;
+    detector.begin(0);
+    unsigned long since = 0;
+    for (unsigned long now = 0; now < SIM_TIMEOUT; now += SIM_STEP) {
+        unsigned long t = (now + phase) % m.interval;
+        unsigned long frameMs = (unsigned long) m.length * 11000UL / m.setting.baud + 1;
+        SerialSetting c = detector.current();
+        if (t < frameMs) {
+            // Bytes of the frame transmitted during this step
+            int from = (int) ((uint64_t) t * m.length / frameMs);
+            int to = (int) ((uint64_t) (t + SIM_STEP) * m.length / frameMs);
+            if (to > m.length) to = m.length;
+            // A lower configured baud rate sees fewer (garbage) bytes, a higher
+            // one a byte for every falling edge
+            for (int i = from; i < to; i++) {
+                if (c.baud < m.setting.baud && (i % (m.setting.baud / c.baud)) != 0) continue;
+                int copies = c.baud > m.setting.baud ? sim_edges(m, i) : 1;
+                for (int k = 0; k < copies; k++) {
+                    uint8_t b;
+                    bool error;
+                    if (!sim_receive(m, c, i, &b, &error)) continue;
+                    detector.sample(b, now);
+                    if (error) detector.error();
+                }
+            }
+            // Decodes if the whole frame came in under the right setting
+            if (to == m.length && same_setting(c, m.setting) && now >= t && now - t >= since) return now;
+        }
+        if (detector.update(now)) since = now + SIM_STEP;
+    }
+    return SIM_TIMEOUT;
+}
+
+void test_autodetect_time_to_lock(void) {
+    static uint8_t hdlc[4096], dsmr[4096];
+    int hn = harness_load_fixture("frames/Kamstrup-Sweden.raw", hdlc, sizeof(hdlc));
+    int dn = harness_load_fixture("frames/dsmr.raw", dsmr, sizeof(dsmr));
+    TEST_ASSERT_GREATER_THAN(0, hn);
+    TEST_ASSERT_GREATER_THAN(0, dn);
+
+    const SerialSetting settings[] = {
+        { 2400, 11, false }, { 2400, 3, false }, { 115200, 3, false }, { 9600, 10, false },
+        { 9600, 11, false }, { 2400, 11, true }, { 115200, 3, true },
+    };
+    // Meter frames it may take to lock on, counting the one that decodes
+    // and one lost to each wrong baud rate that was not skipped by its byte
+    // rate and to each parity change
+    const int frames[] = { 2, 3, 2, 3, 3, 3, 3 };
+    // Position of each in a fixed 12 s sweep over baud rates, parity only
+    // changing after a parity error, for comparison
+    const int oldSteps[] = { 0, 1, 2, 4, 1, 6, 8 };
+
+    for (size_t s = 0; s < sizeof(settings) / sizeof(settings[0]); s++) {
+        bool text = settings[s].baud != 2400;
+        SimMeter m = { settings[s], text ? dsmr : hdlc, text ? dn : hn, text ? 10000UL : 2500UL };
+        // Worst case over where in the meter's interval detection starts
+        unsigned long ms = 0;
+        for (unsigned long phase = 0; phase < m.interval; phase += m.interval / 10) {
+            unsigned long lock = sim_lock(m, phase);
+            if (lock > ms) ms = lock;
+        }
+        unsigned long old = oldSteps[s] * OLD_STEP + 2 * m.interval;
+        printf("  %6lu %d %-5s locked after %5.1f s (fixed 12 s stepping: ~%5.1f s)\n",
+            (unsigned long) m.setting.baud, m.setting.parity, m.setting.invert ? "inv" : "",
+            ms / 1000.0, old / 1000.0);
+        TEST_ASSERT_LESS_OR_EQUAL(frames[s] * m.interval + 1000, ms);
+        TEST_ASSERT_LESS_OR_EQUAL(old, ms);
+    }
+}
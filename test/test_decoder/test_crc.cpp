@@ -0,0 +1,139 @@
+/**
+ * @copyright Utilitech AS 2023-2026
+ * License: Fair Source
+ *
+ * Table-driven CRC: checks crc16/crc16_x25 against the original bit-at-a-time
+ * implementations over every capture in frames/ and every test payload, also
+ * when fed incrementally in uneven pieces, and reports the throughput of both.
+ */
+#include <unity.h>
+#include <stdio.h>
+#include <string.h>
+#include <dirent.h>
+#include <chrono>
+#include "crc.h"
+#include "fixtures_generated.h"
+
+#define COUNT(a) (sizeof(a) / sizeof((a)[0]))
+#define CRC_BENCH_BUF 65536
+
+// Reference: the bitwise implementations the tables replaced
+static uint16_t ref_crc16_x25(const uint8_t* p, int len) {
+    uint16_t crc = UINT16_MAX;
+    while(len--)
+        for (uint16_t i = 0, d = 0xff & *p++; i < 8; i++, d >>= 1)
+            crc = ((crc & 1) ^ (d & 1)) ? (crc >> 1) ^ 0x8408 : (crc >> 1);
+    return (~crc << 8) | (~crc >> 8 & 0xff);
+}
+
+static uint16_t ref_crc16(const uint8_t* p, int len) {
+    uint16_t crc = 0;
+    while (len--) {
+        crc ^= *p++;
+        for (uint8_t i = 0; i < 8; i++)
+            crc = crc & 1 ? (crc >> 1) ^ 0xa001 : crc >> 1;
+    }
+    return crc;
+}
+
+static int read_file(const char* path, uint8_t* buf, int cap) {
+    FILE* f = fopen(path, "rb");
+    if (!f) return -1;
+    int n = (int) fread(buf, 1, cap, f);
+    fclose(f);
+    return n;
+}
+
+// Every prefix length up to 64 bytes plus the whole buffer, and the whole
+// buffer split at a few uneven points through the incremental API
+static int check_buffer(const uint8_t* buf, int n, const char* name) {
+    int fails = 0;
+    for (int len = 0; len <= n; len = len < 64 ? len + 1 : (len == n ? n + 1 : n)) {
+        if (crc16_x25(buf, len) != ref_crc16_x25(buf, len) || crc16(buf, len) != ref_crc16(buf, len)) {
+            printf("  CRC MISMATCH: %s (len %d)\n", name, len);
+            fails++;
+            break;
+        }
+    }
+    static const int SPLITS[] = { 1, 3, 7, 13 };
+    for (size_t s = 0; s < COUNT(SPLITS); s++) {
+        uint16_t x25 = CRC16_X25_INIT, plain = CRC16_INIT;
+        for (int off = 0, step = SPLITS[s]; off < n; off += step, step = step * 2 + 1) {
+            int part = off + step > n ? n - off : step;
+            x25 = crc16_x25_update(x25, buf + off, part);
+            plain = crc16_update(plain, buf + off, part);
+        }
+        if (crc16_x25_final(x25) != ref_crc16_x25(buf, n) || plain != ref_crc16(buf, n)) {
+            printf("  INCREMENTAL CRC MISMATCH: %s (split %d)\n", name, SPLITS[s]);
+            fails++;
+            break;
+        }
+    }
+    return fails;
+}
+
+void test_crc_matches_bitwise(void) {
+    static uint8_t buf[CRC_BENCH_BUF];
+    int files = 0, fails = 0;
+
+    DIR* dir = opendir("frames");
+    if (dir) {
+        struct dirent* e;
+        while ((e = readdir(dir)) != NULL) {
+            if (e->d_name[0] == '.') continue;
+            char path[512];
+            snprintf(path, sizeof(path), "frames/%s", e->d_name);
+            int n = read_file(path, buf, sizeof(buf));
+            if (n <= 0) continue;
+            fails += check_buffer(buf, n, path);
+            files++;
+        }
+        closedir(dir);
+    }
+    for (size_t i = 0; i < COUNT(UNENC_OK); i++) {
+        int n = read_file(UNENC_OK[i].path, buf, sizeof(buf));
+        if (n <= 0) continue;
+        fails += check_buffer(buf, n, UNENC_OK[i].path);
+        files++;
+    }
+    printf("  crc: %d files checked (CRC_SLICES=%d)\n", files, CRC_SLICES);
+    TEST_ASSERT_GREATER_THAN(0, files);
+    TEST_ASSERT_EQUAL(0, fails);
+}
+
+void test_crc_throughput(void) {
+    static uint8_t buf[CRC_BENCH_BUF];
+    int total = 0;
+    DIR* dir = opendir("frames");
+    if (dir) {
+        struct dirent* e;
+        while ((e = readdir(dir)) != NULL && total < CRC_BENCH_BUF) {
+            if (e->d_name[0] == '.') continue;
+            char path[512];
+            snprintf(path, sizeof(path), "frames/%s", e->d_name);
+            int n = read_file(path, buf + total, CRC_BENCH_BUF - total);
+            if (n > 0) total += n;
+        }
+        closedir(dir);
+    }
+    if (total == 0) TEST_IGNORE_MESSAGE("no captures in frames/");
+
+    // Run over the captures a fixed number of times, the sum keeps the calls live
+    const int rounds = 64;
+    volatile uint32_t sink = 0;
+    auto t0 = std::chrono::steady_clock::now();
+    for (int r = 0; r < rounds; r++) sink += ref_crc16_x25(buf, total);
+    auto t1 = std::chrono::steady_clock::now();
+    for (int r = 0; r < rounds; r++) sink += crc16_x25(buf, total);
+    auto t2 = std::chrono::steady_clock::now();
+    (void) sink;
+
+    double bytes = (double) total * rounds;
+    double bitwise = std::chrono::duration<double>(t1 - t0).count();
+    double table = std::chrono::duration<double>(t2 - t1).count();
+    printf("  crc16_x25 over %d bytes x %d: bitwise %.1f MB/s, table (CRC_SLICES=%d) %.1f MB/s\n",
+        total, rounds,
+        bitwise > 0 ? bytes / bitwise / 1e6 : 0.0,
+        CRC_SLICES,
+        table > 0 ? bytes / table / 1e6 : 0.0);
+}
@@ -0,0 +1,162 @@
+/**
+ * @copyright Utilitech AS 2023-2026
+ * License: Fair Source
+ *
+ * EnergyDemand fed with power samples on a local clock: running averages and
+ * projections of the quarter-hour and hour, split at interval boundaries,
+ * top-N peaks for each tariff model, gaps and the month rolling over.
+ */
+#include <unity.h>
+#include <time.h>
+#include "EnergyDemand.h"
+
+#define DEMAND_T0 1772323200UL // 2026-03-01 00:00:00
+
+struct DemandClock {
+    time_t local;
+    uint64_t millis;
+};
+
+static uint8_t month_of(time_t t) {
+    struct tm tm;
+    gmtime_r(&t, &tm);
+    return tm.tm_mon + 1;
+}
+
+// One sample every step seconds for the given time, at a constant power
+static bool feed(EnergyDemand& demand, DemandClock& clock, uint32_t seconds, uint32_t power, uint32_t step = 10) {
+    bool ret = false;
+    for(uint32_t s = 0; s < seconds; s += step) {
+        clock.local += step;
+        clock.millis += step * 1000UL;
+        ret |= demand.update(clock.local, month_of(clock.local), clock.millis, power);
+    }
+    return ret;
+}
+
+static DemandClock start_clock(EnergyDemand& demand, time_t at) {
+    DemandClock clock = { at, 1000 };
+    demand.update(clock.local, month_of(clock.local), clock.millis, 0);
+    return clock;
+}
+
+void test_demand_running_average(void) {
+    EnergyDemand demand;
+    demand.setModel(DEMAND_MODEL_QUARTER, 1);
+    DemandClock clock = start_clock(demand, DEMAND_T0);
+
+    // 5 minutes at 2 kW, then 5 at 5 kW
+    feed(demand, clock, 300, 2000);
+    TEST_ASSERT_EQUAL_UINT32(2000, demand.getQuarterAverage());
+    feed(demand, clock, 300, 5000);
+    TEST_ASSERT_EQUAL_UINT32(3500, demand.getQuarterAverage());
+    // 10 of 15 minutes gone, 5 left at 5 kW
+    TEST_ASSERT_EQUAL_UINT32(4000, demand.getQuarterProjection());
+    TEST_ASSERT_EQUAL_UINT32(3500, demand.getHourAverage());
+    TEST_ASSERT_EQUAL_UINT32(4750, demand.getHourProjection());
+
+    // One sample over the boundary, 10 s at 1 kW before it and 5 s after
+    feed(demand, clock, 290, 5000);
+    clock.local += 15;
+    clock.millis += 15000;
+    TEST_ASSERT_TRUE(demand.update(clock.local, month_of(clock.local), clock.millis, 1000));
+    TEST_ASSERT_EQUAL_UINT8(1, demand.getPeakCount());
+    TEST_ASSERT_EQUAL_UINT32(DEMAND_T0, demand.getPeak(0).start);
+    // (300 * 2000 + 590 * 5000 + 10 * 1000) / 900
+    TEST_ASSERT_EQUAL_UINT32(3955, demand.getPeak(0).value);
+    TEST_ASSERT_EQUAL_UINT32(1000, demand.getQuarterAverage());
+}
+
+void test_demand_peaks_per_model(void) {
+    // Three days, two busy hours each: 03:00 and 18:00
+    const uint32_t loads[3][2] = { { 4000, 6000 }, { 7000, 3000 }, { 6500, 6800 } };
+    const uint8_t models[] = { DEMAND_MODEL_HOUR_DAILY, DEMAND_MODEL_HOUR, DEMAND_MODEL_QUARTER_DAILY, DEMAND_MODEL_QUARTER };
+    // Per day models skip the 6500 of the day that already has 6800, any-day
+    // quarters take three from the same busy hour
+    const uint32_t expected[][3] = { { 7000, 6800, 6000 }, { 7000, 6800, 6500 }, { 7000, 6800, 6000 }, { 7000, 7000, 7000 } };
+    const uint32_t expectedAvg[] = { 6600, 6766, 6600, 7000 };
+
+    for(uint8_t m = 0; m < sizeof(models); m++) {
+        EnergyDemand demand;
+        demand.setModel(models[m], 3);
+        DemandClock clock = start_clock(demand, DEMAND_T0);
+        for(uint8_t d = 0; d < 3; d++) {
+            feed(demand, clock, 3 * 3600, 500);
+            feed(demand, clock, 3600, loads[d][0]);
+            feed(demand, clock, 14 * 3600, 500);
+            feed(demand, clock, 3600, loads[d][1]);
+            feed(demand, clock, 5 * 3600, 500);
+        }
+        TEST_ASSERT_EQUAL_UINT8(3, demand.getPeakCount());
+        for(uint8_t i = 0; i < 3; i++) {
+            TEST_ASSERT_EQUAL_UINT32(expected[m][i], demand.getPeak(i).value);
+        }
+        TEST_ASSERT_EQUAL_UINT32(expectedAvg[m], demand.getPeakAverage());
+    }
+
+    // Any-day hours keep both busy hours of the first day until beaten
+    EnergyDemand demand;
+    demand.setModel(DEMAND_MODEL_HOUR, 2);
+    DemandClock clock = start_clock(demand, DEMAND_T0);
+    feed(demand, clock, 3600, 4000);
+    feed(demand, clock, 3600, 6000);
+    feed(demand, clock, 3600, 500);
+    TEST_ASSERT_EQUAL_UINT8(2, demand.getPeakCount());
+    TEST_ASSERT_EQUAL_UINT32(4000, demand.getPeakThreshold());
+
+    // Heading past the lowest peak warns before the hour is done
+    feed(demand, clock, 1800, 3000);
+    TEST_ASSERT_FALSE(demand.isPeakWarning());
+    feed(demand, clock, 600, 8000);
+    TEST_ASSERT_TRUE(demand.isPeakWarning());
+
+    // Daily hours only compete with the day's own peak once it has one
+    EnergyDemand daily;
+    daily.setModel(DEMAND_MODEL_HOUR_DAILY, 3);
+    clock = start_clock(daily, DEMAND_T0);
+    feed(daily, clock, 3600, 4000);
+    TEST_ASSERT_EQUAL_UINT32(4000, daily.getPeakThreshold());
+    feed(daily, clock, 3600, 6000);
+    TEST_ASSERT_EQUAL_UINT8(1, daily.getPeakCount());
+    TEST_ASSERT_EQUAL_UINT32(6000, daily.getPeak(0).value);
+}
+
+void test_demand_gaps_and_month(void) {
+    EnergyDemand demand;
+    demand.setModel(DEMAND_MODEL_QUARTER, 2);
+    DemandClock clock = start_clock(demand, 1774998000UL); // 2026-03-31 23:00:00
+
+    // Reboot-like gap: 4 of 15 minutes seen is too little to become a peak
+    feed(demand, clock, 240, 9000);
+    clock.local += 660;
+    clock.millis = 1000; // millis restarted
+    demand.update(clock.local, month_of(clock.local), clock.millis, 0);
+    TEST_ASSERT_EQUAL_UINT8(0, demand.getPeakCount());
+
+    feed(demand, clock, 900, 3000);
+    feed(demand, clock, 900, 2000);
+    TEST_ASSERT_EQUAL_UINT8(2, demand.getPeakCount());
+
+    // Persisted and restored, peaks of another model are not taken
+    EnergyDemandData data = demand.getData();
+    EnergyDemand restored;
+    restored.setModel(DEMAND_MODEL_QUARTER, 2);
+    restored.setData(data);
+    TEST_ASSERT_EQUAL_UINT8(2, restored.getPeakCount());
+    TEST_ASSERT_EQUAL_UINT32(3000, restored.getPeak(0).value);
+    EnergyDemand other;
+    other.setModel(DEMAND_MODEL_HOUR, 2);
+    other.setData(data);
+    TEST_ASSERT_EQUAL_UINT8(0, other.getPeakCount());
+
+    // The last quarter of March closes on the first sample of April, it is
+    // billed with March and does not carry over
+    TEST_ASSERT_EQUAL_UINT32(0, demand.getLastMonthPeakAverage());
+    feed(demand, clock, 900, 4000);
+    TEST_ASSERT_EQUAL_UINT8(4, month_of(clock.local));
+    TEST_ASSERT_EQUAL_UINT8(0, demand.getPeakCount());
+    TEST_ASSERT_EQUAL_UINT32(3500, demand.getLastMonthPeakAverage());
+    feed(demand, clock, 900, 2500);
+    TEST_ASSERT_EQUAL_UINT8(1, demand.getPeakCount());
+    TEST_ASSERT_EQUAL_UINT32(2500, demand.getPeak(0).value);
+}
@@ -17,45 +17,12 @@
 #include <stdlib.h>
 #include <string.h>
 #include "AmsData.h"
+#include "GcmParser.h"
 #include "decoder_harness.h"
 #include "fixtures_generated.h"
 
 #define COUNT(a) (sizeof(a) / sizeof((a)[0]))
 
-static int hex16(const char* hex, uint8_t out[16]) {
-    int n = 0;
-    for (int i = 0; i < 16; i++) {
-        unsigned v;
-        if (sscanf(hex + i * 2, "%2x", &v) != 1) return 0;
-        out[i] = (uint8_t)v;
-        n++;
-    }
-    return n == 16;
-}
-
-// Look up a key by secret name: environment first, then keys.local.json.
-static bool load_key(const char* secret, uint8_t out[16]) {
-    if (!secret) return false;
-    const char* env = getenv(secret);
-    if (env && strlen(env) >= 32) return hex16(env, out);
-
-    FILE* f = fopen("test/payloads/keys/keys.local.json", "rb");
-    if (!f) return false;
-    static char buf[8192];
-    size_t n = fread(buf, 1, sizeof(buf) - 1, f);
-    buf[n] = '\0';
-    fclose(f);
-    char needle[96];
-    snprintf(needle, sizeof(needle), "\"%s\"", secret);
-    char* p = strstr(buf, needle);
-    if (!p) return false;
-    p = strchr(p + strlen(needle), ':');
-    if (!p) return false;
-    p = strchr(p, '"');
-    if (!p) return false;
-    return hex16(p + 1, out);
-}
-
 void test_encrypted_decode(void) {
 #if !defined(HAVE_MBEDTLS)
     TEST_IGNORE_MESSAGE("native mbedTLS not available (install libmbedtls-dev) — skipping encrypted decode");
@@ -65,8 +32,8 @@ void test_encrypted_decode(void) {
     for (size_t i = 0; i < COUNT(ENC_KEYED); i++) {
         const KeyedFixture& k = ENC_KEYED[i];
         uint8_t ek[16], ak[16];
-        if (!load_key(k.ek_secret, ek)) { printf("  no key %-22s %s\n", k.ek_secret, k.path); no_key++; continue; }
-        bool haveAk = k.ak_secret && load_key(k.ak_secret, ak);
+        if (!harness_load_key(k.ek_secret, ek)) { printf("  no key %-22s %s\n", k.ek_secret, k.path); no_key++; continue; }
+        bool haveAk = k.ak_secret && harness_load_key(k.ak_secret, ak);
 
         static uint8_t buf[4096];
         int len = harness_load_fixture(k.path, buf, sizeof(buf));
@@ -77,7 +44,7 @@ void test_encrypted_decode(void) {
         if (!d) { printf("  DECRYPT/DECODE FAIL %s\n", k.path); failures++; continue; }
         printf("  list=%d type=%-2d P+=%-6u L1V=%-6.1f id=%s  %s\n",
                d->getListType(), d->getMeterType(), d->getActiveImportPower(),
-               d->getL1Voltage(), d->getMeterId().c_str(), k.path);
+               d->getL1Voltage(), d->getMeterId(), k.path);
         if (d->getListType() < 1) failures++;
         delete d;
     }
@@ -100,8 +67,8 @@ static AmsData* decrypt_or_ignore(const char* path, const char* ekName, const ch
     return NULL;
 #else
     uint8_t ek[16], ak[16];
-    if (!load_key(ekName, ek)) { TEST_IGNORE_MESSAGE("encryption key not available"); return NULL; }
-    bool haveAk = akName && load_key(akName, ak);
+    if (!harness_load_key(ekName, ek)) { TEST_IGNORE_MESSAGE("encryption key not available"); return NULL; }
+    bool haveAk = akName && harness_load_key(akName, ak);
     static uint8_t buf[4096];
     int len = harness_load_fixture(path, buf, sizeof(buf));
     TEST_ASSERT_GREATER_THAN(0, len);
@@ -140,7 +107,7 @@ void test_encrypted_landisgyr_501(void) {
     TEST_ASSERT_NOT_NULL_MESSAGE(d, "gh501-1 failed to decrypt/decode");
     TEST_ASSERT_EQUAL(AmsTypeLandisGyr, d->getMeterType());
     TEST_ASSERT_GREATER_OR_EQUAL(1, d->getListType());
-    TEST_ASSERT_EQUAL_STRING("30137181", d->getMeterId().c_str());
+    TEST_ASSERT_EQUAL_STRING("30137181", d->getMeterId());
     delete d;
 }
 
@@ -151,11 +118,80 @@ void test_encrypted_kaifa_905(void) {
     TEST_ASSERT_NOT_NULL_MESSAGE(d, "gh905-1 failed to decrypt/decode");
     TEST_ASSERT_EQUAL(AmsTypeKaifa, d->getMeterType());
     TEST_ASSERT_GREATER_OR_EQUAL(1, d->getListType());
-    TEST_ASSERT_EQUAL_STRING("1KFM0200169986", d->getMeterId().c_str());
+    TEST_ASSERT_EQUAL_STRING("1KFM0200169986", d->getMeterId());
     delete d;
 }
 
+// Frames encrypted with a published test key, so GcmParser is exercised
+// wherever mbedTLS is available, secrets or not. One parser for all of them:
+// the key schedule set up in the constructor is reused frame after frame and
+// the plaintext lands in place of the ciphertext.
+static const uint8_t GCM_TEST_EK[16] = { 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E, 0x0F };
+static const uint8_t GCM_TEST_AK[16] = { 0xD0, 0xD1, 0xD2, 0xD3, 0xD4, 0xD5, 0xD6, 0xD7, 0xD8, 0xD9, 0xDA, 0xDB, 0xDC, 0xDD, 0xDE, 0xDF };
+static const uint8_t GCM_TEST_PLAIN[21] = { 0x0F, 0x00, 0x00, 0x00, 0x01, 0x00, 0x02, 0x02, 0x09, 0x06, 0x01, 0x00, 0x01, 0x07, 0x00, 0xFF, 0x06, 0x00, 0x00, 0x04, 0xD2 };
+// Security 0x30 (encrypted and authenticated), frame counters 1 and 2
+static const uint8_t GCM_TEST_FRAME1[49] = {
+    0xDB, 0x08, 0x41, 0x4D, 0x53, 0x00, 0x00, 0x00, 0x00, 0x01, 0x26, 0x30, 0x00, 0x00, 0x00, 0x01,
+    0xCB, 0x5C, 0xA6, 0x9D, 0xB5, 0xFF, 0x3B, 0x57, 0x6C, 0x15, 0x98, 0xF2, 0xAA, 0xA9, 0xC9, 0xB5, 0x09, 0xC9, 0x62, 0x0E, 0xF4,
+    0x1C, 0x46, 0x2B, 0x5C, 0xB1, 0x7B, 0xE1, 0xE6, 0xF9, 0x7E, 0x38, 0xD3
+};
+static const uint8_t GCM_TEST_FRAME2[49] = {
+    0xDB, 0x08, 0x41, 0x4D, 0x53, 0x00, 0x00, 0x00, 0x00, 0x01, 0x26, 0x30, 0x00, 0x00, 0x00, 0x02,
+    0xDD, 0x77, 0x63, 0x61, 0x76, 0x06, 0xEC, 0x39, 0x2A, 0x9D, 0xA6, 0xEB, 0x7C, 0x67, 0x78, 0xA3, 0x6A, 0x96, 0x7F, 0x2F, 0x36,
+    0x6D, 0x8B, 0x6D, 0x43, 0xCE, 0x66, 0x60, 0x72, 0xF7, 0xCC, 0x75, 0x7E
+};
+// Security 0x20 (encrypted only), frame counter 3
+static const uint8_t GCM_TEST_FRAME3[37] = {
+    0xDB, 0x08, 0x41, 0x4D, 0x53, 0x00, 0x00, 0x00, 0x00, 0x01, 0x1A, 0x20, 0x00, 0x00, 0x00, 0x03,
+    0xD9, 0x59, 0xD9, 0xF1, 0x25, 0xDB, 0xBC, 0x8C, 0x94, 0x95, 0x1A, 0x2D, 0xBD, 0x8F, 0xE2, 0x9D, 0x68, 0xFF, 0x62, 0x29, 0x46
+};
+
+#if defined(HAVE_MBEDTLS)
+static int8_t gcm_test_parse(GCMParser& gcm, const uint8_t* frame, uint16_t len, uint8_t* buf, DataParserContext& ctx) {
+    memcpy(buf, frame, len);
+    ctx = {DATA_TAG_GCM, len, 0, {}};
+    return gcm.parse(buf, ctx);
+}
+#endif
+
+void test_encrypted_gcm_known_key(void) {
+#if !defined(HAVE_MBEDTLS)
+    // CI installs mbedTLS and sets this, so a lost HAVE_MBEDTLS fails there instead of skipping
+    if (getenv("AMS_TEST_REQUIRE_GCM") != NULL) TEST_FAIL_MESSAGE("AMS_TEST_REQUIRE_GCM is set, but native mbedTLS was not found");
+    TEST_IGNORE_MESSAGE("native mbedTLS not available (install libmbedtls-dev)");
+#else
+    uint8_t ek[16], ak[16], none[16];
+    memcpy(ek, GCM_TEST_EK, 16);
+    memcpy(ak, GCM_TEST_AK, 16);
+    memset(none, 0, 16);
+    GCMParser gcm(ek, ak);
+    uint8_t buf[64];
+    DataParserContext ctx;
 
+    const uint8_t* frames[] = { GCM_TEST_FRAME1, GCM_TEST_FRAME2, GCM_TEST_FRAME1 };
+    for (size_t i = 0; i < COUNT(frames); i++) {
+        TEST_ASSERT_EQUAL(16, gcm_test_parse(gcm, frames[i], sizeof(GCM_TEST_FRAME1), buf, ctx));
+        TEST_ASSERT_EQUAL(sizeof(GCM_TEST_PLAIN), ctx.length);
+        TEST_ASSERT_EQUAL_MEMORY(GCM_TEST_PLAIN, buf + 16, sizeof(GCM_TEST_PLAIN));
+        TEST_ASSERT_EQUAL_MEMORY(GCM_TEST_FRAME1 + 2, ctx.system_title, 8);
+    }
+
+    // A flipped tag bit, or ciphertext from another frame counter, does not authenticate
+    uint8_t tampered[sizeof(GCM_TEST_FRAME1)];
+    memcpy(tampered, GCM_TEST_FRAME1, sizeof(tampered));
+    tampered[sizeof(tampered) - 1] ^= 0x01;
+    TEST_ASSERT_EQUAL(GCM_AUTH_FAILED, gcm_test_parse(gcm, tampered, sizeof(tampered), buf, ctx));
+    memcpy(tampered, GCM_TEST_FRAME1, sizeof(tampered));
+    tampered[15] = 0x02;
+    TEST_ASSERT_EQUAL(GCM_AUTH_FAILED, gcm_test_parse(gcm, tampered, sizeof(tampered), buf, ctx));
+
+    // Encrypted only, the meter has no authentication key
+    GCMParser plain(ek, none);
+    TEST_ASSERT_EQUAL(16, gcm_test_parse(plain, GCM_TEST_FRAME3, sizeof(GCM_TEST_FRAME3), buf, ctx));
+    TEST_ASSERT_EQUAL(sizeof(GCM_TEST_PLAIN), ctx.length);
+    TEST_ASSERT_EQUAL_MEMORY(GCM_TEST_PLAIN, buf + 16, sizeof(GCM_TEST_PLAIN));
+#endif
+}
 
 // Framing / GCM-header coverage for encrypted frames we have no key for.
 // Does not (cannot) test decryption — instead it guards that the transport
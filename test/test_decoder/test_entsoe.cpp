@@ -0,0 +1,118 @@
+/**
+ * @copyright Utilitech AS 2023-2026
+ * License: Fair Source
+ *
+ * EntsoeA44Parser over the documents in test/payloads/entsoe, written to it
+ * in chunks of 1, 7, 64 bytes and all at once: every point matches a plain
+ * string scan of the first time series, with omitted points repeating the one
+ * before. Also reports parse throughput per chunk size.
+ */
+#include <unity.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <chrono>
+#include <string>
+#include <vector>
+#include "EntsoeA44Parser.h"
+
+#define COUNT(a) (sizeof(a) / sizeof((a)[0]))
+
+static const char* A44_FIXTURES[] = {
+    "test/payloads/entsoe/no1_pt60m.xml",
+    "test/payloads/entsoe/no2_pt15m_a03.xml",
+    "test/payloads/entsoe/de_two_series.xml",
+};
+
+static std::string read_doc(const char* path) {
+    std::string doc;
+    FILE* f = fopen(path, "rb");
+    if (!f) return doc;
+    char buf[1024];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), f)) > 0) doc.append(buf, n);
+    fclose(f);
+    return doc;
+}
+
+static std::string text_of(const std::string& doc, const char* tag, size_t from, size_t* end = NULL) {
+    std::string open = std::string("<") + tag + ">";
+    size_t s = doc.find(open, from);
+    if (s == std::string::npos) return "";
+    s += open.size();
+    size_t e = doc.find('<', s);
+    if (end) *end = e;
+    return doc.substr(s, e - s);
+}
+
+// Prices per kWh of the first time series, filled forward the way curve type A03 means it
+static std::vector<double> expected_prices(const std::string& doc, uint8_t* resolution) {
+    size_t seriesEnd = doc.find("</TimeSeries>");
+    *resolution = text_of(doc, "resolution", 0) == "PT15M" ? 15 : 60;
+    std::vector<double> prices(*resolution == 15 ? 100 : 25, NAN);
+    size_t at = 0;
+    int last = -1;
+    while (true) {
+        std::string pos = text_of(doc, "position", at, &at);
+        if (pos.empty() || at > seriesEnd) break;
+        int p = atoi(pos.c_str()) - 1;
+        double v = atof(text_of(doc, "price.amount", at, &at).c_str()) / 1000.0;
+        for (int i = last + 1; last >= 0 && i < p; i++) prices[i] = prices[last];
+        prices[p] = v;
+        last = p;
+    }
+    for (size_t i = last + 1; i < prices.size(); i++) prices[i] = prices[last];
+    return prices;
+}
+
+static void parse_chunked(const std::string& doc, size_t chunk, PricesContainer* container) {
+    EntsoeA44Parser a44(container);
+    const uint8_t* p = (const uint8_t*) doc.data();
+    for (size_t i = 0; i < doc.size(); i += chunk) {
+        a44.write(p + i, doc.size() - i < chunk ? doc.size() - i : chunk);
+    }
+}
+
+void test_entsoe_a44_documents(void) {
+    const size_t chunks[] = { 1, 7, 64, 0 };
+    for (size_t d = 0; d < COUNT(A44_FIXTURES); d++) {
+        std::string doc = read_doc(A44_FIXTURES[d]);
+        TEST_ASSERT_TRUE_MESSAGE(!doc.empty(), A44_FIXTURES[d]);
+        uint8_t resolution;
+        std::vector<double> expected = expected_prices(doc, &resolution);
+
+        for (size_t c = 0; c < COUNT(chunks); c++) {
+            char msg[128];
+            snprintf(msg, sizeof(msg), "%s in chunks of %zu", A44_FIXTURES[d], chunks[c] ? chunks[c] : doc.size());
+            PricesContainer container((char*) "EOE");
+            parse_chunked(doc, chunks[c] ? chunks[c] : doc.size(), &container);
+
+            TEST_ASSERT_EQUAL_UINT8_MESSAGE(resolution, container.getResolutionInMinutes(), msg);
+            TEST_ASSERT_EQUAL_UINT8_MESSAGE(expected.size(), container.getNumberOfPoints(), msg);
+            TEST_ASSERT_EQUAL_STRING_MESSAGE("EUR", container.getCurrency(), msg);
+            for (size_t i = 0; i < expected.size(); i++) {
+                // Stored as 1/10000 of the currency, truncated
+                TEST_ASSERT_FLOAT_WITHIN_MESSAGE(0.00011, expected[i], container.getPrice(i, PRICE_DIRECTION_IMPORT), msg);
+            }
+        }
+    }
+}
+
+void test_entsoe_a44_throughput(void) {
+    std::string doc = read_doc(A44_FIXTURES[1]);
+    if (doc.empty()) TEST_IGNORE_MESSAGE("no A44 documents");
+
+    // Byte at a time as from HTTPClient::writeToStream on a slow link, and one TLS record at a time
+    const size_t chunks[] = { 1, 1460 };
+    const int rounds = 200;
+    for (size_t c = 0; c < COUNT(chunks); c++) {
+        PricesContainer container((char*) "EOE");
+        auto t0 = std::chrono::steady_clock::now();
+        for (int r = 0; r < rounds; r++) parse_chunked(doc, chunks[c], &container);
+        auto t1 = std::chrono::steady_clock::now();
+        double s = std::chrono::duration<double>(t1 - t0).count();
+        printf("  A44 %zu bytes in chunks of %4zu: %8.0f ns/document, %.1f MB/s\n",
+            doc.size(), chunks[c], s * 1e9 / rounds, s > 0 ? (double) doc.size() * rounds / s / 1e6 : 0.0);
+    }
+}
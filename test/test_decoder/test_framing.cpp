@@ -0,0 +1,205 @@
+/**
+ * @copyright Utilitech AS 2023-2026
+ * License: Fair Source
+ *
+ * Streaming frame assembly: replays captures one byte at a time, the way the
+ * HAN port delivers them, and checks that gating the unwrap with FrameAssembler
+ * finds exactly the same frames as unwrapping after every byte did — while only
+ * unwrapping once per frame, so the per-byte cost stays flat with frame size.
+ * FrameReader gets the same frames when the bytes arrive in chunks.
+ */
+#include <unity.h>
+#include <stdio.h>
+#include <string.h>
+#include "FrameAssembler.h"
+#include "FrameReader.h"
+#include "decoder_harness.h"
+#include "fixtures_generated.h"
+
+#define COUNT(a) (sizeof(a) / sizeof((a)[0]))
+
+// Captures in frames/ that are plain hex dumps (the others carry annotations)
+static const char* RAW_FRAMES[] = {
+    "frames/Aidon-Sweden.raw",
+    "frames/Kamstrup-1p.raw",
+    "frames/Kamstrup-Sweden.raw",
+    "frames/dsmr.raw",
+};
+
+static bool same_frames(const HarnessStream& a, const HarnessStream& b) {
+    if (a.frames != b.frames) return false;
+    for (int i = 0; i < a.frames && i < HARNESS_STREAM_MAX_FRAMES; i++) {
+        if (a.results[i] != b.results[i] || a.types[i] != b.types[i] || a.ends[i] != b.ends[i])
+            return false;
+    }
+    return true;
+}
+
+void test_assembler_hdlc_boundary(void) {
+    static uint8_t buf[4096];
+    int n = harness_load_fixture("test/payloads/kamstrup/em001-1.hex", buf, sizeof(buf));
+    TEST_ASSERT_GREATER_THAN(3, n);
+
+    FrameAssembler assembler;
+    for (int len = 1; len < n; len++) {
+        TEST_ASSERT_FALSE(assembler.append(buf, len));
+    }
+    TEST_ASSERT_TRUE(assembler.append(buf, n));
+    TEST_ASSERT_EQUAL(n, assembler.getExpectedLength());
+}
+
+void test_assembler_dsmr_boundary(void) {
+    static uint8_t buf[4096];
+    int n = harness_load_fixture("test/payloads/kamstrup/gh578-1.txt", buf, sizeof(buf));
+    TEST_ASSERT_GREATER_THAN(0, n);
+    int end = -1;
+    for (int i = 1; i < n && end < 0; i++) {
+        if (buf[i] != '!') continue;
+        while (i < n && buf[i] != '\n') i++;
+        end = i;
+    }
+    TEST_ASSERT_GREATER_THAN(0, end);
+
+    FrameAssembler assembler;
+    for (int len = 1; len <= end; len++) {
+        TEST_ASSERT_FALSE(assembler.append(buf, len));
+    }
+    TEST_ASSERT_TRUE(assembler.append(buf, end + 1));
+}
+
+// Read sizes a polled UART hands out: byte by byte, a FIFO's worth, all at once
+static const uint16_t CHUNKS[] = { 1, 7, 64, 0 };
+
+static int chunked_compare(const char* path) {
+    HarnessStream assembled;
+    harness_stream_fixture(path, true, &assembled);
+    if (assembled.bytes == 0) return 0;
+    for (size_t c = 0; c < COUNT(CHUNKS); c++) {
+        HarnessStream chunked;
+        harness_stream_chunked(path, CHUNKS[c], &chunked);
+        if (!same_frames(assembled, chunked)) {
+            printf("  CHUNKED FRAMING MISMATCH: %s (chunk %d)\n", path, CHUNKS[c]);
+            return -1;
+        }
+    }
+    return 1;
+}
+
+static int stream_compare(const char* path, uint64_t* nsPerByteOld, uint64_t* nsPerByteNew) {
+    HarnessStream perByte, assembled;
+    harness_stream_fixture(path, false, &perByte);
+    harness_stream_fixture(path, true, &assembled);
+    if (perByte.bytes == 0) return 0;
+    if (!same_frames(perByte, assembled)) {
+        printf("  FRAMING MISMATCH: %s\n", path);
+        return -1;
+    }
+    if (assembled.unwraps > perByte.unwraps) {
+        printf("  MORE UNWRAPS: %s (%d > %d)\n", path, assembled.unwraps, perByte.unwraps);
+        return -1;
+    }
+    *nsPerByteOld = perByte.ns / perByte.bytes;
+    *nsPerByteNew = assembled.ns / assembled.bytes;
+    return 1;
+}
+
+void test_assembler_matches_per_byte_unwrap(void) {
+    const Fixture* lists[2] = { UNENC_OK, UNENC_EDGE };
+    size_t counts[2] = { COUNT(UNENC_OK), COUNT(UNENC_EDGE) };
+    int mismatches = 0, compared = 0;
+    for (int l = 0; l < 2; l++) {
+        for (size_t i = 0; i < counts[l]; i++) {
+            uint64_t before, after;
+            int r = stream_compare(lists[l][i].path, &before, &after);
+            if (r < 0) mismatches++;
+            if (r > 0) compared++;
+        }
+    }
+    TEST_ASSERT_GREATER_THAN(0, compared);
+    TEST_ASSERT_EQUAL_MESSAGE(0, mismatches, "streamed framing differs from per-byte unwrap");
+}
+
+void test_assembler_raw_frames(void) {
+    printf("\n--- streamed per-byte cost (per-byte unwrap -> assembled) ---\n");
+    for (size_t i = 0; i < COUNT(RAW_FRAMES); i++) {
+        HarnessStream assembled;
+        harness_stream_fixture(RAW_FRAMES[i], true, &assembled);
+        TEST_ASSERT_GREATER_THAN(0, assembled.bytes);
+        // One unwrap per frame, independent of frame size
+        TEST_ASSERT_EQUAL(assembled.frames, assembled.unwraps);
+
+        uint64_t before = 0, after = 0;
+        TEST_ASSERT_EQUAL(1, stream_compare(RAW_FRAMES[i], &before, &after));
+        printf("  %-28s %5d bytes  %6llu -> %4llu ns/byte\n", RAW_FRAMES[i], assembled.bytes,
+               (unsigned long long)before, (unsigned long long)after);
+    }
+}
+
+void test_reader_matches_assembler(void) {
+    const Fixture* lists[2] = { UNENC_OK, UNENC_EDGE };
+    size_t counts[2] = { COUNT(UNENC_OK), COUNT(UNENC_EDGE) };
+    int mismatches = 0, compared = 0;
+    for (int l = 0; l < 2; l++) {
+        for (size_t i = 0; i < counts[l]; i++) {
+            int r = chunked_compare(lists[l][i].path);
+            if (r < 0) mismatches++;
+            if (r > 0) compared++;
+        }
+    }
+    for (size_t i = 0; i < COUNT(RAW_FRAMES); i++) {
+        int r = chunked_compare(RAW_FRAMES[i]);
+        if (r < 0) mismatches++;
+        if (r > 0) compared++;
+    }
+    TEST_ASSERT_GREATER_THAN(0, compared);
+    TEST_ASSERT_EQUAL_MESSAGE(0, mismatches, "chunked framing differs from byte by byte");
+
+    printf("\n--- chunked reads (byte by byte -> whole FIFO) ---\n");
+    for (size_t i = 0; i < COUNT(RAW_FRAMES); i++) {
+        HarnessStream one, bulk;
+        harness_stream_chunked(RAW_FRAMES[i], 1, &one);
+        harness_stream_chunked(RAW_FRAMES[i], 0, &bulk);
+        printf("  %-28s %5d bytes  %4llu -> %4llu ns/byte\n", RAW_FRAMES[i], bulk.bytes,
+               (unsigned long long)(one.ns / one.bytes), (unsigned long long)(bulk.ns / bulk.bytes));
+    }
+}
+
+void test_reader_carries_next_telegram(void) {
+    static uint8_t telegram[2048], stream[4096], han[4096];
+    int n = harness_load_fixture("test/payloads/kamstrup/gh578-1.txt", telegram, sizeof(telegram));
+    TEST_ASSERT_GREATER_THAN(0, n);
+    int end = -1;
+    for (int i = 1; i < n && end < 0; i++) {
+        if (telegram[i] != '!') continue;
+        while (i < n && telegram[i] != '\n') i++;
+        end = i + 1;
+    }
+    TEST_ASSERT_GREATER_THAN(0, end);
+
+    // Three telegrams back to back, as when the loop was held up for a while
+    for (int i = 0; i < 3; i++) memcpy(stream + i * end, telegram, end);
+    MemoryByteSource source(stream, (uint16_t)(3 * end));
+    FrameReader reader;
+    reader.begin(han, sizeof(han));
+
+    int frames = 0, reads = 0;
+    while (reader.read(source) > 0) {
+        reads++;
+        if (!reader.isComplete()) continue;
+        TEST_ASSERT_EQUAL(end, reader.getLength());
+        TEST_ASSERT_EQUAL_MEMORY(telegram, han, end);
+        frames++;
+        reader.next();
+    }
+    TEST_ASSERT_EQUAL(3, frames);
+    TEST_ASSERT_EQUAL(0, reader.getCarry());
+    // A byte to find the tag, the bulk, then the CRC line a byte at a time
+    TEST_ASSERT_LESS_THAN(3 * 16, reads);
+
+    // A full buffer does not read any more
+    reader.begin(han, 16);
+    MemoryByteSource more(stream, (uint16_t)(3 * end));
+    while (reader.read(more) > 0);
+    TEST_ASSERT_TRUE(reader.isFull());
+    TEST_ASSERT_EQUAL(16, reader.getLength());
+}
@@ -0,0 +1,147 @@
+/**
+ * @copyright Utilitech AS 2023-2026
+ * License: Fair Source
+ *
+ * AmsJournal on the in-memory LittleFS shim: newest record per type wins,
+ * a torn or corrupt tail recovers to the last good record, the file is
+ * compacted before it outgrows its limit and legacy files are migrated.
+ */
+#include <unity.h>
+#include <string.h>
+#include "AmsJournal.h"
+#include "LittleFS.h"
+
+#define JOURNAL_RECORD_SIZE(len) (sizeof(JournalRecordHeader) + (len) + 2)
+
+static void fill(uint8_t* buf, uint16_t len, uint8_t seed) {
+    for(uint16_t i = 0; i < len; i++) buf[i] = (uint8_t) (seed + i * 7);
+}
+
+void test_journal_newest_record_wins(void) {
+    LittleFS.format();
+    uint8_t a[100], b[300], c[100], out[300];
+    fill(a, sizeof(a), 1);
+    fill(b, sizeof(b), 2);
+    fill(c, sizeof(c), 3);
+
+    AmsJournal journal;
+    TEST_ASSERT_TRUE(journal.begin());
+    TEST_ASSERT_FALSE(journal.has(JournalDayPlot));
+    TEST_ASSERT_TRUE(journal.write(JournalDayPlot, a, sizeof(a)));
+    TEST_ASSERT_TRUE(journal.write(JournalMonthPlot, b, sizeof(b)));
+    TEST_ASSERT_TRUE(journal.write(JournalDayPlot, c, sizeof(c)));
+    uint32_t size = journal.getSize();
+    TEST_ASSERT_EQUAL_UINT32(JOURNAL_RECORD_SIZE(100) * 2 + JOURNAL_RECORD_SIZE(300), size);
+
+    // Same bytes again is not appended
+    TEST_ASSERT_TRUE(journal.write(JournalDayPlot, c, sizeof(c)));
+    TEST_ASSERT_EQUAL_UINT32(size, journal.getSize());
+
+    // As after a reboot
+    AmsJournal reopened;
+    TEST_ASSERT_TRUE(reopened.begin());
+    TEST_ASSERT_EQUAL_UINT32(size, reopened.getSize());
+    TEST_ASSERT_EQUAL_UINT16(sizeof(c), reopened.read(JournalDayPlot, out, sizeof(out)));
+    TEST_ASSERT_EQUAL_MEMORY(c, out, sizeof(c));
+    TEST_ASSERT_EQUAL_UINT16(sizeof(b), reopened.read(JournalMonthPlot, out, sizeof(out)));
+    TEST_ASSERT_EQUAL_MEMORY(b, out, sizeof(b));
+    // Does not fit
+    TEST_ASSERT_EQUAL_UINT16(0, reopened.read(JournalMonthPlot, out, 10));
+    TEST_ASSERT_FALSE(reopened.has(JournalEnergyAccounting));
+}
+
+void test_journal_torn_tail_recovers(void) {
+    uint8_t a[200], c[200], out[200];
+    fill(a, sizeof(a), 4);
+    fill(c, sizeof(c), 5);
+
+    // Power lost in the middle of the second record
+    LittleFS.format();
+    {
+        AmsJournal journal;
+        journal.begin();
+        journal.write(JournalEnergyAccounting, a, sizeof(a));
+        journal.write(JournalEnergyAccounting, c, sizeof(c));
+    }
+    LittleFS.files[FILE_JOURNAL].resize(JOURNAL_RECORD_SIZE(200) + 50);
+    {
+        AmsJournal journal;
+        TEST_ASSERT_TRUE(journal.begin());
+        TEST_ASSERT_EQUAL_UINT16(sizeof(a), journal.read(JournalEnergyAccounting, out, sizeof(out)));
+        TEST_ASSERT_EQUAL_MEMORY(a, out, sizeof(a));
+        // The torn part is gone, so the next record lands after the good one
+        TEST_ASSERT_EQUAL_UINT32(JOURNAL_RECORD_SIZE(200), LittleFS.files[FILE_JOURNAL].size());
+        TEST_ASSERT_TRUE(journal.write(JournalEnergyAccounting, c, sizeof(c)));
+    }
+    {
+        AmsJournal journal;
+        journal.begin();
+        TEST_ASSERT_EQUAL_UINT16(sizeof(c), journal.read(JournalEnergyAccounting, out, sizeof(out)));
+        TEST_ASSERT_EQUAL_MEMORY(c, out, sizeof(c));
+    }
+
+    // A flipped bit in the newest record fails its CRC
+    LittleFS.files[FILE_JOURNAL][JOURNAL_RECORD_SIZE(200) + sizeof(JournalRecordHeader) + 10] ^= 0x10;
+    {
+        AmsJournal journal;
+        journal.begin();
+        TEST_ASSERT_EQUAL_UINT16(sizeof(a), journal.read(JournalEnergyAccounting, out, sizeof(out)));
+        TEST_ASSERT_EQUAL_MEMORY(a, out, sizeof(a));
+    }
+
+    // An interrupted compaction leaves its copy behind, the journal is used
+    LittleFS.files[FILE_JOURNAL_TMP] = std::vector<uint8_t>(10, 0xFF);
+    {
+        AmsJournal journal;
+        TEST_ASSERT_TRUE(journal.begin());
+        TEST_ASSERT_FALSE(LittleFS.exists(FILE_JOURNAL_TMP));
+        TEST_ASSERT_TRUE(journal.has(JournalEnergyAccounting));
+    }
+}
+
+void test_journal_compacts_when_full(void) {
+    LittleFS.format();
+    uint8_t data[800], keep[40], out[800];
+    fill(keep, sizeof(keep), 6);
+
+    AmsJournal journal;
+    journal.begin();
+    journal.write(JournalMonthPlot, keep, sizeof(keep));
+    for(uint8_t i = 0; i < 60; i++) {
+        fill(data, sizeof(data), i);
+        TEST_ASSERT_TRUE(journal.write(JournalQuarterPlot, data, sizeof(data)));
+        TEST_ASSERT_TRUE(journal.getSize() <= JOURNAL_MAX_SIZE);
+        TEST_ASSERT_EQUAL_UINT32(journal.getSize(), LittleFS.files[FILE_JOURNAL].size());
+    }
+    TEST_ASSERT_FALSE(LittleFS.exists(FILE_JOURNAL_TMP));
+
+    AmsJournal reopened;
+    reopened.begin();
+    TEST_ASSERT_EQUAL_UINT16(sizeof(data), reopened.read(JournalQuarterPlot, out, sizeof(out)));
+    TEST_ASSERT_EQUAL_MEMORY(data, out, sizeof(data));
+    TEST_ASSERT_EQUAL_UINT16(sizeof(keep), reopened.read(JournalMonthPlot, out, sizeof(out)));
+    TEST_ASSERT_EQUAL_MEMORY(keep, out, sizeof(keep));
+
+    // Down to one record per type
+    TEST_ASSERT_TRUE(reopened.compact());
+    TEST_ASSERT_EQUAL_UINT32(JOURNAL_RECORD_SIZE(800) + JOURNAL_RECORD_SIZE(40), reopened.getSize());
+}
+
+void test_journal_migrates_legacy_file(void) {
+    LittleFS.format();
+    uint8_t legacy[60], out[100];
+    fill(legacy, sizeof(legacy), 7);
+    File file = LittleFS.open(FILE_DAYPLOT, "w");
+    file.write(legacy, sizeof(legacy));
+    file.close();
+
+    AmsJournal journal;
+    journal.begin();
+    memset(out, 0, sizeof(out));
+    TEST_ASSERT_EQUAL_UINT16(sizeof(legacy), journal.load(JournalDayPlot, FILE_DAYPLOT, out, sizeof(out)));
+    TEST_ASSERT_EQUAL_MEMORY(legacy, out, sizeof(legacy));
+
+    TEST_ASSERT_TRUE(journal.save(JournalDayPlot, FILE_DAYPLOT, out, sizeof(out)));
+    TEST_ASSERT_FALSE(LittleFS.exists(FILE_DAYPLOT));
+    TEST_ASSERT_EQUAL_UINT16(sizeof(out), journal.load(JournalDayPlot, FILE_DAYPLOT, out, sizeof(out)));
+}
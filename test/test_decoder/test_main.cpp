@@ -7,8 +7,13 @@
 
 #include <unity.h>
 #include "HdlcParser.h"
+#include "crc.h"
+#include "MbusParser.h"
+#include "ObisIndex.h"
+#include "IEC6205675.h"
 #include "DataParser.h"
 #include "AmsData.h"
+#include "MeterDecoders.h"
 #include "decoder_harness.h"
 
 void setUp(void) {}
@@ -35,6 +40,285 @@ void test_hdlc_rejects_short_buffer(void) {
     TEST_ASSERT_EQUAL(DATA_PARSE_INCOMPLETE, ret);
 }
 
+// HDLC frame with a segmentation bit, n payload bytes of value fill and zero
+// HCS/FCS (which the parser does not verify)
+static uint16_t hdlc_segment(uint8_t* buf, uint16_t n, uint8_t fill, bool more) {
+    uint16_t format = (more ? 0xA800 : 0xA000) | (n + 9);
+    uint8_t head[] = { 0x7E, (uint8_t) (format >> 8), (uint8_t) format, 0x03, 0x21, 0x13, 0x00, 0x00 };
+    memcpy(buf, head, sizeof(head));
+    memset(buf + sizeof(head), fill, n);
+    memset(buf + sizeof(head) + n, 0, 2);
+    buf[sizeof(head) + n + 2] = 0x7E;
+    return n + 11;
+}
+
+// The FCS is checked before any header field is read, the address walk stays inside the frame
+void test_hdlc_checks_fcs_before_header(void) {
+    HDLCParser parser;
+    uint8_t buf[32];
+    uint16_t len = hdlc_segment(buf, 4, 0x0F, false);
+    uint16_t hcs = crc16_x25(buf + 1, 5);
+    buf[6] = hcs >> 8;
+    buf[7] = hcs & 0xFF;
+    uint16_t fcs = crc16_x25(buf + 1, len - 4);
+    buf[len - 3] = fcs >> 8;
+    buf[len - 2] = fcs & 0xFF;
+
+    DataParserContext ctx = {DATA_TAG_HDLC, len, 0, {}};
+    TEST_ASSERT_EQUAL(8, parser.parse(buf, ctx));
+
+    // An address byte without its end bit, the FCS catches it
+    buf[3] = 0x02;
+    ctx.length = len;
+    TEST_ASSERT_EQUAL(DATA_PARSE_FOOTER_CHECKSUM_ERROR, parser.parse(buf, ctx));
+
+    // Unchecked frame where no address ever ends
+    len = hdlc_segment(buf, 4, 0x00, false);
+    buf[3] = buf[4] = buf[5] = 0x00;
+    ctx.length = len;
+    TEST_ASSERT_EQUAL(DATA_PARSE_FAIL, parser.parse(buf, ctx));
+}
+
+void test_hdlc_segments_reassemble_in_arena(void) {
+    ReassemblyArena arena;
+    HDLCParser parser(&arena);
+    uint8_t buf[256];
+
+    DataParserContext ctx = {DATA_TAG_HDLC, hdlc_segment(buf, 100, 0x0F, true), 0, {}};
+    TEST_ASSERT_EQUAL(DATA_PARSE_INTERMEDIATE_SEGMENT, parser.parse(buf, ctx));
+    ctx.length = hdlc_segment(buf, 50, 0x11, false);
+    TEST_ASSERT_EQUAL(DATA_PARSE_FINAL_SEGMENT, parser.parse(buf, ctx));
+    TEST_ASSERT_EQUAL(150, ctx.length);
+    TEST_ASSERT_EQUAL(150, arena.getLength());
+    TEST_ASSERT_EQUAL(0x0F, arena.getData()[99]);
+    TEST_ASSERT_EQUAL(0x11, arena.getData()[100]);
+
+    // Never written past the arena: the segment that does not fit fails the APDU
+    int8_t ret = DATA_PARSE_INTERMEDIATE_SEGMENT;
+    int segments = 0;
+    while(ret == DATA_PARSE_INTERMEDIATE_SEGMENT && segments < 10) {
+        ctx.length = hdlc_segment(buf, 200, 0x0F, true);
+        ret = parser.parse(buf, ctx);
+        segments++;
+    }
+    TEST_ASSERT_EQUAL(DATA_PARSE_FAIL, ret);
+    TEST_ASSERT_EQUAL(REASSEMBLY_ARENA_SIZE / 200 + 1, segments);
+
+    // and the next APDU starts over
+    ctx.length = hdlc_segment(buf, 10, 0x0F, true);
+    TEST_ASSERT_EQUAL(DATA_PARSE_INTERMEDIATE_SEGMENT, parser.parse(buf, ctx));
+    TEST_ASSERT_EQUAL(10, arena.getLength());
+}
+
+// M-Bus long frame with CI carrying the finished bit and sequence number
+static uint16_t mbus_segment(uint8_t* buf, uint8_t n, uint8_t ci, uint8_t fill) {
+    uint8_t len = n + 5;
+    uint8_t head[] = { 0x68, len, len, 0x68, 0x53, 0xFF, ci, 0x67, 0xDB };
+    memcpy(buf, head, sizeof(head));
+    memset(buf + sizeof(head), fill, n);
+    uint8_t cs = 0;
+    for(int i = 4; i < 4 + len; i++) cs += buf[i];
+    buf[4 + len] = cs;
+    buf[5 + len] = 0x16;
+    return len + 6;
+}
+
+void test_mbus_segments_share_arena(void) {
+    ReassemblyArena arena;
+    MBUSParser mbus(&arena);
+    HDLCParser hdlc(&arena);
+    uint8_t buf[300];
+
+    DataParserContext ctx = {DATA_TAG_MBUS, mbus_segment(buf, 200, 0x00, 0xAA), 0, {}};
+    TEST_ASSERT_EQUAL(DATA_PARSE_INTERMEDIATE_SEGMENT, mbus.parse(buf, ctx));
+    ctx.length = mbus_segment(buf, 40, 0x11, 0xBB);
+    TEST_ASSERT_EQUAL(DATA_PARSE_FINAL_SEGMENT, mbus.parse(buf, ctx));
+    TEST_ASSERT_EQUAL(240, ctx.length);
+    TEST_ASSERT_EQUAL(0xBB, arena.getData()[239]);
+
+    // A segment for an APDU another parser started is refused
+    ctx.length = mbus_segment(buf, 20, 0x00, 0xAA);
+    TEST_ASSERT_EQUAL(DATA_PARSE_INTERMEDIATE_SEGMENT, mbus.parse(buf, ctx));
+    ctx.type = DATA_TAG_HDLC;
+    ctx.length = hdlc_segment(buf, 10, 0x0F, true);
+    TEST_ASSERT_EQUAL(DATA_PARSE_INTERMEDIATE_SEGMENT, hdlc.parse(buf, ctx));
+    ctx.type = DATA_TAG_MBUS;
+    ctx.length = mbus_segment(buf, 20, 0x11, 0xBB);
+    TEST_ASSERT_EQUAL(DATA_PARSE_FAIL, mbus.parse(buf, ctx));
+}
+
+void test_obis_index_first_match(void) {
+    // structure { obis 1.0.1.7.0.255, u32 1234, obis 1.0.1.7.0.255, u32 99, obis 1.0.32.7.0.255, u16 2301 }
+    uint8_t payload[900] = {
+        0x02, 0x06,
+        0x09, 0x06, 0x01, 0x00, 0x01, 0x07, 0x00, 0xFF, 0x06, 0x00, 0x00, 0x04, 0xD2,
+        0x09, 0x06, 0x01, 0x00, 0x01, 0x07, 0x00, 0xFF, 0x06, 0x00, 0x00, 0x00, 0x63,
+        0x09, 0x06, 0x01, 0x00, 0x20, 0x07, 0x00, 0xFF, 0x12, 0x08, 0xFD,
+    };
+    uint8_t activeImport[4] = { 1, 7, 0, 255 };
+    uint8_t voltageL1[4] = { 32, 7, 0, 255 };
+    uint8_t currentL1[4] = { 31, 7, 0, 255 };
+
+    ObisIndex index;
+    index.build((const char*) payload);
+    CosemData* item = NULL;
+    TEST_ASSERT_TRUE(index.lookup(activeImport, &item));
+    TEST_ASSERT_TRUE(item == (CosemData*) (payload + 10));
+    TEST_ASSERT_TRUE(index.lookup(voltageL1, &item));
+    TEST_ASSERT_TRUE(item == (CosemData*) (payload + 36));
+    TEST_ASSERT_TRUE(index.lookup(currentL1, &item));
+    TEST_ASSERT_NULL(item);
+}
+
+void test_cosem_cursor_walk(void) {
+    // structure { octet "AB", u16 2301, null, u32 1234 }
+    uint8_t payload[900] = {
+        0x02, 0x04,
+        0x09, 0x02, 'A', 'B',
+        0x12, 0x08, 0xFD,
+        0x00,
+        0x06, 0x00, 0x00, 0x04, 0xD2,
+    };
+    CosemCursor cursor((const char*) payload);
+    TEST_ASSERT_TRUE(cursor.next() == (CosemData*) payload);
+    TEST_ASSERT_TRUE(cursor.next() == (CosemData*) (payload + 2));
+    TEST_ASSERT_TRUE(cursor.peek() == (CosemData*) (payload + 6));
+    TEST_ASSERT_TRUE(cursor.at(4) == (CosemData*) (payload + 10));
+    TEST_ASSERT_EQUAL(1234, ntohl(cursor.peek()->dlu.data));
+    TEST_ASSERT_NULL(cursor.at(3)); // behind the cursor
+
+    // The rest of the buffer is nulls, one byte each, the walk ends at COSEM_MAX_WALK
+    cursor.skip(255);
+    cursor.skip(255);
+    cursor.skip(255);
+    cursor.skip(255);
+    TEST_ASSERT_NULL(cursor.peek());
+    TEST_ASSERT_NULL(cursor.next());
+}
+
+void test_kaifa_positional_list(void) {
+    // KFM_001 list 2, three phase: list id, meter id, model, P+ P- Q+ Q-, I1-3 (mA), U1-3 (dV)
+    uint8_t payload[900] = {
+        0x02, 0x0D,
+        0x09, 0x07, 'K', 'F', 'M', '_', '0', '0', '1',
+        0x09, 0x04, '1', '2', '3', '4',
+        0x09, 0x07, 'M', 'A', '3', '0', '4', 'H', '4',
+        0x06, 0x00, 0x00, 0x04, 0xD2,
+        0x06, 0x00, 0x00, 0x00, 0x00,
+        0x06, 0x00, 0x00, 0x00, 0x2A,
+        0x06, 0x00, 0x00, 0x00, 0x07,
+        0x06, 0x00, 0x00, 0x13, 0x88,
+        0x06, 0x00, 0x00, 0x07, 0xD0,
+        0x06, 0x00, 0x00, 0x03, 0xE8,
+        0x06, 0x00, 0x00, 0x08, 0xFD,
+        0x06, 0x00, 0x00, 0x09, 0x01,
+        0x06, 0x00, 0x00, 0x08, 0xF9,
+    };
+    static Timezone tz;
+    static NullStream dbg;
+    MeterConfig cfg;
+    memset(&cfg, 0, sizeof(cfg));
+    DataParserContext ctx = {DATA_TAG_DLMS, sizeof(payload), 0, {}};
+    AmsData state;
+    IEC6205675 parsed((const char*) payload, &tz, AmsTypeUnknown, &cfg, ctx, state, &dbg);
+
+    TEST_ASSERT_EQUAL(2, parsed.getListType());
+    TEST_ASSERT_EQUAL(AmsTypeKaifa, parsed.getMeterType());
+    TEST_ASSERT_EQUAL_STRING("1234", parsed.getMeterId());
+    TEST_ASSERT_EQUAL_STRING("MA304H4", parsed.getMeterModel());
+    TEST_ASSERT_EQUAL(1234, parsed.getActiveImportPower());
+    TEST_ASSERT_EQUAL(42, parsed.getReactiveImportPower());
+    TEST_ASSERT_EQUAL(7, parsed.getReactiveExportPower());
+    TEST_ASSERT_FLOAT_WITHIN(0.001, 5.0, parsed.getL1Current());
+    TEST_ASSERT_FLOAT_WITHIN(0.001, 1.0, parsed.getL3Current());
+    TEST_ASSERT_FLOAT_WITHIN(0.01, 230.1, parsed.getL1Voltage());
+    TEST_ASSERT_FLOAT_WITHIN(0.01, 230.5, parsed.getL2Voltage());
+}
+
+// Decoders that only count how often their signature is looked at
+static int s_matchCalls[3];
+class ListData : public AmsData {
+public:
+    ListData(uint8_t list) { listType = list; }
+};
+static bool match_a(const char* p) { s_matchCalls[0]++; return p[0] == 'a'; }
+static bool match_b(const char* p) { s_matchCalls[1]++; return p[0] == 'b'; }
+static bool match_c(const char* p) { s_matchCalls[2]++; return p[0] != 'a' && p[0] != 'b'; }
+static bool decode_list(DecoderInput& in, AmsData& data) { data = ListData(in.payload[1] - '0'); return true; }
+
+void test_decoder_registry_caches_format(void) {
+    DecoderRegistry registry;
+    registry.add(1, "a", match_a, decode_list);
+    registry.add(2, "b", match_b, decode_list);
+    registry.add(3, "c", match_c, decode_list);
+    DecoderInput in = { "b2", NULL, NULL, NULL, NULL, NULL };
+    AmsData data;
+
+    memset(s_matchCalls, 0, sizeof(s_matchCalls));
+    TEST_ASSERT_TRUE(registry.decode(in, data));
+    TEST_ASSERT_EQUAL(2, registry.getCached()->id);
+    TEST_ASSERT_EQUAL(1, s_matchCalls[0]);
+
+    // Straight to the cached one from now on
+    memset(s_matchCalls, 0, sizeof(s_matchCalls));
+    for (int i = 0; i < 10; i++) TEST_ASSERT_TRUE(registry.decode(in, data));
+    TEST_ASSERT_EQUAL(0, s_matchCalls[0]);
+    TEST_ASSERT_EQUAL(10, s_matchCalls[1]);
+    TEST_ASSERT_EQUAL(0, s_matchCalls[2]);
+
+    // Another format takes over the cache
+    in.payload = "c3";
+    TEST_ASSERT_TRUE(registry.decode(in, data));
+    TEST_ASSERT_EQUAL(3, registry.getCached()->id);
+    TEST_ASSERT_EQUAL(3, data.getListType());
+
+    // Decoded, but to nothing: not cached
+    in.payload = "a0";
+    TEST_ASSERT_TRUE(registry.decode(in, data));
+    TEST_ASSERT_EQUAL(1, registry.getLast()->id);
+    TEST_ASSERT_NULL(registry.getCached());
+
+    // The vendor formats: a Kaifa list is taken by the Kaifa decoder
+    uint8_t kaifa[900] = {
+        0x02, 0x09,
+        0x09, 0x07, 'K', 'F', 'M', '_', '0', '0', '1',
+        0x09, 0x04, '1', '2', '3', '4',
+        0x09, 0x07, 'M', 'A', '1', '0', '5', 'H', '2',
+        0x06, 0x00, 0x00, 0x04, 0xD2,
+        0x06, 0x00, 0x00, 0x00, 0x00,
+        0x06, 0x00, 0x00, 0x00, 0x00,
+        0x06, 0x00, 0x00, 0x00, 0x00,
+        0x06, 0x00, 0x00, 0x13, 0x88,
+        0x06, 0x00, 0x00, 0x08, 0xFD,
+    };
+    static Timezone tz;
+    static NullStream dbg;
+    MeterConfig cfg;
+    memset(&cfg, 0, sizeof(cfg));
+    DataParserContext ctx = {DATA_TAG_DLMS, sizeof(kaifa), 0, {}};
+    AmsData state;
+    DecoderRegistry meters;
+    addMeterDecoders(meters);
+
+    // Even with the generic DLMS decoder cached, it does not overlap the lists
+    uint8_t generic[900] = {
+        0x02, 0x02,
+        0x09, 0x06, 0x01, 0x00, 0x01, 0x07, 0x00, 0xFF,
+        0x06, 0x00, 0x00, 0x04, 0xD2,
+    };
+    DataParserContext gctx = {DATA_TAG_DLMS, 15, 0, {}};
+    DecoderInput gin = { (const char*) generic, &tz, &cfg, &gctx, &state, &dbg };
+    TEST_ASSERT_TRUE(meters.decode(gin, data));
+    TEST_ASSERT_EQUAL(MeterDecoderDlms, meters.getCached()->id);
+
+    DecoderInput kin = { (const char*) kaifa, &tz, &cfg, &ctx, &state, &dbg };
+    TEST_ASSERT_TRUE(meters.decode(kin, data));
+    TEST_ASSERT_EQUAL(MeterDecoderKaifa, meters.getCached()->id);
+    TEST_ASSERT_EQUAL(2, data.getListType());
+    TEST_ASSERT_EQUAL(AmsTypeKaifa, data.getMeterType());
+    TEST_ASSERT_EQUAL(1234, data.getActiveImportPower());
+}
+
 // ---------------------------------------------------------------------------
 // Smoke test: one unencrypted Iskra AM550 (Slovenia) frame decodes to a list
 // ---------------------------------------------------------------------------
@@ -44,11 +328,104 @@ void test_decode_iskra_gh956(void) {
     TEST_ASSERT_NOT_NULL(d);
     printf("gh956-1: listType=%d meterType=%d P+=%u L1V=%.1f id=%s\n",
            d->getListType(), d->getMeterType(), d->getActiveImportPower(),
-           d->getL1Voltage(), d->getMeterId().c_str());
+           d->getL1Voltage(), d->getMeterId());
     TEST_ASSERT_GREATER_OR_EQUAL(1, d->getListType());
     delete d;
 }
 
+// ---------------------------------------------------------------------------
+// Decoding into a reused slot, as the firmware loop does, must not touch the
+// heap once warm
+// ---------------------------------------------------------------------------
+
+void test_decode_into_slot_no_alloc(void) {
+    static uint8_t src[4096], work[4096];
+    int n = harness_load_fixture("test/payloads/iskraemeco/gh956-1.hex", src, sizeof(src));
+    TEST_ASSERT_GREATER_THAN(0, n);
+    MeterConfig cfg;
+    memset(&cfg, 0, sizeof(cfg));
+    AmsData slot;
+
+    memcpy(work, src, n);
+    TEST_ASSERT_TRUE(harness_decode_into(work, (uint16_t)n, &cfg, NULL, NULL, slot));
+    uint64_t allocs = harness_alloc_count();
+    for (int i = 0; i < 3; i++) {
+        memcpy(work, src, n);
+        TEST_ASSERT_TRUE(harness_decode_into(work, (uint16_t)n, &cfg, NULL, NULL, slot));
+    }
+    printf("  decode into slot: %llu allocations over 3 frames\n",
+           (unsigned long long) (harness_alloc_count() - allocs));
+    TEST_ASSERT_EQUAL_UINT32(0, (uint32_t) (harness_alloc_count() - allocs));
+    TEST_ASSERT_GREATER_OR_EQUAL(1, slot.getListType());
+}
+
+// ---------------------------------------------------------------------------
+// Merging frames into the meter state records which fields changed
+// ---------------------------------------------------------------------------
+
+class List2Data : public AmsData {
+public:
+    List2Data(uint64_t ms, uint32_t power, float voltage) {
+        listType = 2;
+        lastUpdateMillis = ms;
+        activeImportPower = power;
+        l1voltage = voltage;
+        setMeterId("1234");
+    }
+};
+
+void test_state_apply_change_mask(void) {
+    AmsData state;
+    TEST_ASSERT_EQUAL_UINT32(0, state.getGeneration());
+
+    List2Data first(1000, 1500, 230.0);
+    state.apply(first);
+    TEST_ASSERT_EQUAL_UINT32(1, state.getGeneration());
+    TEST_ASSERT_TRUE(state.hasChanged(AmsFieldListType));
+    TEST_ASSERT_TRUE(state.hasChanged(AmsFieldMeterId));
+    TEST_ASSERT_TRUE(state.hasChanged(AmsFieldActiveImportPower));
+    TEST_ASSERT_TRUE(state.hasChanged(AmsFieldL1Voltage));
+    TEST_ASSERT_TRUE(state.hasChanged(AmsFieldCounterEstimated));
+    TEST_ASSERT_FALSE(state.hasChanged(AmsFieldL2Voltage));
+
+    // Same values again: only the estimated counter moves
+    List2Data same(2000, 1500, 230.0);
+    state.apply(same);
+    TEST_ASSERT_EQUAL_UINT32(2, state.getGeneration());
+    TEST_ASSERT_TRUE(state.getChanges() == AMS_FIELD(AmsFieldActiveImportCounter));
+
+    List2Data voltage(2000, 1500, 231.0);
+    state.apply(voltage);
+    TEST_ASSERT_EQUAL_UINT32(3, state.getGeneration());
+    TEST_ASSERT_TRUE(state.getChanges() == AMS_FIELD(AmsFieldL1Voltage));
+    TEST_ASSERT_TRUE(state.getChanges() != 0 && (state.getChanges() & ~AMS_FIELDS_ALL) == 0);
+}
+
+void test_state_unchanged_apply_keeps_generation(void) {
+    AmsData state;
+    uint32_t seen = 0;
+    List2Data first(1000, 1500, 230.0);
+    state.apply(first);
+    TEST_ASSERT_TRUE(state.changesSince(seen) == state.getChanges());
+    TEST_ASSERT_EQUAL_UINT32(1, seen);
+
+    // Nothing changes, as when a pulse meter seeds its state between frames
+    List2Data same(1000, 1500, 230.0);
+    state.apply(same);
+    TEST_ASSERT_EQUAL_UINT32(1, state.getGeneration());
+    TEST_ASSERT_TRUE(state.changesSince(seen) == 0);
+
+    // The next frame publishes only what it changed
+    List2Data voltage(1000, 1500, 231.0);
+    state.apply(voltage);
+    TEST_ASSERT_TRUE(state.changesSince(seen) == AMS_FIELD(AmsFieldL1Voltage));
+
+    // A sink that missed a generation gets everything
+    seen = 0;
+    TEST_ASSERT_TRUE(state.changesSince(seen) == AMS_FIELDS_ALL);
+    TEST_ASSERT_EQUAL_UINT32(2, seen);
+}
+
 // defined in test_unencrypted.cpp
 void harness_emit_golden(void);
 void test_unencrypted_golden(void);
@@ -62,17 +439,70 @@ void test_encrypted_iskra_787(void);
 void test_encrypted_landisgyr_501(void);
 void test_encrypted_kaifa_905(void);
 void test_encrypted_kamstrup_73(void);
+void test_encrypted_gcm_known_key(void);
 void test_encrypted_framing_no_key(void);
+// defined in test_framing.cpp
+void test_assembler_hdlc_boundary(void);
+void test_assembler_dsmr_boundary(void);
+void test_assembler_matches_per_byte_unwrap(void);
+void test_assembler_raw_frames(void);
+void test_reader_matches_assembler(void);
+void test_reader_carries_next_telegram(void);
+// defined in test_autodetect.cpp
+void test_autodetect_locks_on_hdlc(void);
+void test_autodetect_infers_parity(void);
+void test_autodetect_time_to_lock(void);
+// defined in test_journal.cpp
+void test_journal_newest_record_wins(void);
+void test_journal_torn_tail_recovers(void);
+void test_journal_compacts_when_full(void);
+void test_journal_migrates_legacy_file(void);
+// defined in test_entsoe.cpp
+void test_entsoe_a44_documents(void);
+void test_entsoe_a44_throughput(void);
+// defined in test_demand.cpp
+void test_demand_running_average(void);
+void test_demand_peaks_per_model(void);
+void test_demand_gaps_and_month(void);
+// defined in test_realtime.cpp
+void test_realtime_buckets_roll_over(void);
+void test_realtime_scale_shift(void);
+void test_realtime_window(void);
+// defined in test_storage.cpp
+void test_storage_quarter_clock_steps_back(void);
+void test_storage_quarter_far_jump(void);
+void test_storage_quarter_estimated_counter(void);
+// defined in test_price_cache.cpp
+void test_price_cache_round_trip(void);
+void test_price_cache_rejects_other_config(void);
+// defined in bench_decoder.cpp
+int decoder_bench(const char* outPath);
+// defined in test_crc.cpp
+void test_crc_matches_bitwise(void);
+void test_crc_throughput(void);
 
 int main(int argc, char** argv) {
     if (argc > 1 && strcmp(argv[1], "gen") == 0) {
         harness_emit_golden();   // regenerate test/test_decoder/expected_unencrypted.h
         return 0;
     }
+    if (argc > 1 && strcmp(argv[1], "bench") == 0) {
+        return decoder_bench(argc > 2 ? argv[2] : "bench.json");   // see bench_decoder.cpp
+    }
     UNITY_BEGIN();
     RUN_TEST(test_hdlc_rejects_non_hdlc_buffer);
     RUN_TEST(test_hdlc_rejects_short_buffer);
+    RUN_TEST(test_hdlc_checks_fcs_before_header);
+    RUN_TEST(test_hdlc_segments_reassemble_in_arena);
+    RUN_TEST(test_mbus_segments_share_arena);
+    RUN_TEST(test_obis_index_first_match);
+    RUN_TEST(test_cosem_cursor_walk);
+    RUN_TEST(test_kaifa_positional_list);
+    RUN_TEST(test_decoder_registry_caches_format);
     RUN_TEST(test_decode_iskra_gh956);
+    RUN_TEST(test_decode_into_slot_no_alloc);
+    RUN_TEST(test_state_apply_change_mask);
+    RUN_TEST(test_state_unchanged_apply_keeps_generation);
     RUN_TEST(test_iskra_am550_slovenia);
     RUN_TEST(test_aidon_norway_list2);
     RUN_TEST(test_kamstrup_norway);
@@ -83,6 +513,35 @@ int main(int argc, char** argv) {
     RUN_TEST(test_encrypted_landisgyr_501);
     RUN_TEST(test_encrypted_kaifa_905);
     RUN_TEST(test_encrypted_kamstrup_73);
+    RUN_TEST(test_encrypted_gcm_known_key);
     RUN_TEST(test_encrypted_framing_no_key);
+    RUN_TEST(test_assembler_hdlc_boundary);
+    RUN_TEST(test_assembler_dsmr_boundary);
+    RUN_TEST(test_assembler_matches_per_byte_unwrap);
+    RUN_TEST(test_assembler_raw_frames);
+    RUN_TEST(test_reader_matches_assembler);
+    RUN_TEST(test_reader_carries_next_telegram);
+    RUN_TEST(test_crc_matches_bitwise);
+    RUN_TEST(test_crc_throughput);
+    RUN_TEST(test_autodetect_locks_on_hdlc);
+    RUN_TEST(test_autodetect_infers_parity);
+    RUN_TEST(test_autodetect_time_to_lock);
+    RUN_TEST(test_journal_newest_record_wins);
+    RUN_TEST(test_journal_torn_tail_recovers);
+    RUN_TEST(test_journal_compacts_when_full);
+    RUN_TEST(test_journal_migrates_legacy_file);
+    RUN_TEST(test_entsoe_a44_documents);
+    RUN_TEST(test_entsoe_a44_throughput);
+    RUN_TEST(test_demand_running_average);
+    RUN_TEST(test_demand_peaks_per_model);
+    RUN_TEST(test_demand_gaps_and_month);
+    RUN_TEST(test_realtime_buckets_roll_over);
+    RUN_TEST(test_realtime_scale_shift);
+    RUN_TEST(test_realtime_window);
+    RUN_TEST(test_storage_quarter_clock_steps_back);
+    RUN_TEST(test_storage_quarter_far_jump);
+    RUN_TEST(test_storage_quarter_estimated_counter);
+    RUN_TEST(test_price_cache_round_trip);
+    RUN_TEST(test_price_cache_rejects_other_config);
     return UNITY_END();
 }
@@ -0,0 +1,106 @@
+/**
+ * @copyright Utilitech AS 2023-2026
+ * License: Fair Source
+ *
+ * PriceCache, the journal record PriceService keeps fetched prices in: a
+ * price set written and read back, days moving on, records for another area,
+ * currency or resolution rejected, and records that do not fit.
+ */
+#include <unity.h>
+#include <string.h>
+#include "PriceCache.h"
+
+#define CACHE_DAY 20514 // 2026-03-02
+
+static PricesContainer* prices(uint8_t resolution, uint8_t points, bool exportPrices, float base) {
+    char source[] = "EOE";
+    char currency[] = "NOK";
+    PricesContainer* c = new PricesContainer(source);
+    c->setup(resolution, points, exportPrices);
+    c->setCurrency(currency);
+    for (uint8_t i = 0; i < points; i++) {
+        c->setPrice(i, base + i / 100.0f, PRICE_DIRECTION_IMPORT);
+        if (exportPrices) c->setPrice(i, base - i / 100.0f, PRICE_DIRECTION_EXPORT);
+    }
+    return c;
+}
+
+void test_price_cache_round_trip(void) {
+    static uint8_t buf[2048];
+    PricesContainer* today = prices(60, 24, false, 1.25f);
+    PricesContainer* tomorrow = prices(15, 96, true, 0.5f);
+
+    PriceCache cache("10YNO-1--------2", "NOK", 60);
+    uint16_t length = cache.write(buf, sizeof(buf), CACHE_DAY, today, tomorrow);
+    TEST_ASSERT_EQUAL(sizeof(PriceCacheHeader) + 2 * sizeof(PriceCacheDay) + (24 + 192) * sizeof(int32_t), length);
+
+    PricesContainer* readToday = NULL;
+    PricesContainer* readTomorrow = NULL;
+    TEST_ASSERT_TRUE(cache.read(buf, length, CACHE_DAY, readToday, readTomorrow));
+    TEST_ASSERT_NOT_NULL(readToday);
+    TEST_ASSERT_NOT_NULL(readTomorrow);
+    TEST_ASSERT_EQUAL_STRING("EOE", readToday->getSource());
+    TEST_ASSERT_EQUAL_STRING("NOK", readToday->getCurrency());
+    TEST_ASSERT_EQUAL(60, readToday->getResolutionInMinutes());
+    TEST_ASSERT_EQUAL(24, readToday->getNumberOfPoints());
+    TEST_ASSERT_FALSE(readToday->isExportPricesDifferentFromImport());
+    TEST_ASSERT_EQUAL_MEMORY(today->getPoints(), readToday->getPoints(), 24 * sizeof(int32_t));
+    TEST_ASSERT_EQUAL(15, readTomorrow->getResolutionInMinutes());
+    TEST_ASSERT_EQUAL(96, readTomorrow->getNumberOfPoints());
+    TEST_ASSERT_TRUE(readTomorrow->isExportPricesDifferentFromImport());
+    TEST_ASSERT_EQUAL_MEMORY(tomorrow->getPoints(), readTomorrow->getPoints(), 192 * sizeof(int32_t));
+
+    // A day later what was tomorrow is today, and there is no tomorrow yet
+    delete readToday;
+    delete readTomorrow;
+    readToday = readTomorrow = NULL;
+    TEST_ASSERT_TRUE(cache.read(buf, length, CACHE_DAY + 1, readToday, readTomorrow));
+    TEST_ASSERT_NOT_NULL(readToday);
+    TEST_ASSERT_NULL(readTomorrow);
+    TEST_ASSERT_EQUAL(96, readToday->getNumberOfPoints());
+    delete readToday;
+
+    // A record cut short keeps the days that are whole
+    readToday = readTomorrow = NULL;
+    TEST_ASSERT_TRUE(cache.read(buf, length - 1, CACHE_DAY, readToday, readTomorrow));
+    TEST_ASSERT_NOT_NULL(readToday);
+    TEST_ASSERT_NULL(readTomorrow);
+    delete readToday;
+
+    // And one that does not fit is not written
+    TEST_ASSERT_EQUAL(0, cache.write(buf, length - 1, CACHE_DAY, today, tomorrow));
+
+    delete today;
+    delete tomorrow;
+}
+
+void test_price_cache_rejects_other_config(void) {
+    static uint8_t buf[2048];
+    PricesContainer* today = prices(60, 24, false, 1.25f);
+    PriceCache cache("10YNO-1--------2", "NOK", 60);
+    uint16_t length = cache.write(buf, sizeof(buf), CACHE_DAY, today, NULL);
+    TEST_ASSERT_GREATER_THAN(0, length);
+
+    PriceCache others[] = {
+        PriceCache("10YNO-2--------T", "NOK", 60),
+        PriceCache("10YNO-1--------2", "EUR", 60),
+        PriceCache("10YNO-1--------2", "NOK", 15),
+    };
+    for (size_t i = 0; i < sizeof(others) / sizeof(others[0]); i++) {
+        PricesContainer* readToday = NULL;
+        PricesContainer* readTomorrow = NULL;
+        TEST_ASSERT_FALSE(others[i].read(buf, length, CACHE_DAY, readToday, readTomorrow));
+        TEST_ASSERT_NULL(readToday);
+        TEST_ASSERT_NULL(readTomorrow);
+    }
+
+    // Nor is a record shorter than its header, or of another version
+    PricesContainer* readToday = NULL;
+    PricesContainer* readTomorrow = NULL;
+    TEST_ASSERT_FALSE(cache.read(buf, sizeof(PriceCacheHeader) - 1, CACHE_DAY, readToday, readTomorrow));
+    buf[0] = PRICE_CACHE_VERSION + 1;
+    TEST_ASSERT_FALSE(cache.read(buf, length, CACHE_DAY, readToday, readTomorrow));
+    TEST_ASSERT_NULL(readToday);
+
+    delete today;
+}
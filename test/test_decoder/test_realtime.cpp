@@ -0,0 +1,131 @@
+/**
+ * @copyright Utilitech AS 2023-2026
+ * License: Fair Source
+ *
+ * RealtimePlot on a clock the test moves: readings folded into avg/min/max
+ * buckets, skipped buckets filled, the ring wrapping, the 16-bit scale shifting
+ * once a value no longer fits and back once it has left the ring, and the
+ * window setting on a board without PSRAM.
+ */
+#include <unity.h>
+#include "RealtimePlot.h"
+#include "decoder_harness.h"
+
+class PlotData : public AmsData {
+public:
+    PlotData(int32_t power) {
+        listType = 1;
+        if(power >= 0) {
+            activeImportPower = power;
+        } else {
+            activeExportPower = -power;
+        }
+    }
+};
+
+static void plot(RealtimePlot& rtp, unsigned long ms, int32_t power) {
+    harness_set_millis(ms);
+    PlotData data(power);
+    rtp.update(data);
+}
+
+void test_realtime_buckets_roll_over(void) {
+    RealtimePlot rtp;
+    TEST_ASSERT_TRUE(rtp.setup(1000, 10));
+    plot(rtp, 100000, 0); // First reading only starts the clock
+
+    // Three readings in bucket 0, one in 1, then a gap to 4
+    plot(rtp, 100200, 1000);
+    plot(rtp, 100500, 2000);
+    plot(rtp, 100800, 3000);
+    plot(rtp, 101200, 500);
+    plot(rtp, 104500, 700);
+
+    int32_t avg[5], min[5], max[5];
+    TEST_ASSERT_EQUAL(5, rtp.getValues(0, 5, avg, min, max));
+    const int32_t expected[] = { 700, 700, 700, 500, 2000 };
+    for(uint8_t i = 0; i < 5; i++) {
+        TEST_ASSERT_EQUAL_INT32(expected[i], avg[i]);
+    }
+    TEST_ASSERT_EQUAL_INT32(1000, min[4]);
+    TEST_ASSERT_EQUAL_INT32(3000, max[4]);
+    TEST_ASSERT_EQUAL_INT32(500, min[3]);
+    TEST_ASSERT_EQUAL_INT32(500, max[3]);
+
+    // Without min/max only the averages are written
+    int32_t only[2];
+    TEST_ASSERT_EQUAL(2, rtp.getValues(3, 2, only));
+    TEST_ASSERT_EQUAL_INT32(500, only[0]);
+    TEST_ASSERT_EQUAL_INT32(2000, only[1]);
+
+    // Around the ring, bucket 0 is reused and the ones passed are filled
+    plot(rtp, 110200, -42);
+    TEST_ASSERT_EQUAL_INT32(-42, rtp.getValue(0));
+    TEST_ASSERT_EQUAL_INT32(-42, rtp.getValue(5));
+    TEST_ASSERT_EQUAL_INT32(700, rtp.getValue(6));
+    TEST_ASSERT_EQUAL_INT32(500, rtp.getValue(9));
+
+    // Asking for more than the ring holds stops at its end
+    int32_t all[20];
+    TEST_ASSERT_EQUAL(11, rtp.getValues(0, 20, all));
+}
+
+void test_realtime_scale_shift(void) {
+    RealtimePlot rtp;
+    TEST_ASSERT_TRUE(rtp.setup(1000, 8));
+    plot(rtp, 100000, 0);
+
+    // 1 W resolution while everything fits in 16 bits
+    plot(rtp, 100500, 30000);
+    TEST_ASSERT_EQUAL_INT32(30000, rtp.getValue(0));
+    plot(rtp, 101500, 12345);
+    TEST_ASSERT_EQUAL_INT32(12345, rtp.getValue(0));
+
+    // 40 kW does not, the ring is halved and keeps its values at 2 W resolution
+    plot(rtp, 102500, 40000);
+    TEST_ASSERT_EQUAL_INT32(40000, rtp.getValue(0));
+    TEST_ASSERT_EQUAL_INT32(12344, rtp.getValue(1));
+    TEST_ASSERT_EQUAL_INT32(30000, rtp.getValue(2));
+
+    // And again for 70 kW of export
+    plot(rtp, 103500, -70000);
+    TEST_ASSERT_EQUAL_INT32(-70000, rtp.getValue(0));
+    TEST_ASSERT_EQUAL_INT32(40000, rtp.getValue(1));
+    TEST_ASSERT_EQUAL_INT32(12344, rtp.getValue(2));
+
+    // min and max of a bucket go through the same scale as its average
+    plot(rtp, 104200, 1000);
+    plot(rtp, 104600, 50000);
+    int32_t avg, min, max;
+    TEST_ASSERT_EQUAL(1, rtp.getValues(0, 1, &avg, &min, &max));
+    TEST_ASSERT_EQUAL_INT32(25500, avg);
+    TEST_ASSERT_EQUAL_INT32(1000, min);
+    TEST_ASSERT_EQUAL_INT32(50000, max);
+
+    // Coarse while 50 kW is still in the ring, and 1 W again once it is overwritten
+    for(unsigned long ms = 105500; ms <= 111500; ms += 1000) {
+        plot(rtp, ms, 1001);
+    }
+    TEST_ASSERT_EQUAL_INT32(1000, rtp.getValue(0));
+    plot(rtp, 112500, 1001);
+    TEST_ASSERT_EQUAL_INT32(1001, rtp.getValue(0));
+    TEST_ASSERT_EQUAL_INT32(1000, rtp.getValue(1));
+    plot(rtp, 113500, 32000);
+    TEST_ASSERT_EQUAL_INT32(32000, rtp.getValue(0));
+}
+
+void test_realtime_window(void) {
+    RealtimePlot rtp;
+    TEST_ASSERT_EQUAL(REALTIME_SIZE, rtp.getSize());
+
+    // No PSRAM here, so the fine window falls back to the default
+    TEST_ASSERT_TRUE(rtp.setWindow(REALTIME_WINDOW_FINE));
+    TEST_ASSERT_EQUAL_UINT32(REALTIME_SAMPLE, rtp.getPeriod());
+    TEST_ASSERT_EQUAL(REALTIME_SIZE, rtp.getSize());
+
+    // Same shape again keeps what was recorded
+    plot(rtp, 100000, 0);
+    plot(rtp, 100500, 1234);
+    TEST_ASSERT_TRUE(rtp.setWindow(REALTIME_WINDOW_DEFAULT));
+    TEST_ASSERT_EQUAL_INT32(1234, rtp.getValue(0));
+}
@@ -0,0 +1,121 @@
+/**
+ * @copyright Utilitech AS 2023-2026
+ * License: Fair Source
+ *
+ * AmsDataStorage quarter-hour history on a clock the test sets: counter
+ * movement per quarter, a clock stepping back a little staying in the
+ * quarter in progress, jumps past the history starting it over, and a
+ * counter estimated since boot not turning into a spike once the meter
+ * sends its own.
+ */
+#include <unity.h>
+#include "AmsDataStorage.h"
+
+// 2026-03-02 10:00 UTC, on a quarter boundary
+#define STORAGE_T0 1772445600
+
+class CounterData : public AmsData {
+public:
+    CounterData(double importKwh, double exportKwh, bool estimated = false, uint32_t power = 3000) {
+        // An estimate before the first list 3 is built from 0 on list 2
+        listType = estimated ? 2 : 3;
+        counterEstimated = estimated;
+        activeImportCounter = importKwh;
+        activeExportCounter = exportKwh;
+        activeImportPower = power;
+        activeExportPower = power;
+    }
+};
+
+static void quarter(AmsDataStorage& ds, time_t now, double importKwh, double exportKwh = 0) {
+    CounterData data(importKwh, exportKwh);
+    ds.updateQuarter(&data, now);
+}
+
+static void estimated(AmsDataStorage& ds, time_t now, double importKwh) {
+    CounterData data(importKwh, 0, true);
+    ds.updateQuarter(&data, now);
+}
+
+void test_storage_quarter_clock_steps_back(void) {
+    AmsDataStorage ds(NULL);
+    quarter(ds, STORAGE_T0 + 10, 100.0);
+    quarter(ds, STORAGE_T0 + 600, 100.2, 0.1);
+    quarter(ds, STORAGE_T0 + 905, 100.5, 0.1);
+    TEST_ASSERT_EQUAL(2, ds.getQuarterCount());
+    TEST_ASSERT_EQUAL(STORAGE_T0 + 900, ds.getLastQuarter());
+    TEST_ASSERT_EQUAL_UINT32(200, ds.getQuarterImport(1));
+    TEST_ASSERT_EQUAL_UINT32(100, ds.getQuarterExport(1));
+
+    // The meter clock a few seconds behind the ESP clock: stays in the quarter in progress
+    quarter(ds, STORAGE_T0 + 895, 100.6, 0.1);
+    TEST_ASSERT_EQUAL(2, ds.getQuarterCount());
+    TEST_ASSERT_EQUAL(STORAGE_T0 + 900, ds.getLastQuarter());
+    TEST_ASSERT_EQUAL_UINT32(400, ds.getQuarterImport(0));
+    TEST_ASSERT_EQUAL_UINT32(200, ds.getQuarterImport(1));
+
+    // Further back, still inside the history, is kept as well
+    quarter(ds, STORAGE_T0 - 3 * 900, 100.7, 0.1);
+    TEST_ASSERT_EQUAL(2, ds.getQuarterCount());
+    TEST_ASSERT_EQUAL_UINT32(500, ds.getQuarterImport(0));
+
+    // And the next quarter carries on from there
+    quarter(ds, STORAGE_T0 + 1800, 101.0, 0.1);
+    TEST_ASSERT_EQUAL(3, ds.getQuarterCount());
+    TEST_ASSERT_EQUAL_UINT32(300, ds.getQuarterImport(0));
+    TEST_ASSERT_EQUAL_UINT32(500, ds.getQuarterImport(1));
+    TEST_ASSERT_EQUAL_UINT32(200, ds.getQuarterImport(2));
+}
+
+void test_storage_quarter_far_jump(void) {
+    const time_t span = (time_t) QUARTER_SLOTS * QUARTER_SECONDS;
+    AmsDataStorage ds(NULL);
+    quarter(ds, STORAGE_T0, 100.0);
+    quarter(ds, STORAGE_T0 + 900, 100.5);
+    TEST_ASSERT_EQUAL(2, ds.getQuarterCount());
+
+    // A gap inside the history is spread over the quarters it covers
+    quarter(ds, STORAGE_T0 + 4 * 900, 100.8);
+    TEST_ASSERT_EQUAL(5, ds.getQuarterCount());
+    TEST_ASSERT_EQUAL_UINT32(100, ds.getQuarterImport(0));
+    TEST_ASSERT_EQUAL_UINT32(100, ds.getQuarterImport(2));
+
+    // Back further than the history reaches starts it over
+    quarter(ds, STORAGE_T0 + 4 * 900 - span, 100.9);
+    TEST_ASSERT_EQUAL(1, ds.getQuarterCount());
+    TEST_ASSERT_EQUAL(STORAGE_T0 + 4 * 900 - span, ds.getLastQuarter());
+    TEST_ASSERT_EQUAL_UINT32(0, ds.getQuarterImport(0));
+
+    // So does forward past it
+    quarter(ds, STORAGE_T0 + 4 * 900, 101.0);
+    TEST_ASSERT_EQUAL(1, ds.getQuarterCount());
+    TEST_ASSERT_EQUAL(STORAGE_T0 + 4 * 900, ds.getLastQuarter());
+    TEST_ASSERT_EQUAL_UINT32(0, ds.getQuarterImport(0));
+    TEST_ASSERT_EQUAL_UINT32(0, ds.getQuarterImport(1));
+}
+
+void test_storage_quarter_estimated_counter(void) {
+    AmsDataStorage ds(NULL);
+    quarter(ds, STORAGE_T0, 50000.0);
+    quarter(ds, STORAGE_T0 + 600, 50000.4);
+    TEST_ASSERT_EQUAL_UINT32(400, ds.getQuarterImport(0));
+
+    // Rebooted, the counter is estimated from 0 until the meter sends it
+    estimated(ds, STORAGE_T0 + 700, 0.01);
+    estimated(ds, STORAGE_T0 + 950, 0.2);
+    TEST_ASSERT_EQUAL(2, ds.getQuarterCount());
+    TEST_ASSERT_EQUAL_UINT32(0, ds.getQuarterImport(0));
+    TEST_ASSERT_EQUAL_UINT32(400, ds.getQuarterImport(1));
+
+    // The real counter only sets where to count from
+    quarter(ds, STORAGE_T0 + 1000, 50000.9);
+    TEST_ASSERT_EQUAL_UINT32(0, ds.getQuarterImport(0));
+    quarter(ds, STORAGE_T0 + 1200, 50001.0);
+    TEST_ASSERT_EQUAL_UINT32(100, ds.getQuarterImport(0));
+
+    // More than the power could have drawn is not usage either
+    quarter(ds, STORAGE_T0 + 1300, 50100.0);
+    TEST_ASSERT_EQUAL_UINT32(100, ds.getQuarterImport(0));
+    quarter(ds, STORAGE_T0 + 1400, 50100.2);
+    TEST_ASSERT_EQUAL_UINT32(300, ds.getQuarterImport(0));
+}
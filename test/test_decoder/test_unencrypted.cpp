@@ -61,7 +61,7 @@ void harness_emit_golden(void) {
                        d->getActiveImportPower(), d->getActiveExportPower(),
                        d->getL1Voltage(), d->getL2Voltage(), d->getL3Voltage(),
                        d->getL1Current(), d->getL2Current(), d->getL3Current(),
-                       d->getActiveImportCounter(), d->getMeterId().c_str());
+                       d->getActiveImportCounter(), d->getMeterId());
                 delete d;
             }
         }
@@ -90,7 +90,7 @@ void test_unencrypted_golden(void) {
             if (!NEAR(d->getL1Current(), g.l1a) || !NEAR(d->getL2Current(), g.l2a) ||
                 !NEAR(d->getL3Current(), g.l3a)) ok = false;
             if (fabs(d->getActiveImportCounter() - g.importCounter) > 0.01) ok = false;
-            if (strcmp(d->getMeterId().c_str(), g.meterId) != 0) ok = false;
+            if (strcmp(d->getMeterId(), g.meterId) != 0) ok = false;
             #undef NEAR
         }
         if (!ok) { printf("  GOLDEN MISMATCH: %s\n", g.path); mismatches++; }
@@ -111,7 +111,7 @@ void test_iskra_am550_slovenia(void) {
     TEST_ASSERT_EQUAL(AmsTypeIskra, d->getMeterType());
     TEST_ASSERT_GREATER_OR_EQUAL(1, d->getListType());
     TEST_ASSERT_FLOAT_WITHIN(5.0, 232.5, d->getL1Voltage());
-    TEST_ASSERT_EQUAL_STRING("16820005", d->getMeterId().c_str());
+    TEST_ASSERT_EQUAL_STRING("16820005", d->getMeterId());
     delete d;
 }
 